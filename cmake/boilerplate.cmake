@@ -338,6 +338,25 @@ macro (gs_addpackage name)
   )
 endmacro()
 
+# ----- Register banks generated from a JSON or IP-XACT description
+# gs_add_reg_bank(<target> <description> [generator options])
+# Generates <description name>.h in the current binary directory, see
+# systemc-components/common/scripts/gen-reg-bank.py
+set(GS_REG_BANK_GENERATOR ${CMAKE_CURRENT_LIST_DIR}/../systemc-components/common/scripts/gen-reg-bank.py)
+macro(gs_add_reg_bank TARGET DESCRIPTION)
+  find_package(Python3 COMPONENTS Interpreter REQUIRED)
+  get_filename_component(_reg_bank_desc ${DESCRIPTION} ABSOLUTE)
+  get_filename_component(_reg_bank_name ${DESCRIPTION} NAME_WE)
+  set(_reg_bank_header ${CMAKE_CURRENT_BINARY_DIR}/${_reg_bank_name}.h)
+  add_custom_command(
+    OUTPUT ${_reg_bank_header}
+    COMMAND ${Python3_EXECUTABLE} ${GS_REG_BANK_GENERATOR} ${_reg_bank_desc} -o ${_reg_bank_header} ${ARGN}
+    DEPENDS ${_reg_bank_desc} ${GS_REG_BANK_GENERATOR}
+    COMMENT "Generating the register bank ${_reg_bank_name}.h")
+  target_sources(${TARGET} PRIVATE ${_reg_bank_header})
+  target_include_directories(${TARGET} PRIVATE ${CMAKE_CURRENT_BINARY_DIR})
+endmacro()
+
 macro(gs_enable_testing)
   if (NOT GS_ONLY)
     if(BUILD_TESTING AND ("${PROJECT_NAME}" STREQUAL "${CMAKE_PROJECT_NAME}"))
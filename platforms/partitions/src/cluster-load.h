@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef __PARTITIONS_CLUSTER_LOAD__
+#define __PARTITIONS_CLUSTER_LOAD__
+
+#include <chrono>
+
+#include <systemc>
+#include <tlm>
+#include <tlm_utils/simple_initiator_socket.h>
+#include <tlm_utils/tlm_quantumkeeper.h>
+#include <cci_configuration>
+#include <scp/report.h>
+
+#include <module_factory_registery.h>
+#include <tlm_sockets_buswidth.h>
+
+/**
+ * @class ClusterLoad
+ *
+ * @brief A loosely timed initiator standing for the activity of a cluster
+ *
+ * @details Writes and reads back its local memory, doing some host work for
+ * each access (e.g. what a model would do to handle it), and goes to the
+ * memory of the other cluster every @remote_every accesses. The accesses
+ * don't use DMI, all of them go through SystemC.
+ */
+class ClusterLoad : public sc_core::sc_module
+{
+    SCP_LOGGER(());
+
+public:
+    tlm_utils::simple_initiator_socket<ClusterLoad, DEFAULT_TLM_BUSWIDTH> initiator_socket;
+
+    cci::cci_param<uint64_t> p_local_base;
+    cci::cci_param<uint64_t> p_local_size;
+    cci::cci_param<uint64_t> p_remote_base;
+    cci::cci_param<uint64_t> p_remote_size;
+    cci::cci_param<uint64_t> p_remote_every;
+    cci::cci_param<uint64_t> p_access_ns;
+    cci::cci_param<uint64_t> p_work;
+    cci::cci_param<uint64_t> p_nb_accesses;
+    cci::cci_param<bool> p_stop_when_done;
+
+private:
+    tlm_utils::tlm_quantumkeeper m_qk;
+    uint64_t m_accesses = 0;
+    uint64_t m_remote_accesses = 0;
+    uint64_t m_errors = 0;
+    std::chrono::steady_clock::time_point m_start;
+
+    /* Some host work, depending on the data so that it isn't optimized out */
+    uint32_t work(uint32_t v)
+    {
+        for (uint64_t i = 0; i < p_work; i++) {
+            v = v * 1664525 + 1013904223;
+        }
+        return v;
+    }
+
+    void access(tlm::tlm_command cmd, uint64_t addr, uint32_t& data)
+    {
+        tlm::tlm_generic_payload txn;
+        txn.set_command(cmd);
+        txn.set_address(addr);
+        txn.set_data_ptr(reinterpret_cast<unsigned char*>(&data));
+        txn.set_data_length(sizeof(data));
+        txn.set_streaming_width(sizeof(data));
+        txn.set_byte_enable_length(0);
+        txn.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+
+        sc_core::sc_time delay = m_qk.get_local_time();
+        initiator_socket->b_transport(txn, delay);
+        m_qk.set(delay);
+        m_qk.inc(sc_core::sc_time(p_access_ns, sc_core::SC_NS));
+        if (m_qk.need_sync()) {
+            m_qk.sync();
+        }
+
+        if (txn.get_response_status() != tlm::TLM_OK_RESPONSE) {
+            m_errors++;
+        }
+        m_accesses++;
+    }
+
+    void run()
+    {
+        m_qk.reset();
+        m_start = std::chrono::steady_clock::now();
+
+        uint64_t words = p_local_size / sizeof(uint32_t);
+        uint64_t remote_words = p_remote_size / sizeof(uint32_t);
+        uint32_t v = 1;
+        for (uint64_t i = 0; !p_nb_accesses || m_accesses < p_nb_accesses; i++) {
+            uint64_t addr = p_local_base + (i % words) * sizeof(uint32_t);
+            if (p_remote_every && remote_words && (i % p_remote_every) == p_remote_every - 1) {
+                addr = p_remote_base + (i % remote_words) * sizeof(uint32_t);
+                m_remote_accesses++;
+            }
+            v = work(v);
+            uint32_t data = v;
+            access(tlm::TLM_WRITE_COMMAND, addr, data);
+            access(tlm::TLM_READ_COMMAND, addr, data);
+            if (data != v) {
+                m_errors++;
+            }
+        }
+
+        m_qk.sync();
+        report();
+        if (p_stop_when_done) {
+            sc_core::sc_stop();
+        }
+    }
+
+    void report()
+    {
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+        SCP_INFO(()) << m_accesses << " accesses (" << m_remote_accesses * 2 << " to the other cluster), "
+                     << m_errors << " errors, in " << secs << "s: " << (secs > 0 ? m_accesses / secs : 0)
+                     << " accesses/s, at " << sc_core::sc_time_stamp();
+    }
+
+public:
+    SC_HAS_PROCESS(ClusterLoad);
+    ClusterLoad(const sc_core::sc_module_name& n)
+        : sc_core::sc_module(n)
+        , initiator_socket("initiator_socket")
+        , p_local_base("local_base", 0, "Base address of the local memory")
+        , p_local_size("local_size", 0x10000, "Size of the local memory used")
+        , p_remote_base("remote_base", 0, "Base address of the memory of the other cluster")
+        , p_remote_size("remote_size", 0, "Size of the memory of the other cluster used (0: none)")
+        , p_remote_every("remote_every", 0, "Go to the other cluster every this many accesses (0: never)")
+        , p_access_ns("access_ns", 10, "SystemC time taken by each access")
+        , p_work("work", 1000, "Host work done for each access, in iterations")
+        , p_nb_accesses("nb_accesses", 0, "Number of accesses to do (0: no limit)")
+        , p_stop_when_done("stop_when_done", false, "Stop the simulation once the accesses are done")
+    {
+        SC_THREAD(run);
+    }
+
+    void end_of_simulation()
+    {
+        if (p_nb_accesses == 0 || m_accesses < p_nb_accesses) {
+            report();
+        }
+    }
+};
+GSC_MODULE_REGISTER(ClusterLoad);
+
+#endif
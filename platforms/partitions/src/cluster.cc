@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Runs a partition of a platform in its own process: the container holding
+ * a RemotePass named "cluster_pass", which gets the configuration of the
+ * partition from the RemotePass of the parent process.
+ */
+#include <systemc>
+#include <cci_configuration>
+
+#include <cciutils.h>
+#include "cluster-load.h"
+#include "gs_memory/include/gs_memory.h"
+#include "router/include/router.h"
+#include "remote.h"
+
+#include <module_factory_container.h>
+
+class ClusterPartition : public gs::ModuleFactory::ContainerDeferModulesConstruct
+{
+    SCP_LOGGER(());
+
+protected:
+    cci::cci_param<int> p_quantum_ns;
+
+public:
+    ClusterPartition(const sc_core::sc_module_name& n)
+        : gs::ModuleFactory::ContainerDeferModulesConstruct(n)
+        , p_quantum_ns("quantum_ns", 1'000'000, "TLM-2.0 global quantum in ns")
+    {
+        using tlm_utils::tlm_quantumkeeper;
+
+        SCP_DEBUG(()) << "Cluster partition constructor";
+
+        sc_core::sc_module* rpass = construct_module("RemotePass", "cluster_pass", {});
+        // the configuration of the partition is known once the remote pass is connected
+        sc_core::sc_time global_quantum(p_quantum_ns, sc_core::SC_NS);
+        tlm_quantumkeeper::set_global_quantum(global_quantum);
+
+        ModulesConstruct();
+        name_bind(rpass);
+    }
+
+    ~ClusterPartition() {}
+};
+
+int sc_main(int argc, char* argv[])
+{
+    auto m_broker = new gs::ConfigurableBroker({
+        { "partition.moduletype", cci::cci_value("ContainerDeferModulesConstruct") },
+    });
+
+    ClusterPartition partition("partition");
+    try {
+        sc_core::sc_start();
+    } catch (std::runtime_error const& e) {
+        std::cerr << "Error: (cluster partition) '" << e.what() << "'\n";
+        exit(1);
+    } catch (const std::exception& err) {
+        std::cerr << "Unknown error (cluster partition) !" << err.what() << "\n";
+        exit(2);
+    }
+    return 0;
+}
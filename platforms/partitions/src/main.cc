@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Two clusters platform, optionally partitioned over two processes */
+#include <chrono>
+#include <string>
+
+#include <cci_configuration>
+#include <systemc>
+
+#include <cciutils.h>
+#include <argparser.h>
+#include "cluster-load.h"
+#include "gs_memory/include/gs_memory.h"
+#include "router/include/router.h"
+#include "remote.h"
+
+#include <module_factory_container.h>
+
+class PartitionsPlatform : public gs::ModuleFactory::Container
+{
+protected:
+    cci::cci_param<int> p_quantum_ns;
+
+public:
+    PartitionsPlatform(const sc_core::sc_module_name& n)
+        : gs::ModuleFactory::Container(n), p_quantum_ns("quantum_ns", 1000000, "TLM-2.0 global quantum in ns")
+    {
+        using tlm_utils::tlm_quantumkeeper;
+
+        SCP_DEBUG(()) << "Constructor";
+
+        sc_core::sc_time global_quantum(p_quantum_ns, sc_core::SC_NS);
+        tlm_quantumkeeper::set_global_quantum(global_quantum);
+    }
+
+    SCP_LOGGER(());
+
+    ~PartitionsPlatform() {}
+};
+
+int sc_main(int argc, char* argv[])
+{
+    gs::ConfigurableBroker m_broker{};
+    cci::cci_originator orig{ "sc_main" };
+    auto broker_h = m_broker.create_broker_handle(orig);
+    ArgParser ap{ broker_h, argc, argv };
+
+    PartitionsPlatform platform("platform");
+
+    auto start = std::chrono::system_clock::now();
+    try {
+        SCP_INFO() << "SC_START";
+        sc_core::sc_start();
+    } catch (std::runtime_error const& e) {
+        std::cerr << argv[0] << "Error: '" << e.what() << std::endl;
+        exit(1);
+    } catch (const std::exception& exc) {
+        std::cerr << argv[0] << " Error: '" << exc.what() << std::endl;
+        exit(2);
+    } catch (...) {
+        SCP_ERR() << "Local platform Unknown error (main.cc)!";
+        exit(3);
+    }
+    auto end = std::chrono::system_clock::now();
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    std::cout << "Simulation Time: " << sc_core::sc_time_stamp().to_seconds() << "SC_SEC" << std::endl;
+    std::cout << "Simulation Duration: " << elapsed.count() << "ms (Wall Clock)" << std::endl;
+
+    return 0;
+}
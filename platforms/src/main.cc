@@ -6,6 +6,7 @@
  */
 
 #include <chrono>
+#include <memory>
 #include <string>
 
 #include <cci_configuration>
@@ -13,6 +14,7 @@
 
 #include <cciutils.h>
 #include <argparser.h>
+#include <fork_server.h>
 #include <module_factory_container.h>
 
 class GreenSocsPlatform : public gs::ModuleFactory::Container
@@ -48,8 +50,30 @@ int sc_main(int argc, char* argv[])
     auto broker_h = m_broker.create_broker_handle(orig);
     ArgParser ap{ broker_h, argc, argv };
 
+    cci::cci_param<std::string> p_fork_socket{ "fork_server.socket", "",
+                                               "Unix socket of the fork server, none to run once",
+                                               cci::CCI_ABSOLUTE_NAME, orig };
+    cci::cci_param<std::string> p_fork_point{ "fork_server.point", "construction",
+                                              "Where the runs are forked: after the configuration (config) or the "
+                                              "construction of the platform (construction)",
+                                              cci::CCI_ABSOLUTE_NAME, orig };
+    std::unique_ptr<gs::fork_server> fork_server;
+    if (!p_fork_socket.get_value().empty()) {
+        if (p_fork_point.get_value() != "config" && p_fork_point.get_value() != "construction") {
+            SCP_FATAL() << "Unknown fork_server.point " << p_fork_point.get_value();
+        }
+        fork_server = std::make_unique<gs::fork_server>(broker_h, p_fork_socket.get_value());
+        if (p_fork_point.get_value() == "config" && !fork_server->serve()) {
+            return 0;
+        }
+    }
+
     GreenSocsPlatform platform("platform");
 
+    if (fork_server && p_fork_point.get_value() == "construction" && !fork_server->serve()) {
+        return 0;
+    }
+
     auto start = std::chrono::system_clock::now();
     try {
         SCP_INFO() << "SC_START";
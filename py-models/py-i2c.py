@@ -65,10 +65,7 @@ def i2c_read(id: int, trans: tlm_generic_payload, delay: sc_time) -> None:
         txn.set_data_length(requested_len)
         txn.set_command(tlm_command.TLM_WRITE_COMMAND)
         biflow_socket.set_default_txn(txn)
-        i = 0
-        while i < trans.get_data_length():
-            biflow_socket.enqueue(q.get())
-            i = i + 1
+        biflow_socket.enqueue(bytes(int(q.get()) for _ in range(requested_len)))
     except SystemExit:
         return
     except Exception as e:
@@ -0,0 +1,275 @@
+/*
+ * This file is part of libqbox
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _LIBQBOX_BLOCK_BACKEND_H
+#define _LIBQBOX_BLOCK_BACKEND_H
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cci_configuration>
+#include <scp/report.h>
+
+#include <qemu-instance.h>
+
+/**
+ * @class QemuBlockBackend
+ *
+ * @brief The QEMU drive of a disk device: its image, overlay, AIO, cache
+ * mode and I/O thread
+ *
+ * @details The parameters are created in the scope of the device owning the
+ * backend. The base image can be shared read-only by parallel runs, each one
+ * writing to its own overlay:
+ *   - overlay = ""          the base image is used directly (and written)
+ *   - overlay = "snapshot"  the writes go to a temporary overlay which QEMU
+ *                           deletes at the end of the run
+ *   - overlay = <file>      the writes go to a qcow2 overlay backed by the
+ *                           base image, created at the start of each run
+ *                           (replacing the one of the previous run)
+ *
+ * With an I/O thread, the device processes its requests in that thread
+ * rather than with the iothread lock held (for the devices and accelerators
+ * which support it, see the README).
+ */
+class QemuBlockBackend
+{
+    SCP_LOGGER();
+
+    static uint64_t be(const uint8_t* b, int n)
+    {
+        uint64_t v = 0;
+        for (int i = 0; i < n; i++) {
+            v = (v << 8) | b[i];
+        }
+        return v;
+    }
+
+    static void put_be(std::vector<uint8_t>& buf, size_t off, uint64_t v, int n)
+    {
+        for (int i = n - 1; i >= 0; i--, v >>= 8) {
+            buf[off + i] = v & 0xff;
+        }
+    }
+
+    QemuInstance& m_inst;
+    std::string m_id;
+    bool m_has_iothread;
+
+public:
+    cci::cci_param<std::string> p_format;
+    cci::cci_param<std::string> p_overlay;
+    cci::cci_param<std::string> p_aio;
+    cci::cci_param<std::string> p_cache;
+    std::unique_ptr<cci::cci_param<bool>> p_iothread;
+
+    QemuBlockBackend(QemuInstance& inst, const std::string& id, bool iothread_support)
+        : m_inst(inst)
+        , m_id(id)
+        , m_has_iothread(false)
+        , p_format("format", "raw", "Format of the image (raw, qcow2...)")
+        , p_overlay("overlay", "",
+                    "Where the writes go: to the image if empty, to a temporary overlay if \"snapshot\", else to "
+                    "this qcow2 overlay file, created at each run")
+        , p_aio("aio", "threads", "AIO backend: threads, native (needs cache none or directsync) or io_uring")
+        , p_cache("cache", "writeback", "Cache mode: writeback, none, writethrough, directsync or unsafe")
+    {
+        if (iothread_support) {
+            p_iothread = std::make_unique<cci::cci_param<bool>>(
+                "iothread", false, "Process the requests in a dedicated QEMU I/O thread");
+        }
+    }
+
+    /* The virtual size of a raw or qcow2 image */
+    static uint64_t image_size(const std::string& file, const std::string& format)
+    {
+        struct stat st;
+        if (stat(file.c_str(), &st) != 0) {
+            SCP_FATAL("QemuBlockBackend") << "Unable to open the image " << file << ": " << strerror(errno);
+        }
+        if (format == "raw") {
+            return st.st_size;
+        }
+
+        uint8_t hdr[32] = {};
+        std::ifstream f(file, std::ios::binary);
+        if (format != "qcow2" || !f.read(reinterpret_cast<char*>(hdr), sizeof(hdr)) || be(hdr, 4) != 0x514649fb) {
+            SCP_FATAL("QemuBlockBackend") << "The base image of an overlay must be a raw or qcow2 image: " << file;
+        }
+        return be(hdr + 24, 8);
+    }
+
+    /**
+     * Write an empty qcow2 (version 3) image of the size of the base image,
+     * backed by it. The layout is the one of qemu-img create: the header and
+     * the backing file name, the refcount table, the refcount block and the
+     * L1 table, with 64KiB clusters.
+     */
+    static void create_overlay(const std::string& path, const std::string& base, const std::string& base_format)
+    {
+        const uint64_t cluster = 1 << 16;
+        const uint64_t l2_coverage = cluster * (cluster / 8);
+
+        char base_path[PATH_MAX];
+        if (!realpath(base.c_str(), base_path)) {
+            SCP_FATAL("QemuBlockBackend") << "Unable to open the image " << base << ": " << strerror(errno);
+        }
+        std::string backing(base_path);
+        /* the overlay replaces the file at its path, which must not be the shared image */
+        char overlay_path[PATH_MAX];
+        if (realpath(path.c_str(), overlay_path) && backing == overlay_path) {
+            SCP_FATAL("QemuBlockBackend") << "The overlay " << path << " is the image " << base << " itself";
+        }
+        if (backing.size() > 1023) {
+            SCP_FATAL("QemuBlockBackend") << "The path of the base image is too long: " << backing;
+        }
+
+        uint64_t size = image_size(base, base_format);
+        uint64_t l1_size = std::max<uint64_t>(1, (size + l2_coverage - 1) / l2_coverage);
+        uint64_t l1_clusters = (l1_size * 8 + cluster - 1) / cluster;
+        uint64_t nb_clusters = 3 + l1_clusters;
+        if (nb_clusters > cluster / 2) {
+            SCP_FATAL("QemuBlockBackend") << "The image " << base << " is too large for an overlay";
+        }
+
+        std::vector<uint8_t> buf(nb_clusters * cluster, 0);
+
+        /* header, then the backing format extension, the end of the extensions and the backing file name */
+        const size_t header_length = 104;
+        size_t ext_len = (base_format.size() + 7) & ~size_t(7);
+        size_t backing_off = header_length + 8 + ext_len + 8;
+
+        put_be(buf, 0, 0x514649fb, 4); /* QFI\xfb */
+        put_be(buf, 4, 3, 4);          /* version */
+        put_be(buf, 8, backing_off, 8);
+        put_be(buf, 16, backing.size(), 4);
+        put_be(buf, 20, 16, 4); /* cluster bits */
+        put_be(buf, 24, size, 8);
+        put_be(buf, 36, l1_size, 4);
+        put_be(buf, 40, 3 * cluster, 8); /* L1 table */
+        put_be(buf, 48, 1 * cluster, 8); /* refcount table */
+        put_be(buf, 56, 1, 4);           /* refcount table clusters */
+        put_be(buf, 96, 4, 4);           /* refcount order: 16 bits */
+        put_be(buf, 100, header_length, 4);
+
+        put_be(buf, header_length, 0xe2792aca, 4); /* backing file format */
+        put_be(buf, header_length + 4, base_format.size(), 4);
+        memcpy(&buf[header_length + 8], base_format.data(), base_format.size());
+        memcpy(&buf[backing_off], backing.data(), backing.size());
+
+        /* the refcount block, and the clusters it counts */
+        put_be(buf, 1 * cluster, 2 * cluster, 8);
+        for (uint64_t i = 0; i < nb_clusters; i++) {
+            put_be(buf, 2 * cluster + i * 2, 1, 2);
+        }
+
+        std::string tmp = path + ".tmp." + std::to_string(getpid());
+        {
+            std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+            if (!f.write(reinterpret_cast<const char*>(buf.data()), buf.size())) {
+                SCP_FATAL("QemuBlockBackend") << "Unable to write the overlay " << tmp;
+            }
+        }
+        if (rename(tmp.c_str(), path.c_str()) != 0) {
+            SCP_FATAL("QemuBlockBackend") << "Unable to write the overlay " << path << ": " << strerror(errno);
+        }
+    }
+
+    /**
+     * Add the drive of the image file (and its I/O thread) to the QEMU
+     * arguments. iface is the -drive "if" option.
+     */
+    void add_drive(const std::string& file, const std::string& iface = "none")
+    {
+        std::string format = p_format;
+        std::string overlay = p_overlay;
+        std::string aio = p_aio;
+        std::string cache = p_cache;
+
+        if (aio != "threads" && aio != "native" && aio != "io_uring") {
+            SCP_FATAL(()) << "Unknown aio backend " << aio;
+        }
+        if (cache != "writeback" && cache != "none" && cache != "writethrough" && cache != "directsync" &&
+            cache != "unsafe") {
+            SCP_FATAL(()) << "Unknown cache mode " << cache;
+        }
+        /* QEMU would refuse it */
+        if (aio == "native" && cache != "none" && cache != "directsync") {
+            SCP_FATAL(()) << "aio native bypasses the host page cache, it needs cache none or directsync";
+        }
+
+        std::stringstream opts;
+        opts << "if=" << iface << ",id=" << m_id;
+        if (overlay.empty()) {
+            opts << ",file=" << file << ",format=" << format;
+        } else if (overlay == "snapshot") {
+            opts << ",file=" << file << ",format=" << format << ",snapshot=on";
+        } else {
+            SCP_INFO(()) << "Creating the overlay " << overlay << " of " << file;
+            create_overlay(overlay, file, format);
+            opts << ",file=" << overlay << ",format=qcow2";
+        }
+        opts << ",aio=" << aio << ",cache=" << cache;
+
+        if (p_iothread && *p_iothread) {
+            m_has_iothread = true;
+            m_inst.add_arg("-object");
+            m_inst.add_arg(("iothread,id=" + iothread_id()).c_str());
+        }
+        m_inst.add_arg("-drive");
+        m_inst.add_arg(opts.str().c_str());
+    }
+
+    /*
+     * For the devices which can also be given their drive options directly:
+     * fail if some of the parameters, which would be ignored, are set.
+     */
+    void check_unused(const std::string& instead)
+    {
+        std::vector<std::string> set;
+        if (!p_format.is_default_value()) set.push_back("format");
+        if (!p_overlay.is_default_value()) set.push_back("overlay");
+        if (!p_aio.is_default_value()) set.push_back("aio");
+        if (!p_cache.is_default_value()) set.push_back("cache");
+        if (p_iothread && !p_iothread->is_default_value()) set.push_back("iothread");
+        if (!set.empty()) {
+            std::string names;
+            for (auto& n : set) {
+                names += (names.empty() ? "" : ", ") + n;
+            }
+            SCP_FATAL(()) << names << " can't be used with " << instead << ", which gives all the drive options";
+        }
+    }
+
+    /* Connect the device to its drive, before it is realized */
+    void set_device_props(qemu::Device& dev)
+    {
+        dev.set_prop_parse("drive", m_id.c_str());
+        if (m_has_iothread) {
+            dev.set_prop_parse("iothread", iothread_id().c_str());
+        }
+    }
+
+    const std::string& id() const { return m_id; }
+
+    std::string iothread_id() const { return m_id + "-iothread"; }
+};
+
+#endif
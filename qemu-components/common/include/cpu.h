@@ -9,9 +9,14 @@
 #ifndef _LIBQBOX_COMPONENTS_CPU_CPU_H
 #define _LIBQBOX_COMPONENTS_CPU_CPU_H
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <sstream>
 #include <mutex>
 #include <condition_variable>
+#include <vector>
 
 #include <tlm>
 #include <tlm_utils/simple_initiator_socket.h>
@@ -24,6 +29,7 @@
 #include "ports/initiator.h"
 #include "tlm-extensions/qemu-cpu-hint.h"
 #include "ports/qemu-target-signal-socket.h"
+#include "perf/counters.h"
 
 class QemuCpu : public QemuDevice, public QemuInitiatorIface
 {
@@ -62,6 +68,39 @@ protected:
 
     uint64_t m_quantum_ns; // For convenience
 
+    QemuVcpuProfile* m_profile = nullptr; // when the instance profiles its vCPUs
+
+    /* In deterministic MULTI mode, see QemuDeterministicScheduler */
+    QemuDeterministicScheduler* m_det = nullptr;
+    int m_det_index = -1;
+    uint64_t m_det_boundary_ns = 0; /* end of the current quantum */
+    bool m_det_started = false;
+    int m_det_io_depth = 0;
+
+    /*
+     * Why the CPU left its execution loop. Set by whoever kicks the CPU, the
+     * first reason wins until the CPU comes back to end_of_loop_cb.
+     */
+    enum ExitReason { EXIT_NONE, EXIT_IO, EXIT_QUANTUM, EXIT_INTERRUPT, EXIT_OTHER, EXIT_NB };
+    std::atomic<int> m_exit_reason{ EXIT_NONE };
+    std::atomic<uint64_t> m_exits[EXIT_NB] = {};
+    std::atomic<uint64_t> m_halts{ 0 };
+    std::chrono::steady_clock::time_point m_host_start;
+    std::vector<std::unique_ptr<gs::perf::probe>> m_stat_probes;
+
+    void set_exit_reason(ExitReason r)
+    {
+        int none = EXIT_NONE;
+        m_exit_reason.compare_exchange_strong(none, r, std::memory_order_relaxed);
+    }
+
+    void count_exit()
+    {
+        int r = m_exit_reason.exchange(EXIT_NONE, std::memory_order_relaxed);
+        /* nobody kicked us: halt, exception, exclusive work... */
+        m_exits[r == EXIT_NONE ? EXIT_OTHER : r].fetch_add(1, std::memory_order_relaxed);
+    }
+
     /*
      * Request quantum keeper from instance
      */
@@ -141,6 +180,7 @@ protected:
     void kick_cb()
     {
         SCP_TRACE(())("QEMU deadline KICK callback");
+        set_exit_reason(EXIT_INTERRUPT);
         if (m_coroutines) {
             if (!m_finished) m_qemu_kick_ev.async_notify();
         } else {
@@ -158,6 +198,7 @@ protected:
     {
         SCP_TRACE(())("QEMU deadline timer callback");
         // All syncing will be done in end_of_loop_cb
+        set_exit_reason(EXIT_QUANTUM);
         m_cpu.kick();
         // Rearm timer for next time ....
         if (!m_finished) {
@@ -183,9 +224,11 @@ protected:
      */
     void wait_for_work()
     {
+        QemuVcpuProfile::Scope prof(m_profile, QemuVcpuProfile::IDLE);
         SCP_TRACE(())("Wait for work");
         m_qk->stop();
         if (m_finished) return;
+        m_halts.fetch_add(1, std::memory_order_relaxed);
 
         if (m_coroutines) {
             m_on_sysc.run_on_sysc([this]() { wait(m_external_ev); });
@@ -292,9 +335,108 @@ protected:
             m_qk->set(sc_core::sc_time(now, sc_core::SC_NS) - sc_t);
         }
         // Important to allow QK to notify itself if it's waiting.
+        QemuVcpuProfile::Scope prof(m_profile, QemuVcpuProfile::SYNC);
         m_qk->sync();
     }
 
+    /*
+     * ---- Deterministic MULTI mode ----
+     */
+
+    /* Move the QK to ns, SystemC then runs all of time ns before the vCPU goes on */
+    void det_set_qk(uint64_t ns)
+    {
+        sc_core::sc_time t = sc_core::sc_time(ns, sc_core::SC_NS) + sc_core::sc_get_time_resolution();
+        sc_core::sc_time sc_t = sc_core::sc_time_stamp();
+        m_qk->set(t > sc_t ? t - sc_t : sc_core::SC_ZERO_TIME);
+    }
+
+    /* Give the vCPU the instructions of the rest of the quantum, from ns */
+    void det_depart(uint64_t ns)
+    {
+        uint64_t insns = m_cpu.get_stats().insns;
+        uint64_t left = m_det_boundary_ns > ns ? m_det->ns_to_insns(m_det_boundary_ns - ns) : 0;
+        m_det->depart(m_det_index, ns, insns);
+        m_cpu.set_insn_budget(insns + std::max<uint64_t>(1, left));
+    }
+
+    /* From the vCPU thread, when the budget of the quantum is spent */
+    void det_budget_expired()
+    {
+        set_exit_reason(EXIT_QUANTUM);
+        m_cpu.kick();
+    }
+
+    /*
+     * From SystemC, when the parked vCPUs resume at ns. The first time, the
+     * vCPU is released from its soft stop, it is waiting in end_of_loop_cb
+     * afterwards.
+     */
+    void det_resume(uint64_t ns)
+    {
+        m_qk->start();
+        det_set_qk(ns);
+        if (!m_det_started) {
+            m_det_started = true;
+            m_det_boundary_ns = (ns / m_quantum_ns + 1) * m_quantum_ns;
+            det_depart(ns);
+            m_cpu.set_soft_stopped(false);
+            m_cpu.kick();
+        }
+    }
+
+    /*
+     * End of loop in deterministic mode. The vCPU goes back to the guest
+     * until the end of its quantum (unless it has no work). It then waits at
+     * the boundary for SystemC and the other vCPUs, and for the quanta to
+     * come if it has no work.
+     */
+    void det_end_of_loop()
+    {
+        uint64_t now = m_det->time(m_det_index);
+        if (now < m_det_boundary_ns && m_cpu.can_run()) {
+            return;
+        }
+
+        m_cpu.set_soft_stopped(true);
+        m_inst.get().unlock_iothread();
+        if (!m_cpu.can_run()) {
+            m_halts.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        m_det->arrive(m_det_index);
+        for (;;) {
+            {
+                QemuVcpuProfile::Scope prof(m_profile, QemuVcpuProfile::SYNC);
+                det_set_qk(m_det_boundary_ns);
+                m_qk->sync();
+            }
+            auto turn = m_det->barrier(m_det_index, sc_core::sc_time(m_det_boundary_ns, sc_core::SC_NS));
+            now = std::max(now, m_det_boundary_ns);
+            m_det_boundary_ns += m_quantum_ns;
+            if (m_finished || turn == QemuDeterministicScheduler::RUN) {
+                break;
+            }
+            if (turn == QemuDeterministicScheduler::PARK) {
+                QemuVcpuProfile::Scope prof(m_profile, QemuVcpuProfile::IDLE);
+                bool run = m_det->wait_resume(m_det_index, now, [this]() { m_qk->stop(); });
+                m_det_boundary_ns = (now / m_quantum_ns + 1) * m_quantum_ns;
+                if (m_finished || run) {
+                    break;
+                }
+            }
+        }
+
+        if (!m_finished) {
+            m_det->start_quantum(now);
+            det_depart(now);
+        }
+        m_inst.get().lock_iothread();
+        if (!m_finished) {
+            m_cpu.set_soft_stopped(false);
+        }
+    }
+
     /*
      * Callback called when the CPU exits its execution loop. In coroutine
      * mode, we yield here to come back to run_cpu_loop(). In TCG thread mode,
@@ -304,12 +446,23 @@ protected:
     {
         SCP_TRACE(())("End of loop");
         if (m_finished) return;
+        count_exit();
         if (m_coroutines) {
             m_inst.get().coroutine_yield();
         } else {
             std::lock_guard<std::mutex> lock(m_can_delete);
-            sync_with_kernel();
-            prepare_run_cpu();
+            if (m_profile) {
+                /* in SINGLE mode, the thread runs the CPUs in turn */
+                QemuVcpuProfile::current() = m_profile;
+                m_profile->enter(QemuVcpuProfile::OTHER);
+            }
+            if (m_det) {
+                det_end_of_loop();
+            } else {
+                sync_with_kernel();
+                prepare_run_cpu();
+            }
+            if (m_profile) m_profile->enter(QemuVcpuProfile::TCG);
         }
     }
 
@@ -322,12 +475,27 @@ protected:
 
         for (; !m_finished;) {
             prepare_run_cpu();
+            if (m_profile) {
+                QemuVcpuProfile::current() = m_profile;
+                m_profile->enter(QemuVcpuProfile::TCG);
+            }
             run_cpu_loop();
+            if (m_profile) m_profile->enter(QemuVcpuProfile::OTHER);
             sync_with_kernel();
         }
     }
 
 public:
+    /* Execution statistics of the CPU, see get_stats */
+    struct Stats : public qemu::CpuStats {
+        uint64_t exits_io = 0;        /* kicked to sync after an I/O access */
+        uint64_t exits_quantum = 0;   /* kicked at the end of the quantum */
+        uint64_t exits_interrupt = 0; /* kicked by QEMU, e.g. to take an interrupt */
+        uint64_t exits_other = 0;     /* left the loop on its own (halt, exception...) */
+        uint64_t halts = 0;           /* waits for work */
+        uint64_t tlb_flushes = 0;     /* DMI regions mapped or unmapped */
+    };
+
     cci::cci_param<unsigned int> p_gdb_port;
 
     /* The default memory socket. Mapped to the default CPU address space in QEMU */
@@ -357,6 +525,7 @@ public:
 
         create_quantum_keeper();
         set_coroutine_mode();
+        m_det = m_inst.get_deterministic_scheduler();
 
         if (!m_coroutines) {
             SC_THREAD(watch_external_ev);
@@ -379,6 +548,15 @@ public:
         if (m_finished) return;
         m_finished = true; // assert before taking lock (for co-routines too)
 
+        if (m_det) {
+            /* Release the vCPUs waiting at a boundary */
+            m_det->stop();
+        }
+
+        if (m_started && m_inst.get().cpu_stats_enabled()) {
+            log_stats();
+        }
+
         if (!m_cpu.valid()) {
             /* CPU hasn't been created yet */
             return;
@@ -451,6 +629,17 @@ public:
     void halt_cb(const bool& val)
     {
         SCP_TRACE(())("Halt : {}", val);
+        if (m_det) {
+            /* applied at the next quantum boundary */
+            if (!m_finished) {
+                m_det->post([this, val]() {
+                    m_inst.get().lock_iothread();
+                    m_cpu.halt(val);
+                    m_inst.get().unlock_iothread();
+                });
+            }
+            return;
+        }
         if (!m_finished) {
             if (val) {
                 m_deadline_timer->del();
@@ -468,6 +657,19 @@ public:
     void reset_cb(const bool& val)
     {
         SCP_TRACE(())("Reset : {}", val);
+        if (m_det) {
+            /* applied at the next quantum boundary */
+            if (!m_finished && val) {
+                SCP_WARN(())("calling reset");
+                m_det->post([this]() {
+                    m_inst.get().lock_iothread();
+                    m_cpu.reset();
+                    socket.reset();
+                    m_inst.get().unlock_iothread();
+                });
+            }
+            return;
+        }
         if (!m_finished && val) {
             m_qk->start();
             SCP_WARN(())("calling reset");
@@ -483,6 +685,13 @@ public:
     {
         QemuDevice::end_of_elaboration();
 
+        if (m_det) {
+            m_det_index = m_cpu.get_index();
+            m_det->add_vcpu(m_det_index, { [this]() { return m_cpu.can_run(); },
+                                           std::bind(&QemuCpu::det_budget_expired, this),
+                                           std::bind(&QemuCpu::det_resume, this, std::placeholders::_1) });
+        }
+
         if (!p_gdb_port.is_default_value()) {
             std::stringstream ss;
             SCP_INFO(()) << "Starting gdb server on TCP port " << p_gdb_port;
@@ -493,7 +702,21 @@ public:
 
     virtual void start_of_simulation() override
     {
-        m_quantum_ns = int64_t(tlm_utils::tlm_quantumkeeper::get_global_quantum().to_seconds() * 1e9);
+        /* the quantum of the domain of the instance */
+        m_quantum_ns = int64_t(m_qk->get_quantum().to_seconds() * 1e9);
+        if (m_det && m_quantum_ns == 0) {
+            SCP_FATAL(()) << "The deterministic mode needs a quantum of at least 1ns";
+        }
+
+        if (m_inst.get_vcpu_profiler()) {
+            /* Outside of coroutine mode, the CPU thread is released running */
+            m_profile = m_inst.get_vcpu_profiler()->new_profile(
+                name(), m_coroutines ? QemuVcpuProfile::OTHER : QemuVcpuProfile::TCG);
+        }
+
+        if (m_inst.eager_dmi()) {
+            socket.map_dmi_eagerly();
+        }
 
         QemuDevice::start_of_simulation();
         if (m_inst.get_tcg_mode() == QemuInstance::TCG_SINGLE) {
@@ -501,7 +724,9 @@ public:
                 m_qk->start();
             }
         }
-        if (!m_coroutines) {
+        if (m_det) {
+            /* Released by the scheduler, with its first budget (see det_resume) */
+        } else if (!m_coroutines) {
             /* Prepare the CPU for its first run and release it */
             m_cpu.set_soft_stopped(false);
             rearm_deadline_timer();
@@ -514,9 +739,66 @@ public:
         // registers to KVM just before running it.
         m_cpu.set_vcpu_dirty(true);
 
+        register_stat_probes();
+        m_host_start = std::chrono::steady_clock::now();
         m_started = true;
     }
 
+    /*
+     * The instructions and translation blocks are only counted when the
+     * instance has cpu_stats set, the other counters are always maintained.
+     * Can be called from any thread.
+     */
+    Stats get_stats() const
+    {
+        Stats s;
+        if (m_cpu.valid()) {
+            static_cast<qemu::CpuStats&>(s) = m_cpu.get_stats();
+        }
+        s.exits_io = m_exits[EXIT_IO].load(std::memory_order_relaxed);
+        s.exits_quantum = m_exits[EXIT_QUANTUM].load(std::memory_order_relaxed);
+        s.exits_interrupt = m_exits[EXIT_INTERRUPT].load(std::memory_order_relaxed);
+        s.exits_other = m_exits[EXIT_OTHER].load(std::memory_order_relaxed);
+        s.halts = m_halts.load(std::memory_order_relaxed);
+        s.tlb_flushes = socket.get_tlb_flushes();
+        return s;
+    }
+
+private:
+    /* Make the statistics part of the perf_stats dumps */
+    void register_stat_probes()
+    {
+        auto add = [this](const char* n, uint64_t Stats::*field) {
+            m_stat_probes.emplace_back(new gs::perf::probe(this, n, [this, field]() { return get_stats().*field; }));
+        };
+
+        if (m_inst.get().cpu_stats_enabled()) {
+            add("insns", &Stats::insns);
+            add("tbs_executed", &Stats::tbs_executed);
+            add("tbs_translated", &Stats::tbs_translated);
+        }
+        add("exits_io", &Stats::exits_io);
+        add("exits_quantum", &Stats::exits_quantum);
+        add("exits_interrupt", &Stats::exits_interrupt);
+        add("exits_other", &Stats::exits_other);
+        add("halts", &Stats::halts);
+        add("tlb_flushes", &Stats::tlb_flushes);
+    }
+
+    void log_stats()
+    {
+        Stats s = get_stats();
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_host_start).count();
+
+        SCP_INFO(()) << s.insns << " instructions (" << (secs > 0 ? s.insns / secs / 1e6 : 0) << " MIPS), "
+                     << s.tbs_executed << " TBs executed, " << s.tbs_translated << " TBs translated, exits: "
+                     << s.exits_io << " I/O, " << s.exits_quantum << " quantum, " << s.exits_interrupt
+                     << " interrupt, " << s.exits_other << " other, " << s.halts << " halts, " << s.tlb_flushes
+                     << " TLB flushes";
+    }
+
+public:
+
     /* QemuInitiatorIface  */
     virtual void initiator_customize_tlm_payload(TlmPayload& payload) override
     {
@@ -537,6 +819,13 @@ public:
 
         int64_t vclock_now;
 
+        if (m_det) {
+            /* The time of the vCPU, SystemC staying at the start of the quantum */
+            sc_time t(m_det->time(m_det_index), SC_NS);
+            sc_time sc_t = sc_core::sc_time_stamp();
+            return t > sc_t ? t - sc_t : sc_core::SC_ZERO_TIME;
+        }
+
         vclock_now = m_inst.get().get_virtual_clock();
         sc_core::sc_time sc_t = sc_core::sc_time_stamp();
         if (sc_time(vclock_now, SC_NS) > sc_t) {
@@ -553,6 +842,11 @@ public:
      */
     virtual void initiator_set_local_time(const sc_core::sc_time& t) override
     {
+        if (m_det) {
+            /* The vCPU runs to the end of its quantum, whatever the delay of the access */
+            return;
+        }
+
         m_qk->set(t);
 
         if (m_qk->need_sync()) {
@@ -560,10 +854,33 @@ public:
              * Kick the CPU out of its execution loop so that we can sync with
              * the kernel.
              */
+            set_exit_reason(EXIT_IO);
             m_cpu.kick();
         }
     }
 
+    /*
+     * In deterministic mode, the I/O accesses are handed over to SystemC in
+     * the order of (time, CPU index). Called with the iothread lock held.
+     */
+    virtual void initiator_io_begin() override
+    {
+        if (!m_det || m_det_io_depth++) {
+            return;
+        }
+        QemuVcpuProfile::Scope prof(m_profile, QemuVcpuProfile::IO_LOCK);
+        m_inst.get().unlock_iothread();
+        m_det->io_enter(m_det_index, m_det->time(m_det_index));
+        m_inst.get().lock_iothread();
+    }
+
+    virtual void initiator_io_end() override
+    {
+        if (m_det && --m_det_io_depth == 0) {
+            m_det->io_leave(m_det_index);
+        }
+    }
+
     /* expose async run interface for DMI invalidation */
     virtual void initiator_async_run(qemu::Cpu::AsyncJobFn job) override
     {
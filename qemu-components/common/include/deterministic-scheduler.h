@@ -0,0 +1,408 @@
+/*
+ * This file is part of libqbox
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBQBOX_DETERMINISTIC_SCHEDULER_H_
+#define LIBQBOX_DETERMINISTIC_SCHEDULER_H_
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#ifndef SC_INCLUDE_DYNAMIC_PROCESSES
+#define SC_INCLUDE_DYNAMIC_PROCESSES
+#endif
+#include <systemc>
+
+#include <scp/report.h>
+
+#include <libqemu-cxx/libqemu-cxx.h>
+
+/**
+ * @class QemuDeterministicScheduler
+ *
+ * @brief Runs the vCPUs of a MULTI instance in lockstep quanta, for the runs
+ * to be reproducible
+ *
+ * @details The time of a vCPU is given by its instruction count (counted by
+ * the cpu-stats plugin, see LibQemu::enable_cpu_stats), one instruction
+ * taking 2^insn_shift ns. Each vCPU is given the instruction budget of a
+ * quantum, then all the vCPUs meet at the quantum boundary, where SystemC has
+ * run up to the boundary (see QemuCpu and the multithread-lockstep sync
+ * policy).
+ *
+ * The changes coming from SystemC (input GPIOs, halt and reset of the CPUs)
+ * are posted to the scheduler and applied at the next boundary, by the last
+ * vCPU reaching it while the others wait. The I/O accesses handed over to
+ * SystemC go through a turnstile, in the order of (time, CPU index): an
+ * access waits for the other vCPUs to be past its time, or at the boundary.
+ *
+ * When no vCPU has work at a boundary, the vCPUs park and SystemC runs
+ * freely, until something posted from SystemC gives work to one of them. The
+ * vCPUs then resume at the time of the change.
+ *
+ * If the cpu-stats plugin controls the virtual clock of QEMU (see
+ * LibQemu::enable_virtual_clock_control), the clock is moved to the start of
+ * each quantum, so that the architectural timers follow the instruction
+ * count rather than the host time.
+ */
+class QemuDeterministicScheduler
+{
+public:
+    /* Callbacks of a vCPU */
+    struct Vcpu {
+        std::function<bool()> can_run;                /* has work, called with the vCPUs stopped */
+        std::function<void()> budget_expired;         /* from the vCPU thread, in the TB */
+        std::function<void(uint64_t ns)> resume_sysc; /* restart after parking, from SystemC */
+    };
+
+    /* What a vCPU does after a boundary */
+    enum Turn {
+        RUN,  /* run the next quantum */
+        SKIP, /* no work, wait for the next boundary */
+        PARK, /* no vCPU has work, wait for wait_resume */
+    };
+
+private:
+    enum State { AT_BARRIER, RUNNING, IN_IO };
+
+    struct Slot {
+        int index = -1;
+        Vcpu vcpu;
+        State state = AT_BARRIER;
+        uint64_t base_ns = 0;
+        uint64_t base_insns = 0;
+        uint64_t io_ns = 0;
+        bool runnable = false;
+        uint64_t resume_gen = 0;
+    };
+
+    struct Action {
+        sc_core::sc_time stamp;
+        std::function<void()> fn;
+    };
+
+    qemu::LibQemu& m_inst;
+    unsigned int m_shift;
+    std::chrono::milliseconds m_io_timeout;
+    bool m_io_give_up;
+    std::map<int, Slot> m_slots;
+
+    std::mutex m_lock;
+    std::condition_variable m_cond;
+    std::deque<Action> m_actions;
+    size_t m_arrived = 0;
+    uint64_t m_generation = 0;
+    bool m_parked = true; /* until the first vCPU has work */
+    uint64_t m_resume_gen = 0;
+    uint64_t m_resume_ns = 0;
+    bool m_stopped = false;
+    uint64_t m_io_gave_up = 0;
+    uint64_t m_clock_ns = 0;
+
+    sc_core::sc_event m_wake_ev;
+
+    uint64_t live_time(const Slot& s) const
+    {
+        return s.base_ns + ((m_inst.get_cpu_stats(s.index).insns - s.base_insns) << m_shift);
+    }
+
+    /* Where a vCPU is in the (time, index) order of the I/O accesses */
+    uint64_t position(const Slot& s) const
+    {
+        switch (s.state) {
+        case AT_BARRIER:
+            return std::numeric_limits<uint64_t>::max();
+        case IN_IO:
+            return s.io_ns;
+        default:
+            return live_time(s);
+        }
+    }
+
+    std::vector<std::function<void()>> take_actions(const sc_core::sc_time& until)
+    {
+        std::vector<std::function<void()>> fns;
+        while (!m_actions.empty() && m_actions.front().stamp <= until) {
+            fns.push_back(std::move(m_actions.front().fn));
+            m_actions.pop_front();
+        }
+        return fns;
+    }
+
+    /* Ask every vCPU whether it has work, with the lock released */
+    bool snapshot_runnable(std::unique_lock<std::mutex>& lock)
+    {
+        std::vector<std::pair<Slot*, bool>> runnable;
+        for (auto& it : m_slots) {
+            runnable.emplace_back(&it.second, it.second.vcpu.can_run());
+        }
+        lock.lock();
+        bool any = false;
+        for (auto& r : runnable) {
+            r.first->runnable = r.second;
+            any |= r.second;
+        }
+        return any;
+    }
+
+    /*
+     * SystemC process, a resolution after something was posted (or the start
+     * of the simulation). Resume the parked vCPUs if one has work.
+     */
+    void wake()
+    {
+        sc_core::sc_time t = sc_core::sc_time_stamp() - sc_core::sc_get_time_resolution();
+
+        std::unique_lock<std::mutex> lock(m_lock);
+        if (!m_parked || m_stopped) {
+            return;
+        }
+        auto fns = take_actions(t);
+        lock.unlock();
+        for (auto& fn : fns) fn();
+        if (!snapshot_runnable(lock)) {
+            return;
+        }
+
+        m_parked = false;
+        m_resume_ns = to_ns(t);
+        lock.unlock();
+
+        SCP_DEBUG("Deterministic.Libqbox") << "Resuming the vCPUs at " << m_resume_ns << "ns";
+        for (auto& it : m_slots) {
+            it.second.vcpu.resume_sysc(m_resume_ns);
+        }
+
+        /* only let them go once SystemC is held back again */
+        lock.lock();
+        m_resume_gen++;
+        m_cond.notify_all();
+    }
+
+public:
+    /*
+     * An I/O access waits at most io_timeout_ms for its turn (see io_enter),
+     * it then goes on if io_give_up, else the simulation stops.
+     */
+    QemuDeterministicScheduler(qemu::LibQemu& inst, unsigned int insn_shift, unsigned int io_timeout_ms,
+                               bool io_give_up)
+        : m_inst(inst), m_shift(insn_shift), m_io_timeout(io_timeout_ms), m_io_give_up(io_give_up)
+    {
+        m_inst.set_cpu_budget_callback([this](int cpu_index) {
+            auto it = m_slots.find(cpu_index);
+            if (it != m_slots.end()) {
+                it->second.vcpu.budget_expired();
+            }
+        });
+
+        sc_core::sc_spawn_options opt;
+        opt.spawn_method();
+        opt.set_sensitivity(&m_wake_ev);
+        opt.dont_initialize();
+        sc_core::sc_spawn(std::bind(&QemuDeterministicScheduler::wake, this), "deterministic_wake", &opt);
+    }
+
+    QemuDeterministicScheduler(const QemuDeterministicScheduler&) = delete;
+
+    /* Ceiling of a SystemC time in ns */
+    static uint64_t to_ns(const sc_core::sc_time& t)
+    {
+        uint64_t per_ns = std::max<uint64_t>(1, sc_core::sc_time(1, sc_core::SC_NS).value());
+        return (t.value() + per_ns - 1) / per_ns;
+    }
+
+    /* Instructions to run for ns to elapse, rounded up */
+    uint64_t ns_to_insns(uint64_t ns) const { return (ns + (uint64_t(1) << m_shift) - 1) >> m_shift; }
+
+    /* Must be called before the start of the simulation */
+    void add_vcpu(int cpu_index, const Vcpu& vcpu)
+    {
+        Slot& s = m_slots[cpu_index];
+        s.index = cpu_index;
+        s.vcpu = vcpu;
+    }
+
+    /* Time of a vCPU in ns, from its thread */
+    uint64_t time(int cpu_index)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return live_time(m_slots.at(cpu_index));
+    }
+
+    /* Apply fn at the next boundary, from SystemC */
+    void post(std::function<void()> fn)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            if (m_stopped) {
+                return;
+            }
+            m_actions.push_back({ sc_core::sc_time_stamp(), std::move(fn) });
+        }
+        m_wake_ev.notify(sc_core::sc_get_time_resolution());
+    }
+
+    /* At the start of the simulation, the vCPUs are parked */
+    void start() { m_wake_ev.notify(sc_core::sc_get_time_resolution()); }
+
+    /* The vCPU won't run before the next boundary */
+    void arrive(int cpu_index)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_slots.at(cpu_index).state = AT_BARRIER;
+        m_cond.notify_all();
+    }
+
+    /*
+     * Wait for all the vCPUs to reach the boundary, SystemC being past it.
+     * The last one applies what was posted up to the boundary and decides
+     * which vCPUs have work.
+     */
+    Turn barrier(int cpu_index, const sc_core::sc_time& boundary)
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        Slot& s = m_slots.at(cpu_index);
+        uint64_t gen = m_generation;
+
+        if (++m_arrived == m_slots.size()) {
+            auto fns = take_actions(boundary);
+            lock.unlock();
+            for (auto& fn : fns) fn();
+            bool any = snapshot_runnable(lock);
+            m_parked = !any;
+            m_arrived = 0;
+            m_generation++;
+            m_cond.notify_all();
+        } else {
+            m_cond.wait(lock, [&] { return m_generation != gen || m_stopped; });
+        }
+
+        s.resume_gen = m_resume_gen;
+        if (s.runnable && !m_stopped) return RUN;
+        return m_parked ? PARK : SKIP;
+    }
+
+    /*
+     * Wait for wake to resume the vCPUs, returns whether this one has work.
+     * park is called first (to let SystemC run freely), unless wake is
+     * already resuming the vCPUs.
+     */
+    bool wait_resume(int cpu_index, uint64_t& ns, std::function<void()> park)
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        Slot& s = m_slots.at(cpu_index);
+        if (m_parked) {
+            park();
+        }
+        m_cond.wait(lock, [&] { return m_resume_gen != s.resume_gen || m_stopped; });
+        ns = m_resume_ns;
+        return s.runnable && !m_stopped;
+    }
+
+    /* The vCPU runs from ns, having executed insns instructions */
+    void depart(int cpu_index, uint64_t ns, uint64_t insns)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        Slot& s = m_slots.at(cpu_index);
+        s.state = RUNNING;
+        s.base_ns = ns;
+        s.base_insns = insns;
+    }
+
+    /*
+     * Move the virtual clock to the start of the quantum at ns, from a vCPU
+     * thread (QEMU runs the timers due on it). The first vCPU leaving a
+     * boundary moves it.
+     */
+    void start_quantum(uint64_t ns)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (ns > m_clock_ns) {
+            m_clock_ns = ns;
+            m_inst.set_virtual_clock(ns);
+        }
+    }
+
+    /*
+     * Wait for the turn of an I/O access of the vCPU at ns. The running vCPUs
+     * don't tell when their time moves, their position is polled. A vCPU
+     * blocked in QEMU waiting for this one (e.g. for exclusive work) would
+     * never move: after the I/O timeout, the simulation stops, unless giving
+     * up was allowed. The access then goes on, which breaks the
+     * reproducibility of the run: the first time is reported, and the count
+     * when stopping.
+     */
+    void io_enter(int cpu_index, uint64_t ns)
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        Slot& s = m_slots.at(cpu_index);
+        s.state = IN_IO;
+        s.io_ns = ns;
+
+        auto my_turn = [&]() {
+            for (auto& it : m_slots) {
+                if (it.first == cpu_index) continue;
+                uint64_t pos = position(it.second);
+                if (pos < ns || (pos == ns && it.first < cpu_index)) return false;
+            }
+            return true;
+        };
+
+        auto deadline = std::chrono::steady_clock::now() + m_io_timeout;
+        while (!my_turn() && !m_stopped) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                std::ostringstream others;
+                for (auto& it : m_slots) {
+                    if (it.first != cpu_index) others << " " << it.first << "@" << position(it.second) << "ns";
+                }
+                if (!m_io_give_up) {
+                    SCP_FATAL("Deterministic.Libqbox")
+                        << "vCPU " << cpu_index << " waited " << m_io_timeout.count() << "ms for its I/O turn at "
+                        << ns << "ns (other vCPUs:" << others.str() << "), a vCPU is likely blocked in QEMU";
+                }
+                if (m_io_gave_up++ == 0) {
+                    SCP_WARN("Deterministic.Libqbox") << "vCPU " << cpu_index << " gave up waiting for its I/O turn at "
+                                                      << ns << "ns (other vCPUs:" << others.str()
+                                                      << "), the run is not reproducible";
+                }
+                break;
+            }
+            m_cond.wait_for(lock, std::chrono::microseconds(20));
+        }
+    }
+
+    void io_leave(int cpu_index)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_slots.at(cpu_index).state = RUNNING;
+        m_cond.notify_all();
+    }
+
+    /* Release all the waiting vCPUs, at the end of the simulation */
+    void stop()
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (!m_stopped && m_io_gave_up) {
+            SCP_WARN("Deterministic.Libqbox") << m_io_gave_up << " I/O accesses didn't wait for their turn, the run "
+                                              << "is not reproducible";
+        }
+        m_stopped = true;
+        m_actions.clear();
+        m_cond.notify_all();
+    }
+};
+
+#endif
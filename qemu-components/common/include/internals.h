@@ -9,7 +9,11 @@
 #ifndef _LIBQEMU_CXX_INTERNALS_
 #define _LIBQEMU_CXX_INTERNALS_
 
+#include <cstdint>
 #include <map>
+#include <mutex>
+#include <string>
+#include <type_traits>
 
 #include <libqemu/libqemu.h>
 #include <libqemu-cxx/libqemu-cxx.h>
@@ -45,11 +49,28 @@ public:
     }
 };
 
+/*
+ * The pixman functions reading the console surfaces. libqemu is linked with
+ * pixman, they are looked up in its dependencies.
+ */
+union pixman_image;
+struct LibQemuPixman {
+    uint32_t* (*image_get_data)(union pixman_image*);
+    int (*image_get_width)(union pixman_image*);
+    int (*image_get_height)(union pixman_image*);
+    int (*image_get_stride)(union pixman_image*);
+    uint32_t (*image_get_format)(union pixman_image*); /* pixman_format_code_t */
+};
+
 class LibQemuInternals
 {
 private:
     LibQemu& m_inst;
     LibQemuExports* m_exports;
+    LibraryLoaderIface::LibraryIfacePtr m_lib;
+
+    std::once_flag m_pixman_once;
+    LibQemuPixman m_pixman{};
 
     LibQemuObjectCallback<Cpu::EndOfLoopCallbackFn> m_cpu_end_of_loop_cbs;
     LibQemuObjectCallback<Cpu::CpuKickCallbackFn> m_cpu_kick_cbs;
@@ -62,9 +83,30 @@ private:
     };
 
 public:
-    LibQemuInternals(LibQemu& inst, LibQemuExports* exports): m_inst(inst), m_exports(exports) {}
+    LibQemuInternals(LibQemu& inst, LibQemuExports* exports, LibraryLoaderIface::LibraryIfacePtr lib)
+        : m_inst(inst), m_exports(exports), m_lib(lib)
+    {
+    }
 
     const LibQemuExports& exports() const { return *m_exports; };
+
+    const LibQemuPixman& pixman()
+    {
+        std::call_once(m_pixman_once, [this]() {
+            auto get = [this](auto& fn, const char* name) {
+                fn = reinterpret_cast<typename std::remove_reference<decltype(fn)>::type>(m_lib->get_symbol(name));
+                if (fn == nullptr) {
+                    throw LibQemuException(std::string("libqemu is not linked with pixman, ") + name + " not found");
+                }
+            };
+            get(m_pixman.image_get_data, "pixman_image_get_data");
+            get(m_pixman.image_get_width, "pixman_image_get_width");
+            get(m_pixman.image_get_height, "pixman_image_get_height");
+            get(m_pixman.image_get_stride, "pixman_image_get_stride");
+            get(m_pixman.image_get_format, "pixman_image_get_format");
+        });
+        return m_pixman;
+    }
     LibQemu& get_inst() { return m_inst; }
 
     void clear_callbacks(Object obj)
@@ -0,0 +1,56 @@
+/*
+ * This file is part of libqemu-cxx
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _LIBQEMU_CXX_CPU_STATS_H
+#define _LIBQEMU_CXX_CPU_STATS_H
+
+#include <stdint.h>
+
+/*
+ * Counters shared between libqemu-cxx and the cpu-stats TCG plugin (see
+ * LibQemu::enable_cpu_stats). This header is also built as C.
+ *
+ * The plugin is loaded by QEMU in the same process, libqemu-cxx passes it the
+ * address of an array of LibQemuCpuStats (one per vCPU index) as plugin
+ * arguments: "stats=<hex address>,max_cpus=<n>[,ctrl=<hex address>]". The
+ * vCPU threads update their entry with relaxed atomic additions. Each QEMU
+ * instance installs the plugin with its own array, the installs don't share
+ * any state.
+ *
+ * A vCPU can be given an instruction budget: once its instruction count
+ * reaches the budget, the plugin clears it and calls the budget callback of
+ * the LibQemuCpuStatsCtrl from the vCPU thread (see
+ * LibQemu::set_cpu_insn_budget). The TB being entered is still executed.
+ *
+ * If libqemu-cxx sets time_control, the plugin asks QEMU for the control of
+ * the virtual clock (which the architectural timers follow), and if granted
+ * gives set_clock and its handle back: the virtual clock then only moves when
+ * set_clock is called, from a vCPU thread (see LibQemu::set_virtual_clock).
+ */
+
+#define LIBQEMU_CPU_STATS_MAX_CPUS 512
+
+typedef struct LibQemuCpuStats {
+    uint64_t insns;          /* guest instructions executed */
+    uint64_t tbs_executed;   /* translation blocks executed */
+    uint64_t tbs_translated; /* translation blocks translated */
+    uint64_t budget;         /* insns count calling the budget callback, 0 if none */
+    uint64_t pad[4];         /* one cache line per vCPU */
+} LibQemuCpuStats;
+
+typedef void (*LibQemuCpuBudgetFn)(void* opaque, unsigned int cpu_index);
+typedef void (*LibQemuSetClockFn)(const void* handle, int64_t ns);
+
+typedef struct LibQemuCpuStatsCtrl {
+    LibQemuCpuBudgetFn budget_cb;
+    void* opaque;
+    int time_control;           /* set by libqemu-cxx before the install */
+    LibQemuSetClockFn set_clock; /* set by the plugin if it controls the virtual clock */
+    const void* clock_handle;
+} LibQemuCpuStatsCtrl;
+
+#endif
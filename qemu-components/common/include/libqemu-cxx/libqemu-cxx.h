@@ -38,6 +38,8 @@ struct QemuMemoryRegionOps;
 struct QemuAddressSpace;
 struct QemuMemoryListener;
 struct QemuTimer;
+struct LibQemuCpuStats;
+struct LibQemuCpuStatsCtrl;
 typedef void* QEMUGLContext;
 struct QEMUGLParams;
 typedef void (*LibQemuGfxUpdateFn)(DisplayChangeListener*, int, int, int, int);
@@ -72,10 +74,19 @@ class DisplayOptions;
 class DisplayGLCtxOps;
 class Console;
 class SDL2Console;
+class DisplayListener;
+class ConsoleSurface;
 class Dcl;
 class DclOps;
 class RcuReadLock;
 
+/* Execution statistics of a vCPU, see LibQemu::enable_cpu_stats */
+struct CpuStats {
+    uint64_t insns = 0;          /* guest instructions executed */
+    uint64_t tbs_executed = 0;   /* translation blocks executed */
+    uint64_t tbs_translated = 0; /* translation blocks translated */
+};
+
 class LibQemu
 {
 private:
@@ -89,6 +100,12 @@ private:
 
     LibraryLoaderIface::LibraryIfacePtr m_lib;
 
+    std::unique_ptr<LibQemuCpuStats[]> m_cpu_stats;
+    std::unique_ptr<LibQemuCpuStatsCtrl> m_cpu_stats_ctrl;
+    std::function<void(int cpu_index)> m_cpu_budget_cb;
+
+    static void cpu_budget_cb(void* opaque, unsigned int cpu_index);
+
     QemuObject* object_new_unparented(const char* type_name);
     QemuObject* object_new_internal(const char* type_name);
 
@@ -111,6 +128,36 @@ public:
     void init();
     bool is_inited() const { return m_lib != nullptr; }
 
+    /*
+     * Count the instructions and translation blocks of each vCPU, with a TCG
+     * plugin (see cpu-stats.h). Must be called before init. The plugin built
+     * with libqemu-cxx is used if plugin_path is null.
+     */
+    void enable_cpu_stats(const char* plugin_path = nullptr);
+    bool cpu_stats_enabled() const { return m_cpu_stats != nullptr; }
+    CpuStats get_cpu_stats(int cpu_index) const;
+
+    /*
+     * Call cb from the vCPU thread once the vCPU has executed insns
+     * instructions in total (the count of get_cpu_stats), if the cpu stats are
+     * enabled. The budget is cleared when the callback is called, 0 clears it.
+     */
+    using CpuBudgetCallbackFn = std::function<void(int cpu_index)>;
+    void set_cpu_budget_callback(CpuBudgetCallbackFn cb) { m_cpu_budget_cb = cb; }
+    void set_cpu_insn_budget(int cpu_index, uint64_t insns);
+
+    /*
+     * Have the cpu-stats plugin take the control of the virtual clock, which
+     * then only moves with set_virtual_clock. Must be called after
+     * enable_cpu_stats and before init. virtual_clock_controlled tells
+     * whether QEMU granted it, once inited.
+     */
+    void enable_virtual_clock_control();
+    bool virtual_clock_controlled() const;
+
+    /* Move the virtual clock forward to ns, from a vCPU thread. The timers due are run. */
+    void set_virtual_clock(int64_t ns);
+
     /* QEMU GDB stub
      * @port: port the gdb server will be listening on. (ex: "tcp::1234") */
     void start_gdb_server(std::string port);
@@ -167,6 +214,8 @@ public:
     DisplayGLCtxOps display_gl_ctx_ops_new(LibQemuIsCompatibleDclFn);
     Dcl dcl_new(DisplayChangeListener* dcl);
     DclOps dcl_ops_new();
+    std::vector<DisplayListener> display_listeners_new(int num);
+    ConsoleSurface surface_new(DisplaySurface* surface);
 
     int sdl2_init() const;
     const char* sdl2_get_error() const;
@@ -508,6 +557,47 @@ public:
     void set_window_id(Console& con) const;
 };
 
+/*
+ * A display change listener, for a display which doesn't use SDL (see
+ * LibQemu::display_listeners_new).
+ */
+class DisplayListener
+{
+private:
+    SDL2Console m_holder;
+
+public:
+    DisplayListener() = default;
+    DisplayListener(const SDL2Console& holder): m_holder(holder) {}
+    DisplayListener(const DisplayListener&) = default;
+
+    void init(Console& con, void* user_data);
+    void set_dcl_ops(DclOps& dcl_ops);
+    DisplayChangeListener* get_dcl() const;
+    void register_dcl() const;
+};
+
+/*
+ * The pixels of a console, as given to the gfx_switch callback of a listener.
+ * Valid until the next gfx_switch.
+ */
+class ConsoleSurface
+{
+public:
+    DisplaySurface* m_surface;
+    std::shared_ptr<LibQemuInternals> m_int;
+
+    ConsoleSurface() = default;
+    ConsoleSurface(DisplaySurface* surface, std::shared_ptr<LibQemuInternals>& internals);
+    ConsoleSurface(const ConsoleSurface&) = default;
+
+    int get_width() const;
+    int get_height() const;
+    int get_stride() const; /* in bytes */
+    void* get_data() const;
+    uint32_t get_format() const; /* a pixman_format_code_t */
+};
+
 class Dcl
 {
 private:
@@ -634,6 +724,10 @@ public:
     bool is_in_exclusive_context() const;
 
     void set_vcpu_dirty(bool dirty) const;
+
+    /* All zeros unless the instance counts them (see LibQemu::enable_cpu_stats) */
+    CpuStats get_stats() const;
+    void set_insn_budget(uint64_t insns);
 };
 
 class Timer
@@ -9,8 +9,12 @@
 #ifndef _LIBQBOX_PORTS_INITIATOR_H
 #define _LIBQBOX_PORTS_INITIATOR_H
 
+#include <algorithm>
+#include <atomic>
 #include <functional>
 #include <limits>
+#include <utility>
+#include <vector>
 #include <cassert>
 #include <cinttypes>
 
@@ -23,9 +27,12 @@
 #include <scp/report.h>
 
 #include <qemu-instance.h>
+#include <vcpu-profiler.h>
 #include <tlm-extensions/qemu-mr-hint.h>
 #include <tlm-extensions/exclusive-access.h>
+#include <tlm-extensions/dmi_map_extension.h>
 #include <tlm_sockets_buswidth.h>
+#include <perf/counters.h>
 
 class QemuInitiatorIface
 {
@@ -37,6 +44,10 @@ public:
     virtual sc_core::sc_time initiator_get_local_time() = 0;
     virtual void initiator_set_local_time(const sc_core::sc_time&) = 0;
     virtual void initiator_async_run(qemu::Cpu::AsyncJobFn job) = 0;
+
+    /* Around the accesses handed over to SystemC, with the iothread lock held */
+    virtual void initiator_io_begin() {}
+    virtual void initiator_io_end() {}
 };
 
 /**
@@ -92,6 +103,21 @@ protected:
     std::map<DmiRegionAliasKey, DmiRegionAlias::Ptr> m_dmi_aliases;
     using AliasesIterator = std::map<DmiRegionAliasKey, DmiRegionAlias::Ptr>::iterator;
 
+    /* The windows of the memory map mapped eagerly (see map_dmi_eagerly) */
+    std::vector<std::pair<uint64_t, uint64_t>> m_dmi_map;
+
+    /* I/O accesses (i.e. not through DMI) and DMI activity */
+    gs::perf::counter m_io_reads;
+    gs::perf::counter m_io_writes;
+    gs::perf::counter m_io_bytes;
+    gs::perf::counter m_dbg_accesses;
+    gs::perf::counter m_dmi_grants;
+    gs::perf::counter m_dmi_invalidations;
+    gs::perf::histogram m_io_host_ns; /* includes the hand over to SystemC */
+
+    /* Changes to the CPU address space, each of them flushes the CPU TLB */
+    std::atomic<uint64_t> m_tlb_flushes{ 0 };
+
     void init_payload(TlmPayload& trans, tlm::tlm_command command, uint64_t addr, uint64_t* val, unsigned int size)
     {
         trans.set_command(command);
@@ -111,6 +137,7 @@ protected:
         SCP_INFO(()) << "Adding " << *alias;
         qemu::MemoryRegion alias_mr = alias->get_alias_mr();
         m_r->m_root->add_subregion(alias_mr, alias->get_start());
+        m_tlb_flushes.fetch_add(1, std::memory_order_relaxed);
         alias->set_installed();
     }
 
@@ -121,6 +148,7 @@ protected:
         }
         SCP_INFO(()) << "Removing " << *alias;
         m_r->m_root->del_subregion(alias->get_alias_mr());
+        m_tlb_flushes.fetch_add(1, std::memory_order_relaxed);
     }
 
     /**
@@ -252,10 +280,35 @@ protected:
 
         m_dmi_aliases[start] = alias;
         add_dmi_mr_alias(m_dmi_aliases[start]);
+        m_dmi_grants.add();
 
         return dmi_data;
     }
 
+    /*
+     * Map the DMI regions of [start, end], one after the other, until a
+     * target doesn't grant DMI. Called with the iothread locked.
+     */
+    void map_dmi_window(uint64_t start, uint64_t end)
+    {
+        TlmPayload trans;
+        uint64_t temp;
+        uint64_t addr = start;
+        init_payload(trans, tlm::TLM_IGNORE_COMMAND, addr, &temp, 0);
+
+        for (;;) {
+            trans.set_address(addr);
+            trans.set_dmi_allowed(true);
+            tlm::tlm_dmi dmi_data = check_dmi_hint_locked(trans);
+            if (!dmi_data.get_dmi_ptr() || dmi_data.get_end_address() < addr || dmi_data.get_end_address() >= end) {
+                break;
+            }
+            addr = dmi_data.get_end_address() + 1;
+        }
+
+        m_initiator.initiator_tidy_tlm_payload(trans);
+    }
+
     void check_qemu_mr_hint(TlmPayload& trans)
     {
         QemuMrHintTlmExtension* ext = nullptr;
@@ -279,12 +332,15 @@ protected:
 
         mr.init_alias(m_dev, "mr-alias", target_mr, 0, target_mr.get_size());
         m_r->m_root->add_subregion(mr, mapping_addr);
+        m_tlb_flushes.fetch_add(1, std::memory_order_relaxed);
     }
 
     void do_regular_access(TlmPayload& trans)
     {
         using sc_core::sc_time;
 
+        gs::perf::timer t(m_io_host_ns);
+        QemuVcpuProfile::Scope prof(QemuVcpuProfile::current(), QemuVcpuProfile::IO);
         uint64_t addr = trans.get_address();
         sc_time now = m_initiator.initiator_get_local_time();
 
@@ -325,18 +381,29 @@ protected:
 
         init_payload(trans, command, addr, val, size);
 
+        if (attrs.debug) {
+            m_dbg_accesses.add();
+        } else {
+            (command == tlm::TLM_WRITE_COMMAND ? m_io_writes : m_io_reads).add();
+            m_io_bytes.add(size);
+        }
+
         if (trans.get_extension<ExclusiveAccessTlmExtension>()) {
             /* in the case of an exclusive access keep the iolock (and assume NO side-effects)
              * clearly dangerous, but exclusives are not guaranteed to work on IO space anyway
              */
             do_direct_access(trans);
         } else {
+            if (!attrs.debug) {
+                m_initiator.initiator_io_begin();
+            }
             if (!m_inst.g_rec_qemu_io_lock.try_lock()) {
                 /* Allow only a single access, but handle re-entrant code,
                  * while allowing side-effects in SystemC (e.g. calling wait)
                  * [NB re-entrant code caused via memory listeners to
                  * creation of memory regions (due to DMI) in some models]
                  */
+                QemuVcpuProfile::Scope prof(QemuVcpuProfile::current(), QemuVcpuProfile::IO_LOCK);
                 m_inst.get().unlock_iothread();
                 m_inst.g_rec_qemu_io_lock.lock();
                 m_inst.get().lock_iothread();
@@ -354,6 +421,9 @@ protected:
 
             reentrancy--;
             m_inst.g_rec_qemu_io_lock.unlock();
+            if (!attrs.debug) {
+                m_initiator.initiator_io_end();
+            }
         }
         m_initiator.initiator_tidy_tlm_payload(trans);
 
@@ -385,6 +455,13 @@ public:
         , m_inst(inst)
         , m_initiator(initiator)
         , m_on_sysc(sc_core::sc_gen_unique_name("initiator_run_on_sysc"))
+        , m_io_reads(this, "io_reads")
+        , m_io_writes(this, "io_writes")
+        , m_io_bytes(this, "io_bytes")
+        , m_dbg_accesses(this, "dbg_accesses")
+        , m_dmi_grants(this, "dmi_grants")
+        , m_dmi_invalidations(this, "dmi_invalidations")
+        , m_io_host_ns(this, "io_host_ns")
     {
         SCP_DEBUG(()) << "QemuInitiatorSocket constructor";
         TlmInitiatorSocket::bind(*static_cast<tlm::tlm_bw_transport_if<>*>(this));
@@ -486,6 +563,46 @@ public:
 
     void cancel_all() { m_on_sysc.cancel_all(); }
 
+    /**
+     * @brief Map the DMI regions of the memory map before the first accesses
+     *
+     * @details The memory map is asked to the router the socket is bound to
+     * (see gs::DmiMapExtension), and the DMI regions of its windows are mapped
+     * at once, rather than on the first I/O access to each of them. The
+     * regions of these windows are asked again when they are invalidated.
+     * The targets which don't grant DMI are still accessed through I/O.
+     *
+     * To be called from SystemC at the start of the simulation, before the
+     * CPU runs, by initiators which handle the DMI invalidations (see
+     * QemuInitiatorIface::initiator_async_run).
+     */
+    void map_dmi_eagerly()
+    {
+        if (!m_r || !TlmInitiatorSocket::size()) {
+            return;
+        }
+
+        TlmPayload trans;
+        gs::DmiMapExtension map;
+        trans.set_command(tlm::TLM_IGNORE_COMMAND);
+        trans.set_data_length(0);
+        trans.set_extension(&map);
+        (*this)->transport_dbg(trans);
+        trans.clear_extension(&map);
+
+        m_dmi_map = std::move(map.windows);
+        if (m_dmi_map.empty()) {
+            return;
+        }
+        SCP_INFO(()) << "Mapping the DMI regions of " << m_dmi_map.size() << " windows of the memory map";
+
+        m_inst.get().lock_iothread();
+        for (auto& w : m_dmi_map) {
+            map_dmi_window(w.first, w.second);
+        }
+        m_inst.get().unlock_iothread();
+    }
+
     /* tlm::tlm_bw_transport_if<> */
     virtual tlm::tlm_sync_enum nb_transport_bw(tlm::tlm_generic_payload& trans, tlm::tlm_phase& phase,
                                                sc_core::sc_time& t)
@@ -567,6 +684,7 @@ private:
             }
 
             it = remove_alias(it);
+            m_dmi_invalidations.add();
 
             SCP_INFO(()) << "Invalidated region [0x" << std::hex << r->get_start() << ", 0x" << std::hex << r->get_end()
                          << "]";
@@ -578,17 +696,38 @@ private:
 
     void invalidate_ranges_safe_cb()
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<std::pair<sc_dt::uint64, sc_dt::uint64>> ranges;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            SCP_INFO(()) << "Invalidating " << m_ranges.size() << " ranges";
+            auto rit = m_ranges.begin();
+            while (rit != m_ranges.end()) {
+                invalidate_single_range(rit->first, rit->second);
+                ranges.push_back(*rit);
+                rit = m_ranges.erase(rit);
+            }
+        }
 
-        SCP_INFO(()) << "Invalidating " << m_ranges.size() << " ranges";
-        auto rit = m_ranges.begin();
-        while (rit != m_ranges.end()) {
-            invalidate_single_range(rit->first, rit->second);
-            rit = m_ranges.erase(rit);
+        /*
+         * Ask the regions of the eagerly mapped windows again, rather than
+         * waiting for the next access (the lock is released, as the targets
+         * may invalidate while granting)
+         */
+        for (auto& r : ranges) {
+            for (auto& w : m_dmi_map) {
+                if (m_finished || w.first > r.second || w.second < r.first) {
+                    continue;
+                }
+                map_dmi_window(std::max<uint64_t>(w.first, r.first), std::min<uint64_t>(w.second, r.second));
+            }
         }
     }
 
 public:
+    /* Number of TLB flushes caused by DMI regions being mapped or unmapped */
+    uint64_t get_tlb_flushes() const { return m_tlb_flushes.load(std::memory_order_relaxed); }
+
     virtual void invalidate_direct_mem_ptr(sc_dt::uint64 start_range, sc_dt::uint64 end_range)
     {
         if (m_finished) return;
@@ -0,0 +1,57 @@
+/*
+ * This file is part of libqbox
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _LIBQBOX_PORTS_QEMU_GPIO_INBOX_H
+#define _LIBQBOX_PORTS_QEMU_GPIO_INBOX_H
+
+#include <memory>
+
+#include <libqemu-cxx/libqemu-cxx.h>
+
+#include <ports/qemu-gpio-mailbox.h>
+
+/**
+ * @class QemuGpioInbox
+ *
+ * @brief Delivery of GPIO levels coming from other QEMU instances
+ *
+ * @details A QemuGpioLineQueue drained in the context of the QEMU instance
+ * owning the inbox, by a timer callback (i.e. in its main loop, with its
+ * iothread lock held). Devices of other instances post to it without taking
+ * any lock of this instance, and without going through SystemC.
+ */
+class QemuGpioInbox
+{
+public:
+    using Line = QemuGpioLineQueue::Line;
+
+protected:
+    qemu::LibQemu& m_inst;
+    QemuGpioLineQueue m_queue;
+    std::shared_ptr<qemu::Timer> m_timer;
+
+public:
+    QemuGpioInbox(qemu::LibQemu& inst): m_inst(inst), m_timer(inst.timer_new())
+    {
+        m_timer->set_callback([this]() { m_queue.drain(); });
+    }
+
+    QemuGpioInbox(const QemuGpioInbox&) = delete;
+
+    /**
+     * @brief Post a new level on a line, from any thread
+     */
+    void post(Line& l, bool val)
+    {
+        if (m_queue.post(l, val)) {
+            /* expire as soon as possible */
+            m_timer->mod(m_inst.get_virtual_clock());
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,192 @@
+/*
+ * This file is part of libqbox
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _LIBQBOX_PORTS_QEMU_GPIO_MAILBOX_H
+#define _LIBQBOX_PORTS_QEMU_GPIO_MAILBOX_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+#include <systemc>
+
+#include <async_event.h>
+
+/**
+ * @class QemuGpioLineQueue
+ *
+ * @brief Lock-free queue of GPIO lines with a pending level
+ *
+ * @details Producers post the new level of a line without waiting for the
+ * consumer. Each line holds its latest level, and lines with a pending level
+ * are pushed on a lock-free list which the consumer drains.
+ *
+ * Changes of a line happening before the consumer drains the queue are
+ * coalesced: only the latest level is delivered. If the line went through a
+ * pulse (e.g. 0->1->0) in between, the opposite level is delivered first so
+ * that the edge is not lost. The order of the changes of a given line is
+ * always kept.
+ *
+ * Posts to a given line must be serialized (QEMU does it with the iothread
+ * lock), different lines may be posted concurrently. There must be a single
+ * consumer.
+ */
+class QemuGpioLineQueue
+{
+public:
+    class Line
+    {
+        friend class QemuGpioLineQueue;
+
+        std::function<void(bool)> m_deliver;
+
+        /* posting side */
+        bool m_posted = false;
+        uint32_t m_seq = 0;
+
+        /* change sequence number << 1 | level */
+        std::atomic<uint32_t> m_state{ 0 };
+        std::atomic<bool> m_queued{ false };
+        Line* m_next = nullptr;
+
+        /* consumer side */
+        uint32_t m_seen = 0;
+        bool m_delivered = false;
+
+    public:
+        Line(const std::function<void(bool)>& deliver): m_deliver(deliver) {}
+
+        Line(const Line&) = delete;
+    };
+
+protected:
+    std::atomic<Line*> m_pending{ nullptr };
+
+public:
+    /**
+     * @brief Post a new level on a line, from any thread
+     *
+     * @return true if the consumer must be woken up to drain the queue
+     */
+    bool post(Line& l, bool val)
+    {
+        if (val == l.m_posted) {
+            return false;
+        }
+        l.m_posted = val;
+        l.m_seq++;
+        l.m_state.store((l.m_seq << 1) | val, std::memory_order_release);
+
+        if (l.m_queued.exchange(true, std::memory_order_acq_rel)) {
+            return false; /* not drained yet, it will see the new level */
+        }
+
+        Line* head = m_pending.load(std::memory_order_relaxed);
+        do {
+            l.m_next = head;
+        } while (!m_pending.compare_exchange_weak(head, &l, std::memory_order_release, std::memory_order_relaxed));
+
+        /* if the list wasn't empty, the consumer has already been woken up */
+        return head == nullptr;
+    }
+
+    /**
+     * @brief Whether no line has a pending level
+     */
+    bool empty() const { return m_pending.load(std::memory_order_acquire) == nullptr; }
+
+    /**
+     * @brief Deliver the pending levels, from the consumer
+     */
+    void drain()
+    {
+        /* the list is LIFO, put it back in posting order */
+        Line* l = m_pending.exchange(nullptr, std::memory_order_acquire);
+        Line* lines = nullptr;
+        while (l) {
+            Line* next = l->m_next;
+            l->m_next = lines;
+            lines = l;
+            l = next;
+        }
+
+        for (l = lines; l;) {
+            Line* next = l->m_next;
+
+            /* from now on, a new post queues the line again */
+            l->m_queued.exchange(false, std::memory_order_acq_rel);
+            uint32_t state = l->m_state.load(std::memory_order_acquire);
+            uint32_t seq = state >> 1;
+            bool level = state & 1;
+
+            if (seq != l->m_seen) {
+                if (level == l->m_delivered) {
+                    /* an even number of changes: a pulse */
+                    l->m_deliver(!level);
+                }
+                l->m_deliver(level);
+                l->m_delivered = level;
+                l->m_seen = seq;
+            }
+            l = next;
+        }
+    }
+};
+
+/**
+ * @class QemuGpioMailbox
+ *
+ * @brief Non blocking delivery of QEMU output GPIO levels to SystemC
+ *
+ * @details A QemuGpioLineQueue drained by a single SystemC process. The
+ * process is a thread, as the signal callbacks of the receivers may wait.
+ */
+class QemuGpioMailbox : public sc_core::sc_module
+{
+public:
+    using Line = QemuGpioLineQueue::Line;
+
+protected:
+    QemuGpioLineQueue m_queue;
+    gs::async_event m_event;
+
+    void drain()
+    {
+        for (;;) {
+            wait(m_event);
+            /*
+             * A receiver may wait, and the notification of a post done in the
+             * meantime is not seen by this thread: drain until nothing is left
+             */
+            do {
+                sc_core::sc_unsuspendable();
+                m_queue.drain();
+                sc_core::sc_suspendable();
+            } while (!m_queue.empty());
+        }
+    }
+
+public:
+    QemuGpioMailbox(const sc_core::sc_module_name& n = sc_core::sc_module_name("gpio_mailbox"))
+        : sc_core::sc_module(n), m_event(false) // don't keep the simulation alive
+    {
+        SC_HAS_PROCESS(QemuGpioMailbox);
+        SC_THREAD(drain);
+    }
+
+    /**
+     * @brief Post a new level on a line, from any thread
+     */
+    void post(Line& l, bool val)
+    {
+        if (m_queue.post(l, val)) {
+            m_event.async_notify();
+        }
+    }
+};
+
+#endif
@@ -20,6 +20,8 @@
 #include <libgssync.h>
 
 #include <ports/qemu-target-signal-socket.h>
+#include <ports/qemu-gpio-mailbox.h>
+#include <device.h>
 
 /**
  * @class QemuInitiatorSignalSocket
@@ -35,6 +37,15 @@
  * propagation is done directly within QEMU and do not go through the SystemC
  * kernel. Note that this is only true if the GPIOs wrapped by both this socket
  * and the remote socket lie in the same QEMU instance.
+ *
+ * If the remote socket lies in another QEMU instance which has its
+ * cross_instance_gpio parameter set, the changes are posted to that
+ * instance's QemuGpioInbox, which sets the remote GPIO from within the remote
+ * instance, again without going through the SystemC kernel.
+ *
+ * Otherwise the QEMU thread waits for SystemC to handle each change, unless
+ * the async_gpio parameter of the QEMU instance is set: the changes are then
+ * posted to the instance's QemuGpioMailbox and the QEMU thread goes on.
  */
 class QemuInitiatorSignalSocket : public InitiatorSignalSocket<bool>
 {
@@ -42,9 +53,25 @@ protected:
     qemu::Gpio m_proxy;
     gs::runonsysc m_on_sysc;
     QemuTargetSignalSocket* m_qemu_remote = nullptr;
+    QemuGpioMailbox* m_mailbox = nullptr;
+    QemuGpioMailbox::Line m_mailbox_line;
+    QemuGpioInbox* m_remote_inbox = nullptr;
+    QemuGpioInbox::Line m_remote_line;
 
     void event_cb(bool val)
     {
+        if (m_remote_inbox) {
+            /*
+             * The remote instance sets its GPIO itself, with its own iothread
+             * lock held, we don't need to take it.
+             */
+            m_remote_inbox->post(m_remote_line, val);
+
+            m_on_sysc.run_on_sysc([this] { m_qemu_remote->notify(); }, false);
+
+            return;
+        }
+
         if (m_qemu_remote && (m_qemu_remote->get_gpio().same_inst_as(m_proxy))) {
             /*
              * We make sure to be in the same instance as the target socket.
@@ -52,8 +79,9 @@ protected:
              * iothread lock. This would require us to unlock our own lock
              * first to ensure we won't deadlock because of a race condition
              * between two initiators trying to set a GPIO in one another.
-             * Don't bother with that. Instead, use the SystemC kernel as a
-             * synchronization point in this case.
+             * Don't bother with that. Instead, use the remote instance's
+             * inbox (see above), or the SystemC kernel as a synchronization
+             * point in this case.
              */
             m_qemu_remote->get_gpio().set(val);
 
@@ -66,6 +94,11 @@ protected:
             return;
         }
 
+        if (m_mailbox) {
+            m_mailbox->post(m_mailbox_line, val);
+            return;
+        }
+
         m_proxy.get_inst().unlock_iothread();
 
         m_on_sysc.run_on_sysc([this, val] { (*this)->write(val); });
@@ -91,6 +124,11 @@ protected:
 
         init_qemu_to_sysc_gpio_proxy(dev);
 
+        QemuDevice* parent = dynamic_cast<QemuDevice*>(get_parent_object());
+        if (parent) {
+            m_mailbox = parent->get_qemu_inst().get_gpio_mailbox();
+        }
+
         iface = get_interface();
 
         /* Check if we're bound to a TargetSignalSocket<bool> */
@@ -114,11 +152,19 @@ protected:
          * instead of going through the SystemC kernel.
          */
         m_qemu_remote = remote;
+
+        QemuDevice* remote_parent = dynamic_cast<QemuDevice*>(remote->get_parent_object());
+        if (parent && remote_parent && (&parent->get_qemu_inst() != &remote_parent->get_qemu_inst())) {
+            m_remote_inbox = remote_parent->get_qemu_inst().get_gpio_inbox();
+        }
     }
 
 public:
     QemuInitiatorSignalSocket(const char* name)
-        : InitiatorSignalSocket<bool>(name), m_on_sysc(sc_core::sc_gen_unique_name("run_on_sysc"))
+        : InitiatorSignalSocket<bool>(name)
+        , m_on_sysc(sc_core::sc_gen_unique_name("run_on_sysc"))
+        , m_mailbox_line([this](bool val) { (*this)->write(val); })
+        , m_remote_line([this](bool val) { m_qemu_remote->get_gpio().set(val); })
     {
     }
 
@@ -14,6 +14,7 @@
 #include <libqemu-cxx/libqemu-cxx.h>
 
 #include <ports/target-signal-socket.h>
+#include <device.h>
 
 /**
  * @class QemuTargetSignalSocket
@@ -23,14 +24,23 @@
  * @details This class exposes an input GPIO of a QEMU device as a
  * TargetSignalSocket<bool>. It can be connected to an sc_core::sc_port<bool>
  * or a TargetInitiatorSocket<bool>. Modifications to this socket will be
- * reported to the wrapped GPIO.
+ * reported to the wrapped GPIO. In deterministic MULTI mode, they are applied
+ * at the next quantum boundary (see QemuDeterministicScheduler).
  */
 class QemuTargetSignalSocket : public TargetSignalSocket<bool>
 {
 protected:
     qemu::Gpio m_gpio_in;
+    QemuDeterministicScheduler* m_det = nullptr;
 
-    void value_changed_cb(const bool& val) { m_gpio_in.set(val); }
+    void value_changed_cb(const bool& val)
+    {
+        if (m_det) {
+            m_det->post([this, val]() { m_gpio_in.set(val); });
+        } else {
+            m_gpio_in.set(val);
+        }
+    }
 
     void init_with_gpio(qemu::Gpio gpio)
     {
@@ -38,6 +48,11 @@ protected:
 
         m_gpio_in = gpio;
 
+        QemuDevice* parent = dynamic_cast<QemuDevice*>(get_parent_object());
+        if (parent) {
+            m_det = parent->get_qemu_inst().get_deterministic_scheduler();
+        }
+
         auto cb = std::bind(&QemuTargetSignalSocket::value_changed_cb, this, _1);
         register_value_changed_cb(cb);
     }
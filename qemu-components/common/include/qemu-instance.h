@@ -9,9 +9,15 @@
 #ifndef LIBQBOX_QEMU_INSTANCE_H_
 #define LIBQBOX_QEMU_INSTANCE_H_
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <functional>
 #include <sstream>
 #include <systemc>
+#include <thread>
+
+#include <unistd.h>
 
 #include <cci_configuration>
 #include <vector>
@@ -19,10 +25,16 @@
 #include <cciutils.h>
 #include <report.h>
 #include <libgssync.h>
+#include <checkpoint/checkpoint.h>
 
 #include <libqemu-cxx/libqemu-cxx.h>
 
 #include <dmi-manager.h>
+#include <ports/qemu-gpio-mailbox.h>
+#include <ports/qemu-gpio-inbox.h>
+#include <vcpu-profiler.h>
+#include <deterministic-scheduler.h>
+#include <qmp-client.h>
 #include <exceptions.h>
 
 #include <scp/report.h>
@@ -86,8 +98,13 @@ public:
  *
  * @brief This class encapsulates a libqemu-cxx qemu::LibQemu instance. It
  * handles QEMU parameters and instance initialization.
+ *
+ * @details When the platform has a checkpoint module, the instance state
+ * (CPUs, devices, timers) is saved and restored through a QEMU migration to
+ * a file of the checkpoint, driven on a private QMP socket. The memories
+ * mapped from SystemC are not part of it, they are saved by their owners.
  */
-class QemuInstance : public sc_core::sc_module
+class QemuInstance : public sc_core::sc_module, public gs::ckpt::checkpointable
 {
 private:
     std::shared_ptr<gs::tlm_quantumkeeper_extended> m_first_qk = NULL;
@@ -155,14 +172,41 @@ protected:
     cci::cci_param<std::string> p_sync_policy;
     TcgMode m_tcg_mode;
 
+    cci::cci_param<uint64_t> p_quantum_ns;
+
     cci::cci_param<bool> p_icount;
     cci::cci_param<int> p_icount_mips;
+    cci::cci_param<bool> p_deterministic;
+    cci::cci_param<unsigned int> p_det_io_timeout_ms;
+    cci::cci_param<bool> p_det_io_give_up;
+    std::unique_ptr<QemuDeterministicScheduler> m_det_sched;
 
     cci::cci_param<std::string> p_args;
     bool p_display_argument_set;
 
     cci::cci_param<std::string> p_accel;
 
+    cci::cci_param<bool> p_async_gpio;
+    std::unique_ptr<QemuGpioMailbox> m_gpio_mailbox;
+
+    cci::cci_param<bool> p_cross_instance_gpio;
+    std::unique_ptr<QemuGpioInbox> m_gpio_inbox;
+
+    cci::cci_param<bool> p_vcpu_profile;
+    cci::cci_param<std::string> p_vcpu_profile_trace;
+    cci::cci_param<uint32_t> p_vcpu_profile_max_events;
+    std::unique_ptr<QemuVcpuProfiler> m_vcpu_profiler;
+
+    cci::cci_param<bool> p_cpu_stats;
+    cci::cci_param<std::string> p_cpu_stats_plugin;
+
+    cci::cci_param<bool> p_eager_dmi;
+
+    cci::cci_param<unsigned int> p_ckpt_timeout_ms;
+
+    QmpClient m_qmp;
+    std::string m_qmp_path;
+
     void push_default_args()
     {
         const size_t l = strlen(name()) + 1;
@@ -196,6 +240,30 @@ protected:
         }
     }
 
+    /*
+     * Deterministic runs: SINGLE and COROUTINE use the QEMU icount, in MULTI
+     * mode the vCPUs count their instructions and run in lockstep quanta (see
+     * QemuDeterministicScheduler).
+     */
+    void setup_deterministic_mode()
+    {
+        p_icount = true;
+        if (m_tcg_mode != TCG_MULTI) {
+            return;
+        }
+        if (p_accel.get_value() != "tcg") {
+            SCP_FATAL(()) << "The deterministic MULTI mode needs the TCG accelerator";
+        }
+        if (p_sync_policy.get_value() != "multithread-lockstep" &&
+            (p_sync_policy.is_preset_value() || p_sync_policy.get_value() != p_sync_policy.get_default_value())) {
+            SCP_FATAL(()) << "The deterministic MULTI mode (selected by " << (p_deterministic ? "deterministic" : "icount")
+                          << ") needs the multithread-lockstep sync policy, not " << p_sync_policy.get_value();
+        }
+        p_sync_policy = std::string("multithread-lockstep");
+        m_det_sched = std::make_unique<QemuDeterministicScheduler>(m_inst, p_icount_mips, p_det_io_timeout_ms,
+                                                                   p_det_io_give_up);
+    }
+
     void push_icount_mode_args()
     {
         std::ostringstream ss;
@@ -206,8 +274,12 @@ protected:
         p_icount_mips.lock();
         if (!p_icount) return;
         if (m_tcg_mode == TCG_MULTI) {
-            SCP_FATAL(()) << "MULTI threading can not be used with icount";
-            assert(m_tcg_mode != TCG_MULTI);
+            if (!m_det_sched) {
+                SCP_FATAL(()) << "MULTI threading can only be used with icount if it is set when the instance is "
+                                 "constructed";
+            }
+            /* the vCPUs count their instructions with the cpu-stats plugin */
+            return;
         }
         m_inst.push_qemu_arg("-icount");
 
@@ -228,10 +300,6 @@ protected:
 
         case TCG_MULTI:
             m_inst.push_qemu_arg("tcg,thread=multi");
-            if (p_icount) {
-                SCP_FATAL(()) << "MULTI threading can not be used with icount";
-                assert(!p_icount);
-            }
             break;
 
         default:
@@ -254,6 +322,81 @@ protected:
         }
     }
 
+    /* A private QMP socket for the checkpoints, and wait for the incoming state when restoring */
+    void push_checkpoint_args()
+    {
+        std::string prefix = "/tmp/qbox-" + std::to_string(getpid()) + "-";
+        m_qmp_path = prefix + checkpoint_name() + ".qmp";
+        if (m_qmp_path.size() >= sizeof(sockaddr_un::sun_path)) {
+            /* too long for a unix socket address */
+            std::stringstream h;
+            h << std::hex << std::hash<std::string>()(checkpoint_name());
+            m_qmp_path = prefix + h.str() + ".qmp";
+        }
+        unlink(m_qmp_path.c_str());
+        std::string qmp = "unix:" + m_qmp_path + ",server=on,wait=off";
+        m_inst.push_qemu_arg({ "-qmp", qmp.c_str() });
+
+        if (gs::ckpt::registry::get().restoring()) {
+            m_inst.push_qemu_arg({ "-incoming", "defer" });
+        }
+    }
+
+    static std::string shell_quote(const std::string& s)
+    {
+        std::string q = "'";
+        for (char c : s) {
+            q += (c == '\'') ? std::string("'\\''") : std::string(1, c);
+        }
+        return q + "'";
+    }
+
+    void qmp_connect()
+    {
+        if (!m_qmp.is_connected() && !m_qmp.connect(m_qmp_path)) {
+            SCP_FATAL(()) << "Unable to connect to the QMP socket " << m_qmp_path;
+        }
+    }
+
+    /* The status of the current migration in a query-migrate reply, empty if there is none */
+    static std::string qmp_migration_status(const std::string& reply)
+    {
+        cci::cci_value v;
+        if (!v.json_deserialize(reply) || !v.is_map() || !v.get_map().has_entry("return")) {
+            return "";
+        }
+        cci::cci_value_cref ret = v.get_map().at("return");
+        if (!ret.is_map() || !ret.get_map().has_entry("status") || !ret.get_map().at("status").is_string()) {
+            return "";
+        }
+        return ret.get_map().at("status").get_string();
+    }
+
+    /* Wait for the current migration (outgoing or incoming) to complete */
+    void qmp_wait_migration(const std::string& what)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(p_ckpt_timeout_ms.get_value());
+        for (;;) {
+            std::string reply = m_qmp.execute("query-migrate");
+            if (!QmpClient::ok(reply)) {
+                SCP_FATAL(()) << "Unable to " << what << ": " << (reply.empty() ? "no reply from QEMU" : reply);
+            }
+            std::string status = qmp_migration_status(reply);
+            if (status == "completed") {
+                return;
+            }
+            if (status == "failed" || status == "cancelled" || status == "cancelling") {
+                SCP_FATAL(()) << "Unable to " << what << ", the migration " << status << ": " << reply;
+            }
+            if (std::chrono::steady_clock::now() > deadline) {
+                SCP_FATAL(()) << "Unable to " << what << " in " << p_ckpt_timeout_ms.get_value()
+                              << "ms (checkpoint_timeout_ms), the migration is "
+                              << (status.empty() ? "not started" : status);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
     LibLoader& get_loader(sc_core::sc_object* o)
     {
         QemuInstanceManager* inst_mgr = dynamic_cast<QemuInstanceManager*>(o);
@@ -288,27 +431,83 @@ public:
 
     QemuInstance(const sc_core::sc_module_name& n, LibLoader& loader, Target t)
         : sc_core::sc_module(n)
+        , gs::ckpt::checkpointable(sc_core::sc_module::name())
         , m_conf_broker(cci::cci_get_broker())
         , m_inst(loader, t)
         , m_dmi_mgr(m_inst)
         , p_tcg_mode("tcg_mode", "MULTI", "The TCG mode required, SINGLE, COROUTINE or MULTI")
         , p_sync_policy("sync_policy", "multithread-quantum", "Synchronization Policy to use")
         , m_tcg_mode(StringToTcgMode(p_tcg_mode))
+        , p_quantum_ns("quantum_ns", 0,
+                       "Quantum of the CPUs of this instance in ns, the TLM-2.0 global quantum if 0. It must be a "
+                       "multiple or a divisor of the global quantum")
         , p_icount("icount", false, "Enable virtual instruction counter")
         , p_icount_mips("icount_mips_shift", 0, "The MIPS shift value for icount mode (1 insn = 2^(mips) ns)")
+        , p_deterministic("deterministic", false,
+                          "Reproducible runs: icount in SINGLE and COROUTINE modes, lockstep quanta of instructions "
+                          "in MULTI mode (also enabled by icount in MULTI mode)")
+        , p_det_io_timeout_ms("deterministic_io_timeout_ms", 1000,
+                              "Deterministic MULTI mode: host time an I/O access waits for its turn at most")
+        , p_det_io_give_up("deterministic_io_give_up", false,
+                           "Deterministic MULTI mode: an I/O access which waited too long for its turn goes on, "
+                           "the run is then not reproducible (the simulation stops otherwise)")
         , p_args("qemu_args", "", "additional space separated arguments")
         , p_display_argument_set(false)
         , p_accel("accel", "tcg", "Virtualization accelerator")
+        , p_async_gpio("async_gpio", false,
+                       "Deliver the output GPIO changes to SystemC without blocking the QEMU threads (coalescing "
+                       "the changes happening before SystemC handles them)")
+        , p_cross_instance_gpio("cross_instance_gpio", false,
+                                "Deliver the GPIOs driven by devices of other QEMU instances directly in this "
+                                "instance, without going through SystemC")
+        , p_vcpu_profile("vcpu_profile", false,
+                         "Measure the host time spent by the vCPU threads in each of their states (running, I/O, "
+                         "sync...), and print a summary at the end of the simulation")
+        , p_vcpu_profile_trace("vcpu_profile_trace", "",
+                               "(optional) write the vCPU timelines to this file, in the Chrome trace event format")
+        , p_vcpu_profile_max_events("vcpu_profile_max_events", 1000000,
+                                    "Maximum number of state changes kept in the timeline of each vCPU")
+        , p_cpu_stats("cpu_stats", false,
+                      "Count the instructions and translation blocks executed by each vCPU, with a TCG plugin "
+                      "(see QemuCpu::get_stats)")
+        , p_cpu_stats_plugin("cpu_stats_plugin", "",
+                             "(optional) path of the cpu-stats TCG plugin, the one built with libqbox if empty")
+        , p_eager_dmi("eager_dmi", true,
+                      "Map the DMI regions of the memory map of the CPUs at the start of the simulation (and again "
+                      "when they are invalidated), rather than on their first access")
+        , p_ckpt_timeout_ms("checkpoint_timeout_ms", 60000,
+                            "Host time the save or the restore of the QEMU state in a checkpoint may take at most")
     {
         SCP_DEBUG(()) << "Libqbox QemuInstance constructor";
         m_running = true;
         p_tcg_mode.lock();
+        p_deterministic.lock();
+        if (p_deterministic || ((p_icount || p_icount_mips > 0) && m_tcg_mode == TCG_MULTI)) {
+            setup_deterministic_mode();
+        }
+        p_async_gpio.lock();
+        if (p_async_gpio && m_det_sched) {
+            SCP_WARN(()) << "async_gpio is not used in deterministic mode";
+        } else if (p_async_gpio) {
+            m_gpio_mailbox = std::make_unique<QemuGpioMailbox>("gpio_mailbox");
+        }
+        if (p_vcpu_profile) {
+            m_vcpu_profiler = std::make_unique<QemuVcpuProfiler>(
+                p_vcpu_profile_trace.get_value().empty() ? 0 : p_vcpu_profile_max_events.get_value());
+        }
         push_default_args();
     }
 
     QemuInstance(const QemuInstance&) = delete;
     QemuInstance(QemuInstance&&) = delete;
-    virtual ~QemuInstance() { m_running = false; }
+    virtual ~QemuInstance()
+    {
+        m_running = false;
+        if (!m_qmp_path.empty()) {
+            m_qmp.close();
+            unlink(m_qmp_path.c_str());
+        }
+    }
 
     bool operator==(const QemuInstance& b) const { return this == &b; }
 
@@ -345,6 +544,48 @@ public:
     bool is_hvf_enabled() const { return p_accel.get_value() == "hvf"; }
     bool is_tcg_enabled() const { return p_accel.get_value() == "tcg"; }
 
+    /**
+     * @brief Get the mailbox used to deliver output GPIOs to SystemC
+     *
+     * @details nullptr unless the async_gpio parameter is set, in which case
+     * the output GPIO sockets of the devices of this instance post their
+     * changes to it instead of waiting for SystemC to handle them.
+     */
+    QemuGpioMailbox* get_gpio_mailbox() { return m_gpio_mailbox.get(); }
+
+    /**
+     * @brief Get the inbox receiving GPIOs from other instances
+     *
+     * @details nullptr unless the cross_instance_gpio parameter is set. In
+     * icount mode, the GPIOs keep going through SystemC so that they stay
+     * deterministic. Must be called during elaboration.
+     */
+    QemuGpioInbox* get_gpio_inbox()
+    {
+        if (!m_gpio_inbox && p_cross_instance_gpio && !p_icount) {
+            m_gpio_inbox = std::make_unique<QemuGpioInbox>(get());
+        }
+        return m_gpio_inbox.get();
+    }
+
+    /**
+     * @brief Get the profiler of the vCPUs of this instance
+     *
+     * @details nullptr unless the vcpu_profile parameter is set.
+     */
+    QemuVcpuProfiler* get_vcpu_profiler() { return m_vcpu_profiler.get(); }
+
+    /**
+     * @brief Get the scheduler of the vCPUs in deterministic MULTI mode
+     *
+     * @details nullptr unless the deterministic parameter (or icount) is set
+     * in MULTI mode.
+     */
+    QemuDeterministicScheduler* get_deterministic_scheduler() { return m_det_sched.get(); }
+
+    /* Whether the CPUs map the DMI regions of their memory map at the start of the simulation */
+    bool eager_dmi() const { return p_eager_dmi; }
+
     /**
      * @brief Get the TCG mode for this instance
      *
@@ -365,11 +606,28 @@ public:
         if (qk->get_thread_type() == gs::SyncPolicy::SYSTEMC_THREAD) {
             assert(m_tcg_mode == TCG_COROUTINE);
         }
-        /* The p_sync_policy parameter should not be modified anymore */
+        qk->set_quantum(sc_core::sc_time(double(p_quantum_ns.get_value()), sc_core::SC_NS));
+        /* The p_sync_policy and p_quantum_ns parameters should not be modified anymore */
         p_sync_policy.lock();
+        p_quantum_ns.lock();
         return qk;
     }
 
+    /**
+     * @brief Get the quantum of the CPUs of this instance
+     *
+     * @details The instances with their own quantum are quantum domains, each
+     * one running up to its quantum ahead of SystemC. SystemC doesn't run past
+     * the slowest domain, so the domains meet at their common boundaries.
+     */
+    sc_core::sc_time get_quantum() const
+    {
+        if (p_quantum_ns.get_value() == 0) {
+            return tlm_utils::tlm_quantumkeeper::get_global_quantum();
+        }
+        return sc_core::sc_time(double(p_quantum_ns.get_value()), sc_core::SC_NS);
+    }
+
     /**
      * @brief Initialize the QEMU instance
      *
@@ -410,6 +668,26 @@ public:
             });
         }
 
+        if (gs::ckpt::registry::get().enabled()) {
+            push_checkpoint_args();
+        }
+
+        if (p_cpu_stats || m_det_sched) {
+            if (p_accel.get_value() != "tcg") {
+                SCP_WARN(()) << "cpu_stats needs the TCG accelerator, the instructions won't be counted";
+            } else {
+                try {
+                    m_inst.enable_cpu_stats(
+                        p_cpu_stats_plugin.get_value().empty() ? nullptr : p_cpu_stats_plugin.get_value().c_str());
+                    if (m_det_sched) {
+                        m_inst.enable_virtual_clock_control();
+                    }
+                } catch (qemu::LibQemuException& e) {
+                    SCP_FATAL(()) << "Unable to enable the vCPU statistics: " << e.what();
+                }
+            }
+        }
+
         bool trace = (SCP_LOGGER_NAME().level >= sc_core::SC_FULL);
         if (trace) {
             SCP_WARN(())("Enabling QEMU debug logging");
@@ -424,6 +702,11 @@ public:
 
         m_inst.init();
         m_dmi_mgr.init();
+
+        if (m_det_sched && !m_inst.virtual_clock_controlled()) {
+            SCP_WARN(()) << "The cpu-stats plugin could not take the control of the virtual clock, the architectural "
+                            "timers follow the host time";
+        }
     }
 
     /**
@@ -458,8 +741,102 @@ public:
 
     int number_devices() { return devices.size(); }
 
+    void checkpoint_pause() override
+    {
+        if (is_inited()) {
+            m_inst.vm_stop_paused();
+        }
+    }
+
+    void checkpoint_continue() override
+    {
+        if (is_inited()) {
+            m_inst.vm_start();
+        }
+    }
+
+    void checkpoint_save(gs::ckpt::state& s) override
+    {
+        bool saved = is_inited() && !m_qmp_path.empty();
+        s.put(saved);
+        if (!saved) {
+            return;
+        }
+        qmp_connect();
+        std::string uri = "exec:cat > " + shell_quote(s.file(".qemu"));
+        if (!QmpClient::ok(m_qmp.execute("migrate", "{\"uri\": " + QmpClient::quote(uri) + "}"))) {
+            SCP_FATAL(()) << "Unable to start saving the QEMU state to " << s.file(".qemu");
+        }
+        qmp_wait_migration("save the QEMU state");
+        s.put(m_inst.get_virtual_clock());
+    }
+
+    void checkpoint_restore(gs::ckpt::state& s) override
+    {
+        bool saved;
+        s.get(saved);
+        if (!saved) {
+            return;
+        }
+        if (!is_inited() || m_qmp_path.empty()) {
+            SCP_FATAL(()) << "The QEMU instance was not started for a restore";
+        }
+        qmp_connect();
+        std::string uri = "exec:cat " + shell_quote(s.file(".qemu"));
+        if (!QmpClient::ok(m_qmp.execute("migrate-incoming", "{\"uri\": " + QmpClient::quote(uri) + "}"))) {
+            SCP_FATAL(()) << "Unable to start restoring the QEMU state from " << s.file(".qemu");
+        }
+        qmp_wait_migration("restore the QEMU state");
+
+        int64_t vclock;
+        s.get(vclock);
+        if (m_inst.get_virtual_clock() != vclock) {
+            SCP_WARN(()) << "The QEMU virtual clock was restored at " << m_inst.get_virtual_clock() << "ns instead of "
+                         << vclock << "ns";
+        }
+    }
+
 private:
-    void start_of_simulation(void) { get().finish_qemu_init(); }
+    /*
+     * The boundaries of a domain must be boundaries of the global quantum, or
+     * the other way round, for the domain to meet the SystemC initiators (and
+     * the other domains) at every boundary of the larger quantum.
+     */
+    void check_quantum()
+    {
+        sc_core::sc_time global = tlm_utils::tlm_quantumkeeper::get_global_quantum();
+        sc_core::sc_time quantum = get_quantum();
+        if (p_quantum_ns.get_value() == 0 || global == sc_core::SC_ZERO_TIME) {
+            return;
+        }
+        sc_core::sc_time common = gs::tlm_quantumkeeper_extended::common_boundary(quantum, global);
+        if (common != std::max(quantum, global)) {
+            SCP_FATAL(()) << "The quantum " << quantum << " is neither a multiple nor a divisor of the global quantum "
+                          << global << ", they would only meet every " << common;
+        }
+        SCP_INFO(()) << "Quantum domain of " << quantum << ", the global quantum is " << global;
+    }
+
+    void start_of_simulation(void)
+    {
+        check_quantum();
+        get().finish_qemu_init();
+        if (m_det_sched) {
+            m_det_sched->start();
+        }
+    }
+
+    void end_of_simulation(void)
+    {
+        if (!m_vcpu_profiler) {
+            return;
+        }
+        SCP_INFO(()) << "vCPU host time profile:\n" << m_vcpu_profiler->summary();
+        if (!p_vcpu_profile_trace.get_value().empty() &&
+            !m_vcpu_profiler->write_trace(p_vcpu_profile_trace.get_value())) {
+            SCP_WARN(()) << "Unable to write the vCPU timelines to " << p_vcpu_profile_trace.get_value();
+        }
+    }
 };
 
 GSC_MODULE_REGISTER(QemuInstanceManager);
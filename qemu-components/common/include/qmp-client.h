@@ -0,0 +1,153 @@
+/*
+ * This file is part of libqbox
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBQBOX_QMP_CLIENT_H_
+#define LIBQBOX_QMP_CLIENT_H_
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * @class QmpClient
+ *
+ * @brief A minimal client of the QEMU monitor protocol, on a unix socket
+ *
+ * @details Used for the few commands libqemu doesn't export (e.g. the
+ * migrations used by the checkpoints). The commands are sent one at a time,
+ * the asynchronous events received in between are skipped. The replies are
+ * returned as text, the callers only look for the values they expect.
+ */
+class QmpClient
+{
+    int m_fd = -1;
+    std::string m_buf;
+
+    /* One JSON message per line */
+    bool read_line(std::string& line, int timeout_ms)
+    {
+        for (;;) {
+            size_t eol = m_buf.find('\n');
+            if (eol != std::string::npos) {
+                line = m_buf.substr(0, eol);
+                m_buf.erase(0, eol + 1);
+                return true;
+            }
+            struct pollfd pfd = { m_fd, POLLIN, 0 };
+            if (poll(&pfd, 1, timeout_ms) <= 0) {
+                return false;
+            }
+            char b[4096];
+            ssize_t n = read(m_fd, b, sizeof(b));
+            if (n <= 0) {
+                return false;
+            }
+            m_buf.append(b, n);
+        }
+    }
+
+public:
+    QmpClient() = default;
+    QmpClient(const QmpClient&) = delete;
+    ~QmpClient() { close(); }
+
+    /* Connect to the QMP server, retrying until QEMU listens, and enter the command mode */
+    bool connect(const std::string& path, int timeout_ms = 5000)
+    {
+        close();
+        struct sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(addr.sun_path)) {
+            return false;
+        }
+        path.copy(addr.sun_path, path.size());
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        for (;;) {
+            m_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (m_fd < 0) {
+                return false;
+            }
+            if (::connect(m_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == 0) {
+                break;
+            }
+            close();
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        std::string greeting;
+        if (!read_line(greeting, timeout_ms) || greeting.find("\"QMP\"") == std::string::npos) {
+            close();
+            return false;
+        }
+        return ok(execute("qmp_capabilities"));
+    }
+
+    void close()
+    {
+        if (m_fd >= 0) {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+        m_buf.clear();
+    }
+
+    bool is_connected() const { return m_fd >= 0; }
+
+    /*
+     * Execute a command, args being a JSON object (or empty). Returns the
+     * reply, or an empty string if QEMU didn't answer in time.
+     */
+    std::string execute(const std::string& cmd, const std::string& args = "", int timeout_ms = 5000)
+    {
+        if (m_fd < 0) {
+            return "";
+        }
+        std::string msg = "{\"execute\": \"" + cmd + "\"";
+        if (!args.empty()) {
+            msg += ", \"arguments\": " + args;
+        }
+        msg += "}\n";
+        if (write(m_fd, msg.data(), msg.size()) != (ssize_t)msg.size()) {
+            return "";
+        }
+
+        std::string line;
+        while (read_line(line, timeout_ms)) {
+            if (line.find("\"return\"") != std::string::npos || line.find("\"error\"") != std::string::npos) {
+                return line;
+            }
+            /* an event */
+        }
+        return "";
+    }
+
+    static bool ok(const std::string& reply) { return reply.find("\"return\"") != std::string::npos; }
+
+    /* Quote a string as a JSON value */
+    static std::string quote(const std::string& s)
+    {
+        std::string q = "\"";
+        for (char c : s) {
+            if (c == '"' || c == '\\') {
+                q += '\\';
+            }
+            q += c;
+        }
+        return q + "\"";
+    }
+};
+
+#endif
@@ -0,0 +1,285 @@
+/*
+ * This file is part of libqbox
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBQBOX_VCPU_PROFILER_H_
+#define LIBQBOX_VCPU_PROFILER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * @class QemuVcpuProfile
+ *
+ * @brief Host time spent by a vCPU thread in each of its states
+ *
+ * @details The vCPU thread moves its profile from state to state (see
+ * QemuCpu and QemuInitiatorSocket). Each transition reads the TSC (or the
+ * monotonic clock on other hosts) and adds the time spent in the previous
+ * state to its total. Optionally, the intervals are also kept (up to a
+ * maximum number) to produce a timeline.
+ *
+ * A profile must only be moved by one thread at a time, the totals and the
+ * timeline can be read from any thread.
+ */
+class QemuVcpuProfile
+{
+public:
+    enum State {
+        TCG,     /* executing guest code */
+        IO,      /* I/O access handed over to SystemC */
+        IO_LOCK, /* waiting for the I/O lock of the instance */
+        SYNC,    /* waiting in the quantum keeper */
+        IDLE,    /* waiting for work */
+        OTHER,   /* the rest of the CPU loop (e.g. taking the iothread lock) */
+        NB_STATES,
+    };
+
+    static const char* state_name(State s)
+    {
+        static const char* names[NB_STATES] = { "tcg", "io", "io_lock", "sync", "idle", "other" };
+        return names[s];
+    }
+
+    struct Event {
+        uint64_t start;
+        uint64_t end;
+        State state;
+    };
+
+    /* Timestamp in ticks, see QemuVcpuProfiler for the conversion */
+    static uint64_t now()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+#endif
+    }
+
+    /* The profile of the vCPU running on this thread, if being profiled */
+    static QemuVcpuProfile*& current()
+    {
+        thread_local QemuVcpuProfile* p = nullptr;
+        return p;
+    }
+
+    /**
+     * @class Scope
+     *
+     * @brief Move a profile (if any) to a state for the lifetime of the scope
+     */
+    class Scope
+    {
+        QemuVcpuProfile* m_p;
+        State m_prev;
+
+    public:
+        Scope(QemuVcpuProfile* p, State s): m_p(p), m_prev(p ? p->enter(s) : OTHER) {}
+        ~Scope()
+        {
+            if (m_p) m_p->enter(m_prev);
+        }
+        Scope(const Scope&) = delete;
+    };
+
+private:
+    std::string m_name;
+    State m_state = OTHER;
+    uint64_t m_since;
+    std::atomic<uint64_t> m_totals[NB_STATES];
+
+    std::vector<Event> m_events;
+    std::atomic<size_t> m_nb_events{ 0 };
+
+public:
+    QemuVcpuProfile(const std::string& name, size_t max_events, State s)
+        : m_name(name), m_state(s), m_since(now()), m_events(max_events)
+    {
+        for (auto& t : m_totals) {
+            t.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    QemuVcpuProfile(const QemuVcpuProfile&) = delete;
+
+    const std::string& name() const { return m_name; }
+
+    /* Move to state s, returns the previous state */
+    State enter(State s)
+    {
+        uint64_t t = now();
+        State prev = m_state;
+
+        /* single writer: no need for an atomic add */
+        m_totals[prev].store(m_totals[prev].load(std::memory_order_relaxed) + (t - m_since),
+                             std::memory_order_relaxed);
+
+        size_t n = m_nb_events.load(std::memory_order_relaxed);
+        if (n < m_events.size()) {
+            m_events[n] = { m_since, t, prev };
+            m_nb_events.store(n + 1, std::memory_order_release);
+        }
+
+        m_state = s;
+        m_since = t;
+        return prev;
+    }
+
+    uint64_t total(State s) const { return m_totals[s].load(std::memory_order_relaxed); }
+
+    size_t nb_events() const { return m_nb_events.load(std::memory_order_acquire); }
+    const Event& event(size_t i) const { return m_events[i]; }
+    bool timeline_full() const { return m_events.size() && nb_events() == m_events.size(); }
+};
+
+/**
+ * @class QemuVcpuProfiler
+ *
+ * @brief The vCPU profiles of a QEMU instance
+ *
+ * @details Converts the ticks to host time by comparing the ticks elapsed
+ * since its creation with the monotonic clock, and outputs a summary table
+ * and a timeline in the Chrome trace event format (which Perfetto and
+ * chrome://tracing open).
+ */
+class QemuVcpuProfiler
+{
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<QemuVcpuProfile>> m_profiles;
+    size_t m_max_events;
+
+    uint64_t m_start_ticks;
+    std::chrono::steady_clock::time_point m_start_time;
+
+    /* ns per tick, measured over the whole run */
+    double ns_per_tick()
+    {
+        uint64_t ticks = QemuVcpuProfile::now() - m_start_ticks;
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - m_start_time).count();
+        return ticks ? ns / ticks : 1.0;
+    }
+
+public:
+    /* max_events: size of the timeline of each vCPU, 0 to disable it */
+    QemuVcpuProfiler(size_t max_events)
+        : m_max_events(max_events)
+        , m_start_ticks(QemuVcpuProfile::now())
+        , m_start_time(std::chrono::steady_clock::now())
+    {
+    }
+
+    QemuVcpuProfile* new_profile(const std::string& name, QemuVcpuProfile::State s)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_profiles.emplace_back(new QemuVcpuProfile(name, m_max_events, s));
+        return m_profiles.back().get();
+    }
+
+    /* The profiles, in creation order */
+    std::vector<const QemuVcpuProfile*> profiles()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<const QemuVcpuProfile*> ret;
+        for (auto& p : m_profiles) {
+            ret.push_back(p.get());
+        }
+        return ret;
+    }
+
+    /* One line per vCPU: the host time (in ms) and share spent in each state */
+    std::string summary()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        double ms_per_tick = ns_per_tick() / 1e6;
+        std::ostringstream os;
+
+        size_t w = 4;
+        for (auto& p : m_profiles) {
+            w = std::max(w, p->name().size());
+        }
+
+        os << std::left << std::setw(w) << "vCPU" << std::right;
+        for (int s = 0; s < QemuVcpuProfile::NB_STATES; s++) {
+            os << std::setw(20) << QemuVcpuProfile::state_name(QemuVcpuProfile::State(s));
+        }
+        os << std::setw(12) << "total" << "\n";
+
+        os << std::fixed << std::setprecision(1);
+        for (auto& p : m_profiles) {
+            uint64_t total = 0;
+            for (int s = 0; s < QemuVcpuProfile::NB_STATES; s++) {
+                total += p->total(QemuVcpuProfile::State(s));
+            }
+            os << std::left << std::setw(w) << p->name() << std::right;
+            for (int s = 0; s < QemuVcpuProfile::NB_STATES; s++) {
+                uint64_t t = p->total(QemuVcpuProfile::State(s));
+                std::ostringstream cell;
+                cell << std::fixed << std::setprecision(1) << t * ms_per_tick << "ms ("
+                     << (total ? 100.0 * t / total : 0.0) << "%)";
+                os << std::setw(20) << cell.str();
+            }
+            os << std::setw(10) << total * ms_per_tick << "ms\n";
+        }
+        return os.str();
+    }
+
+    /* Write the timelines in the Chrome trace event format, one thread per vCPU */
+    bool write_trace(const std::string& fname)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        double us_per_tick = ns_per_tick() / 1e3;
+
+        FILE* f = fopen(fname.c_str(), "w");
+        if (!f) {
+            return false;
+        }
+
+        fprintf(f, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+        const char* sep = "";
+        for (size_t tid = 0; tid < m_profiles.size(); tid++) {
+            QemuVcpuProfile& p = *m_profiles[tid];
+            fprintf(f, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %zu, "
+                       "\"args\": {\"name\": \"%s\"}}",
+                    sep, tid, p.name().c_str());
+            sep = ",\n";
+            if (p.timeline_full()) {
+                fprintf(f, ",\n{\"name\": \"timeline full\", \"ph\": \"i\", \"s\": \"t\", \"pid\": 0, \"tid\": %zu, "
+                           "\"ts\": %.3f}",
+                        tid, (p.event(p.nb_events() - 1).end - m_start_ticks) * us_per_tick);
+            }
+            size_t n = p.nb_events();
+            for (size_t i = 0; i < n; i++) {
+                const QemuVcpuProfile::Event& e = p.event(i);
+                if (e.start < m_start_ticks) {
+                    continue;
+                }
+                fprintf(f, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 0, \"tid\": %zu, \"ts\": %.3f, \"dur\": %.3f}",
+                        QemuVcpuProfile::state_name(e.state), tid, (e.start - m_start_ticks) * us_per_tick,
+                        (e.end - e.start) * us_per_tick);
+            }
+        }
+        fprintf(f, "\n]}\n");
+        return fclose(f) == 0;
+    }
+};
+
+#endif
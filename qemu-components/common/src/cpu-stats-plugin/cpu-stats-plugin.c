@@ -0,0 +1,143 @@
+/*
+ * This file is part of libqemu-cxx
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * TCG plugin counting the instructions and translation blocks executed, and
+ * the translation blocks translated, by each vCPU into the counters given by
+ * libqemu-cxx (see libqemu-cxx/cpu-stats.h).
+ *
+ * The instructions are counted when a TB is entered, an exit in the middle of
+ * a TB (e.g. an I/O or an exception) counts the whole TB. QEMU gives no vCPU
+ * index to the translation callback, the translation is counted for the last
+ * vCPU that executed a TB on the same thread.
+ *
+ * The instruction budgets are checked at the same place: the callback is
+ * called once the TB which reaches the budget is entered.
+ *
+ * The control of the virtual clock needs the time control API of the
+ * plugins (QEMU_PLUGIN_VERSION 3), without it the clock keeps following the
+ * host time.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <qemu-plugin.h>
+
+#include <libqemu-cxx/cpu-stats.h>
+
+QEMU_PLUGIN_EXPORT int qemu_plugin_version = QEMU_PLUGIN_VERSION;
+
+/*
+ * The plugin is loaded once in the process, but installed by every QEMU
+ * instance which counts its vCPUs (and each one numbers its vCPUs from 0):
+ * every install has its own counters. The translation callback finds them
+ * from the plugin id, the execution callback from its userdata, which holds
+ * the install and the number of instructions of the TB.
+ */
+#define MAX_INSTALLS 64
+#define UDATA_INSNS_BITS 16 /* more than TCG_MAX_INSNS */
+
+typedef struct Install {
+    qemu_plugin_id_t id;
+    LibQemuCpuStats* stats;
+    LibQemuCpuStatsCtrl* ctrl;
+    unsigned int max_cpus;
+} Install;
+
+static Install installs[MAX_INSTALLS];
+static unsigned int n_installs;
+
+static __thread unsigned int current_vcpu;
+
+static void tb_exec(unsigned int vcpu_index, void* udata)
+{
+    Install* in = &installs[(uintptr_t)udata >> UDATA_INSNS_BITS];
+    uint64_t n_insns = (uintptr_t)udata & ((1 << UDATA_INSNS_BITS) - 1);
+
+    if (vcpu_index >= in->max_cpus) {
+        return;
+    }
+    current_vcpu = vcpu_index;
+    LibQemuCpuStats* s = &in->stats[vcpu_index];
+    __atomic_fetch_add(&s->tbs_executed, 1, __ATOMIC_RELAXED);
+    uint64_t insns = __atomic_add_fetch(&s->insns, n_insns, __ATOMIC_RELAXED);
+
+    uint64_t budget = __atomic_load_n(&s->budget, __ATOMIC_RELAXED);
+    if (budget && insns >= budget && in->ctrl) {
+        __atomic_store_n(&s->budget, 0, __ATOMIC_RELAXED);
+        in->ctrl->budget_cb(in->ctrl->opaque, vcpu_index);
+    }
+}
+
+static void tb_trans(qemu_plugin_id_t id, struct qemu_plugin_tb* tb)
+{
+    unsigned int n = __atomic_load_n(&n_installs, __ATOMIC_ACQUIRE);
+    uintptr_t i;
+
+    for (i = 0; i < n && installs[i].id != id; i++) {
+    }
+    if (i == n) {
+        return;
+    }
+
+    uintptr_t n_insns = qemu_plugin_tb_n_insns(tb);
+    if (current_vcpu < installs[i].max_cpus) {
+        __atomic_fetch_add(&installs[i].stats[current_vcpu].tbs_translated, 1, __ATOMIC_RELAXED);
+    }
+    qemu_plugin_register_vcpu_tb_exec_cb(tb, tb_exec, QEMU_PLUGIN_CB_NO_REGS,
+                                         (void*)((i << UDATA_INSNS_BITS) | n_insns));
+}
+
+#if QEMU_PLUGIN_VERSION >= 3
+static void set_clock(const void* handle, int64_t ns) { qemu_plugin_update_ns(handle, ns); }
+#endif
+
+QEMU_PLUGIN_EXPORT int qemu_plugin_install(qemu_plugin_id_t id, const qemu_info_t* info, int argc, char** argv)
+{
+    Install in = { id, NULL, NULL, 0 };
+
+    for (int i = 0; i < argc; i++) {
+        if (strncmp(argv[i], "stats=", 6) == 0) {
+            in.stats = (LibQemuCpuStats*)(uintptr_t)strtoull(argv[i] + 6, NULL, 16);
+        } else if (strncmp(argv[i], "ctrl=", 5) == 0) {
+            in.ctrl = (LibQemuCpuStatsCtrl*)(uintptr_t)strtoull(argv[i] + 5, NULL, 16);
+        } else if (strncmp(argv[i], "max_cpus=", 9) == 0) {
+            in.max_cpus = strtoul(argv[i] + 9, NULL, 10);
+        } else {
+            fprintf(stderr, "cpu-stats plugin: unknown argument %s\n", argv[i]);
+            return -1;
+        }
+    }
+    if (!in.stats || !in.max_cpus) {
+        fprintf(stderr, "cpu-stats plugin: must be loaded by libqemu-cxx\n");
+        return -1;
+    }
+
+    /* the instances are initialized one after the other */
+    unsigned int n = __atomic_load_n(&n_installs, __ATOMIC_RELAXED);
+    if (n == MAX_INSTALLS) {
+        fprintf(stderr, "cpu-stats plugin: more than %d QEMU instances\n", MAX_INSTALLS);
+        return -1;
+    }
+#if QEMU_PLUGIN_VERSION >= 3
+    if (in.ctrl && in.ctrl->time_control) {
+        in.ctrl->clock_handle = qemu_plugin_request_time_control();
+        if (in.ctrl->clock_handle) {
+            in.ctrl->set_clock = set_clock;
+        }
+    }
+#endif
+
+    installs[n] = in;
+    __atomic_store_n(&n_installs, n + 1, __ATOMIC_RELEASE);
+
+    qemu_plugin_register_vcpu_tb_trans_cb(id, tb_trans);
+    return 0;
+}
@@ -62,6 +62,36 @@ void SDL2Console::register_dcl() const { m_int->exports().dcl_register(get_dcl()
 
 void SDL2Console::set_window_id(Console& con) const { m_int->exports().sdl2_console_set_window_id(m_cons, con.m_cons); }
 
+void DisplayListener::init(Console& con, void* user_data) { m_holder.init(con, user_data); }
+
+void DisplayListener::set_dcl_ops(DclOps& dcl_ops) { m_holder.set_dcl_ops(dcl_ops); }
+
+DisplayChangeListener* DisplayListener::get_dcl() const { return m_holder.get_dcl(); }
+
+void DisplayListener::register_dcl() const { m_holder.register_dcl(); }
+
+ConsoleSurface::ConsoleSurface(DisplaySurface* surface, std::shared_ptr<LibQemuInternals>& internals)
+    : m_surface(surface), m_int(internals)
+{
+}
+
+/*
+ * libqemu doesn't export the surface getters of QEMU, which are inline. They
+ * read the pixman image a DisplaySurface starts with (see QEMU's
+ * include/ui/surface.h), so do we.
+ */
+static union pixman_image* surface_image(DisplaySurface* s) { return *reinterpret_cast<union pixman_image**>(s); }
+
+int ConsoleSurface::get_width() const { return m_int->pixman().image_get_width(surface_image(m_surface)); }
+
+int ConsoleSurface::get_height() const { return m_int->pixman().image_get_height(surface_image(m_surface)); }
+
+int ConsoleSurface::get_stride() const { return m_int->pixman().image_get_stride(surface_image(m_surface)); }
+
+void* ConsoleSurface::get_data() const { return m_int->pixman().image_get_data(surface_image(m_surface)); }
+
+uint32_t ConsoleSurface::get_format() const { return m_int->pixman().image_get_format(surface_image(m_surface)); }
+
 DisplayGLCtxOps::DisplayGLCtxOps(::DisplayGLCtxOps* ops, std::shared_ptr<LibQemuInternals>& internals)
     : m_ops(ops), m_int(internals)
 {
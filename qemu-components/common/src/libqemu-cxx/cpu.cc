@@ -94,4 +94,8 @@ bool Cpu::is_in_exclusive_context() const { return m_int->exports().cpu_in_exclu
 
 void Cpu::set_vcpu_dirty(bool dirty) const { m_int->exports().cpu_set_vcpu_dirty(m_obj, dirty); }
 
+CpuStats Cpu::get_stats() const { return m_int->get_inst().get_cpu_stats(get_index()); }
+
+void Cpu::set_insn_budget(uint64_t insns) { m_int->get_inst().set_cpu_insn_budget(get_index(), insns); }
+
 }; // namespace qemu
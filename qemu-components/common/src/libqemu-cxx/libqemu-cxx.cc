@@ -8,10 +8,13 @@
 
 #include <cstring>
 #include <cassert>
+#include <cinttypes>
+#include <cstdio>
 
 #include <libqemu/libqemu.h>
 
 #include <libqemu-cxx/libqemu-cxx.h>
+#include <libqemu-cxx/cpu-stats.h>
 #include <internals.h>
 
 namespace qemu {
@@ -52,6 +55,80 @@ void LibQemu::push_qemu_arg(std::initializer_list<const char*> args)
     }
 }
 
+void LibQemu::enable_cpu_stats(const char* plugin_path)
+{
+    assert(!is_inited());
+
+    if (plugin_path == nullptr) {
+#ifdef LIBQEMU_CPU_STATS_PLUGIN
+        plugin_path = LIBQEMU_CPU_STATS_PLUGIN;
+#else
+        throw LibQemuException("libqemu-cxx was built without the cpu-stats plugin");
+#endif
+    }
+
+    m_cpu_stats.reset(new LibQemuCpuStats[LIBQEMU_CPU_STATS_MAX_CPUS]());
+    m_cpu_stats_ctrl.reset(new LibQemuCpuStatsCtrl{ &LibQemu::cpu_budget_cb, this });
+
+    char arg[96];
+    std::snprintf(arg, sizeof(arg), ",stats=%" PRIxPTR ",max_cpus=%d,ctrl=%" PRIxPTR,
+                  reinterpret_cast<uintptr_t>(m_cpu_stats.get()), LIBQEMU_CPU_STATS_MAX_CPUS,
+                  reinterpret_cast<uintptr_t>(m_cpu_stats_ctrl.get()));
+    push_qemu_arg({ "-plugin", (std::string(plugin_path) + arg).c_str() });
+}
+
+CpuStats LibQemu::get_cpu_stats(int cpu_index) const
+{
+    CpuStats ret;
+
+    if (!m_cpu_stats || cpu_index < 0 || cpu_index >= LIBQEMU_CPU_STATS_MAX_CPUS) {
+        return ret;
+    }
+
+    LibQemuCpuStats& s = m_cpu_stats[cpu_index];
+    ret.insns = __atomic_load_n(&s.insns, __ATOMIC_RELAXED);
+    ret.tbs_executed = __atomic_load_n(&s.tbs_executed, __ATOMIC_RELAXED);
+    ret.tbs_translated = __atomic_load_n(&s.tbs_translated, __ATOMIC_RELAXED);
+    return ret;
+}
+
+void LibQemu::cpu_budget_cb(void* opaque, unsigned int cpu_index)
+{
+    LibQemu* inst = static_cast<LibQemu*>(opaque);
+
+    if (inst->m_cpu_budget_cb) {
+        inst->m_cpu_budget_cb(cpu_index);
+    }
+}
+
+void LibQemu::set_cpu_insn_budget(int cpu_index, uint64_t insns)
+{
+    if (!m_cpu_stats || cpu_index < 0 || cpu_index >= LIBQEMU_CPU_STATS_MAX_CPUS) {
+        return;
+    }
+
+    __atomic_store_n(&m_cpu_stats[cpu_index].budget, insns, __ATOMIC_RELAXED);
+}
+
+void LibQemu::enable_virtual_clock_control()
+{
+    assert(!is_inited());
+
+    if (!m_cpu_stats_ctrl) {
+        throw LibQemuException("The virtual clock control needs the cpu stats");
+    }
+    m_cpu_stats_ctrl->time_control = 1;
+}
+
+bool LibQemu::virtual_clock_controlled() const { return m_cpu_stats_ctrl && m_cpu_stats_ctrl->set_clock; }
+
+void LibQemu::set_virtual_clock(int64_t ns)
+{
+    if (virtual_clock_controlled()) {
+        m_cpu_stats_ctrl->set_clock(m_cpu_stats_ctrl->clock_handle, ns);
+    }
+}
+
 void LibQemu::init()
 {
     const char* libname;
@@ -87,7 +164,7 @@ void LibQemu::init()
     qemu_init = reinterpret_cast<LibQemuInitFct>(m_lib->get_symbol(LIBQEMU_INIT_SYM_STR));
     exports = qemu_init(m_qemu_argv.size(), &m_qemu_argv[0]);
 
-    m_int = std::make_shared<LibQemuInternals>(*this, exports);
+    m_int = std::make_shared<LibQemuInternals>(*this, exports, m_lib);
     init_callbacks();
 }
 
@@ -273,6 +350,29 @@ DclOps LibQemu::dcl_ops_new()
     return DclOps(ops, m_int);
 }
 
+std::vector<DisplayListener> LibQemu::display_listeners_new(int num)
+{
+    /*
+     * libqemu only allocates listeners as part of its SDL2 consoles, which
+     * are used as plain holders: SDL isn't initialized and no window is
+     * created. They are the ones of sdl2_create_consoles, an instance can't
+     * use both.
+     */
+    std::vector<DisplayListener> ret;
+    for (SDL2Console& holder : sdl2_create_consoles(num)) {
+        holder.set_idx(ret.size());
+        holder.set_opengl(false);
+        ret.push_back(DisplayListener(holder));
+    }
+    return ret;
+}
+
+ConsoleSurface LibQemu::surface_new(DisplaySurface* surface)
+{
+    assert(surface != nullptr);
+    return ConsoleSurface(surface, m_int);
+}
+
 void LibQemu::sdl2_2d_update(DisplayChangeListener* dcl, int x, int y, int w, int h)
 {
     m_int->exports().sdl2_2d_update(dcl, x, y, w, h);
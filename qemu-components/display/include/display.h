@@ -19,6 +19,8 @@
 #include <virtio/virtio-mmio-gpugl.h>
 #include <virtio_gpu.h>
 
+#include <headless-display.h>
+
 /**
  * @class MainThreadQemuDisplay
  *
@@ -102,12 +104,35 @@ public:
 
 QemuInstance* MainThreadQemuDisplay::inst = nullptr;
 
+/**
+ * @class display
+ *
+ * @brief Display of a QEMU GPU
+ *
+ * @details By default the GPU is shown in a SDL window. In headless mode the
+ * consoles are kept in memory instead (see HeadlessQemuDisplay), and
+ * optionally captured to files.
+ *
+ * @param @headless : keep the consoles in memory instead of opening a window
+ * @param @capture_dir : directory where the headless captures are written, none if empty
+ * @param @capture_format : "png" or "raw" (binary PPM)
+ * @param @capture_interval_ms : host time between captures, 0 to only capture at the end of simulation
+ * @param @capture_skip_identical : don't capture a frame identical to the previous capture
+ */
 class display : public sc_core::sc_module
 {
+public:
+    cci::cci_param<bool> p_headless;
+    cci::cci_param<std::string> p_capture_dir;
+    cci::cci_param<std::string> p_capture_format;
+    cci::cci_param<uint64_t> p_capture_interval_ms;
+    cci::cci_param<bool> p_capture_skip_identical;
+
 private:
 #ifdef __APPLE__
     MainThreadQemuDisplay m_main_display;
 #endif
+    std::unique_ptr<HeadlessQemuDisplay> m_headless;
 
     display (const sc_core::sc_module_name& name, QemuDevice& gpu);
 
@@ -142,12 +167,17 @@ public:
 
     void start_of_simulation() override;
 
+    void end_of_simulation() override;
+
     QemuInstance* get_qemu_inst();
 
     bool is_instantiated() const;
     bool is_realized() const;
 
     const std::vector<qemu::SDL2Console>* get_sdl2_consoles() const;
+
+    /* The in-memory display in headless mode, nullptr otherwise */
+    HeadlessQemuDisplay* get_headless() { return m_headless.get(); }
 };
 
 extern "C" void module_register();
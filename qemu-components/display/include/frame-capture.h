@@ -0,0 +1,171 @@
+/*
+ * This file is part of libqbox
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _LIBQBOX_COMPONENTS_FRAME_CAPTURE_H
+#define _LIBQBOX_COMPONENTS_FRAME_CAPTURE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+/**
+ * @class FrameCapture
+ *
+ * @brief A copy of a display framebuffer, and its hash and image file
+ * encodings.
+ *
+ * @details Pixels are 32 bits x8r8g8b8 (the top byte is ignored), row after
+ * row without padding.
+ */
+class FrameCapture
+{
+public:
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint32_t> pixels;
+
+    FrameCapture() = default;
+    FrameCapture(uint32_t w, uint32_t h): width(w), height(h), pixels(size_t(w) * h) {}
+
+    bool empty() const { return !width || !height; }
+
+    uint32_t& at(uint32_t x, uint32_t y) { return pixels[size_t(y) * width + x]; }
+
+    /* FNV-1a of the size and the RGB values, the same frame always gives the same hash */
+    uint64_t hash() const
+    {
+        uint64_t h = 0xcbf29ce484222325ull;
+        auto mix = [&h](uint32_t v) {
+            for (int i = 0; i < 4; i++) {
+                h = (h ^ ((v >> (8 * i)) & 0xff)) * 0x100000001b3ull;
+            }
+        };
+        mix(width);
+        mix(height);
+        for (uint32_t p : pixels) {
+            mix(p & 0xffffff);
+        }
+        return h;
+    }
+
+    /* Binary PPM (P6): a short text header followed by the raw RGB bytes */
+    bool write_ppm(const std::string& fname) const
+    {
+        FILE* f = fopen(fname.c_str(), "wb");
+        if (!f) {
+            return false;
+        }
+        fprintf(f, "P6\n%u %u\n255\n", width, height);
+        std::vector<uint8_t> row;
+        bool ok = true;
+        for (uint32_t y = 0; y < height && ok; y++) {
+            rgb_row(y, row);
+            ok = fwrite(row.data(), 1, row.size(), f) == row.size();
+        }
+        return (fclose(f) == 0) && ok;
+    }
+
+    static bool png_supported()
+    {
+#ifdef HAVE_ZLIB
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /* 8 bits RGB PNG, level is the zlib compression level */
+    bool write_png(const std::string& fname, int level = 6) const
+    {
+#ifdef HAVE_ZLIB
+        /* each row is prefixed with its filter type (0: none) */
+        std::vector<uint8_t> raw;
+        raw.reserve(size_t(height) * (1 + 3 * size_t(width)));
+        std::vector<uint8_t> row;
+        for (uint32_t y = 0; y < height; y++) {
+            rgb_row(y, row);
+            raw.push_back(0);
+            raw.insert(raw.end(), row.begin(), row.end());
+        }
+
+        uLongf zlen = compressBound(raw.size());
+        std::vector<uint8_t> z(zlen);
+        if (compress2(z.data(), &zlen, raw.data(), raw.size(), level) != Z_OK) {
+            return false;
+        }
+        z.resize(zlen);
+
+        uint8_t ihdr[13];
+        put_be32(ihdr, width);
+        put_be32(ihdr + 4, height);
+        ihdr[8] = 8;  /* bit depth */
+        ihdr[9] = 2;  /* color type: RGB */
+        ihdr[10] = 0; /* compression */
+        ihdr[11] = 0; /* filter */
+        ihdr[12] = 0; /* no interlace */
+
+        FILE* f = fopen(fname.c_str(), "wb");
+        if (!f) {
+            return false;
+        }
+        static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+        bool ok = fwrite(signature, 1, sizeof(signature), f) == sizeof(signature);
+        ok = ok && write_chunk(f, "IHDR", ihdr, sizeof(ihdr));
+        ok = ok && write_chunk(f, "IDAT", z.data(), z.size());
+        ok = ok && write_chunk(f, "IEND", nullptr, 0);
+        return (fclose(f) == 0) && ok;
+#else
+        return false;
+#endif
+    }
+
+private:
+    void rgb_row(uint32_t y, std::vector<uint8_t>& row) const
+    {
+        row.resize(3 * size_t(width));
+        const uint32_t* p = &pixels[size_t(y) * width];
+        for (uint32_t x = 0; x < width; x++) {
+            row[3 * x] = p[x] >> 16;
+            row[3 * x + 1] = p[x] >> 8;
+            row[3 * x + 2] = p[x];
+        }
+    }
+
+    static void put_be32(uint8_t* b, uint32_t v)
+    {
+        b[0] = v >> 24;
+        b[1] = v >> 16;
+        b[2] = v >> 8;
+        b[3] = v;
+    }
+
+#ifdef HAVE_ZLIB
+    static bool write_chunk(FILE* f, const char* type, const uint8_t* data, size_t len)
+    {
+        uint8_t hdr[8];
+        put_be32(hdr, len);
+        for (int i = 0; i < 4; i++) {
+            hdr[4 + i] = type[i];
+        }
+        /* the CRC covers the type and the data */
+        uLong crc = crc32(0, hdr + 4, 4);
+        if (len) {
+            crc = crc32(crc, data, len);
+        }
+        uint8_t tail[4];
+        put_be32(tail, crc);
+        return fwrite(hdr, 1, 8, f) == 8 && (!len || fwrite(data, 1, len, f) == len) && fwrite(tail, 1, 4, f) == 4;
+    }
+#endif
+};
+
+#endif // _LIBQBOX_COMPONENTS_FRAME_CAPTURE_H
@@ -0,0 +1,119 @@
+/*
+ * This file is part of libqbox
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _LIBQBOX_COMPONENTS_HEADLESS_DISPLAY_H
+#define _LIBQBOX_COMPONENTS_HEADLESS_DISPLAY_H
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <systemc>
+#include <scp/report.h>
+
+#include <libqemu/libqemu.h>
+#include <qemu-instance.h>
+
+#include <frame-capture.h>
+
+union pixman_image;
+
+/**
+ * @class HeadlessQemuDisplay
+ *
+ * @brief A display listener keeping the consoles of a QEMU instance in memory
+ *
+ * @details Registers one display change listener per QEMU console. Its
+ * callbacks run on the QEMU thread updating the display (with the iothread
+ * lock held), and copy the dirty rectangles of the console surface into a
+ * framebuffer. Nothing goes through SystemC, no window or GPU is needed.
+ *
+ * A host thread periodically captures the framebuffers which changed, hashes
+ * them and writes them as PNG or PPM files.
+ */
+class HeadlessQemuDisplay
+{
+public:
+    struct Config {
+        std::string dir;      /* where to write the captures, none if empty */
+        std::string format;   /* "png" or "raw" (PPM) */
+        uint64_t interval_ms; /* host time between captures, 0 for the end of simulation only */
+        bool skip_identical;  /* don't write a capture identical to the previous one */
+    };
+
+private:
+    struct Console {
+        HeadlessQemuDisplay* display;
+        int idx;
+
+        std::mutex mutex;
+        pixman_image* surface_image = nullptr; /* the pixels of the QEMU surface */
+        FrameCapture fb;
+        pixman_image* fb_image = nullptr;
+        uint64_t updates = 0;
+
+        /* capture side */
+        uint64_t captured = 0;
+        uint64_t last_hash = 0;
+        unsigned nb_captures = 0;
+    };
+
+    std::string m_name;
+    QemuInstance& m_inst;
+    qemu::DclOps m_ops;
+    std::vector<qemu::DisplayListener> m_listeners;
+    std::vector<std::unique_ptr<Console>> m_consoles;
+    bool m_realized = false;
+
+    Config m_config;
+    std::mutex m_thread_mutex;
+    std::condition_variable m_cond;
+    bool m_stop = false;
+    std::thread m_capturer;
+
+    static void gfx_switch(DisplayChangeListener* dcl, DisplaySurface* new_surface);
+    static void gfx_update(DisplayChangeListener* dcl, int x, int y, int w, int h);
+
+    static Console* console_of(DisplayChangeListener* dcl);
+    void copy_rect(Console& c, int x, int y, int w, int h);
+    void capture_all();
+    void capturer();
+
+public:
+    /* name: used in the messages and as the prefix of the capture files */
+    HeadlessQemuDisplay(const std::string& name, QemuInstance& inst);
+    ~HeadlessQemuDisplay();
+
+    HeadlessQemuDisplay(const HeadlessQemuDisplay&) = delete;
+
+    /* Register the listeners, the graphic devices must be realized */
+    void realize();
+
+    /* Start capturing, with the given configuration */
+    void start(const Config& config);
+
+    /* Stop capturing, and capture the frames which changed since the last capture */
+    void stop();
+
+    bool is_realized() const { return m_realized; }
+
+    size_t nb_consoles() const { return m_consoles.size(); }
+
+    /* A copy of the current framebuffer of a console */
+    FrameCapture snapshot(size_t console);
+
+    /* Number of updates received by a console */
+    uint64_t nb_updates(size_t console);
+
+    /* Hash of the last frame captured from a console, 0 if none */
+    uint64_t last_hash(size_t console);
+};
+
+#endif // _LIBQBOX_COMPONENTS_HEADLESS_DISPLAY_H
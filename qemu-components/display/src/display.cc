@@ -215,15 +215,27 @@ void MainThreadQemuDisplay::realize()
 
 display::display(const sc_core::sc_module_name& name, sc_core::sc_object* o)
     : sc_module(name)
+    , p_headless("headless", false, "Keep the consoles in memory instead of opening a window")
+    , p_capture_dir("capture_dir", "", "Directory where the headless captures are written, none if empty")
+    , p_capture_format("capture_format", "png", "Format of the headless captures: png or raw (binary PPM)")
+    , p_capture_interval_ms("capture_interval_ms", 1000,
+                            "Host time between headless captures, 0 to only capture at the end of simulation")
+    , p_capture_skip_identical("capture_skip_identical", true,
+                               "Don't capture a frame identical to the previous capture")
 #ifdef __APPLE__
     // On MacOS use libqbox's display SystemC module.
     , m_main_display(o)
 #endif
 {
+    QemuDevice* gpu = (dynamic_cast<QemuDevice*>(o));
+    if (p_headless) {
+        // QEMU keeps its default "-display none", our listeners are registered at end of elaboration
+        m_headless = std::make_unique<HeadlessQemuDisplay>(this->name(), gpu->get_qemu_inst());
+        return;
+    }
 #ifndef __APPLE__
     // Use QEMU's integrated display only if we are NOT on MacOS.
     // On MacOS use libqbox's display SystemC module.
-    QemuDevice* gpu = (dynamic_cast<QemuDevice*>(o));
     gpu->get_qemu_inst().set_display_arg("sdl,gl=on");
 #endif
 }
@@ -246,12 +258,18 @@ display::display(const sc_core::sc_module_name& name, QemuVirtioMMIOGpuGl& gpu)
 void display::before_end_of_elaboration()
 {
 #ifdef __APPLE__
-    m_main_display.instantiate();
+    if (!m_headless) {
+        m_main_display.instantiate();
+    }
 #endif
 }
 
 void display::end_of_elaboration()
 {
+    if (m_headless) {
+        m_headless->realize();
+        return;
+    }
 #ifdef __APPLE__
     m_main_display.realize();
 #endif
@@ -259,11 +277,23 @@ void display::end_of_elaboration()
 
 void display::start_of_simulation()
 {
+    if (m_headless) {
+        m_headless->start({ p_capture_dir.get_value(), p_capture_format.get_value(), p_capture_interval_ms.get_value(),
+                            p_capture_skip_identical.get_value() });
+        return;
+    }
 #ifdef __APPLE__
     m_main_display.start_of_simulation();
 #endif
 }
 
+void display::end_of_simulation()
+{
+    if (m_headless) {
+        m_headless->stop();
+    }
+}
+
 QemuInstance* display::get_qemu_inst()
 {
 #ifdef __APPLE__
@@ -276,7 +306,7 @@ QemuInstance* display::get_qemu_inst()
 bool display::is_instantiated() const
 {
 #ifdef __APPLE__
-    return m_main_display.is_instantiated();
+    return m_headless || m_main_display.is_instantiated();
 #else
     return true;
 #endif
@@ -284,6 +314,9 @@ bool display::is_instantiated() const
 
 bool display::is_realized() const
 {
+    if (m_headless) {
+        return m_headless->is_realized();
+    }
 #ifdef __APPLE__
     return m_main_display.is_realized();
 #else
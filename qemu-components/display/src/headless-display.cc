@@ -0,0 +1,307 @@
+/*
+ * This file is part of libqbox
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <headless-display.h>
+
+#ifdef HAVE_PIXMAN
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <map>
+
+#include <sys/stat.h>
+
+#include <pixman.h>
+
+/*
+ * The callbacks are shared by all the instances, find the console of a
+ * listener. The map only changes during elaboration and teardown.
+ */
+static std::mutex s_listeners_mutex;
+static std::map<DisplayChangeListener*, void*> s_listeners;
+
+HeadlessQemuDisplay::Console* HeadlessQemuDisplay::console_of(DisplayChangeListener* dcl)
+{
+    std::lock_guard<std::mutex> lock(s_listeners_mutex);
+    auto it = s_listeners.find(dcl);
+    return it == s_listeners.end() ? nullptr : static_cast<Console*>(it->second);
+}
+
+HeadlessQemuDisplay::HeadlessQemuDisplay(const std::string& name, QemuInstance& inst): m_name(name), m_inst(inst) {}
+
+HeadlessQemuDisplay::~HeadlessQemuDisplay()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_thread_mutex);
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    if (m_capturer.joinable()) {
+        m_capturer.join();
+    }
+
+    if (!m_realized) {
+        return;
+    }
+
+    // The listeners stay registered in QEMU, make them do nothing
+    m_ops.set_name("deleted");
+    m_ops.set_gfx_switch(nullptr);
+    m_ops.set_gfx_update(nullptr);
+
+    std::lock_guard<std::mutex> lock(s_listeners_mutex);
+    for (size_t i = 0; i < m_listeners.size(); i++) {
+        s_listeners.erase(m_listeners[i].get_dcl());
+    }
+    for (auto& c : m_consoles) {
+        if (c->surface_image) {
+            pixman_image_unref(c->surface_image);
+        }
+        if (c->fb_image) {
+            pixman_image_unref(c->fb_image);
+        }
+    }
+}
+
+void HeadlessQemuDisplay::realize()
+{
+    if (m_realized) {
+        return;
+    }
+
+    qemu::LibQemu& lib = m_inst.get();
+
+    std::vector<qemu::Console> consoles;
+    for (qemu::Console& cons : lib.get_all_consoles()) {
+        if (cons.is_graphic()) {
+            consoles.push_back(cons);
+        }
+    }
+    if (consoles.empty()) {
+        SCP_WARN() << m_name << ": no graphic console to display. Please make sure the graphics device is "
+                                "realized before the display.";
+        return;
+    }
+
+    m_ops = lib.dcl_ops_new();
+    m_ops.set_name("headless");
+    m_ops.set_gfx_switch(&gfx_switch);
+    m_ops.set_gfx_update(&gfx_update);
+
+    m_listeners = lib.display_listeners_new(consoles.size());
+
+    for (size_t i = 0; i < consoles.size(); i++) {
+        m_consoles.emplace_back(new Console());
+        Console* c = m_consoles.back().get();
+        c->display = this;
+        c->idx = i;
+
+        qemu::DisplayListener& listener = m_listeners[i];
+        listener.init(consoles[i], c);
+        listener.set_dcl_ops(m_ops);
+        {
+            std::lock_guard<std::mutex> lock(s_listeners_mutex);
+            s_listeners[listener.get_dcl()] = c;
+        }
+
+        // Registering switches the listener to the current surface
+        listener.register_dcl();
+    }
+
+    m_realized = true;
+}
+
+void HeadlessQemuDisplay::gfx_switch(DisplayChangeListener* dcl, DisplaySurface* new_surface)
+{
+    Console* c = console_of(dcl);
+    if (!c) {
+        return;
+    }
+
+    uint32_t w = 0, h = 0;
+    {
+        std::lock_guard<std::mutex> lock(c->mutex);
+        if (c->surface_image) {
+            pixman_image_unref(c->surface_image);
+            c->surface_image = nullptr;
+        }
+        if (!new_surface) {
+            return;
+        }
+
+        // Read the pixels of the surface in place
+        qemu::ConsoleSurface surface = c->display->m_inst.get().surface_new(new_surface);
+        w = surface.get_width();
+        h = surface.get_height();
+        c->surface_image = pixman_image_create_bits(static_cast<pixman_format_code_t>(surface.get_format()), w, h,
+                                                    static_cast<uint32_t*>(surface.get_data()), surface.get_stride());
+
+        if (w != c->fb.width || h != c->fb.height) {
+            if (c->fb_image) {
+                pixman_image_unref(c->fb_image);
+                c->fb_image = nullptr;
+            }
+            c->fb = FrameCapture(w, h);
+            if (!c->fb.empty()) {
+                c->fb_image = pixman_image_create_bits(PIXMAN_x8r8g8b8, w, h, c->fb.pixels.data(), w * 4);
+            }
+        }
+    }
+
+    c->display->copy_rect(*c, 0, 0, w, h);
+}
+
+void HeadlessQemuDisplay::gfx_update(DisplayChangeListener* dcl, int x, int y, int w, int h)
+{
+    Console* c = console_of(dcl);
+    if (c) {
+        c->display->copy_rect(*c, x, y, w, h);
+    }
+}
+
+void HeadlessQemuDisplay::copy_rect(Console& c, int x, int y, int w, int h)
+{
+    std::lock_guard<std::mutex> lock(c.mutex);
+    if (!c.surface_image || !c.fb_image) {
+        return;
+    }
+
+    // Clip to the framebuffer, and let pixman convert from the surface format
+    int x0 = std::max(x, 0), y0 = std::max(y, 0);
+    int x1 = std::min<int>(x + w, c.fb.width), y1 = std::min<int>(y + h, c.fb.height);
+    if (x1 <= x0 || y1 <= y0) {
+        return;
+    }
+    pixman_image_composite32(PIXMAN_OP_SRC, c.surface_image, nullptr, c.fb_image, x0, y0, 0, 0, x0, y0,
+                             x1 - x0, y1 - y0);
+    c.updates++;
+}
+
+void HeadlessQemuDisplay::capture_all()
+{
+    for (auto& cp : m_consoles) {
+        Console& c = *cp;
+        FrameCapture frame;
+        {
+            std::lock_guard<std::mutex> lock(c.mutex);
+            if (c.updates == c.captured) {
+                continue;
+            }
+            c.captured = c.updates;
+            frame = c.fb;
+        }
+        if (frame.empty()) {
+            continue;
+        }
+
+        uint64_t hash = frame.hash();
+        if (m_config.skip_identical && hash == c.last_hash) {
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(c.mutex);
+            c.last_hash = hash;
+        }
+
+        char hex[17];
+        snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)hash);
+        SCP_INFO() << m_name << ": console " << c.idx << " frame " << c.nb_captures << " " << frame.width << "x"
+                   << frame.height << " hash " << hex;
+
+        if (!m_config.dir.empty()) {
+            char seq[16];
+            snprintf(seq, sizeof(seq), "%05u", c.nb_captures);
+            bool png = m_config.format == "png";
+            std::string fname = m_config.dir + "/" + m_name + "." + std::to_string(c.idx) + "." + seq +
+                                (png ? ".png" : ".ppm");
+            if (!(png ? frame.write_png(fname) : frame.write_ppm(fname))) {
+                SCP_WARN() << m_name << ": unable to write the capture " << fname;
+            }
+        }
+        c.nb_captures++;
+    }
+}
+
+void HeadlessQemuDisplay::capturer()
+{
+    std::unique_lock<std::mutex> lock(m_thread_mutex);
+    while (!m_cond.wait_for(lock, std::chrono::milliseconds(m_config.interval_ms), [this] { return m_stop; })) {
+        capture_all();
+    }
+}
+
+void HeadlessQemuDisplay::start(const Config& config)
+{
+    m_config = config;
+
+    if (m_config.format != "png" && m_config.format != "raw") {
+        SCP_FATAL() << m_name << ": unknown capture format '" << m_config.format << "' (png or raw)";
+    }
+    if (m_config.format == "png" && !FrameCapture::png_supported()) {
+        SCP_WARN() << m_name << ": built without zlib, writing raw captures instead of PNG";
+        m_config.format = "raw";
+    }
+    if (!m_config.dir.empty() && mkdir(m_config.dir.c_str(), 0777) != 0 && errno != EEXIST) {
+        SCP_WARN() << m_name << ": unable to create the capture directory " << m_config.dir;
+    }
+
+    if (m_realized && m_config.interval_ms && !m_capturer.joinable()) {
+        m_capturer = std::thread(&HeadlessQemuDisplay::capturer, this);
+    }
+}
+
+void HeadlessQemuDisplay::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_thread_mutex);
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    if (m_capturer.joinable()) {
+        m_capturer.join();
+    }
+    capture_all();
+}
+
+FrameCapture HeadlessQemuDisplay::snapshot(size_t console)
+{
+    Console& c = *m_consoles.at(console);
+    std::lock_guard<std::mutex> lock(c.mutex);
+    return c.fb;
+}
+
+uint64_t HeadlessQemuDisplay::nb_updates(size_t console)
+{
+    Console& c = *m_consoles.at(console);
+    std::lock_guard<std::mutex> lock(c.mutex);
+    return c.updates;
+}
+
+uint64_t HeadlessQemuDisplay::last_hash(size_t console)
+{
+    Console& c = *m_consoles.at(console);
+    std::lock_guard<std::mutex> lock(c.mutex);
+    return c.last_hash;
+}
+
+#else
+
+HeadlessQemuDisplay::HeadlessQemuDisplay(const std::string& name, QemuInstance& inst): m_name(name), m_inst(inst)
+{
+    SCP_FATAL() << m_name << ": the headless display needs pixman, which was not found at build time";
+}
+
+HeadlessQemuDisplay::~HeadlessQemuDisplay() {}
+void HeadlessQemuDisplay::realize() {}
+void HeadlessQemuDisplay::start(const Config& config) {}
+void HeadlessQemuDisplay::stop() {}
+FrameCapture HeadlessQemuDisplay::snapshot(size_t console) { return FrameCapture(); }
+uint64_t HeadlessQemuDisplay::nb_updates(size_t console) { return 0; }
+uint64_t HeadlessQemuDisplay::last_hash(size_t console) { return 0; }
+
+#endif
@@ -15,6 +15,7 @@
 #include <libgssync.h>
 
 #include <qemu_gpex.h>
+#include <block-backend.h>
 
 class nvme_disk : public qemu_gpex::Device
 {
@@ -23,7 +24,7 @@ protected:
     cci::cci_param<std::string> p_serial;
     cci::cci_param<std::string> p_blob_file;
     cci::cci_param<uint32_t> max_ioqpairs;
-    std::string m_drive_id;
+    QemuBlockBackend m_drive;
 
 public:
     nvme_disk(const sc_core::sc_module_name& name, sc_core::sc_object* o)
@@ -35,15 +36,9 @@ public:
         , p_serial("serial", basename(), "Serial name of the nvme disk")
         , p_blob_file("blob_file", "", "Blob file to load as data storage")
         , max_ioqpairs("max_ioqpairs", 64, "Passed through to QEMU max_ioqpairs")
-        , m_drive_id(basename())
+        , m_drive(inst, std::string(basename()) + "_drive", false)
     {
-        m_drive_id += "_drive";
-        std::string file = p_blob_file;
-
-        std::stringstream opts;
-        opts << "if=sd,id=" << m_drive_id << ",file=" << file << ",format=raw";
-        m_inst.add_arg("-drive");
-        m_inst.add_arg(opts.str().c_str());
+        m_drive.add_drive(p_blob_file, "sd");
     }
 
     void before_end_of_elaboration() override
@@ -52,7 +47,7 @@ public:
 
         std::string serial = p_serial;
         m_dev.set_prop_str("serial", serial.c_str());
-        m_dev.set_prop_parse("drive", m_drive_id.c_str());
+        m_drive.set_device_props(m_dev);
         m_dev.set_prop_int("max_ioqpairs", max_ioqpairs);
     }
 
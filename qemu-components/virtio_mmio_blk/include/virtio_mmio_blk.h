@@ -18,12 +18,15 @@
 #include <virtio/virtio-mmio.h>
 #include <qemu-instance.h>
 #include <module_factory_registery.h>
+#include <block-backend.h>
 
 class virtio_mmio_blk : public QemuVirtioMMIO
 {
 private:
     std::string blkdev_id;
     cci::cci_param<std::string> blkdev_str;
+    cci::cci_param<std::string> p_blob_file;
+    QemuBlockBackend m_drive;
 
 public:
     virtio_mmio_blk(const sc_core::sc_module_name& name, sc_core::sc_object* o)
@@ -34,7 +37,19 @@ public:
         : QemuVirtioMMIO(nm, inst, "virtio-blk-device")
         , blkdev_id(std::string(name()) + "-id")
         , blkdev_str("blkdev_str", "", "blkdev string for QEMU (do not specify ID)")
+        , p_blob_file("blob_file", "", "Image of the disk, with the drive options of the parameters (see blkdev_str)")
+        , m_drive(inst, blkdev_id, true)
     {
+        if (!p_blob_file.get_value().empty()) {
+            if (!blkdev_str.get_value().empty()) {
+                SCP_FATAL(()) << "blkdev_str and blob_file are exclusive";
+            }
+            m_drive.add_drive(p_blob_file);
+            return;
+        }
+
+        m_drive.check_unused("blkdev_str");
+
         std::stringstream opts;
         opts << blkdev_str.get_value();
         opts << ",id=" << blkdev_id;
@@ -47,7 +62,7 @@ public:
     {
         QemuVirtioMMIO::before_end_of_elaboration();
 
-        m_dev.set_prop_parse("drive", blkdev_id.c_str());
+        m_drive.set_device_props(m_dev);
     }
 };
 
@@ -0,0 +1,11 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <backends/net-switch.h>
+
+typedef NetworkSwitch net_switch;
+
+void module_register() { GSC_MODULE_REGISTER_C(net_switch); }
\ No newline at end of file
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _GREENSOCS_BASE_COMPONENTS_CHECKPOINT_H
+#define _GREENSOCS_BASE_COMPONENTS_CHECKPOINT_H
+
+#include <chrono>
+#include <string>
+
+#include <cci_configuration>
+#include <systemc>
+#include <scp/report.h>
+
+#include <module_factory_registery.h>
+#include <checkpoint/checkpoint.h>
+
+namespace gs {
+
+/**
+ * @class checkpoint
+ *
+ * @brief Saves the platform to a checkpoint at a given SystemC time, and/or
+ * restores it from a checkpoint (see checkpoint/checkpoint.h).
+ *
+ * @details A checkpoint must be restored by the same platform, with the same
+ * configuration (except for the checkpoint parameters). When restoring,
+ * SystemC first runs to the checkpoint time with the CPUs stopped, then the
+ * components are restored and the platform resumes.
+ *
+ * The module must be constructed before the end of elaboration, for the
+ * other components to know whether a checkpoint is being restored.
+ *
+ * @param @save_dir : directory where to save a checkpoint, no checkpoint is saved if empty
+ * @param @save_at_ns : SystemC time at which the checkpoint is saved
+ * @param @exit_after_save : stop the simulation once the checkpoint is saved
+ * @param @restore_dir : checkpoint to restore, if any
+ */
+class checkpoint : public sc_core::sc_module
+{
+    SCP_LOGGER(());
+
+public:
+    cci::cci_param<std::string> p_save_dir;
+    cci::cci_param<uint64_t> p_save_at_ns;
+    cci::cci_param<bool> p_exit_after_save;
+    cci::cci_param<std::string> p_restore_dir;
+
+private:
+    sc_core::sc_event m_resume_ev;
+
+    void run()
+    {
+        ckpt::registry& reg = ckpt::registry::get();
+
+        if (reg.restoring()) {
+            auto start = std::chrono::steady_clock::now();
+            SCP_INFO(()) << "Running to the checkpoint time " << reg.restore_time();
+            wait(reg.restore_time() - sc_core::sc_time_stamp());
+            reg.restore_all();
+            SCP_INFO(()) << "Restored " << reg.restore_dir() << " at " << sc_core::sc_time_stamp() << " in "
+                         << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << "s";
+        }
+
+        if (!p_save_dir.get_value().empty()) {
+            sc_core::sc_time at(p_save_at_ns.get_value(), sc_core::SC_NS);
+            if (at > sc_core::sc_time_stamp()) {
+                wait(at - sc_core::sc_time_stamp());
+            }
+            save(p_save_dir);
+            if (p_exit_after_save) {
+                sc_core::sc_stop();
+            }
+        }
+    }
+
+public:
+    checkpoint(const sc_core::sc_module_name& nm)
+        : sc_core::sc_module(nm)
+        , p_save_dir("save_dir", "", "Directory where to save a checkpoint, none is saved if empty")
+        , p_save_at_ns("save_at_ns", 0, "SystemC time at which the checkpoint is saved, in ns")
+        , p_exit_after_save("exit_after_save", true, "Stop the simulation once the checkpoint is saved")
+        , p_restore_dir("restore_dir", "", "Checkpoint to restore, if any")
+    {
+        ckpt::registry& reg = ckpt::registry::get();
+        reg.enable();
+        if (!p_restore_dir.get_value().empty()) {
+            reg.open(p_restore_dir, m_resume_ev);
+        }
+
+        SC_HAS_PROCESS(checkpoint);
+        SC_THREAD(run);
+    }
+
+    checkpoint() = delete;
+    checkpoint(const checkpoint&) = delete;
+
+    /* Save the platform now, from a SystemC thread */
+    void save(const std::string& dir)
+    {
+        auto start = std::chrono::steady_clock::now();
+        ckpt::registry::get().save_all(dir, !p_exit_after_save);
+        SCP_INFO(()) << "Saved " << dir << " at " << sc_core::sc_time_stamp() << " in "
+                     << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << "s";
+    }
+};
+} // namespace gs
+
+extern "C" void module_register();
+#endif
@@ -16,6 +16,7 @@
 #include <scp/report.h>
 #include <getopt.h>
 #include <memory>
+#include "config_cache.h"
 #include "luafile_tool.h"
 
 /**
@@ -27,6 +28,11 @@ class ArgParser
 {
     SCP_LOGGER();
 
+    /* long only options */
+    enum { OPT_CONFIG_CACHE = 256, OPT_CONFIG_CACHE_VALIDATE };
+
+    using option_list = std::vector<std::pair<char, std::string>>;
+
 public:
     ArgParser(cci::cci_broker_handle a_broker, const int argc, char* const argv[], bool enforce_config_file = false)
         : lua()
@@ -88,9 +94,18 @@ protected:
         // Don't add 'i' here. It must be specified as a long option.
         const char* optstring = "l:p:";
 
-        struct option long_options[] = { { "gs_luafile", required_argument, 0, 'l' }, // '--luafile filename'
-                                         { "param", required_argument, 0, 'p' },      // --param foo.baa=10
-                                         { 0, 0, 0, 0 } };
+        struct option long_options[] = {
+            { "gs_luafile", required_argument, 0, 'l' },                               // '--luafile filename'
+            { "param", required_argument, 0, 'p' },                                    // --param foo.baa=10
+            { "gs_config_cache", required_argument, 0, OPT_CONFIG_CACHE },             // --gs_config_cache file
+            { "gs_config_cache_validate", no_argument, 0, OPT_CONFIG_CACHE_VALIDATE }, // --gs_config_cache_validate
+            { 0, 0, 0, 0 }
+        };
+
+        // the options are applied in order once all are read, the cache options may come last
+        option_list options;
+        std::string cache_file;
+        bool validate = false;
 
         while (1) {
             int c = getopt_long(argc, argv_cp_raw, optstring, long_options, 0);
@@ -100,19 +115,25 @@ protected:
             case 'l': // -l and --gs_luafile
             {
                 SCP_INFO(()) << "Option --gs_luafile with value " << optarg;
-                SCP_INFO(()) << "Lua file command line parser: parse option --gs_luafile " << optarg << std::endl;
-                lua.config(a_broker, optarg);
+                options.emplace_back('l', optarg);
                 luafile_found = true;
                 break;
             }
 
             case 'p': // -p and --param
             {
-                auto param = get_key_val_args(std::string(optarg));
-                a_broker.set_preset_cci_value(param.first, cci::cci_value(cci::cci_value::from_json(param.second)));
+                options.emplace_back('p', optarg);
                 break;
             }
 
+            case OPT_CONFIG_CACHE:
+                cache_file = optarg;
+                break;
+
+            case OPT_CONFIG_CACHE_VALIDATE:
+                validate = true;
+                break;
+
             default:
                 /* unrecognized option */
                 break;
@@ -122,6 +143,78 @@ protected:
         if (enforce_config_file && !luafile_found) {
             SCP_FATAL(()) << "fatal: missing required --gs_luafile argument";
         }
+
+        if (cache_file.empty()) {
+            if (validate) {
+                SCP_FATAL(()) << "fatal: --gs_config_cache_validate requires --gs_config_cache";
+            }
+            apply_options(a_broker, options, nullptr);
+        } else {
+            apply_options_cached(a_broker, options, cache_file, validate);
+        }
+    }
+
+    /// Read the Lua files and set the parameters, in the order of the command line
+    void apply_options(cci::cci_broker_handle a_broker, const option_list& options, gs::config_record* record)
+    {
+        lua.set_record(record);
+        for (auto& o : options) {
+            if (o.first == 'l') {
+                SCP_INFO(()) << "Lua file command line parser: parse option --gs_luafile " << o.second << std::endl;
+                lua.config(a_broker, o.second.c_str());
+            } else {
+                auto param = get_key_val_args(o.second);
+                auto value = cci::cci_value::from_json(param.second);
+                a_broker.set_preset_cci_value(param.first, value);
+                if (record) {
+                    record->presets[param.first] = value;
+                }
+            }
+        }
+        lua.set_record(nullptr);
+    }
+
+    /// Same as apply_options, through the cache file (see config_cache.h)
+    void apply_options_cached(cci::cci_broker_handle a_broker, const option_list& options,
+                              const std::string& cache_file, bool validate)
+    {
+        gs::config_cache cache(cache_file);
+        uint64_t key = gs::config_cache::key(options);
+
+        bool cached = cache.load(key);
+        std::string changed;
+        if (cached && !cache.up_to_date(changed)) {
+            SCP_INFO(()) << "Configuration cache " << cache_file << " is out of date (" << changed << " changed)";
+            cached = false;
+        } else if (!cached) {
+            SCP_INFO(()) << "No configuration cache for this command line in " << cache_file;
+        }
+
+        if (cached && !validate) {
+            SCP_INFO(()) << "Reading the configuration from the cache " << cache_file;
+            cache.apply(a_broker);
+            a_broker.ignore_unconsumed_preset_values(gs::LuaFile_Tool::is_lua_builtin);
+            return;
+        }
+
+        gs::config_record record;
+        apply_options(a_broker, options, &record);
+
+        if (cached) {
+            size_t n = cache.diff(record);
+            if (n) {
+                SCP_FATAL(()) << "fatal: the configuration cache " << cache_file << " differs from the configuration ("
+                              << n << " parameters), an input is not tracked";
+            }
+            SCP_INFO(()) << "Configuration cache " << cache_file << " is valid";
+            return;
+        }
+
+        if (record.failed) {
+            SCP_WARN(()) << "The configuration failed, it is not cached";
+        } else {
+            cache.save(key, record);
+        }
     }
 
 private:
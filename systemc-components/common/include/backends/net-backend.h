@@ -33,3 +33,11 @@ public:
         m_can_receive = can_receive;
     }
 };
+
+/* Implemented by MAC models so that a backend can be attached to them by name */
+class NetworkBackendAttachable
+{
+public:
+    virtual void set_backend(NetworkBackend* backend) = 0;
+    virtual ~NetworkBackendAttachable() {}
+};
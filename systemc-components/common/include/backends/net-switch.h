@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <systemc>
+#include <cci_configuration>
+#include <scp/report.h>
+
+#include <backends/net-backend.h>
+#include <async_event.h>
+#include <module_factory_registery.h>
+
+/**
+ * @brief NetworkSwitch: an in-simulation learning Ethernet switch.
+ *
+ * Each port is a NetworkBackend, so any MAC model may be attached to it
+ * with set_backend(). Ports may also be attached by name through the
+ * port_N.mac parameter, or to a QEMU NIC through a localhost UDP socket
+ * (QEMU side: -netdev socket,udp=127.0.0.1:<udp_port>,localaddr=127.0.0.1:<udp_peer_port>).
+ *
+ * When neither link_rate_mbps nor latency_ns is set, frames are handed to the
+ * destination MAC by reference, without being copied.
+ *
+ * @param @num_ports : number of switch ports
+ * @param @link_rate_mbps : egress link rate in Mbit/s (0 = infinite)
+ * @param @latency_ns : per hop latency in ns (0 = none)
+ * @param @pcap_file : if set, every frame entering the switch is captured in this file
+ * @param @port_N.mac : (optional) path to a MAC model implementing NetworkBackendAttachable
+ * @param @port_N.udp_port : (optional) localhost UDP port on which this port listens
+ * @param @port_N.udp_peer_port : (optional) localhost UDP port to which this port sends
+ */
+class NetworkSwitch : public sc_core::sc_module
+{
+    SCP_LOGGER();
+
+public:
+    class Port : public sc_core::sc_module, public NetworkBackend
+    {
+        SCP_LOGGER();
+        friend class NetworkSwitch;
+
+        NetworkSwitch* m_switch;
+        int m_index;
+
+        /* egress queue, only used when timing is modelled or the peer is busy */
+        struct Pending {
+            sc_core::sc_time when;
+            Payload* frame;
+        };
+        std::deque<Pending> m_egress;
+        sc_core::sc_time m_busy_until;
+        sc_core::sc_event m_egress_event;
+
+        /* UDP attachment */
+        int m_fd;
+        std::thread m_rcv_thread;
+        std::atomic<bool> m_running;
+        std::mutex m_mutex;
+        std::queue<Payload*> m_ingress;
+        gs::async_event m_ingress_event;
+
+        void udp_open();
+        void udp_close();
+        void udp_rcv_thread();
+        void udp_rcv();
+        void udp_send(Payload& frame);
+
+        void egress();
+        void deliver(Payload& frame);
+
+    public:
+        cci::cci_param<std::string> p_mac;
+        cci::cci_param<uint32_t> p_udp_port;
+        cci::cci_param<uint32_t> p_udp_peer_port;
+
+        uint64_t rx_frames;
+        uint64_t tx_frames;
+        uint64_t dropped_frames;
+
+        SC_HAS_PROCESS(Port);
+        Port(const sc_core::sc_module_name& name, NetworkSwitch* sw, int index);
+        virtual ~Port();
+
+        /* Frame sent by the MAC attached to this port (i.e. entering the switch) */
+        void send(Payload& frame) override;
+
+        bool attached() const { return m_receive != nullptr || m_fd >= 0; }
+    };
+
+private:
+    std::unordered_map<uint64_t, int> m_fdb; // MAC address -> port
+    std::vector<Payload*> m_pool;
+    FILE* m_pcap;
+
+    bool timed() const { return p_link_rate_mbps.get_value() != 0 || p_latency_ns.get_value() != 0; }
+
+    Payload* alloc_frame(const Payload& src);
+    void free_frame(Payload* frame);
+
+    void pcap_open();
+    void pcap_write(const Payload& frame);
+
+    void forward(int from, Payload& frame);
+    void output(int to, Payload& frame);
+
+public:
+    cci::cci_param<uint32_t> p_num_ports;
+    cci::cci_param<uint64_t> p_link_rate_mbps;
+    cci::cci_param<uint64_t> p_latency_ns;
+    cci::cci_param<std::string> p_pcap_file;
+
+    sc_core::sc_vector<Port> ports;
+
+    NetworkSwitch(const sc_core::sc_module_name& name, uint32_t num_ports = 0);
+    virtual ~NetworkSwitch();
+
+    Port& port(int i) { return ports[i]; }
+
+    void before_end_of_elaboration() override;
+    void end_of_simulation() override;
+};
+
+extern "C" void module_register();
@@ -0,0 +1,345 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _GREENSOCS_CHECKPOINT_H
+#define _GREENSOCS_CHECKPOINT_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <type_traits>
+
+#include <sys/stat.h>
+
+#include <systemc>
+#include <scp/report.h>
+
+namespace gs {
+namespace ckpt {
+
+/*
+ * Whole platform checkpoints (see the checkpoint module).
+ *
+ * A checkpoint is a directory holding a state.bin file with the SystemC time
+ * and the state of each registered component, plus whatever large files the
+ * components write next to it (e.g. the memory images).
+ *
+ * A checkpoint is restored in a new process running the same platform: the
+ * components see restoring() during elaboration (e.g. the loaders don't load
+ * anything), SystemC is fast-forwarded to the checkpoint time with the CPUs
+ * stopped, and the components are then restored and resumed.
+ */
+
+/**
+ * @class state
+ *
+ * @brief The saved state of a component, read back in the order it was
+ * written
+ */
+class state
+{
+    std::string m_owner;
+    std::string m_dir;
+    std::string m_data;
+    size_t m_pos = 0;
+
+public:
+    state(const std::string& owner, const std::string& dir, const std::string& data = "")
+        : m_owner(owner), m_dir(dir), m_data(data)
+    {
+    }
+
+    /* Directory of the checkpoint */
+    const std::string& dir() const { return m_dir; }
+
+    /* Path of a file of the checkpoint belonging to the component */
+    std::string file(const std::string& suffix) const { return m_dir + "/" + m_owner + suffix; }
+
+    const std::string& data() const { return m_data; }
+
+    template <typename T>
+    void put(const T& v)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values can be saved");
+        m_data.append(reinterpret_cast<const char*>(&v), sizeof(T));
+    }
+
+    void put(const std::string& s)
+    {
+        put<uint64_t>(s.size());
+        m_data.append(s);
+    }
+
+    void put_bytes(const void* p, size_t len) { m_data.append(static_cast<const char*>(p), len); }
+
+    template <typename T>
+    void get(T& v)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values can be restored");
+        get_bytes(&v, sizeof(T));
+    }
+
+    void get(std::string& s)
+    {
+        uint64_t len;
+        get(len);
+        check(len);
+        s = m_data.substr(m_pos, len);
+        m_pos += len;
+    }
+
+    void get_bytes(void* p, size_t len)
+    {
+        check(len);
+        memcpy(p, &m_data[m_pos], len);
+        m_pos += len;
+    }
+
+private:
+    void check(size_t len)
+    {
+        if (m_pos + len > m_data.size()) {
+            SCP_FATAL("checkpoint") << "The checkpoint of " << m_owner << " is truncated or was saved by another "
+                                    << "version of the platform";
+        }
+    }
+};
+
+/**
+ * @class checkpointable
+ *
+ * @brief A component with state to save in the checkpoints, registered by
+ * name for its whole lifetime
+ */
+class checkpointable
+{
+    std::string m_ckpt_name;
+
+protected:
+    inline checkpointable(const std::string& name);
+
+public:
+    checkpointable(const checkpointable&) = delete;
+    inline virtual ~checkpointable();
+
+    const std::string& checkpoint_name() const { return m_ckpt_name; }
+
+    /* Stop the activity which is not under the control of SystemC (e.g. the vCPUs) */
+    virtual void checkpoint_pause() {}
+    /* Restart it, after a save or a restore */
+    virtual void checkpoint_continue() {}
+
+    virtual void checkpoint_save(state& s) = 0;
+    virtual void checkpoint_restore(state& s) = 0;
+};
+
+/**
+ * @class registry
+ *
+ * @brief The checkpointable components, and the checkpoint being restored if
+ * any. Use registry::get().
+ */
+class registry
+{
+    static const char* magic() { return "GSCKPT01"; }
+
+    std::mutex m_mutex;
+    std::map<std::string, checkpointable*> m_items;
+
+    bool m_enabled = false;
+    std::string m_restore_dir;
+    sc_core::sc_time m_restore_time;
+    std::map<std::string, std::string> m_restore_states;
+    bool m_resumed = false;
+    sc_core::sc_event* m_resume_event = nullptr;
+
+    static void put_string(FILE* f, const std::string& s)
+    {
+        uint64_t len = s.size();
+        fwrite(&len, sizeof(len), 1, f);
+        fwrite(s.data(), 1, s.size(), f);
+    }
+
+    static bool get_string(FILE* f, std::string& s)
+    {
+        uint64_t len;
+        if (fread(&len, sizeof(len), 1, f) != 1) {
+            return false;
+        }
+        s.resize(len);
+        return len == 0 || fread(&s[0], 1, len, f) == len;
+    }
+
+public:
+    static registry& get()
+    {
+        static registry r;
+        return r;
+    }
+
+    /* Returns the name the component is registered with, made unique if needed */
+    std::string add(const std::string& name, checkpointable* c)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::string n = name;
+        for (int i = 1; m_items.count(n); i++) {
+            n = name + "_" + std::to_string(i);
+        }
+        m_items[n] = c;
+        return n;
+    }
+
+    void remove(const std::string& name)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_items.erase(name);
+    }
+
+    /* A checkpoint module is present, checkpoints may be saved or restored */
+    bool enabled() const { return m_enabled; }
+    void enable() { m_enabled = true; }
+
+    /* Restoring a checkpoint, known from the construction of the checkpoint module */
+    bool restoring() const { return !m_restore_dir.empty(); }
+    const std::string& restore_dir() const { return m_restore_dir; }
+    const sc_core::sc_time& restore_time() const { return m_restore_time; }
+
+    /* Path of a file of the checkpoint being restored, see state::file */
+    std::string restore_file(const std::string& owner, const std::string& suffix) const
+    {
+        return m_restore_dir + "/" + owner + suffix;
+    }
+
+    /* The components have been restored and the platform runs again */
+    bool resumed() const { return m_resumed; }
+
+    /* From a SystemC thread: wait until the restored platform runs, if restoring */
+    void wait_resumed()
+    {
+        if (restoring() && !m_resumed) {
+            sc_core::wait(*m_resume_event);
+        }
+    }
+
+    /* Read the state of a checkpoint, to be restored by restore_all */
+    void open(const std::string& dir, sc_core::sc_event& resume_event)
+    {
+        std::string fname = dir + "/state.bin";
+        FILE* f = fopen(fname.c_str(), "rb");
+        if (!f) {
+            SCP_FATAL("checkpoint") << "Unable to open the checkpoint " << fname << ": " << strerror(errno);
+        }
+        char m[8];
+        double resolution;
+        uint64_t time, n;
+        bool ok = fread(m, 1, sizeof(m), f) == sizeof(m) && !memcmp(m, magic(), sizeof(m)) &&
+                  fread(&resolution, sizeof(resolution), 1, f) == 1 && fread(&time, sizeof(time), 1, f) == 1 &&
+                  fread(&n, sizeof(n), 1, f) == 1;
+        for (uint64_t i = 0; ok && i < n; i++) {
+            std::string name, data;
+            ok = get_string(f, name) && get_string(f, data);
+            m_restore_states[name] = data;
+        }
+        fclose(f);
+        if (!ok) {
+            SCP_FATAL("checkpoint") << fname << " is not a valid checkpoint";
+        }
+        if (resolution != sc_core::sc_get_time_resolution().to_seconds()) {
+            SCP_FATAL("checkpoint") << fname << " was saved with another SystemC time resolution";
+        }
+        m_restore_dir = dir;
+        m_restore_time = sc_core::sc_time::from_value(time);
+        m_resume_event = &resume_event;
+    }
+
+    /* Save the platform at the current SystemC time, from the SystemC thread */
+    void save_all(const std::string& dir, bool resume)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (dir == m_restore_dir) {
+            SCP_FATAL("checkpoint") << "Can't save a checkpoint over the one being restored (" << dir << ")";
+        }
+        if (mkdir(dir.c_str(), 0777) != 0 && errno != EEXIST) {
+            SCP_FATAL("checkpoint") << "Unable to create the checkpoint directory " << dir << ": " << strerror(errno);
+        }
+
+        for (auto& i : m_items) {
+            i.second->checkpoint_pause();
+        }
+
+        std::string fname = dir + "/state.bin";
+        std::string tmp = fname + ".tmp";
+        FILE* f = fopen(tmp.c_str(), "wb");
+        if (!f) {
+            SCP_FATAL("checkpoint") << "Unable to write the checkpoint " << fname << ": " << strerror(errno);
+        }
+        double resolution = sc_core::sc_get_time_resolution().to_seconds();
+        uint64_t time = sc_core::sc_time_stamp().value();
+        uint64_t n = m_items.size();
+        fwrite(magic(), 1, 8, f);
+        fwrite(&resolution, sizeof(resolution), 1, f);
+        fwrite(&time, sizeof(time), 1, f);
+        fwrite(&n, sizeof(n), 1, f);
+        for (auto& i : m_items) {
+            state s(i.first, dir);
+            i.second->checkpoint_save(s);
+            put_string(f, i.first);
+            put_string(f, s.data());
+        }
+        bool ok = !ferror(f);
+        ok = (fclose(f) == 0) && ok && rename(tmp.c_str(), fname.c_str()) == 0;
+        if (!ok) {
+            SCP_FATAL("checkpoint") << "Unable to write the checkpoint " << fname;
+        }
+
+        if (resume) {
+            for (auto& i : m_items) {
+                i.second->checkpoint_continue();
+            }
+        }
+    }
+
+    /* Restore the components, once SystemC reached the checkpoint time */
+    void restore_all()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (auto& i : m_items) {
+            auto it = m_restore_states.find(i.first);
+            if (it == m_restore_states.end()) {
+                SCP_WARN("checkpoint") << i.first << " is not in the checkpoint, it keeps its initial state";
+                continue;
+            }
+            state s(i.first, m_restore_dir, it->second);
+            i.second->checkpoint_restore(s);
+        }
+        for (auto& s : m_restore_states) {
+            if (!m_items.count(s.first)) {
+                SCP_WARN("checkpoint") << s.first << " was saved but is not in the platform";
+            }
+        }
+        for (auto& i : m_items) {
+            i.second->checkpoint_continue();
+        }
+
+        m_resumed = true;
+        m_resume_event->notify(sc_core::SC_ZERO_TIME);
+    }
+};
+
+checkpointable::checkpointable(const std::string& name): m_ckpt_name(registry::get().add(name, this)) {}
+
+checkpointable::~checkpointable() { registry::get().remove(m_ckpt_name); }
+
+} // namespace ckpt
+} // namespace gs
+
+#endif
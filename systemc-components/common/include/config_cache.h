@@ -0,0 +1,379 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _GREENSOCS_CONFIG_CACHE_H
+#define _GREENSOCS_CONFIG_CACHE_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cci_configuration>
+#include <scp/report.h>
+
+namespace gs {
+
+/*
+ * Cache of the configuration read by ArgParser (see --gs_config_cache).
+ *
+ * The cache file holds the preset values resulting from the Lua files and
+ * the command line, and the inputs the Lua files used, each with a signature
+ * of its content when the cache was written. It is used as long as the
+ * command line (and working directory) is the same and no input changed.
+ */
+
+/* What a configuration depends on */
+enum config_input_kind : uint8_t {
+    CONFIG_INPUT_SOURCE, /* a Lua file, by its content */
+    CONFIG_INPUT_FILE,   /* a file opened for reading, by its size and modification time */
+    CONFIG_INPUT_ABSENT, /* a file which could not be opened, by its existence */
+    CONFIG_INPUT_ENV,    /* an environment variable, by its value */
+};
+
+/* Filled in while the configuration is read */
+struct config_record {
+    std::map<std::string, cci::cci_value> presets;
+    std::set<std::pair<std::string, int>> inputs;
+    bool failed = false;
+};
+
+/**
+ * @class config_cache
+ *
+ * @brief Reads and writes a configuration cache file
+ */
+class config_cache
+{
+    enum value_tag : uint8_t { TAG_NULL, TAG_BOOL, TAG_INT64, TAG_UINT64, TAG_DOUBLE, TAG_STRING, TAG_JSON };
+
+    struct input {
+        std::string name;
+        uint8_t kind;
+        uint64_t sig;
+    };
+
+    static std::string magic() { return std::string("GSCFGC1", 8); }
+
+    std::string m_path;
+    uint64_t m_key = 0;
+    std::vector<input> m_inputs;
+    std::map<std::string, cci::cci_value> m_presets;
+
+    /* FNV-1a */
+    static uint64_t hash(const void* p, size_t len, uint64_t h = 0xcbf29ce484222325ULL)
+    {
+        const uint8_t* b = static_cast<const uint8_t*>(p);
+        for (size_t i = 0; i < len; i++) {
+            h = (h ^ b[i]) * 0x100000001b3ULL;
+        }
+        return h;
+    }
+
+    static uint64_t hash(const std::string& s, uint64_t h = 0xcbf29ce484222325ULL)
+    {
+        /* with the length, for the strings of a list not to run into each other */
+        uint64_t len = s.size();
+        return hash(s.data(), s.size(), hash(&len, sizeof(len), h));
+    }
+
+    template <typename T>
+    static void put(std::string& out, const T& v)
+    {
+        out.append(reinterpret_cast<const char*>(&v), sizeof(T));
+    }
+
+    static void put(std::string& out, const std::string& s)
+    {
+        put<uint32_t>(out, s.size());
+        out.append(s);
+    }
+
+    class reader
+    {
+        const std::string& m_data;
+        size_t m_pos = 0;
+
+    public:
+        bool ok = true;
+
+        reader(const std::string& data): m_data(data) {}
+
+        template <typename T>
+        T get()
+        {
+            T v{};
+            if (m_pos + sizeof(T) > m_data.size()) {
+                ok = false;
+                return v;
+            }
+            memcpy(&v, m_data.data() + m_pos, sizeof(T));
+            m_pos += sizeof(T);
+            return v;
+        }
+
+        std::string get_string()
+        {
+            uint32_t len = get<uint32_t>();
+            if (!ok || m_pos + len > m_data.size()) {
+                ok = false;
+                return "";
+            }
+            std::string s = m_data.substr(m_pos, len);
+            m_pos += len;
+            return s;
+        }
+
+        void skip(size_t n) { m_pos += n; }
+
+        bool at_end() const { return m_pos == m_data.size(); }
+    };
+
+    static void put_value(std::string& out, const cci::cci_value& v)
+    {
+        if (v.is_null()) {
+            put<uint8_t>(out, TAG_NULL);
+        } else if (v.is_bool()) {
+            put<uint8_t>(out, TAG_BOOL);
+            put<uint8_t>(out, v.get_bool());
+        } else if (v.is_uint64()) {
+            put<uint8_t>(out, TAG_UINT64);
+            put<uint64_t>(out, v.get_uint64());
+        } else if (v.is_int64()) {
+            put<uint8_t>(out, TAG_INT64);
+            put<int64_t>(out, v.get_int64());
+        } else if (v.is_double()) {
+            put<uint8_t>(out, TAG_DOUBLE);
+            put<double>(out, v.get_double());
+        } else if (v.is_string()) {
+            put<uint8_t>(out, TAG_STRING);
+            put(out, v.get_string());
+        } else {
+            /* lists and maps, from the command line */
+            put<uint8_t>(out, TAG_JSON);
+            put(out, v.to_json());
+        }
+    }
+
+    static bool get_value(reader& r, cci::cci_value& v)
+    {
+        switch (r.get<uint8_t>()) {
+        case TAG_NULL:
+            v = cci::cci_value();
+            break;
+        case TAG_BOOL:
+            v = cci::cci_value(bool(r.get<uint8_t>()));
+            break;
+        case TAG_UINT64:
+            v = cci::cci_value(r.get<uint64_t>());
+            break;
+        case TAG_INT64:
+            v = cci::cci_value(r.get<int64_t>());
+            break;
+        case TAG_DOUBLE:
+            v = cci::cci_value(r.get<double>());
+            break;
+        case TAG_STRING:
+            v = cci::cci_value(r.get_string());
+            break;
+        case TAG_JSON:
+            v = cci::cci_value::from_json(r.get_string());
+            break;
+        default:
+            return false;
+        }
+        return r.ok;
+    }
+
+public:
+    config_cache(const std::string& path): m_path(path) {}
+
+    /* The key of a configuration: the working directory and the ordered arguments read */
+    static uint64_t key(const std::vector<std::pair<char, std::string>>& args)
+    {
+        char cwd[4096];
+        uint64_t h = hash(getcwd(cwd, sizeof(cwd)) ? std::string(cwd) : std::string());
+        for (auto& a : args) {
+            h = hash(&a.first, 1, h);
+            h = hash(a.second, h);
+        }
+        return h;
+    }
+
+    /* Signature of an input as it is now */
+    static uint64_t signature(const std::string& name, int kind)
+    {
+        struct stat st;
+        switch (kind) {
+        case CONFIG_INPUT_SOURCE: {
+            std::ifstream f(name, std::ios::binary);
+            if (!f) {
+                return 0;
+            }
+            std::stringstream ss;
+            ss << f.rdbuf();
+            return hash(ss.str(), 1);
+        }
+        case CONFIG_INPUT_FILE:
+            if (stat(name.c_str(), &st) != 0) {
+                return 0;
+            }
+            return hash(&st.st_mtim, sizeof(st.st_mtim), hash(&st.st_size, sizeof(st.st_size), 1));
+        case CONFIG_INPUT_ABSENT:
+            return access(name.c_str(), F_OK) == 0;
+        case CONFIG_INPUT_ENV: {
+            const char* v = getenv(name.c_str());
+            return v ? hash(std::string(v), 1) : 0;
+        }
+        default:
+            return 0;
+        }
+    }
+
+    /*
+     * Read the cache file, returns false if there is none, or if it's not for
+     * this key
+     */
+    bool load(uint64_t key)
+    {
+        std::ifstream f(m_path, std::ios::binary);
+        if (!f) {
+            return false;
+        }
+        std::stringstream ss;
+        ss << f.rdbuf();
+        std::string data = ss.str();
+        if (data.compare(0, magic().size(), magic()) != 0) {
+            SCP_WARN("config_cache") << m_path << " is not a configuration cache, it will be rewritten";
+            return false;
+        }
+
+        reader r(data);
+        r.skip(magic().size());
+        m_key = r.get<uint64_t>();
+        if (m_key != key) {
+            return false;
+        }
+
+        m_inputs.clear();
+        m_presets.clear();
+        uint32_t n = r.get<uint32_t>();
+        for (uint32_t i = 0; i < n && r.ok; i++) {
+            input in;
+            in.kind = r.get<uint8_t>();
+            in.name = r.get_string();
+            in.sig = r.get<uint64_t>();
+            m_inputs.push_back(in);
+        }
+        n = r.get<uint32_t>();
+        for (uint32_t i = 0; i < n && r.ok; i++) {
+            std::string name = r.get_string();
+            cci::cci_value v;
+            if (!get_value(r, v)) {
+                break;
+            }
+            m_presets[name] = v;
+        }
+        if (!r.ok || !r.at_end()) {
+            SCP_WARN("config_cache") << m_path << " is truncated, it will be rewritten";
+            return false;
+        }
+        return true;
+    }
+
+    /* Whether the inputs of the loaded configuration are unchanged, or the first which changed */
+    bool up_to_date(std::string& changed) const
+    {
+        for (auto& in : m_inputs) {
+            if (signature(in.name, in.kind) != in.sig) {
+                changed = in.name;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const std::map<std::string, cci::cci_value>& presets() const { return m_presets; }
+
+    void apply(cci::cci_broker_handle broker) const
+    {
+        for (auto& p : m_presets) {
+            broker.set_preset_cci_value(p.first, p.second);
+        }
+    }
+
+    /* Write the configuration read, replacing the cache file at once */
+    bool save(uint64_t key, const config_record& rec)
+    {
+        std::string out = magic();
+        put<uint64_t>(out, key);
+        put<uint32_t>(out, rec.inputs.size());
+        for (auto& in : rec.inputs) {
+            put<uint8_t>(out, in.second);
+            put(out, in.first);
+            put<uint64_t>(out, signature(in.first, in.second));
+        }
+        put<uint32_t>(out, rec.presets.size());
+        for (auto& p : rec.presets) {
+            put(out, p.first);
+            put_value(out, p.second);
+        }
+
+        std::string tmp = m_path + ".tmp." + std::to_string(getpid());
+        {
+            std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+            if (!f.write(out.data(), out.size())) {
+                SCP_WARN("config_cache") << "Unable to write " << tmp;
+                return false;
+            }
+        }
+        if (rename(tmp.c_str(), m_path.c_str()) != 0) {
+            SCP_WARN("config_cache") << "Unable to write " << m_path << ": " << strerror(errno);
+            unlink(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    /* Log the differences between the loaded presets and the ones read, returns their number */
+    size_t diff(const config_record& rec) const
+    {
+        size_t n = 0;
+        for (auto& p : rec.presets) {
+            auto it = m_presets.find(p.first);
+            if (it == m_presets.end()) {
+                SCP_WARN("config_cache") << p.first << " = " << p.second.to_json() << " is not in the cache";
+                n++;
+            } else if (it->second != p.second) {
+                SCP_WARN("config_cache") << p.first << " = " << p.second.to_json() << " but "
+                                         << it->second.to_json() << " in the cache";
+                n++;
+            }
+        }
+        for (auto& p : m_presets) {
+            if (rec.presets.find(p.first) == rec.presets.end()) {
+                SCP_WARN("config_cache") << p.first << " = " << p.second.to_json() << " is only in the cache";
+                n++;
+            }
+        }
+        return n;
+    }
+};
+
+} // namespace gs
+
+#endif
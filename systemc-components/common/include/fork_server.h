@@ -0,0 +1,302 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _GREENSOCS_FORK_SERVER_H
+#define _GREENSOCS_FORK_SERVER_H
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cci_configuration>
+#include <scp/report.h>
+
+#include <uutils.h>
+
+namespace gs {
+
+/**
+ * @class fork_server
+ *
+ * @brief Runs many short simulations of one platform, forking them from a
+ * process which has already parsed the configuration (and built the
+ * platform)
+ *
+ * @details The server listens on a unix socket. A request is made of lines,
+ * ended by "run":
+ *
+ *     param <name>=<JSON value>   set a CCI parameter of the run
+ *     output <file>               stdout and stderr of the run go to file
+ *     run
+ *
+ * The server forks a child per request, which goes on with the simulation,
+ * and answers "pid <pid>" then, once the child is done, "exit <status>" (or
+ * "signal <number>"). A bad request is answered by "error <reason>". A
+ * "quit" request stops the server once its children are done.
+ *
+ * The child inherits the memory of the server copy-on-write. Forking only
+ * keeps the calling thread, so the server must be single threaded when
+ * forking, apart from the SigHandler thread which the child restarts: QEMU
+ * instances can't be initialized before, nor can the remote processes and
+ * the shared memories be created (they would be shared by all the children).
+ */
+class fork_server
+{
+    struct request {
+        std::vector<std::pair<std::string, cci::cci_value>> params;
+        std::string output;
+        bool quit = false;
+    };
+
+    cci::cci_broker_handle m_broker;
+    std::string m_path;
+    int m_listen_fd = -1;
+    std::map<pid_t, int> m_children; /* pid to the connection of its request */
+    bool m_quit = false;
+
+    static void reply(int fd, const std::string& msg)
+    {
+        std::string line = msg + "\n";
+        if (write(fd, line.data(), line.size()) != (ssize_t)line.size()) {
+            SCP_WARN("fork_server") << "Unable to answer a request: " << strerror(errno);
+        }
+    }
+
+    static bool read_line(int fd, std::string& buf, std::string& line)
+    {
+        for (;;) {
+            size_t eol = buf.find('\n');
+            if (eol != std::string::npos) {
+                line = buf.substr(0, eol);
+                buf.erase(0, eol + 1);
+                return true;
+            }
+            struct pollfd pfd = { fd, POLLIN, 0 };
+            if (poll(&pfd, 1, 5000) <= 0) {
+                return false;
+            }
+            char b[4096];
+            ssize_t n = read(fd, b, sizeof(b));
+            if (n <= 0) {
+                return false;
+            }
+            buf.append(b, n);
+        }
+    }
+
+    /* The values are checked here, not to fork children which would fail */
+    bool read_request(int fd, request& r, std::string& error)
+    {
+        std::string buf, line;
+        while (read_line(fd, buf, line)) {
+            if (line == "run") {
+                return true;
+            }
+            if (line == "quit") {
+                r.quit = true;
+                return true;
+            }
+            if (line.empty()) {
+                continue;
+            }
+            size_t sp = line.find(' ');
+            std::string cmd = line.substr(0, sp);
+            std::string arg = (sp == std::string::npos) ? "" : line.substr(sp + 1);
+            if (cmd == "output" && !arg.empty()) {
+                r.output = arg;
+            } else if (cmd == "param" && arg.find('=') != std::string::npos) {
+                size_t eq = arg.find('=');
+                try {
+                    r.params.emplace_back(arg.substr(0, eq), cci::cci_value::from_json(arg.substr(eq + 1)));
+                } catch (const std::exception& e) {
+                    error = "bad value for " + arg.substr(0, eq);
+                    return false;
+                }
+            } else {
+                error = "bad line: " + line;
+                return false;
+            }
+        }
+        error = "incomplete request";
+        return false;
+    }
+
+    /* Only the children of the server, the platform may have others */
+    void reap()
+    {
+        for (auto it = m_children.begin(); it != m_children.end();) {
+            int status;
+            if (waitpid(it->first, &status, WNOHANG) != it->first) {
+                ++it;
+                continue;
+            }
+            if (WIFEXITED(status)) {
+                reply(it->second, "exit " + std::to_string(WEXITSTATUS(status)));
+            } else {
+                reply(it->second, "signal " + std::to_string(WTERMSIG(status)));
+            }
+            close(it->second);
+            it = m_children.erase(it);
+        }
+    }
+
+    void start_child(int fd, const request& r)
+    {
+        close(m_listen_fd);
+        m_listen_fd = -1;
+        for (auto& c : m_children) {
+            close(c.second);
+        }
+        m_children.clear();
+        close(fd);
+
+        SigHandler::get().restart_after_fork();
+
+        if (!r.output.empty()) {
+            int out = open(r.output.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (out < 0) {
+                SCP_FATAL("fork_server") << "Unable to open " << r.output << ": " << strerror(errno);
+            }
+            dup2(out, STDOUT_FILENO);
+            dup2(out, STDERR_FILENO);
+            close(out);
+        }
+
+        /*
+         * The parameters which already exist are set, the others are preset.
+         * A parameter which was already read (e.g. in a constructor) keeps
+         * its effect.
+         */
+        for (auto& p : r.params) {
+            SCP_INFO("fork_server") << "Setting param " << p.first << " to value " << p.second.to_json();
+            auto h = m_broker.get_param_handle(p.first);
+            if (h.is_valid()) {
+                h.set_cci_value(p.second);
+            } else {
+                m_broker.set_preset_cci_value(p.first, p.second);
+            }
+        }
+    }
+
+    /* A SIGCHLD handler would be run for the children (and may stop the server) */
+    static bool has_children_of_its_own()
+    {
+        struct sigaction act;
+        sigaction(SIGCHLD, NULL, &act);
+        return act.sa_handler != SIG_DFL && act.sa_handler != SIG_IGN;
+    }
+
+public:
+    fork_server(cci::cci_broker_handle broker, const std::string& path): m_broker(broker), m_path(path)
+    {
+        struct sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        if (m_path.size() >= sizeof(addr.sun_path)) {
+            SCP_FATAL("fork_server") << "The socket path " << m_path << " is too long";
+        }
+        m_path.copy(addr.sun_path, m_path.size());
+
+        unlink(m_path.c_str());
+        m_listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (m_listen_fd < 0 || bind(m_listen_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0 ||
+            listen(m_listen_fd, 16) < 0) {
+            SCP_FATAL("fork_server") << "Unable to listen on " << m_path << ": " << strerror(errno);
+        }
+    }
+
+    fork_server(const fork_server&) = delete;
+
+    ~fork_server()
+    {
+        /* only the server owns the socket */
+        if (m_listen_fd >= 0) {
+            close(m_listen_fd);
+            unlink(m_path.c_str());
+        }
+    }
+
+    /**
+     * Serve the requests. Returns true in a child, with the parameters of its
+     * request set, and false in the server once asked to quit.
+     */
+    bool serve()
+    {
+        if (has_children_of_its_own()) {
+            SCP_FATAL("fork_server") << "The platform already runs child processes (remote platforms or shared "
+                                        "memories), it can't be forked";
+        }
+        SCP_INFO("fork_server") << "Waiting for requests on " << m_path;
+
+        for (;;) {
+            reap();
+            if (m_quit && m_children.empty()) {
+                return false;
+            }
+
+            struct pollfd pfd = { m_listen_fd, POLLIN, 0 };
+            int n = poll(&pfd, 1, 100);
+            if (n < 0 && errno != EINTR) {
+                SCP_FATAL("fork_server") << "poll: " << strerror(errno);
+            }
+            if (n <= 0 || m_quit) {
+                continue;
+            }
+            int fd = accept(m_listen_fd, NULL, NULL);
+            if (fd < 0) {
+                continue;
+            }
+
+            request r;
+            std::string error;
+            if (!read_request(fd, r, error)) {
+                reply(fd, "error " + error);
+                close(fd);
+                continue;
+            }
+            if (r.quit) {
+                m_quit = true;
+                close(fd);
+                continue;
+            }
+
+            /* not to print the buffered output once per child */
+            std::cout.flush();
+            std::cerr.flush();
+            fflush(NULL);
+
+            pid_t pid = fork();
+            if (pid == 0) {
+                start_child(fd, r);
+                return true;
+            }
+            if (pid < 0) {
+                reply(fd, std::string("error fork: ") + strerror(errno));
+                close(fd);
+                continue;
+            }
+            SCP_INFO("fork_server") << "Started run " << pid;
+            reply(fd, "pid " + std::to_string(pid));
+            m_children[pid] = fd;
+        }
+    }
+};
+
+} // namespace gs
+
+#endif
@@ -9,6 +9,7 @@
 #include "qk_factory.h"
 #include "qkmultithread.h"
 #include "qkmulti-quantum.h"
+#include "qkmulti-lockstep.h"
 #include "qkmulti-rolling.h"
 #include "qkmulti-adaptive.h"
 #include "qkmulti-unconstrained.h"
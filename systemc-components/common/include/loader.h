@@ -16,6 +16,7 @@
 #include <tlm_utils/simple_initiator_socket.h>
 #include <scp/report.h>
 #include <module_factory_registery.h>
+#include <checkpoint/checkpoint.h>
 #include <ports/target-signal-socket.h>
 #include <tlm_sockets_buswidth.h>
 
@@ -283,6 +284,11 @@ protected:
     }
     void end_of_elaboration()
     {
+        if (ckpt::registry::get().restoring() && !ckpt::registry::get().resumed()) {
+            // The memories are restored with what was loaded
+            SCP_INFO(()) << "Restoring a checkpoint, nothing to load";
+            return;
+        }
         int i = 0;
         auto children = sc_cci_children(name());
         for (std::string s : children) {
@@ -50,19 +50,30 @@ int lua_cci_get_val(lua_State* L);
  */
 
 namespace gs {
+struct config_record;
+
 class LuaFile_Tool
 {
     SCP_LOGGER();
     using key_val_args = std::vector<std::pair<std::string, std::string>>;
 
     std::string m_orig_name;
+    config_record* m_record = nullptr;
 
     std::string rel(std::string& n) const;
 
+    void set_preset(cci::cci_broker_handle a_broker, const std::string& name, const cci::cci_value& value);
+
 public:
     /// Constructor
     LuaFile_Tool(std::string _orig_name = "");
 
+    /// Record the parameters set and the files read by the next configurations (see config_cache.h)
+    void set_record(config_record* record) { m_record = record; }
+
+    /// The values of the Lua globals which are not parameters
+    static bool is_lua_builtin(const std::pair<std::string, cci::cci_value>& iv);
+
     /// Makes the configuration
     /**
      * Configure parameters from a lua file.
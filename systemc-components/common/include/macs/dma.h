@@ -6,57 +6,202 @@
  */
 
 #pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
 #include <tlm_sockets_buswidth.h>
 #include <module_factory_registery.h>
 
+/**
+ * @brief dma: bus master helper for device models.
+ *
+ * Keeps a small cache of DMI regions (invalidated through the socket's
+ * backward path), so that once a buffer or descriptor ring has been mapped,
+ * accesses are plain memcpy's. On a cache miss, DMI is requested directly
+ * before falling back to b_transport.
+ *
+ * Scatter-gather lists (e.g. the buffers of a frame spread over several
+ * descriptors) can be transferred with a single read_sg/write_sg call.
+ */
 class dma : public sc_core::sc_module
 {
 public:
+    struct sg_entry {
+        uint64_t addr;
+        uint32_t len;
+    };
+    using sg_list = std::vector<sg_entry>;
+
+    static const int DMI_CACHE_SIZE = 4;
+
     tlm_utils::simple_initiator_socket<dma, DEFAULT_TLM_BUSWIDTH> socket;
 
-    tlm::tlm_dmi dmi_data;
-    bool dmi_valid;
+private:
+    std::mutex m_dmi_mutex;
+    tlm::tlm_dmi m_dmi[DMI_CACHE_SIZE];
+    bool m_dmi_valid[DMI_CACHE_SIZE];
+    int m_dmi_victim;
 
-    dma(const sc_core::sc_module_name& name): sc_core::sc_module(name), socket("socket") { dmi_valid = false; }
+    tlm::tlm_generic_payload m_trans;
 
-    ~dma() {}
+    /* Must be called with m_dmi_mutex held */
+    tlm::tlm_dmi* dmi_lookup(uint64_t addr, bool is_write)
+    {
+        for (int i = 0; i < DMI_CACHE_SIZE; i++) {
+            tlm::tlm_dmi& d = m_dmi[i];
+            if (m_dmi_valid[i] && addr >= d.get_start_address() && addr <= d.get_end_address() &&
+                (is_write ? d.is_write_allowed() : d.is_read_allowed())) {
+                return &d;
+            }
+        }
+        return nullptr;
+    }
 
-    void bus_do(uint64_t addr, uint8_t* data, uint32_t size, bool is_write)
+    tlm::tlm_dmi* dmi_request(uint64_t addr, bool is_write)
     {
-        tlm::tlm_generic_payload trans;
+        tlm::tlm_dmi dmi_data;
 
-        if (dmi_valid && addr >= dmi_data.get_start_address() && (addr + size) < dmi_data.get_end_address()) {
-            if (is_write && dmi_data.is_write_allowed()) {
-                uint64_t off = addr - dmi_data.get_start_address();
-                unsigned char* ptr = dmi_data.get_dmi_ptr();
-                memcpy(ptr + off, data, size);
-                return;
-            } else if (!is_write && dmi_data.is_read_allowed()) {
-                uint64_t off = addr - dmi_data.get_start_address();
-                unsigned char* ptr = dmi_data.get_dmi_ptr();
-                memcpy(data, ptr + off, size);
-                return;
+        m_trans.set_command(is_write ? tlm::TLM_WRITE_COMMAND : tlm::TLM_READ_COMMAND);
+        m_trans.set_address(addr);
+        m_trans.set_data_ptr(nullptr);
+        m_trans.set_data_length(0);
+        m_trans.set_streaming_width(0);
+        m_trans.set_byte_enable_length(0);
+        m_trans.set_dmi_allowed(false);
+        m_trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+
+        if (!socket->get_direct_mem_ptr(m_trans, dmi_data) || !dmi_data.get_dmi_ptr()) {
+            return nullptr;
+        }
+
+        std::lock_guard<std::mutex> lock(m_dmi_mutex);
+        int slot = m_dmi_victim;
+        m_dmi_victim = (m_dmi_victim + 1) % DMI_CACHE_SIZE;
+        m_dmi[slot] = dmi_data;
+        m_dmi_valid[slot] = true;
+        return dmi_lookup(addr, is_write);
+    }
+
+    void invalidate_direct_mem_ptr(sc_dt::uint64 start, sc_dt::uint64 end)
+    {
+        std::lock_guard<std::mutex> lock(m_dmi_mutex);
+        for (int i = 0; i < DMI_CACHE_SIZE; i++) {
+            if (m_dmi_valid[i] && m_dmi[i].get_start_address() <= end && m_dmi[i].get_end_address() >= start) {
+                m_dmi_valid[i] = false;
             }
         }
+    }
 
-        trans.set_command(is_write ? tlm::TLM_WRITE_COMMAND : tlm::TLM_READ_COMMAND);
-        trans.set_address(addr);
-        trans.set_data_ptr(reinterpret_cast<unsigned char*>(data));
-        trans.set_data_length(size);
-        trans.set_streaming_width(size);
-        trans.set_byte_enable_length(0);
-        trans.set_dmi_allowed(false);
-        trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+    /* Copy as much as possible through cached DMI regions, returns the number of bytes copied */
+    uint32_t dmi_copy(uint64_t addr, uint8_t* data, uint32_t size, bool is_write)
+    {
+        std::lock_guard<std::mutex> lock(m_dmi_mutex);
+        uint32_t done = 0;
+
+        while (done < size) {
+            tlm::tlm_dmi* d = dmi_lookup(addr + done, is_write);
+            if (!d) {
+                break;
+            }
+            uint64_t cur = addr + done;
+            uint64_t off = cur - d->get_start_address();
+            /* the last byte to copy, without overflowing for a region ending at ~0 */
+            uint64_t last = std::min<uint64_t>(size - done - 1, d->get_end_address() - cur);
+            uint32_t len = last + 1;
+            unsigned char* ptr = d->get_dmi_ptr() + off;
+            if (is_write) {
+                memcpy(ptr, data + done, len);
+            } else {
+                memcpy(data + done, ptr, len);
+            }
+            done += len;
+        }
+        return done;
+    }
+
+    void transport(uint64_t addr, uint8_t* data, uint32_t size, bool is_write)
+    {
+        m_trans.set_command(is_write ? tlm::TLM_WRITE_COMMAND : tlm::TLM_READ_COMMAND);
+        m_trans.set_address(addr);
+        m_trans.set_data_ptr(reinterpret_cast<unsigned char*>(data));
+        m_trans.set_data_length(size);
+        m_trans.set_streaming_width(size);
+        m_trans.set_byte_enable_length(0);
+        m_trans.set_dmi_allowed(false);
+        m_trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
 
         sc_core::sc_time delay(sc_core::SC_ZERO_TIME);
-        socket->b_transport(trans, delay);
+        socket->b_transport(m_trans, delay);
+    }
+
+public:
+    dma(const sc_core::sc_module_name& name): sc_core::sc_module(name), socket("socket"), m_dmi_victim(0)
+    {
+        for (int i = 0; i < DMI_CACHE_SIZE; i++) {
+            m_dmi_valid[i] = false;
+        }
+        socket.register_invalidate_direct_mem_ptr(this, &dma::invalidate_direct_mem_ptr);
+    }
 
-        if (trans.is_dmi_allowed()) {
-            dmi_valid = socket->get_direct_mem_ptr(trans, dmi_data);
+    ~dma() {}
+
+    void bus_do(uint64_t addr, uint8_t* data, uint32_t size, bool is_write)
+    {
+        while (size) {
+            uint32_t done = dmi_copy(addr, data, size, is_write);
+            addr += done;
+            data += done;
+            size -= done;
+            if (!size) {
+                return;
+            }
+            if (!dmi_request(addr, is_write)) {
+                /* No DMI here (e.g. a device), go through the bus for what is left */
+                transport(addr, data, size, is_write);
+                return;
+            }
         }
     }
 
     void bus_write(uint64_t addr, uint8_t* data, uint32_t size) { bus_do(addr, data, size, 1); }
 
     void bus_read(uint64_t addr, uint8_t* data, uint32_t size) { bus_do(addr, data, size, 0); }
+
+    /* Gather the buffers described by sg into data, returns the number of bytes read */
+    uint32_t read_sg(const sg_list& sg, uint8_t* data)
+    {
+        uint32_t off = 0;
+        for (auto& e : sg) {
+            bus_read(e.addr, data + off, e.len);
+            off += e.len;
+        }
+        return off;
+    }
+
+    /* Scatter data over the buffers described by sg, returns the number of bytes written */
+    uint32_t write_sg(const sg_list& sg, uint8_t* data, uint32_t size)
+    {
+        uint32_t off = 0;
+        for (auto& e : sg) {
+            if (off >= size) {
+                break;
+            }
+            uint32_t len = (e.len < size - off) ? e.len : size - off;
+            bus_write(e.addr, data + off, len);
+            off += len;
+        }
+        return off;
+    }
+
+    static uint32_t sg_size(const sg_list& sg)
+    {
+        uint32_t size = 0;
+        for (auto& e : sg) {
+            size += e.len;
+        }
+        return size;
+    }
 };
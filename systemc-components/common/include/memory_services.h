@@ -9,6 +9,9 @@
 
 #include <fstream>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 
 #include <cci_configuration>
 #include <systemc>
@@ -32,6 +35,7 @@ namespace gs {
 #define ALIGNEDBITS        12
 #define MAX_SHM_STR_LENGTH 255
 #define MAX_SHM_SEGS_NUM   1024
+#define MEMFD_ID_PREFIX    "memfd:"
 
 class MemoryServices
 {
@@ -45,6 +49,7 @@ private:
     struct shmem_info {
         uint8_t* base;
         size_t size;
+        int fd = -1; /* memfd segments created here, passed to the other processes */
     };
     struct shm_cleaner_info {
         int count;
@@ -58,6 +63,19 @@ private:
     shm_cleaner_info* cl_info = nullptr;
     std::string m_name;
 
+    /* the fd server thread looks up the memfd segments */
+    mutable std::mutex m_shmem_mutex;
+    int m_fd_server = -1;
+    int m_fd_server_stop[2] = { -1, -1 };
+    std::thread m_fd_server_thread;
+
+    static std::string fd_server_addr(pid_t pid);
+    void start_fd_server();
+    void stop_fd_server();
+    void fd_server();
+    void send_memfd(int conn);
+    int recv_memfd(const char* memid);
+
 public:
     ~MemoryServices();
 
@@ -89,10 +107,24 @@ public:
      */
     void start_shm_cleaner_proc();
 
-    uint8_t* map_file(const char* mapfile, uint64_t size, uint64_t offset);
+    /* copy_on_write: the file is only read, writes go to private copies of its pages */
+    uint8_t* map_file(const char* mapfile, uint64_t size, uint64_t offset, bool copy_on_write = false);
 
     uint8_t* map_mem_create(const char* memname, uint64_t size);
 
+    /**
+     * Create a shared memory with memfd_create (Linux only). Unlike
+     * map_mem_create, the pages are only committed when touched, there is no
+     * name to clean up and no limit on the number of segments: the memory is
+     * freed when the last process using it unmaps it or exits.
+     *
+     * Returns the id to give to map_mem_join in the other processes. They
+     * receive the file descriptor from this process, over a unix socket
+     * (SCM_RIGHTS), which is served as long as this process lives.
+     */
+    uint8_t* map_memfd_create(const char* memname, uint64_t size, std::string& memid);
+
+    /* memname is a map_mem_create name, or a map_memfd_create id */
     uint8_t* map_mem_join(const char* memname, size_t size);
 
     uint8_t* alloc(uint64_t size);
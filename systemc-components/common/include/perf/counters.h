@@ -0,0 +1,388 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _GREENSOCS_PERF_COUNTERS_H
+#define _GREENSOCS_PERF_COUNTERS_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+#include <systemc>
+
+namespace gs {
+namespace perf {
+
+/*
+ * Performance counters and histograms, registered by name in a global
+ * registry which can be dumped as JSON (see the perf_stats module).
+ *
+ * Recording is disabled by default, in which case it costs a relaxed load
+ * and a branch. When enabled, each host thread updates its own shard of the
+ * statistic with relaxed atomics, so that the vCPU threads don't bounce
+ * cache lines between each other. Shards are summed when the value is read.
+ */
+
+static constexpr unsigned SHARDS = 16;
+static constexpr unsigned CACHE_LINE = 64;
+
+inline std::atomic<bool>& enabled_flag()
+{
+    static std::atomic<bool> enabled{ false };
+    return enabled;
+}
+
+inline bool enabled() { return enabled_flag().load(std::memory_order_relaxed); }
+
+inline void enable(bool e = true) { enabled_flag().store(e, std::memory_order_relaxed); }
+
+/* Shard of the calling thread, threads are spread round robin */
+inline unsigned shard()
+{
+    static std::atomic<unsigned> next{ 0 };
+    thread_local unsigned s = next.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+    return s;
+}
+
+class stat;
+
+/**
+ * @class registry
+ *
+ * @brief The named statistics of the simulation, use registry::get()
+ */
+class registry
+{
+    std::mutex m_mutex;
+    std::map<std::string, stat*> m_stats;
+
+public:
+    static registry& get()
+    {
+        static registry r;
+        return r;
+    }
+
+    /* Returns the name the stat is registered with, made unique if needed */
+    std::string add(const std::string& name, stat* s)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::string n = name;
+        for (int i = 1; m_stats.count(n); i++) {
+            n = name + "_" + std::to_string(i);
+        }
+        m_stats[n] = s;
+        return n;
+    }
+
+    void remove(const std::string& name)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.erase(name);
+    }
+
+    /* The stat registered with this name, or nullptr */
+    stat* find(const std::string& name)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_stats.find(name);
+        return it == m_stats.end() ? nullptr : it->second;
+    }
+
+    inline void clear();
+    inline std::string to_json();
+
+    /* Write the JSON to a file, replacing it atomically */
+    bool dump(const std::string& fname)
+    {
+        std::string json = to_json();
+        std::string tmp = fname + ".tmp";
+        FILE* f = fopen(tmp.c_str(), "w");
+        if (!f) {
+            return false;
+        }
+        bool ok = fwrite(json.data(), 1, json.size(), f) == json.size();
+        ok = (fclose(f) == 0) && ok;
+        return ok && rename(tmp.c_str(), fname.c_str()) == 0;
+    }
+};
+
+/**
+ * @class stat
+ *
+ * @brief Base of the statistics, registered for their whole lifetime
+ */
+class stat
+{
+    std::string m_name;
+
+protected:
+    stat(const std::string& name): m_name(registry::get().add(name, this)) {}
+
+    static std::string full_name(const sc_core::sc_object* owner, const std::string& name)
+    {
+        return owner ? std::string(owner->name()) + "." + name : name;
+    }
+
+public:
+    stat(const stat&) = delete;
+    virtual ~stat() { registry::get().remove(m_name); }
+
+    const std::string& name() const { return m_name; }
+
+    virtual void clear() = 0;
+    virtual void to_json(std::ostream& os) const = 0;
+};
+
+/**
+ * @class counter
+ *
+ * @brief A monotonic event or byte count
+ */
+class counter : public stat
+{
+    struct alignas(CACHE_LINE) cell {
+        std::atomic<uint64_t> value{ 0 };
+    };
+    cell m_cells[SHARDS];
+
+public:
+    counter(const std::string& name): stat(name) {}
+    counter(const sc_core::sc_object* owner, const std::string& name): stat(full_name(owner, name)) {}
+
+    void add(uint64_t n = 1)
+    {
+        if (enabled()) {
+            m_cells[shard()].value.fetch_add(n, std::memory_order_relaxed);
+        }
+    }
+
+    counter& operator++()
+    {
+        add();
+        return *this;
+    }
+
+    uint64_t value() const
+    {
+        uint64_t v = 0;
+        for (auto& c : m_cells) {
+            v += c.value.load(std::memory_order_relaxed);
+        }
+        return v;
+    }
+
+    void clear() override
+    {
+        for (auto& c : m_cells) {
+            c.value.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void to_json(std::ostream& os) const override { os << value(); }
+};
+
+/**
+ * @class probe
+ *
+ * @brief A count maintained elsewhere (e.g. by QEMU), read when the stats are
+ * dumped. It doesn't depend on the recording being enabled.
+ */
+class probe : public stat
+{
+    std::function<uint64_t()> m_read;
+    std::atomic<uint64_t> m_base{ 0 };
+
+public:
+    probe(const sc_core::sc_object* owner, const std::string& name, std::function<uint64_t()> read)
+        : stat(full_name(owner, name)), m_read(read)
+    {
+    }
+
+    uint64_t value() const { return m_read() - m_base.load(std::memory_order_relaxed); }
+
+    void clear() override { m_base.store(m_read(), std::memory_order_relaxed); }
+
+    void to_json(std::ostream& os) const override { os << value(); }
+};
+
+/**
+ * @class histogram
+ *
+ * @brief Distribution of values (typically durations in ns) in power of 2
+ * buckets: bucket i counts the values in [2^(i-1), 2^i), bucket 0 the zeros.
+ */
+class histogram : public stat
+{
+public:
+    static constexpr unsigned BUCKETS = 65;
+
+private:
+    struct alignas(CACHE_LINE) cell {
+        std::atomic<uint64_t> count{ 0 };
+        std::atomic<uint64_t> sum{ 0 };
+        std::atomic<uint64_t> max{ 0 };
+        std::atomic<uint64_t> buckets[BUCKETS] = {};
+    };
+    cell m_cells[SHARDS];
+
+public:
+    histogram(const std::string& name): stat(name) {}
+    histogram(const sc_core::sc_object* owner, const std::string& name): stat(full_name(owner, name)) {}
+
+    static unsigned bucket(uint64_t v) { return v ? 64 - __builtin_clzll(v) : 0; }
+
+    void record(uint64_t v)
+    {
+        if (!enabled()) {
+            return;
+        }
+        cell& c = m_cells[shard()];
+        c.count.fetch_add(1, std::memory_order_relaxed);
+        c.sum.fetch_add(v, std::memory_order_relaxed);
+        c.buckets[bucket(v)].fetch_add(1, std::memory_order_relaxed);
+        if (v > c.max.load(std::memory_order_relaxed)) {
+            c.max.store(v, std::memory_order_relaxed); /* racy, but only for a shared shard */
+        }
+    }
+
+    uint64_t count() const
+    {
+        uint64_t v = 0;
+        for (auto& c : m_cells) {
+            v += c.count.load(std::memory_order_relaxed);
+        }
+        return v;
+    }
+
+    uint64_t sum() const
+    {
+        uint64_t v = 0;
+        for (auto& c : m_cells) {
+            v += c.sum.load(std::memory_order_relaxed);
+        }
+        return v;
+    }
+
+    uint64_t max() const
+    {
+        uint64_t v = 0;
+        for (auto& c : m_cells) {
+            v = std::max(v, c.max.load(std::memory_order_relaxed));
+        }
+        return v;
+    }
+
+    uint64_t bucket_count(unsigned b) const
+    {
+        uint64_t v = 0;
+        for (auto& c : m_cells) {
+            v += c.buckets[b].load(std::memory_order_relaxed);
+        }
+        return v;
+    }
+
+    void clear() override
+    {
+        for (auto& c : m_cells) {
+            c.count.store(0, std::memory_order_relaxed);
+            c.sum.store(0, std::memory_order_relaxed);
+            c.max.store(0, std::memory_order_relaxed);
+            for (auto& b : c.buckets) {
+                b.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /* {"count": n, "sum": s, "max": m, "buckets": [[upper bound (excluded), count], ...]} */
+    void to_json(std::ostream& os) const override
+    {
+        os << "{\"count\": " << count() << ", \"sum\": " << sum() << ", \"max\": " << max() << ", \"buckets\": [";
+        const char* sep = "";
+        for (unsigned b = 0; b < BUCKETS; b++) {
+            uint64_t n = bucket_count(b);
+            if (n) {
+                /* the last bucket has no representable upper bound */
+                os << sep << "[" << (b < 64 ? (uint64_t(1) << b) : UINT64_MAX) << ", " << n << "]";
+                sep = ", ";
+            }
+        }
+        os << "]}";
+    }
+};
+
+/**
+ * @class timer
+ *
+ * @brief Record the host time spent in a scope (in ns) into a histogram.
+ * The clock isn't read when recording is disabled.
+ */
+class timer
+{
+    histogram& m_hist;
+    bool m_on;
+    std::chrono::steady_clock::time_point m_start;
+
+public:
+    timer(histogram& h): m_hist(h), m_on(enabled())
+    {
+        if (m_on) {
+            m_start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~timer()
+    {
+        if (m_on) {
+            m_hist.record(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start)
+                    .count());
+        }
+    }
+};
+
+void registry::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& s : m_stats) {
+        s.second->clear();
+    }
+}
+
+/* A flat object, keyed by the full name of the stats */
+std::string registry::to_json()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::ostringstream os;
+    os << "{";
+    const char* sep = "\n";
+    for (auto& s : m_stats) {
+        os << sep << "  \"";
+        for (char c : s.first) {
+            if (c == '"' || c == '\\') {
+                os << '\\';
+            }
+            os << c;
+        }
+        os << "\": ";
+        s.second->to_json(os);
+        sep = ",\n";
+    }
+    os << "\n}\n";
+    return os.str();
+}
+
+} // namespace perf
+} // namespace gs
+
+#endif
@@ -248,6 +248,21 @@ public:
         m_send_event.notify();
     }
 
+    /**
+     * @brief enqueue
+     * Enqueue len items to be sent at once (unlimited queue size)
+     * NOTE: Thread safe.
+     * @param data
+     * @param len
+     */
+    void enqueue(const T* data, size_t len)
+    {
+        if (!len) return;
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_queue.insert(m_queue.end(), data, data + len);
+        m_send_event.notify();
+    }
+
     /**
      * @brief set_default_txn
      * set transaction parameters (command, address and data_length)
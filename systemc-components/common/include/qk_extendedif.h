@@ -31,6 +31,18 @@ enum Type { SYSTEMC_THREAD, OS_THREAD };
 
 class tlm_quantumkeeper_extended : public tlm_utils::tlm_quantumkeeper, public sc_core::sc_object
 {
+    sc_core::sc_time m_quantum = sc_core::SC_ZERO_TIME;
+
+protected:
+    // next boundary of the quantum of this QK, rather than of the global one
+    virtual sc_core::sc_time compute_local_quantum() override
+    {
+        sc_core::sc_time quantum = get_quantum();
+        if (quantum == sc_core::SC_ZERO_TIME) return sc_core::SC_ZERO_TIME;
+        sc_dt::uint64 now = sc_core::sc_time_stamp().value();
+        return sc_core::sc_time::from_value((now / quantum.value() + 1) * quantum.value() - now);
+    }
+
 public:
     tlm_quantumkeeper_extended(): sc_object("qk") {}
 
@@ -38,6 +50,34 @@ public:
      * Additional functions
      */
 
+    /*
+     * The quantum of the domain of this QK (e.g. the CPUs of a QEMU
+     * instance), the global quantum if SC_ZERO_TIME. To be set before the
+     * QK is started.
+     */
+    virtual void set_quantum(const sc_core::sc_time& quantum) { m_quantum = quantum; }
+
+    sc_core::sc_time get_quantum() const
+    {
+        return m_quantum != sc_core::SC_ZERO_TIME ? m_quantum : tlm_utils::tlm_quantumkeeper::get_global_quantum();
+    }
+
+    /*
+     * The period at which two quantum domains are both on a quantum boundary
+     * (their least common multiple), SC_ZERO_TIME if one of them has none.
+     */
+    static sc_core::sc_time common_boundary(const sc_core::sc_time& a, const sc_core::sc_time& b)
+    {
+        sc_dt::uint64 x = a.value(), y = b.value();
+        if (x == 0 || y == 0) return sc_core::SC_ZERO_TIME;
+        while (y) {
+            sc_dt::uint64 r = x % y;
+            x = y;
+            y = r;
+        }
+        return sc_core::sc_time::from_value(a.value() / x * b.value());
+    }
+
     // based on standard tlm2 QK.
     virtual sc_core::sc_time time_to_sync()
     {
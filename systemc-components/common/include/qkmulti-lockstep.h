@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef QKMULTI_LOCKSTEP_H
+#define QKMULTI_LOCKSTEP_H
+
+#include <qkmultithread.h>
+
+namespace gs {
+/*
+ * SystemC and the initiator take turns: the initiator doesn't run past its
+ * local time until SystemC has caught up with it, and SystemC doesn't run
+ * past the local time of the slowest initiator. Used by the deterministic
+ * mode of libqbox, which moves the local time a quantum at a time.
+ */
+class tlm_quantumkeeper_multi_lockstep : public tlm_quantumkeeper_multithread
+{
+    // A quantum of budget once SystemC has reached our local time, none before
+    virtual sc_core::sc_time time_to_sync() override
+    {
+        if (sc_core::sc_time_stamp() >= get_current_time()) {
+            return get_quantum();
+        } else {
+            return sc_core::SC_ZERO_TIME;
+        }
+    }
+
+    virtual bool need_sync() override { return time_to_sync() == sc_core::SC_ZERO_TIME; }
+};
+} // namespace gs
+#endif
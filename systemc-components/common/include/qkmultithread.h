@@ -16,6 +16,7 @@
 #include <tlm_utils/tlm_quantumkeeper.h>
 #include <async_event.h>
 #include <qk_extendedif.h>
+#include <perf/counters.h>
 
 namespace gs {
 // somewhat tuned multiple threaded QK
@@ -32,6 +33,10 @@ protected:
     bool m_extern_waiting;
     async_event m_tick;
 
+    /* registered under the object the QK is created in (e.g. the CPU) */
+    perf::counter m_syncs;
+    perf::histogram m_sync_wait_ns;
+
     virtual bool is_sysc_thread() const;
 
 private:
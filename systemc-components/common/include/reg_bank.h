@@ -0,0 +1,372 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef GS_REG_BANK_H
+#define GS_REG_BANK_H
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <systemc>
+#include <tlm>
+#include <tlm_utils/simple_target_socket.h>
+#include <scp/report.h>
+#include <tlm_sockets_buswidth.h>
+#include <registers.h>
+
+namespace gs {
+
+/*
+ * Register banks generated from a register description by
+ * systemc-components/common/scripts/gen-reg-bank.py.
+ *
+ * A bank holds the values of all its registers in one storage block, behind
+ * a single target socket. The generator emits the register descriptions and
+ * the offset to register decode table as constant tables. Unlike gs_register,
+ * a register of a bank has no socket and no CCI parameter of its own. Its
+ * callbacks are the ones of gs_register (tlm_fnct::TLMFUNC), called with the
+ * address being the offset in the bank.
+ */
+
+enum reg_access : uint8_t { REG_RW, REG_RO, REG_WO };
+
+struct reg_desc {
+    const char* name;
+    uint64_t offset;
+    uint32_t size;  /* of an element, in bytes */
+    uint32_t count; /* number of elements */
+    uint64_t reset;
+    uint8_t access;
+};
+
+/**
+ * @class reg_bank
+ *
+ * @brief The generated banks derive from it. It decodes the accesses to the
+ * registers, calls their callbacks and stores their values.
+ *
+ * @details The decode table, if any, gives the index + 1 of the register of
+ * each granule of the bank (0 if none). The generator doesn't emit it for
+ * large sparse banks, which are decoded by binary search in the register
+ * descriptions (sorted by offset).
+ *
+ * DMI to the storage is granted while no register has callbacks, over the
+ * runs of contiguous registers with the same access: read write, or read only.
+ * The write only registers and the holes between the registers are never
+ * reachable through DMI.
+ */
+class reg_bank : public sc_core::sc_module
+{
+    SCP_LOGGER(());
+
+public:
+    struct handlers {
+        std::vector<std::shared_ptr<tlm_fnct>> pre_read;
+        std::vector<std::shared_ptr<tlm_fnct>> pre_write;
+        std::vector<std::shared_ptr<tlm_fnct>> post_read;
+        std::vector<std::shared_ptr<tlm_fnct>> post_write;
+    };
+
+    tlm_utils::simple_target_socket<reg_bank, DEFAULT_TLM_BUSWIDTH> target_socket;
+
+private:
+    const reg_desc* m_regs;
+    size_t m_nregs;
+    uint64_t m_size;
+    const uint16_t* m_decode;
+    unsigned int m_granule_shift;
+    std::vector<uint8_t> m_storage;
+    std::vector<handlers> m_handlers;
+    size_t m_nb_callbacks = 0;
+
+    struct dmi_range {
+        uint64_t start;
+        uint64_t end; /* included */
+        bool read_only;
+    };
+    std::vector<dmi_range> m_dmi_ranges; /* sorted by address */
+
+    const reg_desc* find(uint64_t offset) const
+    {
+        if (offset >= m_size) {
+            return nullptr;
+        }
+        if (m_decode) {
+            uint16_t i = m_decode[offset >> m_granule_shift];
+            return i ? &m_regs[i - 1] : nullptr;
+        }
+        size_t lo = 0, hi = m_nregs;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (m_regs[mid].offset <= offset) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        if (lo == 0) {
+            return nullptr;
+        }
+        const reg_desc* r = &m_regs[lo - 1];
+        return (offset - r->offset < uint64_t(r->size) * r->count) ? r : nullptr;
+    }
+
+    const dmi_range* find_dmi(uint64_t offset) const
+    {
+        auto it = std::upper_bound(m_dmi_ranges.begin(), m_dmi_ranges.end(), offset,
+                                   [](uint64_t o, const dmi_range& d) { return o < d.start; });
+        if (it == m_dmi_ranges.begin() || offset > (it - 1)->end) {
+            return nullptr;
+        }
+        return &*(it - 1);
+    }
+
+    static void call(std::vector<std::shared_ptr<tlm_fnct>>& fncts, tlm::tlm_generic_payload& txn,
+                     sc_core::sc_time& delay)
+    {
+        for (auto& cb : fncts) (*cb)(txn, delay);
+    }
+
+    void b_transport(tlm::tlm_generic_payload& txn, sc_core::sc_time& delay)
+    {
+        uint64_t addr = txn.get_address();
+        unsigned int len = txn.get_data_length();
+        const reg_desc* r = find(addr);
+
+        txn.set_dmi_allowed(false);
+        if (!r || txn.get_byte_enable_ptr() || txn.get_streaming_width() < len ||
+            ((addr - r->offset) % r->size) + len > r->size) {
+            SCP_WARN(())("Access to no register (or across registers) at offset 0x{:x} size {}", addr, len);
+            txn.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+            return;
+        }
+
+        bool is_read = txn.is_read();
+        if (!is_read && !txn.is_write()) {
+            txn.set_response_status(tlm::TLM_OK_RESPONSE);
+            return;
+        }
+        if ((is_read && r->access == REG_WO) || (!is_read && r->access == REG_RO)) {
+            SCP_WARN(())("{} of the {} register {}", is_read ? "Read" : "Write",
+                         r->access == REG_RO ? "read only" : "write only", r->name);
+            txn.set_response_status(tlm::TLM_COMMAND_ERROR_RESPONSE);
+            return;
+        }
+
+        handlers& h = m_handlers[r - m_regs];
+        txn.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+        call(is_read ? h.pre_read : h.pre_write, txn, delay);
+        if (txn.get_response_status() < tlm::TLM_INCOMPLETE_RESPONSE) {
+            return;
+        }
+        if (is_read) {
+            memcpy(txn.get_data_ptr(), &m_storage[addr], len);
+        } else {
+            memcpy(&m_storage[addr], txn.get_data_ptr(), len);
+        }
+        txn.set_response_status(tlm::TLM_OK_RESPONSE);
+        call(is_read ? h.post_read : h.post_write, txn, delay);
+        txn.set_dmi_allowed(m_nb_callbacks == 0 && find_dmi(addr));
+    }
+
+    unsigned int transport_dbg(tlm::tlm_generic_payload& txn)
+    {
+        uint64_t addr = txn.get_address();
+        unsigned int len = txn.get_data_length();
+
+        if (addr >= m_size || len > m_size - addr) {
+            txn.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+            return 0;
+        }
+        if (txn.is_read()) {
+            memcpy(txn.get_data_ptr(), &m_storage[addr], len);
+        } else if (txn.is_write()) {
+            memcpy(&m_storage[addr], txn.get_data_ptr(), len);
+        }
+        txn.set_response_status(tlm::TLM_OK_RESPONSE);
+        return len;
+    }
+
+    bool get_direct_mem_ptr(tlm::tlm_generic_payload& txn, tlm::tlm_dmi& dmi_data)
+    {
+        const dmi_range* d = find_dmi(txn.get_address());
+        if (m_nb_callbacks || !d) {
+            return false;
+        }
+        dmi_data.set_dmi_ptr(&m_storage[d->start]);
+        dmi_data.set_start_address(d->start);
+        dmi_data.set_end_address(d->end);
+        dmi_data.set_granted_access(d->read_only ? tlm::tlm_dmi::DMI_ACCESS_READ
+                                                 : tlm::tlm_dmi::DMI_ACCESS_READ_WRITE);
+        return true;
+    }
+
+public:
+    reg_bank(const sc_core::sc_module_name& nm, const reg_desc* regs, size_t nregs, uint64_t size,
+             const uint16_t* decode, unsigned int granule_shift)
+        : sc_core::sc_module(nm)
+        , target_socket("target_socket")
+        , m_regs(regs)
+        , m_nregs(nregs)
+        , m_size(size)
+        , m_decode(decode)
+        , m_granule_shift(granule_shift)
+        , m_storage(size)
+        , m_handlers(nregs)
+    {
+        for (size_t i = 0; i < m_nregs; i++) {
+            const reg_desc& r = m_regs[i];
+            if (r.access == REG_WO) {
+                continue;
+            }
+            uint64_t end = r.offset + uint64_t(r.size) * r.count - 1;
+            bool ro = (r.access == REG_RO);
+            if (!m_dmi_ranges.empty() && m_dmi_ranges.back().end + 1 == r.offset &&
+                m_dmi_ranges.back().read_only == ro) {
+                m_dmi_ranges.back().end = end;
+            } else {
+                m_dmi_ranges.push_back({ r.offset, end, ro });
+            }
+        }
+        reset();
+
+        target_socket.register_b_transport(this, &reg_bank::b_transport);
+        target_socket.register_transport_dbg(this, &reg_bank::transport_dbg);
+        target_socket.register_get_direct_mem_ptr(this, &reg_bank::get_direct_mem_ptr);
+    }
+
+    reg_bank() = delete;
+    reg_bank(const reg_bank&) = delete;
+
+    /* Set all the registers to their reset value */
+    void reset()
+    {
+        std::fill(m_storage.begin(), m_storage.end(), 0);
+        for (size_t i = 0; i < m_nregs; i++) {
+            const reg_desc& r = m_regs[i];
+            for (uint32_t e = 0; e < r.count; e++) {
+                memcpy(&m_storage[r.offset + e * r.size], &r.reset, r.size);
+            }
+        }
+    }
+
+    uint8_t* storage(uint64_t offset) { return &m_storage[offset]; }
+
+    const reg_desc& desc(size_t idx) const { return m_regs[idx]; }
+
+    /* The storage is not DMI-able anymore once a register has callbacks */
+    handlers& add_callback(size_t idx)
+    {
+        if (m_nb_callbacks++ == 0 && sc_core::sc_get_status() >= sc_core::SC_END_OF_ELABORATION &&
+            target_socket.get_base_port().size()) {
+            target_socket->invalidate_direct_mem_ptr(0, m_size - 1);
+        }
+        return m_handlers[idx];
+    }
+};
+
+/**
+ * @class bank_register
+ *
+ * @brief A register of a bank, with the value and callbacks API of
+ * gs_register
+ */
+template <class TYPE = uint32_t>
+class bank_register
+{
+    static_assert(std::is_unsigned<TYPE>::value, "Register types must be unsigned");
+
+    reg_bank& m_bank;
+    size_t m_idx;
+    TYPE* m_ptr;
+
+public:
+    bank_register(reg_bank& bank, size_t idx)
+        : m_bank(bank), m_idx(idx), m_ptr(reinterpret_cast<TYPE*>(bank.storage(bank.desc(idx).offset)))
+    {
+        sc_assert(bank.desc(idx).size == sizeof(TYPE));
+    }
+    bank_register(const bank_register&) = delete;
+
+    TYPE get(uint64_t idx = 0) const
+    {
+        sc_assert(idx < m_bank.desc(m_idx).count);
+        return m_ptr[idx];
+    }
+    void set(TYPE value, uint64_t idx = 0)
+    {
+        sc_assert(idx < m_bank.desc(m_idx).count);
+        m_ptr[idx] = value;
+    }
+
+    operator TYPE() const { return get(); }
+    void operator=(TYPE value) { set(value); }
+    void operator+=(TYPE other) { set(get() + other); }
+    void operator-=(TYPE other) { set(get() - other); }
+    void operator&=(TYPE other) { set(get() & other); }
+    void operator|=(TYPE other) { set(get() | other); }
+    void operator<<=(TYPE other) { set(get() << other); }
+    void operator>>=(TYPE other) { set(get() >> other); }
+
+    TYPE& operator[](int idx) { return m_ptr[idx]; }
+
+    void pre_read(tlm_fnct::TLMFUNC cb)
+    {
+        m_bank.add_callback(m_idx).pre_read.push_back(std::make_shared<tlm_fnct>(cb));
+    }
+    void pre_write(tlm_fnct::TLMFUNC cb)
+    {
+        m_bank.add_callback(m_idx).pre_write.push_back(std::make_shared<tlm_fnct>(cb));
+    }
+    void post_read(tlm_fnct::TLMFUNC cb)
+    {
+        m_bank.add_callback(m_idx).post_read.push_back(std::make_shared<tlm_fnct>(cb));
+    }
+    void post_write(tlm_fnct::TLMFUNC cb)
+    {
+        m_bank.add_callback(m_idx).post_write.push_back(std::make_shared<tlm_fnct>(cb));
+    }
+
+    std::string get_regname() const { return m_bank.desc(m_idx).name; }
+    uint64_t get_offset() const { return m_bank.desc(m_idx).offset; }
+    uint64_t get_size() const { return uint64_t(m_bank.desc(m_idx).size) * m_bank.desc(m_idx).count; }
+};
+
+/**
+ * @class bank_field
+ *
+ * @brief A field of a bank register, its position known at compile time
+ */
+template <class TYPE, unsigned int START, unsigned int LENGTH>
+class bank_field
+{
+    static_assert(START + LENGTH <= sizeof(TYPE) * 8, "Field out of the register");
+
+    bank_register<TYPE>& m_reg;
+
+public:
+    static constexpr TYPE mask = (LENGTH == sizeof(TYPE) * 8) ? std::numeric_limits<TYPE>::max()
+                                                              : TYPE(((TYPE(1) << LENGTH) - 1) << START);
+
+    bank_field(bank_register<TYPE>& reg): m_reg(reg) {}
+    bank_field(const bank_field&) = delete;
+
+    operator TYPE() const { return (m_reg.get() & mask) >> START; }
+    void operator=(TYPE value)
+    {
+        sc_assert(((value << START) & ~mask) == 0);
+        m_reg = (m_reg.get() & ~mask) | (value << START);
+    }
+};
+
+} // namespace gs
+
+#endif // GS_REG_BANK_H
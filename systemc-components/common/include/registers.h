@@ -7,6 +7,7 @@
 #ifndef GS_REGISTERS_H
 #define GS_REGISTERS_H
 
+#include <limits>
 #include <type_traits>
 
 #include <systemc>
@@ -111,7 +112,16 @@ class port_fnct : public tlm_utils::simple_target_socket<port_fnct, DEFAULT_TLM_
                 m_in_callback = false;
             }
         }
-        txn.set_dmi_allowed(false);
+        /* Tell the reg_router whether the register may be accessed through DMI */
+        txn.set_dmi_allowed(!has_callbacks());
+    }
+
+    /* The reg_router may have granted DMI to the register while it had no callback */
+    void callbacks_changed()
+    {
+        if (sc_core::sc_get_status() >= sc_core::SC_END_OF_ELABORATION && get_base_port().size()) {
+            (*this)->invalidate_direct_mem_ptr(0, std::numeric_limits<sc_dt::uint64>::max());
+        }
     }
 
     template <typename T>
@@ -122,10 +132,32 @@ class port_fnct : public tlm_utils::simple_target_socket<port_fnct, DEFAULT_TLM_
     }
 
 public:
-    void pre_read(tlm_fnct::TLMFUNC cb) { m_pre_read_fncts.push_back(std::make_shared<tlm_fnct>(cb)); }
-    void pre_write(tlm_fnct::TLMFUNC cb) { m_pre_write_fncts.push_back(std::make_shared<tlm_fnct>(cb)); }
-    void post_read(tlm_fnct::TLMFUNC cb) { m_post_read_fncts.push_back(std::make_shared<tlm_fnct>(cb)); }
-    void post_write(tlm_fnct::TLMFUNC cb) { m_post_write_fncts.push_back(std::make_shared<tlm_fnct>(cb)); }
+    void pre_read(tlm_fnct::TLMFUNC cb)
+    {
+        m_pre_read_fncts.push_back(std::make_shared<tlm_fnct>(cb));
+        callbacks_changed();
+    }
+    void pre_write(tlm_fnct::TLMFUNC cb)
+    {
+        m_pre_write_fncts.push_back(std::make_shared<tlm_fnct>(cb));
+        callbacks_changed();
+    }
+    void post_read(tlm_fnct::TLMFUNC cb)
+    {
+        m_post_read_fncts.push_back(std::make_shared<tlm_fnct>(cb));
+        callbacks_changed();
+    }
+    void post_write(tlm_fnct::TLMFUNC cb)
+    {
+        m_post_write_fncts.push_back(std::make_shared<tlm_fnct>(cb));
+        callbacks_changed();
+    }
+
+    bool has_callbacks() const
+    {
+        return m_pre_read_fncts.size() || m_pre_write_fncts.size() || m_post_read_fncts.size() ||
+               m_post_write_fncts.size();
+    }
 
     port_fnct() = delete;
     port_fnct(std::string name, std::string path_name)
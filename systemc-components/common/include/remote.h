@@ -329,6 +329,7 @@ public:
     cci::cci_param<uint32_t> p_tlm_target_ports_num;
     cci::cci_param<uint32_t> p_initiator_signals_num;
     cci::cci_param<uint32_t> p_target_signals_num;
+    cci::cci_param<uint64_t> p_sync_quantum_ns;
 
 private:
     rpc::client* client = nullptr;
@@ -427,6 +428,14 @@ private:
 
     std::unique_ptr<trans_waiter> btspt_waiter;
 
+    /* Horizon published by the remote (its time plus its quantum), in ns */
+    std::atomic<uint64_t> m_remote_horizon_ns{ 0 };
+    gs::async_event m_remote_time_ev{ false };
+    uint64_t m_next_publish_ns = 0;
+    bool m_sync_suspended = false;
+    /* The most we were past the time of a transaction from the remote */
+    sc_core::sc_time m_max_late;
+
     template <typename... Args>
     std::future<RPCLIB_MSGPACK::object_handle> do_rpc_async_call(std::string const& func_name, Args... args)
     {
@@ -621,10 +630,8 @@ private:
         }
 
         r.update_to_tlm(trans);
+        // with the time the access took in the remote
         delay = sc_core::sc_time(r.m_quantum_time, sc_core::SC_SEC);
-        sc_core::sc_time other_time = sc_core::sc_time(r.m_sc_time, sc_core::SC_SEC);
-        //        m_qk->set(other_time+delay);
-        //        m_qk->sync();
         //        SCP_DEBUG(()) << name() << " update_to_tlm " << txn_str(trans);
         //        SCP_DEBUG(()) << name() << " b_transport socket ID " << id << " returned " <<
         //        txn_str(trans);
@@ -639,23 +646,29 @@ private:
         sc_core::sc_time delay = sc_core::sc_time(t.m_quantum_time, sc_core::SC_SEC);
         sc_core::sc_time other_time = sc_core::sc_time(t.m_sc_time, sc_core::SC_SEC);
 
-        //       SCP_DEBUG(()) << "Here"<<m_qk->time_to_sync();
-        //        m_qk->sync();
-        //        SCP_DEBUG(()) << "THere";
         //        SCP_DEBUG(()) << getpid() <<" IS THE rpc RPC PID " <<
         //        std::this_thread::get_id() <<" is the thread ID";
         m_sc.run_on_sysc([&] {
-            //             SCP_DEBUG(()) <<"gere "<<id;
-            //        SCP_DEBUG(()) << getpid() <<" IS THE rpc RPC PID " <<
-            //        std::this_thread::get_id()
-            //        <<" is the thread ID";
-            //             m_qk->set(other_time+delay - sc_core::sc_time_stamp());
-            //             SCP_DEBUG(()) << "WHAT Sync";
-            //             m_qk->sync();
-            //             m_qk->reset();
-            initiator_sockets[id]->b_transport(trans, delay);
-            //             SCP_DEBUG(()) << "WHAT";
-            //             m_qk->sync();
+            sc_core::sc_time local_delay = delay;
+            if (p_sync_quantum_ns.get_value()) {
+                /*
+                 * The access happens at the time of the remote plus its delay.
+                 * If we are already past it (by less than the quantum of the
+                 * remote), it happens now.
+                 */
+                sc_core::sc_time at = other_time + delay;
+                sc_core::sc_time now = sc_core::sc_time_stamp();
+                local_delay = at > now ? at - now : sc_core::SC_ZERO_TIME;
+                if (now > at) {
+                    m_max_late = std::max(m_max_late, now - at);
+                }
+            }
+            sc_core::sc_time start = local_delay;
+            initiator_sockets[id]->b_transport(trans, local_delay);
+            // hand back the time the access took
+            if (local_delay > start) {
+                delay += local_delay - start;
+            }
         });
         t.from_tlm(trans);
         t.m_quantum_time = delay.to_seconds();
@@ -884,6 +897,9 @@ public:
         , p_tlm_target_ports_num("tlm_target_ports_num", 0, "number of tlm target ports")
         , p_initiator_signals_num("initiator_signals_num", 0, "number of initiator signals")
         , p_target_signals_num("target_signals_num", 0, "number of target signals")
+        , p_sync_quantum_ns("sync_quantum_ns", 0,
+                            "Let the remote run up to this far ahead of us, while we run up to the horizon it "
+                            "publishes (0: the SystemC times of the processes are not synchronized)")
         , cancel_waiting(false)
     {
         SigHandler::get().add_sig_handler(SIGINT, SigHandler::Handler_CB::PASS);
@@ -995,6 +1011,14 @@ public:
                 return;
             });
 
+            server->bind("time", [&](uint64_t horizon_ns) {
+                if (horizon_ns > m_remote_horizon_ns) {
+                    m_remote_horizon_ns = horizon_ns;
+                }
+                m_remote_time_ev.async_notify();
+                return;
+            });
+
             server->bind("sock_pair", [&](int sock_fd0, int sock_fd1) {
                 pahandler.recv_sockpair_fds_from_remote(sock_fd0, sock_fd1);
                 pahandler.check_parent_conn_nth([&]() {
@@ -1086,6 +1110,12 @@ public:
             is_client_connected.wait(ul, [&]() { return (p_cport > 0 || cancel_waiting); });
             ul.unlock();
             send_status();
+
+            // the remote side only knows the value once connected
+            if (p_sync_quantum_ns.get_value()) {
+                SC_HAS_PROCESS(MOD);
+                SC_METHOD(time_sync);
+            }
         }
     }                                                                              // namespace gs
     PassRPC(const sc_core::sc_module_name& nm, int port): PassRPC(nm, "", port){}; // convenience constructor
@@ -1100,6 +1130,63 @@ public:
         SCP_DEBUG(()) << "SIMULATION STATE synced " << name() << " to status " << sc_core::sc_get_status();
     }
 
+    /*
+     * Conservative time synchronization with the remote. Once per quantum,
+     * a null message publishes our time plus the quantum as the horizon the
+     * remote may run up to. SystemC runs freely up to the horizon published
+     * by the remote, and is suspended there until the remote publishes a
+     * later one, the transactions and signals crossing over being handled
+     * meanwhile. So the processes only wait for each other when one falls
+     * behind, and a process is never ahead of the other by more than the
+     * quantum of the other. The quanta may differ on each side.
+     */
+    void time_sync()
+    {
+        if (cancel_waiting) {
+            if (m_sync_suspended) {
+                m_sync_suspended = false;
+                m_remote_time_ev.async_detach_suspending();
+                sc_core::sc_unsuspend_all();
+            }
+            return;
+        }
+
+        // rounded, the time resolution may be coarser or finer than 1ns
+        uint64_t now_ns = uint64_t(sc_core::sc_time_stamp().to_seconds() * 1e9 + 0.5);
+        if (now_ns >= m_next_publish_ns) {
+            m_next_publish_ns = now_ns + p_sync_quantum_ns.get_value();
+            do_rpc_async_call("time", m_next_publish_ns);
+        }
+
+        uint64_t horizon_ns = m_remote_horizon_ns;
+        if (horizon_ns > now_ns) {
+            if (m_sync_suspended) {
+                m_sync_suspended = false;
+                m_remote_time_ev.async_detach_suspending();
+                SCP_TRACE(()) << "Unsuspending, the remote horizon is " << horizon_ns << "ns";
+                sc_core::sc_unsuspend_all();
+            }
+            sc_core::sc_time next(double(std::min(horizon_ns, m_next_publish_ns) - now_ns), sc_core::SC_NS);
+            // at least a resolution, for a coarse resolution not to round it to 0
+            next_trigger(std::max(next, sc_core::sc_get_time_resolution()));
+        } else {
+            if (!m_sync_suspended) {
+                m_sync_suspended = true;
+                // keep SystemC alive while the remote is behind
+                m_remote_time_ev.async_attach_suspending();
+                SCP_TRACE(()) << "Suspending at the remote horizon " << horizon_ns << "ns";
+                sc_core::sc_suspend_all();
+            }
+            next_trigger(m_remote_time_ev);
+        }
+    }
+
+    /* The horizon published by the remote (its time plus its quantum), we don't run past it */
+    sc_core::sc_time get_remote_horizon() const
+    {
+        return sc_core::sc_time(double(m_remote_horizon_ns.load()), sc_core::SC_NS);
+    }
+
     void handle_before_sim_start_signals()
     {
         std::lock_guard<std::mutex> lg(sig_queue_mut);
@@ -1114,6 +1201,9 @@ public:
     {
         if (cancel_waiting) return;
         cancel_waiting = true;
+        if (p_sync_quantum_ns.get_value()) {
+            m_remote_time_ev.async_notify();
+        }
         {
             std::lock_guard<std::mutex> cc_lg(client_conncted_mut);
             is_client_connected.notify_one();
@@ -1180,6 +1270,9 @@ public:
     void end_of_simulation() override
     {
         if (is_local_mode()) return;
+        if (p_sync_quantum_ns.get_value()) {
+            SCP_INFO(()) << "Transactions from the remote were handled up to " << m_max_late << " late";
+        }
         // m_qk->stop();
         stop();
     }
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _GREENSOCS_DMI_MAP_EXTENSION_H
+#define _GREENSOCS_DMI_MAP_EXTENSION_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <systemc>
+#include <tlm>
+
+namespace gs {
+
+/**
+ * @class DMI map query TLM extension
+ *
+ * @details Set on a debug transaction with the TLM_IGNORE_COMMAND command, to
+ * ask for the static memory map of the interconnect. The first router the
+ * transaction reaches fills in the [start, end] windows of its targets, which
+ * may grant DMI, and does not forward the transaction. The windows are left
+ * empty if no router is found. The extension is owned by the initiator.
+ */
+class DmiMapExtension : public tlm::tlm_extension<DmiMapExtension>
+{
+public:
+    std::vector<std::pair<uint64_t, uint64_t>> windows;
+
+    DmiMapExtension() = default;
+    DmiMapExtension(const DmiMapExtension&) = default;
+
+    virtual tlm_extension_base* clone() const override { return new DmiMapExtension(*this); }
+
+    virtual void copy_from(const tlm_extension_base& ext) override
+    {
+        windows = static_cast<const DmiMapExtension&>(ext).windows;
+    }
+};
+} // namespace gs
+#endif
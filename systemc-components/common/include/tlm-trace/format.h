@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _GREENSOCS_TLM_TRACE_FORMAT_H
+#define _GREENSOCS_TLM_TRACE_FORMAT_H
+
+#include <cstdint>
+
+/*
+ * Binary transaction trace format
+ *
+ * A trace file is a file_header followed by fixed size records. Records are
+ * in order for a given host thread, but records of different threads may be
+ * interleaved out of order (use the time field to sort them).
+ *
+ * Recording points (routers, probes) are identified by a source number,
+ * whose name is given by KIND_SOURCE records: the name is split into chunks
+ * of up to DATA_LEN bytes, 'address' is the offset of the chunk in the name,
+ * and 'length' the total length of the name.
+ */
+namespace gs {
+namespace trace {
+
+static constexpr char TRACE_MAGIC[8] = { 'G', 'S', 'T', 'R', 'A', 'C', 'E', '1' };
+
+static constexpr uint16_t NO_ID = 0xffff;
+static constexpr int PATH_LEN = 4;
+static constexpr int DATA_LEN = 20;
+
+enum record_kind : uint8_t {
+    KIND_TXN = 0,     /* b_transport */
+    KIND_DBG = 1,     /* transport_dbg */
+    KIND_SOURCE = 2,  /* source name (see above) */
+    KIND_DROPPED = 3, /* 'length' records were lost because a ring buffer was full */
+};
+
+struct file_header {
+    char magic[8];
+    uint32_t record_size;
+    uint32_t reserved;
+    uint64_t time_unit_fs; /* unit of the time and delay fields, in femtoseconds */
+};
+
+struct record {
+    uint64_t time;          /* SystemC time when the transaction returned */
+    uint64_t delay;         /* annotated delay when the transaction returned */
+    uint64_t address;       /* address as seen by the recording point */
+    uint32_t length;        /* data length */
+    uint16_t source;        /* recording point */
+    uint16_t target;        /* target port on the recording point, NO_ID if unknown */
+    uint16_t path[PATH_LEN]; /* initiator path id (gs::PathIDExtension), NO_ID terminated */
+    uint8_t kind;           /* record_kind */
+    uint8_t command;        /* tlm::tlm_command */
+    int8_t response;        /* tlm::tlm_response_status */
+    uint8_t data_len;       /* number of valid bytes in data */
+    uint8_t data[DATA_LEN]; /* first bytes of the data */
+};
+
+static_assert(sizeof(record) == 64, "trace records must be 64 bytes");
+
+} // namespace trace
+} // namespace gs
+
+#endif
@@ -0,0 +1,334 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _GREENSOCS_TLM_TRACE_RECORDER_H
+#define _GREENSOCS_TLM_TRACE_RECORDER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <systemc>
+#include <tlm>
+
+#include <tlm-trace/format.h>
+#include <tlm-extensions/pathid_extension.h>
+
+namespace gs {
+namespace trace {
+
+/**
+ * @class recorder
+ *
+ * @brief Records transactions into a binary trace file (see format.h).
+ *
+ * Each host thread records into its own lock-free ring buffer, which a
+ * background thread flushes to the file. Recording never blocks: if a ring
+ * is full, the record is dropped and counted (see KIND_DROPPED).
+ *
+ * Recorders are shared per file, use recorder::get() to obtain one.
+ */
+class recorder
+{
+    struct ring {
+        std::vector<record> buf;
+        uint64_t mask;
+        std::atomic<uint64_t> head{ 0 }; /* written by the recording thread */
+        std::atomic<uint64_t> tail{ 0 }; /* written by the flusher */
+
+        ring(uint32_t size): buf(size), mask(size - 1) {}
+    };
+
+    uint64_t m_id;
+    std::string m_fname;
+    FILE* m_file;
+    uint32_t m_ring_size;
+
+    std::mutex m_rings_mutex;
+    std::vector<std::unique_ptr<ring>> m_rings;
+    std::map<std::thread::id, ring*> m_thread_rings;
+
+    std::mutex m_sources_mutex;
+    std::vector<std::string> m_sources;
+
+    std::atomic<uint64_t> m_dropped{ 0 };
+    uint64_t m_dropped_reported = 0;
+
+    std::mutex m_mutex; /* file access */
+    std::condition_variable m_cond;
+    bool m_stop = false;
+    std::thread m_flusher;
+
+    static std::atomic<uint64_t>& next_id()
+    {
+        static std::atomic<uint64_t> id{ 1 };
+        return id;
+    }
+
+    /*
+     * The ring of this thread. A thread keeps the rings of the last few
+     * recorders it used, so that alternating between recorders (e.g. two
+     * routers tracing to different files) doesn't take the lock.
+     */
+    ring* local_ring()
+    {
+        static constexpr size_t CACHE_SIZE = 8;
+        struct cache_entry {
+            uint64_t id;
+            ring* r;
+        };
+        thread_local std::vector<cache_entry> cache;
+        thread_local size_t next_victim = 0;
+
+        for (const cache_entry& e : cache) {
+            if (e.id == m_id) {
+                return e.r;
+            }
+        }
+
+        ring* r;
+        {
+            std::lock_guard<std::mutex> lock(m_rings_mutex);
+            ring*& tr = m_thread_rings[std::this_thread::get_id()];
+            if (!tr) {
+                m_rings.emplace_back(new ring(m_ring_size));
+                tr = m_rings.back().get();
+            }
+            r = tr;
+        }
+        if (cache.size() < CACHE_SIZE) {
+            cache.push_back({ m_id, r });
+        } else {
+            cache[next_victim++ % CACHE_SIZE] = { m_id, r };
+        }
+        return r;
+    }
+
+    record* alloc(ring* r)
+    {
+        uint64_t head = r->head.load(std::memory_order_relaxed);
+        uint64_t tail = r->tail.load(std::memory_order_acquire);
+        if (head - tail >= r->buf.size()) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        return &r->buf[head & r->mask];
+    }
+
+    void commit(ring* r)
+    {
+        uint64_t head = r->head.load(std::memory_order_relaxed) + 1;
+        r->head.store(head, std::memory_order_release);
+        if (head - r->tail.load(std::memory_order_relaxed) == r->buf.size() / 2) {
+            /* don't wait for the next period to make room */
+            m_cond.notify_one();
+        }
+    }
+
+    /* Must be called with m_mutex held */
+    void drain()
+    {
+        std::vector<ring*> rings;
+        {
+            std::lock_guard<std::mutex> lock(m_rings_mutex);
+            for (auto& r : m_rings) {
+                rings.push_back(r.get());
+            }
+        }
+
+        for (ring* r : rings) {
+            uint64_t head = r->head.load(std::memory_order_acquire);
+            uint64_t tail = r->tail.load(std::memory_order_relaxed);
+            while (tail != head) {
+                uint64_t idx = tail & r->mask;
+                uint64_t n = std::min<uint64_t>(head - tail, r->buf.size() - idx);
+                fwrite(&r->buf[idx], sizeof(record), n, m_file);
+                tail += n;
+            }
+            r->tail.store(tail, std::memory_order_release);
+        }
+
+        uint64_t dropped = m_dropped.load(std::memory_order_relaxed);
+        if (dropped != m_dropped_reported) {
+            record rec = {};
+            rec.kind = KIND_DROPPED;
+            rec.source = NO_ID;
+            rec.target = NO_ID;
+            rec.length = dropped - m_dropped_reported;
+            fwrite(&rec, sizeof(rec), 1, m_file);
+            m_dropped_reported = dropped;
+        }
+    }
+
+    void flusher()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_stop) {
+            m_cond.wait_for(lock, std::chrono::milliseconds(10));
+            drain();
+        }
+        drain();
+    }
+
+    void record_source(uint16_t id, const std::string& name)
+    {
+        ring* r = local_ring();
+        for (size_t off = 0; off < name.size() || off == 0; off += DATA_LEN) {
+            record* rec = alloc(r);
+            if (!rec) {
+                return;
+            }
+            memset(rec, 0, sizeof(*rec));
+            rec->kind = KIND_SOURCE;
+            rec->source = id;
+            rec->target = NO_ID;
+            rec->address = off;
+            rec->length = name.size();
+            rec->data_len = std::min<size_t>(DATA_LEN, name.size() - off);
+            memcpy(rec->data, name.data() + off, rec->data_len);
+            commit(r);
+            if (name.empty()) {
+                break;
+            }
+        }
+    }
+
+public:
+    recorder(const std::string& fname, uint32_t ring_size)
+        : m_id(next_id()++), m_fname(fname), m_file(fopen(fname.c_str(), "wb")), m_ring_size(1)
+    {
+        /* ring sizes must be powers of 2 */
+        while (m_ring_size < ring_size) {
+            m_ring_size <<= 1;
+        }
+        if (!m_file) {
+            SC_REPORT_ERROR("tlm_trace", ("Unable to open trace file " + fname).c_str());
+            return;
+        }
+        setvbuf(m_file, nullptr, _IOFBF, 1 << 20);
+
+        file_header h = {};
+        memcpy(h.magic, TRACE_MAGIC, sizeof(h.magic));
+        h.record_size = sizeof(record);
+        h.time_unit_fs = sc_core::sc_get_time_resolution().to_seconds() * 1e15 + 0.5;
+        fwrite(&h, sizeof(h), 1, m_file);
+
+        m_flusher = std::thread(&recorder::flusher, this);
+    }
+
+    ~recorder()
+    {
+        if (!m_file) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cond.notify_one();
+        m_flusher.join();
+        fclose(m_file);
+    }
+
+    recorder(const recorder&) = delete;
+
+    /* Get the recorder writing to fname, creating it if needed */
+    static std::shared_ptr<recorder> get(const std::string& fname, uint32_t ring_size = 16384)
+    {
+        static std::mutex mutex;
+        static std::map<std::string, std::weak_ptr<recorder>> recorders;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        std::shared_ptr<recorder> r = recorders[fname].lock();
+        if (!r) {
+            r = std::make_shared<recorder>(fname, ring_size);
+            recorders[fname] = r;
+        }
+        return r;
+    }
+
+    bool is_open() const { return m_file != nullptr; }
+
+    /* Register a recording point, returns its source number */
+    uint16_t add_source(const std::string& name)
+    {
+        std::lock_guard<std::mutex> lock(m_sources_mutex);
+        uint16_t id = m_sources.size();
+        m_sources.push_back(name);
+        record_source(id, name);
+        return id;
+    }
+
+    void record_txn(uint16_t source, uint16_t target, const tlm::tlm_generic_payload& txn,
+                    const sc_core::sc_time& delay, bool dbg = false, bool data = true)
+    {
+        if (!m_file) {
+            return;
+        }
+        ring* r = local_ring();
+        record* rec = alloc(r);
+        if (!rec) {
+            return;
+        }
+
+        rec->time = sc_core::sc_time_stamp().value();
+        rec->delay = delay.value();
+        rec->address = txn.get_address();
+        rec->length = txn.get_data_length();
+        rec->source = source;
+        rec->target = target;
+        rec->kind = dbg ? KIND_DBG : KIND_TXN;
+        rec->command = txn.get_command();
+        rec->response = txn.get_response_status();
+
+        PathIDExtension* ext = nullptr;
+        txn.get_extension(ext);
+        int n = 0;
+        if (ext) {
+            for (; n < PATH_LEN && n < (int)ext->size(); n++) {
+                rec->path[n] = (*ext)[n];
+            }
+        }
+        for (; n < PATH_LEN; n++) {
+            rec->path[n] = NO_ID;
+        }
+
+        rec->data_len = 0;
+        if (data && txn.get_data_ptr()) {
+            rec->data_len = std::min<uint32_t>(DATA_LEN, txn.get_data_length());
+            memcpy(rec->data, txn.get_data_ptr(), rec->data_len);
+        }
+
+        commit(r);
+    }
+
+    /* Write everything recorded so far to the file */
+    void flush()
+    {
+        if (!m_file) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        drain();
+        fflush(m_file);
+    }
+
+    uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+};
+
+} // namespace trace
+} // namespace gs
+
+#endif
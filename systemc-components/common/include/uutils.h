@@ -83,6 +83,12 @@ public:
 
     void mark_error_signal(int signum, std::string error_msg);
 
+    /**
+     * To be called in the child after a fork(): the pass_handler thread was
+     * not forked, and the child needs a self pipe of its own.
+     */
+    void restart_after_fork();
+
     ~SigHandler();
 
 private:
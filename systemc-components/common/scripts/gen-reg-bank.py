@@ -0,0 +1,340 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+#
+# SPDX-License-Identifier: BSD-3-Clause
+#
+
+"""
+Generate a register bank (see reg_bank.h) from a register description.
+
+The description is either JSON:
+
+    {
+        "name": "uart_regs",
+        "size": "0x100",
+        "registers": [
+            { "name": "CTRL", "offset": "0x0", "size": 4, "reset": "0x1", "access": "rw",
+              "fields": [ { "name": "EN", "lsb": 0, "width": 1 } ] },
+            { "name": "FIFO", "offset": "0x10", "size": 4, "count": 4, "access": "ro" }
+        ]
+    }
+
+where the register sizes are in bytes, or IP-XACT (1685-2009 or 1685-2014),
+of which the first address block of the first memory map (or --block) is
+used: the registers with their dim, access, reset value and fields.
+
+The bank size defaults to the end of the last register. The class name is
+the name of the description (or of the address block), unless --name is
+given.
+"""
+
+import argparse
+import json
+import math
+import os
+import re
+import sys
+import xml.etree.ElementTree as ET
+
+ACCESS = {
+    "rw": "gs::REG_RW",
+    "read-write": "gs::REG_RW",
+    "ro": "gs::REG_RO",
+    "read-only": "gs::REG_RO",
+    "wo": "gs::REG_WO",
+    "write-only": "gs::REG_WO",
+}
+
+# The decode table has one uint16_t entry per granule
+MAX_DECODE_ENTRIES = 65536
+
+
+class DescriptionError(Exception):
+    pass
+
+
+def to_int(v, what):
+    if isinstance(v, int):
+        return v
+    s = str(v).strip().replace("_", "")
+    # Verilog style constants, as found in IP-XACT: 'h10, 32'h10
+    m = re.match(r"^(\d*)'([hHdDbBoO])([0-9a-fA-F]+)$", s)
+    if m:
+        return int(m.group(3), {"h": 16, "d": 10, "b": 2, "o": 8}[m.group(2).lower()])
+    try:
+        return int(s, 0)
+    except ValueError:
+        raise DescriptionError("{}: not a number: {}".format(what, v))
+
+
+def check_name(name, what):
+    if not re.match(r"^[A-Za-z_][A-Za-z0-9_]*$", name):
+        raise DescriptionError("{}: not a valid C++ identifier: {}".format(what, name))
+    return name
+
+
+def make_register(name, offset, size, count, reset, access, fields):
+    what = "register " + name
+    check_name(name, what)
+    if size not in (1, 2, 4, 8):
+        raise DescriptionError("{}: size must be 1, 2, 4 or 8 bytes, not {}".format(what, size))
+    if count < 1:
+        raise DescriptionError("{}: count must be at least 1".format(what))
+    if offset % size:
+        raise DescriptionError("{}: offset 0x{:x} is not aligned on its size".format(what, offset))
+    if access not in ACCESS:
+        raise DescriptionError("{}: unknown access {}".format(what, access))
+    if reset >> (size * 8):
+        raise DescriptionError("{}: reset value 0x{:x} doesn't fit in the register".format(what, reset))
+    names = set()
+    for f in fields:
+        check_name(f["name"], what + " field")
+        if f["name"] in names:
+            raise DescriptionError("{}: field {} defined twice".format(what, f["name"]))
+        names.add(f["name"])
+        if f["width"] < 1 or f["lsb"] < 0 or f["lsb"] + f["width"] > size * 8:
+            raise DescriptionError("{}: field {} out of the register".format(what, f["name"]))
+    return {
+        "name": name,
+        "offset": offset,
+        "size": size,
+        "count": count,
+        "reset": reset,
+        "access": ACCESS[access],
+        "fields": fields,
+    }
+
+
+def parse_json(fname):
+    with open(fname) as f:
+        d = json.load(f)
+    regs = []
+    for r in d.get("registers", []):
+        name = r.get("name", "?")
+        fields = [
+            {
+                "name": f["name"],
+                "lsb": to_int(f.get("lsb", 0), name),
+                "width": to_int(f.get("width", 1), name),
+            }
+            for f in r.get("fields", [])
+        ]
+        regs.append(
+            make_register(
+                name,
+                to_int(r["offset"], name),
+                to_int(r.get("size", 4), name),
+                to_int(r.get("count", 1), name),
+                to_int(r.get("reset", 0), name),
+                r.get("access", "rw").lower(),
+                fields,
+            )
+        )
+    size = to_int(d["size"], "size") if "size" in d else None
+    return d.get("name"), size, regs
+
+
+def strip_ns(root):
+    for e in root.iter():
+        if isinstance(e.tag, str) and "}" in e.tag:
+            e.tag = e.tag.split("}", 1)[1]
+
+
+def parse_ipxact(fname, block):
+    root = ET.parse(fname).getroot()
+    strip_ns(root)
+
+    blocks = root.findall("./memoryMaps/memoryMap/addressBlock")
+    if block:
+        blocks = [b for b in blocks if b.findtext("name") == block]
+    if not blocks:
+        raise DescriptionError("no address block {}in {}".format(block + " " if block else "", fname))
+    b = blocks[0]
+
+    regs = []
+    for r in b.findall("register"):
+        name = r.findtext("name", "?")
+        bits = to_int(r.findtext("size", "32"), name)
+        if bits % 8:
+            raise DescriptionError("register {}: size of {} bits".format(name, bits))
+        # 1685-2014 has resets/reset/value, 1685-2009 reset/value
+        reset = r.findtext("./resets/reset/value") or r.findtext("./reset/value") or "0"
+        access = r.findtext("access") or b.findtext("access") or "read-write"
+        fields = [
+            {
+                "name": f.findtext("name", "?"),
+                "lsb": to_int(f.findtext("bitOffset", "0"), name),
+                "width": to_int(f.findtext("bitWidth", "1"), name),
+            }
+            for f in r.findall("field")
+        ]
+        regs.append(
+            make_register(
+                name,
+                to_int(r.findtext("addressOffset", "0"), name),
+                bits // 8,
+                to_int(r.findtext("dim", "1"), name),
+                to_int(reset, name),
+                access.lower(),
+                fields,
+            )
+        )
+    size = to_int(b.findtext("range"), "range") if b.findtext("range") else None
+    return b.findtext("name"), size, regs
+
+
+def layout(regs, size):
+    regs.sort(key=lambda r: r["offset"])
+    end = 0
+    names = set()
+    for r in regs:
+        if r["name"] in names:
+            raise DescriptionError("register {} defined twice".format(r["name"]))
+        names.add(r["name"])
+        if r["offset"] < end:
+            raise DescriptionError("register {} overlaps the previous one".format(r["name"]))
+        end = r["offset"] + r["size"] * r["count"]
+    if size is None:
+        size = end
+    if size < end or size == 0:
+        raise DescriptionError("the bank (0x{:x} bytes) doesn't hold its registers".format(size))
+
+    # The granule is the largest power of 2 dividing all the register boundaries
+    g = 0
+    for r in regs:
+        g = math.gcd(g, math.gcd(r["offset"], r["size"]))
+    g = math.gcd(g, size) or 1
+    shift = (g & -g).bit_length() - 1
+
+    entries = size >> shift
+    if len(regs) >= 0xFFFF or entries > MAX_DECODE_ENTRIES:
+        return size, shift, None
+    decode = [0] * entries
+    for i, r in enumerate(regs):
+        first = r["offset"] >> shift
+        last = (r["offset"] + r["size"] * r["count"]) >> shift
+        decode[first:last] = [i + 1] * (last - first)
+    return size, shift, decode
+
+
+def ctype(size):
+    return "uint{}_t".format(size * 8)
+
+
+def generate(cls, source, regs, size, shift, decode):
+    guard = "GS_REG_BANK_{}_H".format(cls.upper())
+    out = []
+    w = out.append
+
+    w("/*")
+    w(" * Generated by gen-reg-bank.py from {}, do not edit.".format(os.path.basename(source)))
+    w(" */")
+    w("")
+    w("#ifndef {}".format(guard))
+    w("#define {}".format(guard))
+    w("")
+    w("#include <reg_bank.h>")
+    w("")
+    w("class {} : public gs::reg_bank".format(cls))
+    w("{")
+    w("    static const gs::reg_desc* regs()")
+    w("    {")
+    w("        static constexpr gs::reg_desc r[] = {")
+    for r in regs:
+        w(
+            '            {{ "{}", 0x{:x}, {}, {}, 0x{:x}, {} }},'.format(
+                r["name"], r["offset"], r["size"], r["count"], r["reset"], r["access"]
+            )
+        )
+    w("        };")
+    w("        return r;")
+    w("    }")
+    w("")
+    w("    static const uint16_t* decode()")
+    w("    {")
+    if decode is None:
+        w("        /* too sparse, decoded by binary search */")
+        w("        return nullptr;")
+    else:
+        w("        static constexpr uint16_t d[] = {")
+        for i in range(0, len(decode), 16):
+            w("            " + ", ".join(str(v) for v in decode[i : i + 16]) + ",")
+        w("        };")
+        w("        return d;")
+    w("    }")
+    w("")
+    w("public:")
+
+    for r in regs:
+        if not r["fields"]:
+            continue
+        t = ctype(r["size"])
+        w("    struct {}_reg : public gs::bank_register<{}> {{".format(r["name"], t))
+        for f in r["fields"]:
+            w("        gs::bank_field<{}, {}, {}> {};".format(t, f["lsb"], f["width"], f["name"]))
+        w("")
+        inits = "".join(", {}(*this)".format(f["name"]) for f in r["fields"])
+        w(
+            "        {}_reg(gs::reg_bank& bank, size_t idx): gs::bank_register<{}>(bank, idx){} {{}}".format(
+                r["name"], t, inits
+            )
+        )
+        w("        using gs::bank_register<{}>::operator=;".format(t))
+        w("    };")
+        w("")
+
+    for r in regs:
+        if r["fields"]:
+            w("    {}_reg {};".format(r["name"], r["name"]))
+        else:
+            w("    gs::bank_register<{}> {};".format(ctype(r["size"]), r["name"]))
+    w("")
+    w("    {}(const sc_core::sc_module_name& nm)".format(cls))
+    w("        : gs::reg_bank(nm, regs(), {}, 0x{:x}, decode(), {})".format(len(regs), size, shift))
+    for i, r in enumerate(regs):
+        w("        , {}(*this, {})".format(r["name"], i))
+    w("    {")
+    w("    }")
+    w("")
+    w("    {}() = delete;".format(cls))
+    w("    {}(const {}&) = delete;".format(cls, cls))
+    w("};")
+    w("")
+    w("#endif // {}".format(guard))
+    return "\n".join(out) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate a register bank from a JSON or IP-XACT description")
+    parser.add_argument("description", help="JSON or IP-XACT register description")
+    parser.add_argument("-o", "--output", help="generated header (default: stdout)")
+    parser.add_argument("-n", "--name", help="name of the generated class")
+    parser.add_argument("-b", "--block", help="IP-XACT address block to use (default: the first one)")
+    args = parser.parse_args()
+
+    try:
+        if args.description.endswith(".json"):
+            name, size, regs = parse_json(args.description)
+        else:
+            name, size, regs = parse_ipxact(args.description, args.block)
+        cls = check_name(args.name or name or "", "class name")
+        size, shift, decode = layout(regs, size)
+    except (DescriptionError, KeyError, ValueError, ET.ParseError) as e:
+        sys.exit("{}: {}".format(args.description, e))
+
+    text = generate(cls, args.description, regs, size, shift, decode)
+    if args.output:
+        # Don't touch an up to date header, not to rebuild its users
+        if os.path.exists(args.output):
+            with open(args.output) as f:
+                if f.read() == text:
+                    return
+        with open(args.output, "w") as f:
+            f.write(text)
+    else:
+        sys.stdout.write(text)
+
+
+if __name__ == "__main__":
+    main()
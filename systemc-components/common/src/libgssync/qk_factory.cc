@@ -13,6 +13,7 @@ std::shared_ptr<gs::tlm_quantumkeeper_extended> tlm_quantumkeeper_factory(std::s
     if (name == "tlm2") return std::make_shared<gs::tlm_quantumkeeper_extended>();
     if (name == "multithread") return std::make_shared<gs::tlm_quantumkeeper_multithread>();
     if (name == "multithread-quantum") return std::make_shared<gs::tlm_quantumkeeper_multi_quantum>();
+    if (name == "multithread-lockstep") return std::make_shared<gs::tlm_quantumkeeper_multi_lockstep>();
     if (name == "multithread-adaptive") return std::make_shared<gs::tlm_quantumkeeper_multi_adaptive>();
     if (name == "multithread-rolling") return std::make_shared<gs::tlm_quantumkeeper_multi_rolling>();
     if (name == "multithread-unconstrained") return std::make_shared<gs::tlm_quantumkeeper_unconstrained>();
@@ -22,6 +22,12 @@
 #include <uutils.h>
 
 namespace gs {
+static std::string qk_stat_name(const char* name)
+{
+    sc_core::sc_object* owner = sc_core::sc_get_current_object();
+    return (owner ? std::string(owner->name()) + ".qk." : std::string("qk.")) + name;
+}
+
 /* constantly monitor SystemC and dont let it get ahead of the
    local_time - this is the tlm2.0 rule (h) */
 void tlm_quantumkeeper_multithread::timehandler()
@@ -39,7 +45,7 @@ void tlm_quantumkeeper_multithread::timehandler()
         m_systemc_waiting = false;
         SCP_TRACE(())("Unsuspending");
         sc_core::sc_unsuspend_all();
-        sc_core::sc_time m_quantum = tlm_utils::tlm_quantumkeeper::get_global_quantum();
+        sc_core::sc_time m_quantum = get_quantum();
         m_tick.notify(std::min(get_current_time() - sc_core::sc_time_stamp(), m_quantum));
     } else {
         // Suspend SystemC if SystemC has caught up with our
@@ -58,7 +64,11 @@ tlm_quantumkeeper_multithread::~tlm_quantumkeeper_multithread() { cond.notify_al
 // but it's functions may be called from other threads
 // The QK may be instanced outside of elaboration
 tlm_quantumkeeper_multithread::tlm_quantumkeeper_multithread()
-    : m_systemc_thread_id(std::this_thread::get_id()), status(NONE), m_tick(false) /* handle attach manually */
+    : m_systemc_thread_id(std::this_thread::get_id())
+    , status(NONE)
+    , m_tick(false) /* handle attach manually */
+    , m_syncs(qk_stat_name("syncs"))
+    , m_sync_wait_ns(qk_stat_name("sync_wait_ns"))
 {
     SCP_TRACE(())("Constructor");
     sc_core::sc_spawn_options opt;
@@ -115,7 +125,7 @@ void tlm_quantumkeeper_multithread::stop()
 /* return the time remaining till the next sync point*/
 sc_core::sc_time tlm_quantumkeeper_multithread::time_to_sync()
 {
-    sc_core::sc_time m_quantum = tlm_utils::tlm_quantumkeeper::get_global_quantum();
+    sc_core::sc_time m_quantum = get_quantum();
     sc_core::sc_time q = sc_core::sc_time_stamp() + (m_quantum * 2);
     if (q >= get_current_time()) {
         return q - get_current_time();
@@ -143,6 +153,7 @@ void tlm_quantumkeeper_multithread::set(const sc_core::sc_time& t)
 
 void tlm_quantumkeeper_multithread::sync()
 {
+    m_syncs.add();
     if (is_sysc_thread()) {
         assert(m_local_time >= sc_core::sc_time_stamp());
         sc_core::sc_time t = m_local_time - sc_core::sc_time_stamp();
@@ -151,6 +162,7 @@ void tlm_quantumkeeper_multithread::sync()
             sc_core::wait(t);
         }
     } else {
+        perf::timer t(m_sync_wait_ns);
         std::unique_lock<std::mutex> lock(mutex);
         /* Wake up the SystemC thread if it's waiting for us to keep up */
         m_tick.notify(sc_core::SC_ZERO_TIME);
@@ -5,6 +5,7 @@
  */
 
 #include "luafile_tool.h"
+#include "config_cache.h"
 
 int lua_cci_get_val(lua_State* L)
 {
@@ -53,6 +54,53 @@ int lua_cci_get_val(lua_State* L)
     return 1; // number of results
 }
 
+/* __gs_record_input(name, kind), the record is the upvalue */
+static int lua_record_input(lua_State* L)
+{
+    auto record = static_cast<gs::config_record*>(lua_touserdata(L, lua_upvalueindex(1)));
+    const char* name = luaL_checkstring(L, 1);
+    int kind = static_cast<int>(luaL_checkinteger(L, 2));
+    record->inputs.emplace(name, kind);
+    return 0;
+}
+
+/*
+ * Record the files and environment variables a configuration reads. The
+ * wrappers only see what goes through the Lua libraries.
+ */
+static const char* record_inputs_script =
+    "local record = __gs_record_input\n"
+    "__gs_record_input = nil\n"
+    "local dofile_, loadfile_, open_, lines_, getenv_ = dofile, loadfile, io.open, io.lines, os.getenv\n"
+    "dofile = function(f)\n"
+    "  if f then record(f, 0) end\n"
+    "  return dofile_(f)\n"
+    "end\n"
+    "loadfile = function(f, ...)\n"
+    "  if f then record(f, 0) end\n"
+    "  return loadfile_(f, ...)\n"
+    "end\n"
+    "io.open = function(f, m)\n"
+    "  local r, e, n = open_(f, m)\n"
+    "  if m == nil or m:sub(1, 1) == 'r' then record(f, r and 1 or 2) end\n"
+    "  return r, e, n\n"
+    "end\n"
+    "io.lines = function(f, ...)\n"
+    "  if f then record(f, 1) end\n"
+    "  return lines_(f, ...)\n"
+    "end\n"
+    "os.getenv = function(v)\n"
+    "  record(v, 3)\n"
+    "  return getenv_(v)\n"
+    "end\n"
+    "local searchers = package.searchers or package.loaders\n"
+    "if searchers and package.searchpath then\n"
+    "  table.insert(searchers, 2, function(name)\n"
+    "    local f = package.searchpath(name, package.path)\n"
+    "    if f then record(f, 0) end\n"
+    "  end)\n"
+    "end\n";
+
 std::string gs::LuaFile_Tool::rel(std::string& n) const
 {
     if (m_orig_name.empty())
@@ -61,6 +109,21 @@ std::string gs::LuaFile_Tool::rel(std::string& n) const
         return (m_orig_name + n);
 }
 
+void gs::LuaFile_Tool::set_preset(cci::cci_broker_handle a_broker, const std::string& name,
+                                  const cci::cci_value& value)
+{
+    a_broker.set_preset_cci_value(name, value);
+    if (m_record) {
+        m_record->presets[name] = value;
+    }
+}
+
+bool gs::LuaFile_Tool::is_lua_builtin(const std::pair<std::string, cci::cci_value>& iv)
+{
+    return ((iv.first)[0] == '_' || iv.first == "math.maxinteger") || (iv.first == "math.mininteger") ||
+           (iv.first == "utf8.charpattern");
+}
+
 gs::LuaFile_Tool::LuaFile_Tool(std::string _orig_name)
 {
     SCP_DEBUG(()) << "LuaFile_Tool Constructor";
@@ -78,8 +141,21 @@ int gs::LuaFile_Tool::config(cci::cci_broker_handle a_broker, const char* a_conf
     lua_State* L = luaL_newstate();
     luaL_openlibs(L);
 
+    if (m_record) {
+        m_record->inputs.emplace(a_config_file, gs::CONFIG_INPUT_SOURCE);
+        lua_pushlightuserdata(L, m_record);
+        lua_pushcclosure(L, lua_record_input, 1);
+        lua_setglobal(L, "__gs_record_input");
+        if (luaL_dostring(L, record_inputs_script)) {
+            SCP_FATAL(()) << lua_tostring(L, -1);
+        }
+    }
+
     // load a script as the function "config_chunk"
     int error = luaL_loadfile(L, a_config_file);
+    if (error && m_record) {
+        m_record->failed = true;
+    }
     switch (error) {
     case 0:
         break;
@@ -142,6 +218,9 @@ int gs::LuaFile_Tool::config(cci::cci_broker_handle a_broker, const char* a_conf
 
     // run
     if (luaL_dostring(L, config_loader.get())) {
+        if (m_record) {
+            m_record->failed = true;
+        }
         SCP_ERR(()) << lua_tostring(L, -1);
         lua_pop(L, 1); /* pop error message from the stack */
     }
@@ -152,16 +231,16 @@ int gs::LuaFile_Tool::config(cci::cci_broker_handle a_broker, const char* a_conf
     lua_getglobal(L, "_G");
     error = setParamsFromLuaTable(a_broker, L, lua_gettop(L));
     if (error < 0) {
+        if (m_record) {
+            m_record->failed = true;
+        }
         SCP_INFO(()) << "Error loading lua config file: " << a_config_file;
         return error;
     }
     lua_close(L);
 
     // remove lua builtins
-    a_broker.ignore_unconsumed_preset_values([](const std::pair<std::string, cci::cci_value>& iv) -> bool {
-        return ((iv.first)[0] == '_' || iv.first == "math.maxinteger") || (iv.first == "math.mininteger") ||
-               (iv.first == "utf8.charpattern");
-    });
+    a_broker.ignore_unconsumed_preset_values(is_lua_builtin);
     return 0;
 }
 
@@ -241,13 +320,13 @@ int gs::LuaFile_Tool::setParamsFromLuaTable(cci::cci_broker_handle a_broker, lua
                 double num = lua_tonumber(L, -1);
                 if ((floor(num) == num && num >= 0.0 && num < ldexp(1.0, 64))) {
                     std::string keys = key;
-                    a_broker.set_preset_cci_value(rel(keys), cci::cci_value((uint64_t)num));
+                    set_preset(a_broker, rel(keys), cci::cci_value((uint64_t)num));
                 } else if (floor(num) == num && num >= -ldexp(1.0, 63) && num < ldexp(1.0, 63)) {
                     std::string keys = key;
-                    a_broker.set_preset_cci_value(rel(keys), cci::cci_value((int64_t)num));
+                    set_preset(a_broker, rel(keys), cci::cci_value((int64_t)num));
                 } else {
                     std::string keys = key;
-                    a_broker.set_preset_cci_value(rel(keys), cci::cci_value(num));
+                    set_preset(a_broker, rel(keys), cci::cci_value(num));
                 }
 
                 if (GC_LUA_VERBOSE) {
@@ -261,7 +340,7 @@ int gs::LuaFile_Tool::setParamsFromLuaTable(cci::cci_broker_handle a_broker, lua
 
         case LUA_TBOOLEAN: {
             std::string keys = key;
-            a_broker.set_preset_cci_value(rel(keys), cci::cci_value((bool)lua_toboolean(L, -1)));
+            set_preset(a_broker, rel(keys), cci::cci_value((bool)lua_toboolean(L, -1)));
             if (GC_LUA_VERBOSE)
                 SCP_INFO(()) << "(SET " << lua_typename(L, lua_type(L, -1)) << ") " << rel(keys).c_str() << " = "
                              << (lua_toboolean(L, -1) ? "true" : "false");
@@ -277,7 +356,7 @@ int gs::LuaFile_Tool::setParamsFromLuaTable(cci::cci_broker_handle a_broker, lua
                                  << "   (ignored because it's Lua specific)";
             } else {
                 std::string keys = key;
-                a_broker.set_preset_cci_value(rel(keys), cci::cci_value(std::string(lua_tostring(L, -1))));
+                set_preset(a_broker, rel(keys), cci::cci_value(std::string(lua_tostring(L, -1))));
                 if (GC_LUA_VERBOSE)
                     SCP_INFO(()) << "(SET " << lua_typename(L, lua_type(L, -1)) << ") " << rel(keys).c_str() << " = "
                                  << lua_tostring(L, -1);
@@ -0,0 +1,397 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <systemc>
+#include <scp/report.h>
+
+#include <cciutils.h>
+#include "backends/net-switch.h"
+
+using namespace sc_core;
+
+/* Largest frame we carry (jumbo frame + VLAN tag) */
+static const size_t SWITCH_FRAME_SIZE = 9018;
+/* Number of frames an egress port may hold before we start dropping */
+static const size_t SWITCH_EGRESS_DEPTH = 256;
+
+static inline uint64_t mac_key(const uint8_t* mac)
+{
+    return ((uint64_t)mac[0] << 40) | ((uint64_t)mac[1] << 32) | ((uint64_t)mac[2] << 24) | ((uint64_t)mac[3] << 16) |
+           ((uint64_t)mac[4] << 8) | (uint64_t)mac[5];
+}
+
+NetworkSwitch::Port::Port(const sc_module_name& name, NetworkSwitch* sw, int index)
+    : sc_module(name)
+    , m_switch(sw)
+    , m_index(index)
+    , m_busy_until(SC_ZERO_TIME)
+    , m_fd(-1)
+    , m_running(false)
+    , m_ingress_event(false)
+    , p_mac("mac", "", "path of the MAC model attached to this port")
+    , p_udp_port("udp_port", 0, "localhost UDP port to listen on (0 = no UDP attachment)")
+    , p_udp_peer_port("udp_peer_port", 0, "localhost UDP port to send frames to")
+    , rx_frames(0)
+    , tx_frames(0)
+    , dropped_frames(0)
+{
+    SC_METHOD(egress);
+    sensitive << m_egress_event;
+    dont_initialize();
+
+    SC_METHOD(udp_rcv);
+    sensitive << m_ingress_event;
+    dont_initialize();
+
+    if (p_udp_port.get_value()) {
+        udp_open();
+    }
+}
+
+NetworkSwitch::Port::~Port()
+{
+    udp_close();
+    for (auto& p : m_egress) {
+        delete p.frame;
+    }
+}
+
+void NetworkSwitch::Port::udp_open()
+{
+    m_fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (m_fd < 0) {
+        SCP_ERR(()) << "Failed to create UDP socket: " << strerror(errno);
+        return;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(p_udp_port.get_value());
+    if (::bind(m_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        SCP_ERR(()) << "Failed to bind UDP port " << p_udp_port.get_value() << ": " << strerror(errno);
+        ::close(m_fd);
+        m_fd = -1;
+        return;
+    }
+
+    SCP_DEBUG(()) << "listening on UDP port " << p_udp_port.get_value();
+    m_ingress_event.async_attach_suspending();
+    m_running = true;
+    m_rcv_thread = std::thread(&NetworkSwitch::Port::udp_rcv_thread, this);
+}
+
+void NetworkSwitch::Port::udp_close()
+{
+    if (m_fd < 0) {
+        return;
+    }
+    m_running = false;
+    ::shutdown(m_fd, SHUT_RDWR);
+    if (m_rcv_thread.joinable()) {
+        m_rcv_thread.join();
+    }
+    ::close(m_fd);
+    m_fd = -1;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    while (!m_ingress.empty()) {
+        delete m_ingress.front();
+        m_ingress.pop();
+    }
+}
+
+void NetworkSwitch::Port::udp_rcv_thread()
+{
+    while (m_running) {
+        Payload* frame = new Payload(SWITCH_FRAME_SIZE);
+
+        ssize_t r = ::recv(m_fd, frame->data(), frame->capacity(), 0);
+        if (r <= 0) {
+            delete frame;
+            if (r < 0 && errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (r < 60) {
+            /* Pad with zeroes as the minimal payload size is 60 bytes */
+            std::memset(frame->data() + r, 0, 60 - r);
+            r = 60;
+        }
+        frame->resize(r);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_ingress.push(frame);
+        m_ingress_event.async_notify();
+    }
+}
+
+void NetworkSwitch::Port::udp_rcv()
+{
+    std::queue<Payload*> frames;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::swap(frames, m_ingress);
+    }
+    while (!frames.empty()) {
+        Payload* frame = frames.front();
+        frames.pop();
+        send(*frame);
+        delete frame;
+    }
+}
+
+void NetworkSwitch::Port::udp_send(Payload& frame)
+{
+    if (!p_udp_peer_port.get_value()) {
+        return;
+    }
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(p_udp_peer_port.get_value());
+    if (::sendto(m_fd, frame.data(), frame.size(), 0, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        SCP_WARN(()) << "UDP send failed: " << strerror(errno);
+    }
+}
+
+void NetworkSwitch::Port::send(Payload& frame)
+{
+    rx_frames++;
+    m_switch->forward(m_index, frame);
+}
+
+void NetworkSwitch::Port::deliver(Payload& frame)
+{
+    tx_frames++;
+    if (m_fd >= 0) {
+        udp_send(frame);
+    } else {
+        m_receive(m_opaque, frame);
+    }
+}
+
+void NetworkSwitch::Port::egress()
+{
+    while (!m_egress.empty()) {
+        Pending& p = m_egress.front();
+        if (p.when > sc_time_stamp()) {
+            m_egress_event.notify(p.when - sc_time_stamp());
+            return;
+        }
+        if (m_fd < 0 && m_can_receive && !m_can_receive(m_opaque)) {
+            /* notify myself later, hopefully the MAC drains its ring */
+            m_egress_event.notify(sc_time(1, SC_MS));
+            return;
+        }
+        Payload* frame = p.frame;
+        m_egress.pop_front();
+        deliver(*frame);
+        m_switch->free_frame(frame);
+    }
+}
+
+NetworkSwitch::NetworkSwitch(const sc_module_name& name, uint32_t num_ports)
+    : sc_module(name)
+    , m_pcap(nullptr)
+    , p_num_ports("num_ports", 2, "number of switch ports")
+    , p_link_rate_mbps("link_rate_mbps", 0, "egress link rate in Mbit/s (0 = infinite)")
+    , p_latency_ns("latency_ns", 0, "per hop latency in ns")
+    , p_pcap_file("pcap_file", "", "capture every frame entering the switch in this pcap file")
+    , ports("port")
+{
+    SCP_TRACE(()) << "Constructor";
+
+    // A number of ports given by a config always takes precedence
+    if (num_ports && !cci::cci_get_broker().has_preset_value(p_num_ports.name())) {
+        p_num_ports = num_ports;
+    }
+    ports.init(p_num_ports.get_value(),
+               [this](const char* n, size_t i) { return new Port(n, this, static_cast<int>(i)); });
+
+    pcap_open();
+}
+
+NetworkSwitch::~NetworkSwitch()
+{
+    if (m_pcap) {
+        fclose(m_pcap);
+    }
+    for (auto f : m_pool) {
+        delete f;
+    }
+}
+
+void NetworkSwitch::before_end_of_elaboration()
+{
+    for (auto& p : ports) {
+        std::string mac = p.p_mac.get_value();
+        if (mac.empty()) {
+            continue;
+        }
+        if (mac[0] == '&') {
+            mac.erase(0, 1);
+        }
+        auto obj = dynamic_cast<NetworkBackendAttachable*>(gs::find_sc_obj(nullptr, mac));
+        if (!obj) {
+            SCP_FATAL(()) << p.name() << ": " << mac << " is not a MAC model that can be attached to a switch";
+        }
+        obj->set_backend(&p);
+        SCP_INFO(()) << "Attached " << mac << " to " << p.name();
+    }
+}
+
+void NetworkSwitch::end_of_simulation()
+{
+    for (auto& p : ports) {
+        SCP_INFO(()) << p.name() << ": rx " << p.rx_frames << " tx " << p.tx_frames << " dropped "
+                     << p.dropped_frames;
+    }
+    if (m_pcap) {
+        fflush(m_pcap);
+    }
+}
+
+Payload* NetworkSwitch::alloc_frame(const Payload& src)
+{
+    Payload* frame;
+    if (m_pool.empty()) {
+        frame = new Payload(SWITCH_FRAME_SIZE);
+    } else {
+        frame = m_pool.back();
+        m_pool.pop_back();
+    }
+    frame->resize(src.size());
+    memcpy(frame->data(), src.data(), src.size());
+    return frame;
+}
+
+void NetworkSwitch::free_frame(Payload* frame) { m_pool.push_back(frame); }
+
+void NetworkSwitch::pcap_open()
+{
+    if (p_pcap_file.get_value().empty()) {
+        return;
+    }
+    m_pcap = fopen(p_pcap_file.get_value().c_str(), "wb");
+    if (!m_pcap) {
+        SCP_ERR(()) << "Unable to open " << p_pcap_file.get_value() << ": " << strerror(errno);
+        return;
+    }
+
+    /* libpcap global header: magic, version 2.4, GMT, accuracy, snaplen, LINKTYPE_ETHERNET */
+    uint32_t magic = 0xa1b2c3d4;
+    uint16_t major = 2, minor = 4;
+    int32_t zone = 0;
+    uint32_t sigfigs = 0, snaplen = SWITCH_FRAME_SIZE, linktype = 1;
+    fwrite(&magic, sizeof(magic), 1, m_pcap);
+    fwrite(&major, sizeof(major), 1, m_pcap);
+    fwrite(&minor, sizeof(minor), 1, m_pcap);
+    fwrite(&zone, sizeof(zone), 1, m_pcap);
+    fwrite(&sigfigs, sizeof(sigfigs), 1, m_pcap);
+    fwrite(&snaplen, sizeof(snaplen), 1, m_pcap);
+    fwrite(&linktype, sizeof(linktype), 1, m_pcap);
+}
+
+void NetworkSwitch::pcap_write(const Payload& frame)
+{
+    /* Timestamps are SystemC time, not host time */
+    uint64_t us = sc_time_stamp().value() / sc_time(1, SC_US).value();
+    uint32_t hdr[4] = { static_cast<uint32_t>(us / 1000000), static_cast<uint32_t>(us % 1000000),
+                        static_cast<uint32_t>(frame.size()), static_cast<uint32_t>(frame.size()) };
+    fwrite(hdr, sizeof(hdr), 1, m_pcap);
+    fwrite(frame.data(), 1, frame.size(), m_pcap);
+}
+
+void NetworkSwitch::forward(int from, Payload& frame)
+{
+    if (frame.size() < 14) {
+        ports[from].dropped_frames++;
+        return;
+    }
+
+    if (m_pcap) {
+        pcap_write(frame);
+    }
+
+    const uint8_t* dst = frame.data();
+    const uint8_t* src = frame.data() + 6;
+
+    /* Learn where the source lives (never learn multicast sources) */
+    if (!(src[0] & 1)) {
+        m_fdb[mac_key(src)] = from;
+    }
+
+    if (!(dst[0] & 1)) {
+        auto it = m_fdb.find(mac_key(dst));
+        if (it != m_fdb.end()) {
+            if (it->second != from) {
+                output(it->second, frame);
+            }
+            return;
+        }
+    }
+
+    /* Broadcast, multicast or unknown unicast: flood */
+    for (int i = 0; i < (int)ports.size(); i++) {
+        if (i != from && ports[i].attached()) {
+            output(i, frame);
+        }
+    }
+}
+
+void NetworkSwitch::output(int to, Payload& frame)
+{
+    Port& p = ports[to];
+
+    if (!p.attached()) {
+        p.dropped_frames++;
+        return;
+    }
+
+    bool busy = !p.m_egress.empty() || (p.m_fd < 0 && p.m_can_receive && !p.m_can_receive(p.m_opaque));
+
+    if (!timed() && !busy) {
+        /* Zero-copy: the frame is handed over by reference */
+        p.deliver(frame);
+        return;
+    }
+
+    if (p.m_egress.size() >= SWITCH_EGRESS_DEPTH) {
+        SCP_DEBUG(()) << p.name() << ": egress queue full, dropping frame";
+        p.dropped_frames++;
+        return;
+    }
+
+    sc_time now = sc_time_stamp();
+    sc_time start = std::max(now, p.m_busy_until);
+    sc_time when = start;
+    if (p_link_rate_mbps.get_value()) {
+        /* serialisation time, including preamble, SFD, FCS and inter-frame gap */
+        uint64_t bits = (frame.size() + 24) * 8;
+        when += sc_time(static_cast<double>(bits) * 1000.0 / p_link_rate_mbps.get_value(), SC_NS);
+    }
+    p.m_busy_until = when;
+    when += sc_time(static_cast<double>(p_latency_ns.get_value()), SC_NS);
+
+    bool was_empty = p.m_egress.empty();
+    p.m_egress.push_back({ when, alloc_frame(frame) });
+    if (was_empty) {
+        p.m_egress_event.notify(when - now);
+    }
+}
@@ -6,6 +6,11 @@
 
 #include "memory_services.h"
 
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+
 gs::MemoryServices::MemoryServices(): m_name("MemoryServices")
 {
     SCP_DEBUG(()) << "MemoryServices constructor";
@@ -23,6 +28,10 @@ gs::MemoryServices::~MemoryServices()
 {
     SCP_DEBUG(()) << "MemoryServices Destructor";
     cleanup();
+    stop_fd_server();
+    for (auto n : m_shmem_info_map) {
+        if (n.second.fd >= 0) close(n.second.fd);
+    }
     if (cl_info) {
         if (munmap(cl_info, sizeof(shm_cleaner_info)) == -1) {
             SCP_FATAL(()) << "failed to munmap shm_cleaner_info struct at: 0x" << std::hex << cl_info
@@ -35,12 +44,17 @@ gs::MemoryServices::~MemoryServices()
 
 const char* gs::MemoryServices::name() const { return m_name.c_str(); }
 
-size_t gs::MemoryServices::get_shmem_seg_num() const { return m_shmem_info_map.size(); }
+size_t gs::MemoryServices::get_shmem_seg_num() const
+{
+    std::lock_guard<std::mutex> lock(m_shmem_mutex);
+    return m_shmem_info_map.size();
+}
 
 void gs::MemoryServices::cleanup()
 {
     if (finished || !child_cleaner_forked) return;
     for (auto n : m_shmem_info_map) {
+        if (n.first.rfind(MEMFD_ID_PREFIX, 0) == 0) continue; // nothing to delete
         SCP_INFO(()) << "Deleting " << n.first; // can't use SCP_ in global destructor
                                                 // as it's probably already destroyed
         shm_unlink(n.first.c_str());
@@ -95,13 +109,14 @@ void gs::MemoryServices::start_shm_cleaner_proc()
     }
 } // start_shm_cleaner_proc()
 
-uint8_t* gs::MemoryServices::map_file(const char* mapfile, uint64_t size, uint64_t offset)
+uint8_t* gs::MemoryServices::map_file(const char* mapfile, uint64_t size, uint64_t offset, bool copy_on_write)
 {
-    int fd = open(mapfile, O_RDWR);
+    int fd = open(mapfile, copy_on_write ? O_RDONLY : O_RDWR);
     if (fd < 0) {
         SCP_FATAL(()) << "Unable to find backing file [Error: " << strerror(errno) << "]";
     }
-    uint8_t* ptr = (uint8_t*)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, offset);
+    uint8_t* ptr = (uint8_t*)mmap(NULL, size, PROT_READ | PROT_WRITE, copy_on_write ? MAP_PRIVATE : MAP_SHARED, fd,
+                                  offset);
     int mmap_error = errno;
     close(fd);
     if (ptr == MAP_FAILED) {
@@ -140,7 +155,10 @@ uint8_t* gs::MemoryServices::map_mem_create(const char* memname, uint64_t size)
         die_sys_api(mmap_error, memname, "can't mmap(shared memory create)");
     }
     SCP_DEBUG(()) << "Shared memory created: " << memname << " length " << size;
-    m_shmem_info_map.insert({ std::string(memname), { ptr, size } });
+    {
+        std::lock_guard<std::mutex> lock(m_shmem_mutex);
+        m_shmem_info_map.insert({ std::string(memname), { ptr, size } });
+    }
     if ((strlen(memname) + 1) > MAX_SHM_STR_LENGTH)
         SCP_FATAL(()) << "shm name length exceeded max allowed length: " << MAX_SHM_STR_LENGTH << std::endl;
     start_shm_cleaner_proc();
@@ -150,16 +168,211 @@ uint8_t* gs::MemoryServices::map_mem_create(const char* memname, uint64_t size)
     return ptr;
 }
 
+/*
+ * The memfd segments are served by the process which created them, on an
+ * abstract unix socket (no file to clean up) named after its pid. A request
+ * is the id of a segment, the reply is a status byte carrying the fd.
+ */
+#ifdef __linux__
+std::string gs::MemoryServices::fd_server_addr(pid_t pid)
+{
+    return std::string(1, '\0') + "gs-memfd-" + std::to_string(pid);
+}
+
+static socklen_t fill_unix_addr(struct sockaddr_un& addr, const std::string& path)
+{
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.data(), path.size());
+    return offsetof(struct sockaddr_un, sun_path) + path.size();
+}
+
+void gs::MemoryServices::start_fd_server()
+{
+    if (m_fd_server >= 0) return;
+
+    struct sockaddr_un addr;
+    socklen_t len = fill_unix_addr(addr, fd_server_addr(getpid()));
+    m_fd_server = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_fd_server < 0 || bind(m_fd_server, (struct sockaddr*)&addr, len) == -1 || listen(m_fd_server, 16) == -1) {
+        SCP_FATAL(()) << "can't serve the memfd segments, error: " << std::strerror(errno);
+    }
+    if (pipe2(m_fd_server_stop, O_CLOEXEC) == -1) {
+        SCP_FATAL(()) << "can't create the memfd server pipe, error: " << std::strerror(errno);
+    }
+    m_fd_server_thread = std::thread(&MemoryServices::fd_server, this);
+}
+
+void gs::MemoryServices::stop_fd_server()
+{
+    if (m_fd_server < 0) return;
+    if (write(m_fd_server_stop[1], "", 1) != 1) perror("write");
+    m_fd_server_thread.join();
+    close(m_fd_server);
+    close(m_fd_server_stop[0]);
+    close(m_fd_server_stop[1]);
+    m_fd_server = -1;
+}
+
+void gs::MemoryServices::fd_server()
+{
+    for (;;) {
+        struct pollfd pfds[2] = { { m_fd_server, POLLIN, 0 }, { m_fd_server_stop[0], POLLIN, 0 } };
+        if (poll(pfds, 2, -1) == -1) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        if (pfds[1].revents) return;
+        int conn = accept4(m_fd_server, nullptr, nullptr, SOCK_CLOEXEC);
+        if (conn >= 0) {
+            send_memfd(conn);
+            close(conn);
+        }
+    }
+}
+
+void gs::MemoryServices::send_memfd(int conn)
+{
+    /* Only the processes of the same user get the memory */
+    struct ucred cred;
+    socklen_t cred_len = sizeof(cred);
+    if (getsockopt(conn, SOL_SOCKET, SO_PEERCRED, &cred, &cred_len) == -1 || cred.uid != getuid()) {
+        return;
+    }
+
+    char memid[MAX_SHM_STR_LENGTH + 1];
+    ssize_t n = recv(conn, memid, MAX_SHM_STR_LENGTH, 0);
+    if (n <= 0) return;
+    memid[n] = '\0';
+
+    int fd = -1;
+    {
+        std::lock_guard<std::mutex> lock(m_shmem_mutex);
+        auto it = m_shmem_info_map.find(memid);
+        if (it != m_shmem_info_map.end()) fd = it->second.fd;
+    }
+
+    char status = (fd >= 0);
+    struct iovec iov = { &status, 1 };
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } ctrl;
+    struct msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if (fd >= 0) {
+        msg.msg_control = ctrl.buf;
+        msg.msg_controllen = sizeof(ctrl.buf);
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    }
+    sendmsg(conn, &msg, MSG_NOSIGNAL);
+}
+
+int gs::MemoryServices::recv_memfd(const char* memid)
+{
+    /* the id is memfd:<pid of the creator>:<segment> */
+    pid_t pid = strtol(memid + strlen(MEMFD_ID_PREFIX), nullptr, 10);
+    struct sockaddr_un addr;
+    socklen_t len = fill_unix_addr(addr, fd_server_addr(pid));
+
+    int conn = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (conn < 0 || connect(conn, (struct sockaddr*)&addr, len) == -1 ||
+        send(conn, memid, strlen(memid), MSG_NOSIGNAL) != (ssize_t)strlen(memid)) {
+        int error = errno;
+        if (conn >= 0) close(conn);
+        errno = error;
+        return -1;
+    }
+
+    char status = 0;
+    struct iovec iov = { &status, 1 };
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } ctrl;
+    struct msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl.buf;
+    msg.msg_controllen = sizeof(ctrl.buf);
+    ssize_t n = recvmsg(conn, &msg, MSG_CMSG_CLOEXEC);
+    close(conn);
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (n != 1 || !status || !cmsg || cmsg->cmsg_type != SCM_RIGHTS) {
+        errno = ENOENT;
+        return -1;
+    }
+    int fd;
+    memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    return fd;
+}
+
+#else
+std::string gs::MemoryServices::fd_server_addr(pid_t pid) { return ""; }
+void gs::MemoryServices::start_fd_server() {}
+void gs::MemoryServices::stop_fd_server() {}
+void gs::MemoryServices::fd_server() {}
+void gs::MemoryServices::send_memfd(int conn) {}
+int gs::MemoryServices::recv_memfd(const char* memid)
+{
+    errno = ENOSYS;
+    return -1;
+}
+#endif
+
+uint8_t* gs::MemoryServices::map_memfd_create(const char* memname, uint64_t size, std::string& memid)
+{
+#ifdef __linux__
+    int fd = memfd_create(memname, MFD_CLOEXEC);
+    if (fd == -1) {
+        SCP_FATAL(()) << "can't memfd_create " << memname << " [Error: " << strerror(errno) << "]";
+    }
+    /* sparse: the pages are allocated when first touched */
+    if (ftruncate(fd, size) == -1) {
+        SCP_FATAL(()) << "can't truncate " << memname << " [Error: " << strerror(errno) << "]";
+    }
+    uint8_t* ptr = (uint8_t*)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED) {
+        SCP_FATAL(()) << "can't mmap(memfd create) " << memname << " [Error: " << strerror(errno) << "]";
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_shmem_mutex);
+        memid = MEMFD_ID_PREFIX + std::to_string(getpid()) + ":" + std::to_string(m_shmem_info_map.size());
+        m_shmem_info_map.insert({ memid, { ptr, size, fd } });
+    }
+    start_fd_server();
+    SCP_DEBUG(()) << "memfd shared memory created: " << memid << " (" << memname << ") length " << size;
+    return ptr;
+#else
+    SCP_FATAL(()) << "memfd shared memory is only available on Linux";
+    return nullptr;
+#endif
+}
+
 uint8_t* gs::MemoryServices::map_mem_join(const char* memname, size_t size)
 {
-    auto cache = m_shmem_info_map.find(memname);
-    if (cache != m_shmem_info_map.end()) {
-        assert(cache->second.size == size);
-        return cache->second.base;
+    {
+        std::lock_guard<std::mutex> lock(m_shmem_mutex);
+        auto cache = m_shmem_info_map.find(memname);
+        if (cache != m_shmem_info_map.end()) {
+            assert(cache->second.size == size);
+            return cache->second.base;
+        }
     }
 
-    int fd = shm_open(memname, O_RDWR, S_IRUSR | S_IWUSR);
+    bool memfd = strncmp(memname, MEMFD_ID_PREFIX, strlen(MEMFD_ID_PREFIX)) == 0;
+    int fd = memfd ? recv_memfd(memname) : shm_open(memname, O_RDWR, S_IRUSR | S_IWUSR);
     if (fd == -1) {
+        if (memfd) {
+            SCP_FATAL(()) << "can't receive the memfd " << memname << " [Error: " << strerror(errno) << "]";
+        }
         die_sys_api(errno, memname, "can't shm_open join");
     }
     SCP_INFO(()) << "Join Length " << size;
@@ -167,8 +380,12 @@ uint8_t* gs::MemoryServices::map_mem_join(const char* memname, size_t size)
     int mmap_error = errno;
     close(fd);
     if (ptr == MAP_FAILED) {
+        if (memfd) {
+            SCP_FATAL(()) << "can't mmap(memfd join) " << memname << " [Error: " << strerror(mmap_error) << "]";
+        }
         die_sys_api(mmap_error, memname, "can't mmap(shared memory join)");
     }
+    std::lock_guard<std::mutex> lock(m_shmem_mutex);
     m_shmem_info_map.insert({ std::string(memname), { ptr, size } });
     return ptr;
 }
@@ -96,6 +96,27 @@ void gs::SigHandler::mark_error_signal(int signum, std::string error_msg)
     }
 }
 
+void gs::SigHandler::restart_after_fork()
+{
+    sigset_t all, old;
+    sigfillset(&all);
+    sigprocmask(SIG_BLOCK, &all, &old);
+
+    /* the thread only exists in the parent, forget it */
+    if (pass_handler.joinable()) pass_handler.detach();
+    close(self_sockpair_fd[0]);
+    close(self_sockpair_fd[1]);
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, self_sockpair_fd) == -1) {
+        perror("SigHandler socketpair");
+        std::exit(EXIT_FAILURE);
+    }
+    stop_running = false;
+    is_pass_handler_requested = false;
+    _start_pass_signal_handler();
+
+    sigprocmask(SIG_SETMASK, &old, NULL);
+}
+
 gs::SigHandler::~SigHandler()
 {
     _change_pass_sig_cbs_to_force_exit();
@@ -23,6 +23,8 @@
 
 #include <tlm-extensions/shmem_extension.h>
 #include <module_factory_registery.h>
+#include <checkpoint/checkpoint.h>
+#include <perf/counters.h>
 #include <tlm_sockets_buswidth.h>
 #include <unordered_map>
 
@@ -30,6 +32,7 @@
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #endif
 
 namespace gs {
@@ -48,11 +51,13 @@ namespace gs {
  *    - gs_memory does not allocate individual "pages" but a single large block
  *    - It supports DMI requests with the method `get_direct_mem_ptr`
  *    - DMI invalidates are not issued.
+ *    - In a checkpoint, its content is saved as a sparse image, which is mapped copy-on-write when
+ *      the checkpoint is restored, so that it is only read as it is used.
  */
 #define ALIGNEDBITS 12
 
 template <unsigned int BUSWIDTH = DEFAULT_TLM_BUSWIDTH>
-class gs_memory : public sc_core::sc_module
+class gs_memory : public sc_core::sc_module, public ckpt::checkpointable
 {
     uint64_t m_size = 0;
     uint64_t m_address;
@@ -108,10 +113,19 @@ class gs_memory : public sc_core::sc_module
             }
 
             if (!m_use_sub_blocks) {
+                if (!m_mem.m_restore_image.empty() && ((std::string)m_mem.p_mapfile).empty() && !m_mem.p_shmem) {
+                    // Pages are read from the checkpoint when first used, and copied when written
+                    if ((m_ptr = MemoryServices::get().map_file(m_mem.m_restore_image.c_str(), m_len, m_address,
+                                                                true)) != nullptr) {
+                        m_mapped = true;
+                        return *this;
+                    }
+                }
                 if (!((std::string)m_mem.p_mapfile).empty()) {
                     if ((m_ptr = MemoryServices::get().map_file(((std::string)(m_mem.p_mapfile)).c_str(), m_len,
                                                                 m_address)) != nullptr) {
                         m_mapped = true;
+                        load_image();
                         return *this;
                     }
                 }
@@ -129,9 +143,18 @@ class gs_memory : public sc_core::sc_module
                         shmname_stream << "/" << std::hex << hash;
                     }
                     std::string shmname = shmname_stream.str();
-                    if ((m_ptr = MemoryServices::get().map_mem_create(shmname.c_str(), m_len)) != nullptr) {
+                    if (m_mem.p_shmem_backend.get_value() == "memfd") {
+                        /* the segment is then known by its memfd id */
+                        std::string memid;
+                        m_ptr = MemoryServices::get().map_memfd_create(shmname.c_str(), m_len, memid);
+                        shmname = memid;
+                    } else {
+                        m_ptr = MemoryServices::get().map_mem_create(shmname.c_str(), m_len);
+                    }
+                    if (m_ptr != nullptr) {
                         m_mapped = true;
                         m_shmemID = ShmemIDExtension(shmname, (uint64_t)m_ptr, m_len);
+                        load_image();
                         return *this;
                     }
                 }
@@ -181,6 +204,51 @@ class gs_memory : public sc_core::sc_module
             return remain_len;
         }
 
+        /* Copy the checkpoint being restored, for memories which can't map it */
+        void load_image()
+        {
+            const std::string& image = m_mem.m_restore_image;
+            if (image.empty()) {
+                return;
+            }
+            int fd = open(image.c_str(), O_RDONLY);
+            if (fd < 0) {
+                SCP_FATAL(m_mem.name()) << "Unable to open " << image << ": " << strerror(errno);
+            }
+            for (uint64_t done = 0; done < m_len;) {
+                ssize_t n = pread(fd, m_ptr + done, m_len - done, m_address + done);
+                if (n <= 0) {
+                    SCP_FATAL(m_mem.name()) << "Unable to read " << image;
+                }
+                done += n;
+            }
+            close(fd);
+        }
+
+        /* Write the non-zero pages at their offset in the image */
+        void save(int fd)
+        {
+            if (m_use_sub_blocks) {
+                for (auto& b : m_sub_blocks) {
+                    if (b) b->save(fd);
+                }
+                return;
+            }
+            if (!m_ptr) {
+                return;
+            }
+            static const std::vector<uint8_t> zeros(sysconf(_SC_PAGE_SIZE), 0);
+            for (uint64_t off = 0; off < m_len; off += zeros.size()) {
+                uint64_t len = std::min<uint64_t>(zeros.size(), m_len - off);
+                if (!memcmp(m_ptr + off, zeros.data(), len)) {
+                    continue;
+                }
+                if (pwrite(fd, m_ptr + off, len, m_address + off) != (ssize_t)len) {
+                    SCP_FATAL(m_mem.name()) << "Unable to save the memory: " << strerror(errno);
+                }
+            }
+        }
+
         uint8_t* get_ptr() { return m_ptr; }
 
         uint64_t get_len() { return m_len; }
@@ -207,6 +275,16 @@ private:
     std::unique_ptr<gs_memory<BUSWIDTH>::SubBlock<>> m_sub_block;
     cci::cci_broker_handle m_broker;
 
+    /* image of the checkpoint being restored, if any */
+    std::string m_restore_image;
+
+    /* accesses include the debug ones */
+    perf::counter m_reads;
+    perf::counter m_writes;
+    perf::counter m_bytes_read;
+    perf::counter m_bytes_written;
+    perf::counter m_dmi_grants;
+
 protected:
     virtual bool get_direct_mem_ptr(int id, tlm::tlm_generic_payload& txn, tlm::tlm_dmi& dmi_data)
     {
@@ -255,6 +333,7 @@ protected:
             txn.set_extension(ext);
         }
 
+        m_dmi_grants.add();
         return true;
     }
 
@@ -297,6 +376,8 @@ protected:
                     SCP_FATAL(()) << "Address + length is out of range of the memory size";
                 }
             }
+            m_reads.add();
+            m_bytes_read.add(len);
             break;
         case tlm::TLM_WRITE_COMMAND:
             if (p_rom) {
@@ -315,6 +396,8 @@ protected:
                     SCP_FATAL(()) << "Address + length is out of range of the memory size";
                 }
             }
+            m_writes.add();
+            m_bytes_written.add(len);
             break;
         default:
             SCP_FATAL(()) << "TLM command not supported";
@@ -398,6 +481,7 @@ public:
     cci::cci_param<uint64_t> p_min_block_size;
     cci::cci_param<bool> p_shmem;
     cci::cci_param<std::string> p_shmem_prefix;
+    cci::cci_param<std::string> p_shmem_backend;
     cci::cci_param<bool> p_init_mem;
     cci::cci_param<int> p_init_mem_val; // to match the signature of memset
 
@@ -409,8 +493,14 @@ public:
     // the size given on an e.g. 'add_target' in the router
 
     gs_memory(sc_core::sc_module_name name, uint64_t _size = 0)
-        : m_sub_block(nullptr)
+        : ckpt::checkpointable(sc_module::name())
+        , m_sub_block(nullptr)
         , m_broker(cci::cci_get_broker())
+        , m_reads(this, "reads")
+        , m_writes(this, "writes")
+        , m_bytes_read(this, "bytes_read")
+        , m_bytes_written(this, "bytes_written")
+        , m_dmi_grants(this, "dmi_grants")
         , socket("target_socket")
         , reset("reset")
         , p_rom("read_only", false, "Read Only memory (default false)")
@@ -421,6 +511,9 @@ public:
         , p_min_block_size("min_block_size", sysconf(_SC_PAGE_SIZE), "Minimum size of the sub bloc")
         , p_shmem("shared_memory", false, "Allocate using shared memory")
         , p_shmem_prefix("shared_memory_prefix", "", "(optional) prefix_for shared memory file")
+        , p_shmem_backend("shared_memory_backend", "shm",
+                          "shm: named POSIX shared memory, allocated upfront. memfd (Linux): anonymous memory "
+                          "allocated when touched, given to the remote processes as a file descriptor")
         , p_init_mem("init_mem", false, "Initialize allocated memory")
         , p_init_mem_val("init_mem_val", 0, "Value to initialize memory to")
         , load("load", [&](const uint8_t* data, uint64_t offset, uint64_t len) -> void {
@@ -431,6 +524,9 @@ public:
     {
         SCP_DEBUG(()) << "Memory constructor";
         MemoryServices::get().init(); // allow any init required
+        if (p_shmem_backend.get_value() != "shm" && p_shmem_backend.get_value() != "memfd") {
+            SCP_FATAL(()) << "Unknown shared memory backend " << p_shmem_backend.get_value() << " (shm or memfd)";
+        }
         if (_size) {
             std::string ts_name = std::string(sc_module::name()) + ".target_socket";
             if (!m_broker.has_preset_value(ts_name + ".size")) {
@@ -462,6 +558,11 @@ public:
         m_address = base();
         m_size = size();
 
+        ckpt::registry& ckpts = ckpt::registry::get();
+        if (ckpts.restoring()) {
+            m_restore_image = ckpts.restore_file(checkpoint_name(), ".mem");
+        }
+
         m_sub_block = std::make_unique<gs_memory<BUSWIDTH>::SubBlock<>>(0, m_size, *this);
 
         SCP_DEBUG(()) << "m_address: " << m_address;
@@ -478,6 +579,35 @@ public:
 
     ~gs_memory() {}
 
+    void checkpoint_save(ckpt::state& s) override
+    {
+        std::string image = s.file(".mem");
+        int fd = open(image.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+        if (fd < 0) {
+            SCP_FATAL(()) << "Unable to create " << image << ": " << strerror(errno);
+        }
+        if (m_sub_block) {
+            m_sub_block->save(fd);
+        }
+        if (ftruncate(fd, m_size) != 0) {
+            SCP_FATAL(()) << "Unable to save the memory: " << strerror(errno);
+        }
+        close(fd);
+        s.put(m_size);
+    }
+
+    void checkpoint_restore(ckpt::state& s) override
+    {
+        uint64_t size;
+        s.get(size);
+        if (size != m_size) {
+            SCP_FATAL(()) << "The memory size changed since the checkpoint (0x" << std::hex << size << ")";
+        }
+        if (m_restore_image.empty()) {
+            SCP_FATAL(()) << "The memory was set up before the checkpoint module was created";
+        }
+    }
+
     /**
      * @brief this function returns the size of the memory
      *
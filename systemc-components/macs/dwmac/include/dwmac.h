@@ -23,6 +23,7 @@
 #include <module_factory_registery.h>
 
 #include <deque>
+#include <vector>
 
 union opr_mode_reg {
     struct {
@@ -375,7 +376,7 @@ struct dma_desc {
     unsigned int des7;
 };
 
-class dwmac : public sc_core::sc_module
+class dwmac : public sc_core::sc_module, public NetworkBackendAttachable
 {
 protected:
     bool warn_anregs = true;
@@ -436,6 +437,10 @@ protected:
 
     DmaRegisters m_dma;
 
+    /* buffers and descriptors of the frame being transmitted */
+    dma::sg_list m_tx_sg;
+    std::vector<std::pair<uint32_t, dma_desc>> m_tx_descs;
+
     /* DWMAC registers */
     static const uint32_t DWMAC_VERSION_VALUE = 0x0010;
 
@@ -492,7 +497,7 @@ public:
     phy phy_inst;
 
     NetworkBackend* m_backend;
-    void set_backend(NetworkBackend* backend)
+    void set_backend(NetworkBackend* backend) override
     {
         m_backend = backend;
         m_backend->register_receive(this, eth_rx_sc, eth_can_rx_sc);
@@ -547,27 +547,36 @@ bool dwmac::tx()
 
     m_dma.intr.setTxState(DwmacState::TX_READING);
 
-    m_tx_frame.resize(desc.des01.etx.buffer1_size);
-    dma_inst.bus_read(desc.des2, m_tx_frame.data(), desc.des01.etx.buffer1_size);
+    // walk the descriptors of the whole frame, then fetch all its buffers at once
+    m_tx_sg.clear();
+    m_tx_descs.clear();
+    m_tx_sg.push_back({ desc.des2, desc.des01.etx.buffer1_size });
 
-    // fetching the whole frame
     while (!desc.des01.etx.last_segment) {
-        uint32_t cur_desc_addr = m_dma.current_tx_desc;
+        m_tx_descs.push_back({ m_dma.current_tx_desc, desc });
 
         move_to_next_tx_desc(desc);
 
-        // disown descriptor
-        desc.des01.etx.own = 0;
-        dma_inst.bus_write(cur_desc_addr, (uint8_t*)&desc, m_dma.desc_size());
-
         // read next descriptor
         if (!read_tx_desc(&desc)) {
             SCP_ERR(SCMOD) << "cannot read descriptor";
             exit(1);
         }
-        int offset = m_tx_frame.size();
-        m_tx_frame.resize(offset + desc.des01.etx.buffer1_size);
-        dma_inst.bus_read(desc.des2, m_tx_frame.data() + offset, desc.des01.etx.buffer1_size);
+        m_tx_sg.push_back({ desc.des2, desc.des01.etx.buffer1_size });
+    }
+
+    if (dma::sg_size(m_tx_sg) > m_tx_frame.capacity()) {
+        SCP_ERR(SCMOD) << "frame of size " << dma::sg_size(m_tx_sg) << " is too large";
+        m_dma.intr.setTxState(DwmacState::TX_SUSPENDED);
+        return false;
+    }
+    m_tx_frame.resize(dma::sg_size(m_tx_sg));
+    dma_inst.read_sg(m_tx_sg, m_tx_frame.data());
+
+    // disown the descriptors now that their buffers have been fetched
+    for (auto& d : m_tx_descs) {
+        d.second.des01.etx.own = 0;
+        dma_inst.bus_write(d.first, (uint8_t*)&d.second, m_dma.desc_size());
     }
 
     if (m_tx_frame.size() < 14) {
@@ -17,6 +17,7 @@
 #include "macs/mac.h"
 
 #include <deque>
+#include <vector>
 #include <tlm_sockets_buswidth.h>
 
 struct XGmacDesc {
@@ -40,7 +41,7 @@ struct RxTxStats {
 
 #define R_MAX 0x400
 
-class xgmac : public sc_core::sc_module
+class xgmac : public sc_core::sc_module, public NetworkBackendAttachable
 {
 public:
     sc_core::sc_out<bool> sbd_irq, pmt_irq, mci_irq;
@@ -55,6 +56,7 @@ protected:
     bool eth_can_rx() const;
     ssize_t eth_rx(const uint8_t* buf, size_t size);
     void xgmac_read_desc(XGmacDesc* d, int rx);
+    uint32_t xgmac_next_desc(const XGmacDesc* d, uint32_t addr, int rx);
     void xgmac_write_desc(XGmacDesc* d, int rx);
     void xgmac_enet_send();
     void enet_update_irq();
@@ -65,6 +67,10 @@ protected:
 private:
     Payload m_tx_frame;
 
+    /* buffers and descriptors of the frame being transmitted */
+    dma::sg_list m_tx_sg;
+    std::vector<XGmacDesc> m_tx_descs;
+
     MACAddress m_mac;
 
     sc_core::sc_event update_event;
@@ -75,7 +81,7 @@ public:
     virtual ~xgmac();
 
     NetworkBackend* m_backend;
-    void set_backend(NetworkBackend* backend)
+    void set_backend(NetworkBackend* backend) override
     {
         m_backend = backend;
         m_backend->register_receive(this, eth_rx_sc, eth_can_rx_sc);
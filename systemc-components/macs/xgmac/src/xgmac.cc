@@ -185,18 +185,22 @@ void xgmac::xgmac_read_desc(XGmacDesc* d, int rx)
     m_dma.bus_read(addr, (uint8_t*)d, sizeof(*d));
 }
 
+uint32_t xgmac::xgmac_next_desc(const XGmacDesc* d, uint32_t addr, int rx)
+{
+    if (!rx && (d->ctl_stat & 0x00200000)) {
+        return m_regs[DMA_TX_BASE_ADDR];
+    } else if (rx && (d->buffer1_size & 0x8000)) {
+        return m_regs[DMA_RCV_BASE_ADDR];
+    }
+    return addr + sizeof(*d);
+}
+
 void xgmac::xgmac_write_desc(XGmacDesc* d, int rx)
 {
     int reg = rx ? DMA_CUR_RX_DESC_ADDR : DMA_CUR_TX_DESC_ADDR;
     uint32_t addr = m_regs[reg];
 
-    if (!rx && (d->ctl_stat & 0x00200000)) {
-        m_regs[reg] = m_regs[DMA_TX_BASE_ADDR];
-    } else if (rx && (d->buffer1_size & 0x8000)) {
-        m_regs[reg] = m_regs[DMA_RCV_BASE_ADDR];
-    } else {
-        m_regs[reg] += sizeof(*d);
-    }
+    m_regs[reg] = xgmac_next_desc(d, addr, rx);
 
     m_dma.bus_write(addr, (uint8_t*)d, sizeof(*d));
 }
@@ -204,15 +208,14 @@ void xgmac::xgmac_write_desc(XGmacDesc* d, int rx)
 void xgmac::xgmac_enet_send()
 {
     XGmacDesc bd;
-    int frame_size;
+    uint32_t addr = m_regs[DMA_CUR_TX_DESC_ADDR];
     int len;
-    uint8_t frame[8192];
-    uint8_t* ptr;
 
-    ptr = frame;
-    frame_size = 0;
+    m_tx_sg.clear();
+    m_tx_descs.clear();
     while (1) {
-        xgmac_read_desc(&bd, 0);
+        SCP_TRACE(SCMOD) << "Reading XGmacDesc at addr " << std::hex << addr;
+        m_dma.bus_read(addr, (uint8_t*)&bd, sizeof(bd));
         if ((bd.ctl_stat & 0x80000000) == 0) {
             /* Run out of descriptors to transmit.  */
             break;
@@ -227,29 +230,33 @@ void xgmac::xgmac_enet_send()
             SCP_ERR(SCMOD) << __func__ << ":ERROR...ERROR...ERROR... -- xgmac buffer 2 len on send > 2048 (0x"
                            << std::hex << bd.buffer2_size << ")";
         }
-        if (size_t(len) >= sizeof(frame)) {
-            SCP_ERR(SCMOD) << __func__ << ": buffer overflow " << len << " read into " << sizeof(frame);
-            SCP_ERR(SCMOD) << __func__ << ": buffer1.size=" << bd.buffer1_size << "; buffer2.size=" << bd.buffer2_size;
-        }
 
-        m_dma.bus_read(((bd.buffer2_addr << 32) | bd.buffer1_addr), ptr, len);
-        ptr += len;
-        frame_size += len;
+        m_tx_sg.push_back({ ((bd.buffer2_addr << 32) | bd.buffer1_addr), static_cast<uint32_t>(len) });
+        m_tx_descs.push_back(bd);
+        addr = xgmac_next_desc(&bd, addr, 0);
+
         if (bd.ctl_stat & 0x20000000) {
-            /* Last buffer in frame.  */
-            SCP_TRACE(SCMOD) << "Last buffer in frame, sending. Size: " << frame_size;
-            m_tx_frame.resize(frame_size);
-            memcpy(m_tx_frame.data(), frame, frame_size);
-            m_backend->send(m_tx_frame);
-
-            ptr = frame;
-            frame_size = 0;
+            /* Last buffer in frame: fetch all its buffers at once.  */
+            uint32_t frame_size = dma::sg_size(m_tx_sg);
+            if (frame_size > m_tx_frame.capacity()) {
+                SCP_ERR(SCMOD) << __func__ << ": buffer overflow " << frame_size << " read into "
+                               << m_tx_frame.capacity();
+            } else {
+                SCP_TRACE(SCMOD) << "Last buffer in frame, sending. Size: " << frame_size;
+                m_tx_frame.resize(frame_size);
+                m_dma.read_sg(m_tx_sg, m_tx_frame.data());
+                m_backend->send(m_tx_frame);
+            }
             m_regs[DMA_STATUS] |= DMA_STATUS_TI | DMA_STATUS_NIS;
-        }
-        bd.ctl_stat &= ~0x80000000;
 
-        /* Write back the modified descriptor.  */
-        xgmac_write_desc(&bd, 0);
+            /* Write back the modified descriptors.  */
+            for (auto& d : m_tx_descs) {
+                d.ctl_stat &= ~0x80000000;
+                xgmac_write_desc(&d, 0);
+            }
+            m_tx_sg.clear();
+            m_tx_descs.clear();
+        }
     }
 }
 
@@ -0,0 +1,406 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _GREENSOCS_BASE_COMPONENTS_MEMORY_DUMP_H
+#define _GREENSOCS_BASE_COMPONENTS_MEMORY_DUMP_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#endif
+
+/*
+ * Sparse memory dump format
+ *
+ * A sparse dump starts with a file_header, followed by any number of records
+ * in any order. Each record is a record_header followed by 'stored' bytes.
+ * If stored == size the data is raw, otherwise it is compressed with the
+ * algorithm given in the file header. Pages not covered by any record are
+ * zero, or, for incremental dumps, unchanged since the base dump.
+ *
+ * Every sparse dump comes with a '<dump>.hashes' file (hash_header followed
+ * by one 64 bit hash per page) which later dumps can be made relative to.
+ */
+namespace gs {
+namespace memdump {
+
+enum compression : uint32_t {
+    COMP_NONE = 0,
+    COMP_ZSTD = 1,
+    COMP_LZ4 = 2,
+};
+
+static constexpr uint32_t FLAG_INCREMENTAL = 1;
+
+struct file_header {
+    char magic[8]; /* "GSMDUMP1" */
+    uint64_t base; /* address of the memory */
+    uint64_t size; /* size of the memory */
+    uint32_t page_size;
+    uint32_t compression;
+    uint32_t flags;
+    uint32_t reserved;
+};
+
+struct record_header {
+    uint64_t offset; /* offset of the data in the memory */
+    uint32_t size;   /* size of the data */
+    uint32_t stored; /* size of the data in the file */
+};
+
+struct hash_header {
+    char magic[8]; /* "GSMHASH1" */
+    uint32_t page_size;
+    uint32_t reserved;
+    uint64_t npages;
+};
+
+static constexpr char DUMP_MAGIC[8] = { 'G', 'S', 'M', 'D', 'U', 'M', 'P', '1' };
+static constexpr char HASH_MAGIC[8] = { 'G', 'S', 'M', 'H', 'A', 'S', 'H', '1' };
+
+inline bool compression_from_string(const std::string& s, uint32_t& comp)
+{
+    if (s == "none") {
+        comp = COMP_NONE;
+        return true;
+    }
+#ifdef HAVE_ZSTD
+    if (s == "zstd") {
+        comp = COMP_ZSTD;
+        return true;
+    }
+#endif
+#ifdef HAVE_LZ4
+    if (s == "lz4") {
+        comp = COMP_LZ4;
+        return true;
+    }
+#endif
+    return false;
+}
+
+/* Hash a page, len must be a multiple of 8. zero is set if the page only contains zeros */
+inline uint64_t page_hash(const uint8_t* p, size_t len, bool& zero)
+{
+    uint64_t h = 0x9e3779b97f4a7c15ULL ^ len;
+    uint64_t acc = 0;
+
+    for (size_t i = 0; i < len; i += 8) {
+        uint64_t w;
+        memcpy(&w, p + i, 8);
+        acc |= w;
+        w *= 0x87c37b91114253d5ULL;
+        w = (w << 31) | (w >> 33);
+        h ^= w * 0x4cf5ad432745937fULL;
+        h = ((h << 27) | (h >> 37)) * 5 + 0x52dce729;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+
+    zero = (acc == 0);
+    return h;
+}
+
+/* Append len bytes from src to out, compressed if possible. Returns the stored size */
+inline uint32_t compress_append(std::vector<uint8_t>& out, const uint8_t* src, uint32_t len, uint32_t comp)
+{
+    size_t pos = out.size();
+    size_t stored = 0;
+
+    switch (comp) {
+#ifdef HAVE_ZSTD
+    case COMP_ZSTD: {
+        out.resize(pos + ZSTD_compressBound(len));
+        size_t r = ZSTD_compress(out.data() + pos, out.size() - pos, src, len, ZSTD_CLEVEL_DEFAULT);
+        stored = ZSTD_isError(r) ? 0 : r;
+        break;
+    }
+#endif
+#ifdef HAVE_LZ4
+    case COMP_LZ4: {
+        out.resize(pos + LZ4_compressBound(len));
+        int r = LZ4_compress_default(reinterpret_cast<const char*>(src), reinterpret_cast<char*>(out.data() + pos),
+                                     len, out.size() - pos);
+        stored = (r > 0) ? r : 0;
+        break;
+    }
+#endif
+    default:
+        break;
+    }
+
+    if (stored == 0 || stored >= len) {
+        /* not compressible, keep it raw */
+        out.resize(pos + len);
+        memcpy(out.data() + pos, src, len);
+        return len;
+    }
+    out.resize(pos + stored);
+    return stored;
+}
+
+inline bool decompress(uint32_t comp, const uint8_t* src, uint32_t stored, uint8_t* dst, uint32_t len)
+{
+    if (stored == len) {
+        memcpy(dst, src, len);
+        return true;
+    }
+    switch (comp) {
+#ifdef HAVE_ZSTD
+    case COMP_ZSTD:
+        return ZSTD_decompress(dst, len, src, stored) == len;
+#endif
+#ifdef HAVE_LZ4
+    case COMP_LZ4:
+        return LZ4_decompress_safe(reinterpret_cast<const char*>(src), reinterpret_cast<char*>(dst), stored, len) ==
+               (int)len;
+#endif
+    default:
+        return false;
+    }
+}
+
+/*
+ * Encode the pages of [ptr, ptr + len) (found at offset in the memory) as
+ * records appended to out. Pages that are zero (full dump) or whose hash
+ * matches base_hashes (incremental dump) are skipped. The hash of every page
+ * is stored in hashes.
+ */
+inline void encode(const uint8_t* ptr, uint64_t offset, uint64_t len, uint32_t page_size, uint32_t comp,
+                   const uint64_t* base_hashes, uint64_t* hashes, std::vector<uint8_t>& out)
+{
+    uint64_t run_start = 0;
+    uint64_t run_len = 0;
+
+    auto flush = [&]() {
+        if (!run_len) {
+            return;
+        }
+        size_t hdr = out.size();
+        out.resize(hdr + sizeof(record_header));
+        record_header r;
+        r.offset = offset + run_start;
+        r.size = run_len;
+        r.stored = compress_append(out, ptr + run_start, run_len, comp);
+        memcpy(out.data() + hdr, &r, sizeof(r));
+        run_len = 0;
+    };
+
+    for (uint64_t p = 0; p < len; p += page_size) {
+        uint64_t plen = std::min<uint64_t>(page_size, len - p);
+        uint64_t idx = p / page_size;
+        bool zero;
+
+        hashes[idx] = page_hash(ptr + p, plen & ~7ULL, zero);
+        if (plen & 7) {
+            /* trailing bytes of a memory which is not a multiple of 8 */
+            for (uint64_t i = plen & ~7ULL; i < plen; i++) {
+                hashes[idx] = hashes[idx] * 31 + ptr[p + i];
+                zero = zero && !ptr[p + i];
+            }
+        }
+
+        bool skip = base_hashes ? (base_hashes[idx] == hashes[idx]) : zero;
+        if (skip) {
+            flush();
+        } else {
+            if (!run_len) {
+                run_start = p;
+            }
+            run_len += plen;
+        }
+    }
+    flush();
+}
+
+/* Load the page hashes of a previous dump, returns false if they can't be used */
+inline bool load_hashes(const std::string& fname, uint32_t page_size, uint64_t npages, std::vector<uint64_t>& hashes)
+{
+    FILE* f = fopen(fname.c_str(), "rb");
+    if (!f) {
+        return false;
+    }
+    hash_header h;
+    bool ok = fread(&h, sizeof(h), 1, f) == 1 && !memcmp(h.magic, HASH_MAGIC, sizeof(h.magic)) &&
+              h.page_size == page_size && h.npages == npages;
+    if (ok) {
+        hashes.resize(npages);
+        ok = fread(hashes.data(), sizeof(uint64_t), npages, f) == npages;
+    }
+    fclose(f);
+    return ok;
+}
+
+/*
+ * Apply a sparse dump to image. For a full dump the image is resized and
+ * zero filled, for an incremental dump it must already contain the base dump.
+ */
+inline bool restore(const std::string& fname, std::vector<uint8_t>& image)
+{
+    FILE* f = fopen(fname.c_str(), "rb");
+    if (!f) {
+        return false;
+    }
+
+    file_header h;
+    if (fread(&h, sizeof(h), 1, f) != 1 || memcmp(h.magic, DUMP_MAGIC, sizeof(h.magic))) {
+        fclose(f);
+        return false;
+    }
+    if (!(h.flags & FLAG_INCREMENTAL)) {
+        image.assign(h.size, 0);
+    } else if (image.size() != h.size) {
+        fclose(f);
+        return false;
+    }
+
+    bool ok = true;
+    record_header r;
+    std::vector<uint8_t> buf;
+    while (ok && fread(&r, sizeof(r), 1, f) == 1) {
+        buf.resize(r.stored);
+        ok = r.offset + r.size <= h.size && fread(buf.data(), 1, r.stored, f) == r.stored &&
+             decompress(h.compression, buf.data(), r.stored, image.data() + r.offset, r.size);
+    }
+    fclose(f);
+    return ok;
+}
+
+/*
+ * Thread pool used by the memory dumper: a number of workers capture and
+ * encode chunks of memory, while a single writer thread does the file I/O in
+ * submission order.
+ */
+class pool
+{
+    std::vector<std::thread> m_workers;
+    std::thread m_writer;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::deque<std::function<void()>> m_jobs;
+    std::deque<std::function<void()>> m_writes;
+    size_t m_busy = 0;
+    bool m_writing = false;
+    bool m_stop = false;
+
+    void worker()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            m_cond.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+            if (m_jobs.empty()) {
+                return;
+            }
+            auto job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+            m_busy++;
+            lock.unlock();
+            job();
+            lock.lock();
+            m_busy--;
+            m_cond.notify_all();
+        }
+    }
+
+    void writer()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            m_cond.wait(lock, [this] { return m_stop || !m_writes.empty(); });
+            if (m_writes.empty()) {
+                return;
+            }
+            auto w = std::move(m_writes.front());
+            m_writes.pop_front();
+            m_writing = true;
+            m_cond.notify_all();
+            lock.unlock();
+            w();
+            lock.lock();
+            m_writing = false;
+            m_cond.notify_all();
+        }
+    }
+
+public:
+    pool(unsigned int nthreads)
+    {
+        for (unsigned int i = 0; i < std::max(1u, nthreads); i++) {
+            m_workers.emplace_back(&pool::worker, this);
+        }
+        m_writer = std::thread(&pool::writer, this);
+    }
+
+    ~pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cond.notify_all();
+        for (auto& t : m_workers) {
+            t.join();
+        }
+        m_writer.join();
+    }
+
+    size_t size() const { return m_workers.size(); }
+
+    void submit(std::function<void()> job)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back(std::move(job));
+        m_cond.notify_all();
+    }
+
+    /* Queue a write. If max_pending is not 0, wait for the queue to drain below it first */
+    void write(std::function<void()> w, size_t max_pending = 0)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (max_pending) {
+            m_cond.wait(lock, [&] { return m_writes.size() < max_pending; });
+        }
+        m_writes.push_back(std::move(w));
+        m_cond.notify_all();
+    }
+
+    /* Wait for all the capture jobs to be done */
+    void wait_jobs()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cond.wait(lock, [this] { return m_jobs.empty() && !m_busy; });
+    }
+
+    /* Wait for everything, including the writes, to be done */
+    void wait_all()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cond.wait(lock, [this] { return m_jobs.empty() && !m_busy && m_writes.empty() && !m_writing; });
+    }
+};
+
+} // namespace memdump
+} // namespace gs
+
+#endif
@@ -18,6 +18,7 @@
 #include <cciutils.h>
 #include <module_factory_registery.h>
 #include <tlm_sockets_buswidth.h>
+#include <memory_dump.h>
 
 namespace gs {
 
@@ -55,6 +56,21 @@ std::vector<std::string> find_object_of_type(sc_core::sc_object* m = NULL)
  *
  * @brief A device that finds Memory components through the system and trys to
  * dump their MemoryDumper
+ *
+ * Memories are captured through DMI by a pool of worker threads, and written
+ * out by a background thread. With async set, the dump returns (and the
+ * simulation goes on) as soon as the memories have been captured. Note that
+ * for the raw format this means holding a copy of the memories until they
+ * are written.
+ *
+ * @param @format : "raw" (one image per memory) or "sparse" (see memory_dump.h)
+ * @param @compression : "none", "zstd" or "lz4", compressed dumps are sparse
+ * @param @incremental_base : outfile of a previous sparse dump, only the pages which
+ * changed since that dump are saved
+ * @param @async : don't wait for the dump to be written before returning
+ * @param @threads : number of capture threads (0 = one per host CPU)
+ * @param @page_size : sparse dump granularity
+ * @param @chunk_size : amount of memory captured and compressed by a thread at once
  */
 
 template <unsigned int BUSWIDTH = DEFAULT_TLM_BUSWIDTH>
@@ -64,49 +80,243 @@ class memory_dumper : public sc_core::sc_module
 
     cci::cci_param<bool> p_dump;
     cci::cci_param<std::string> p_outfile;
+    cci::cci_param<std::string> p_format;
+    cci::cci_param<std::string> p_compression;
+    cci::cci_param<std::string> p_incremental_base;
+    cci::cci_param<bool> p_async;
+    cci::cci_param<uint32_t> p_threads;
+    cci::cci_param<uint32_t> p_page_size;
+    cci::cci_param<uint32_t> p_chunk_size;
+
+    struct dump_file {
+        std::string name;
+        FILE* f = nullptr;
+        std::vector<uint64_t> hashes;
+        std::vector<uint64_t> base_hashes;
+        std::atomic<bool> error{ false };
+    };
+
+    std::unique_ptr<memdump::pool> m_pool;
+    std::vector<std::shared_ptr<dump_file>> m_files;
+
+    /* Wait for the previous dump to be written, and report its errors */
+    void complete()
+    {
+        if (!m_pool) {
+            return;
+        }
+        m_pool->wait_all();
+        for (auto& df : m_files) {
+            if (df->error) {
+                SCP_WARN(SCMOD) << "saving data to file " << df->name;
+            }
+        }
+        m_files.clear();
+    }
+
+    static void write_at(std::shared_ptr<dump_file> df, uint64_t pos, const uint8_t* ptr, uint64_t len)
+    {
+        if (fseeko(df->f, pos, SEEK_SET) || fwrite(ptr, len, 1, df->f) != 1) {
+            df->error = true;
+        }
+    }
+
+    static void write_append(std::shared_ptr<dump_file> df, const uint8_t* ptr, uint64_t len)
+    {
+        if (fwrite(ptr, len, 1, df->f) != 1) {
+            df->error = true;
+        }
+    }
+
+    static void write_hashes(std::shared_ptr<dump_file> df, uint32_t page_size)
+    {
+        std::string fname = df->name + ".hashes";
+        FILE* f = fopen(fname.c_str(), "wb");
+        memdump::hash_header h = {};
+        memcpy(h.magic, memdump::HASH_MAGIC, sizeof(h.magic));
+        h.page_size = page_size;
+        h.npages = df->hashes.size();
+        if (!f || fwrite(&h, sizeof(h), 1, f) != 1 ||
+            fwrite(df->hashes.data(), sizeof(uint64_t), df->hashes.size(), f) != df->hashes.size()) {
+            df->error = true;
+        }
+        if (f) {
+            fclose(f);
+        }
+    }
+
+    /* Capture len bytes at ptr, found at offset in the memory dumped in df */
+    void capture(std::shared_ptr<dump_file> df, const uint8_t* ptr, uint64_t offset, uint64_t len, bool sparse,
+                 uint32_t comp)
+    {
+        uint32_t page_size = p_page_size;
+        /* bound the amount of captured data waiting to be written, unless the simulation must go on */
+        size_t max_pending = p_async ? 0 : 2 * m_pool->size();
+
+        if (!sparse && !p_async) {
+            /* nothing can touch the memory until the dump is complete */
+            m_pool->write([df, ptr, offset, len]() { write_at(df, offset, ptr, len); });
+            return;
+        }
+
+        m_pool->submit([this, df, ptr, offset, len, sparse, comp, page_size, max_pending]() {
+            auto out = std::make_shared<std::vector<uint8_t>>();
+            if (sparse) {
+                const uint64_t* base = df->base_hashes.empty() ? nullptr : &df->base_hashes[offset / page_size];
+                memdump::encode(ptr, offset, len, page_size, comp, base, &df->hashes[offset / page_size], *out);
+                if (out->empty()) {
+                    return;
+                }
+                m_pool->write([df, out]() { write_append(df, out->data(), out->size()); }, max_pending);
+            } else {
+                out->assign(ptr, ptr + len);
+                m_pool->write([df, out, offset]() { write_at(df, offset, out->data(), out->size()); }, max_pending);
+            }
+        });
+    }
+
+    /* Capture a page that spans several DMI regions through the debug interface */
+    void capture_dbg(std::shared_ptr<dump_file> df, uint64_t addr, uint64_t offset, uint64_t len, bool sparse,
+                     uint32_t comp)
+    {
+        auto buf = std::make_shared<std::vector<uint8_t>>(len);
+        tlm::tlm_generic_payload trans;
+        trans.set_command(tlm::TLM_READ_COMMAND);
+        trans.set_address(addr + offset);
+        trans.set_data_ptr(buf->data());
+        trans.set_data_length(len);
+        trans.set_streaming_width(len);
+        trans.set_byte_enable_length(0);
+        if (initiator_socket->transport_dbg(trans) != len) {
+            SCP_WARN(SCMOD) << "loading data (debug) from memory @ "
+                            << "0x" << std::hex << addr + offset;
+        }
+        if (sparse) {
+            auto out = std::make_shared<std::vector<uint8_t>>();
+            const uint64_t* base = df->base_hashes.empty() ? nullptr : &df->base_hashes[offset / p_page_size];
+            memdump::encode(buf->data(), offset, len, p_page_size, comp, base, &df->hashes[offset / p_page_size],
+                            *out);
+            if (!out->empty()) {
+                m_pool->write([df, out]() { write_append(df, out->data(), out->size()); });
+            }
+        } else {
+            m_pool->write([df, buf, offset]() { write_at(df, offset, buf->data(), buf->size()); });
+        }
+    }
 
 protected:
-#define LINESIZE 16
     void dump()
     {
+        uint32_t page_size = p_page_size;
+        uint32_t comp;
+
+        if (!memdump::compression_from_string(p_compression, comp)) {
+            SCP_WARN(SCMOD) << "compression " << p_compression.get_value() << " not available, not compressing";
+            comp = memdump::COMP_NONE;
+        }
+        bool sparse = (p_format.get_value() == "sparse") || (comp != memdump::COMP_NONE);
+        if (!sparse && p_format.get_value() != "raw") {
+            SCP_FATAL(SCMOD) << "unknown dump format " << p_format.get_value();
+        }
+        if (!page_size || page_size % 8 || !p_chunk_size || p_chunk_size % page_size) {
+            SCP_FATAL(SCMOD) << "page_size must be a multiple of 8, chunk_size a multiple of page_size";
+        }
+
+        complete();
+        if (!m_pool) {
+            uint32_t nthreads = p_threads ? p_threads.get_value() : std::thread::hardware_concurrency();
+            m_pool = std::make_unique<memdump::pool>(nthreads);
+        }
+
         for (std::string m : gs::find_object_of_type<gs::gs_memory<BUSWIDTH>>()) {
             uint64_t addr = gs::cci_get<uint64_t>(m_broker, m + ".target_socket.address");
             uint64_t size = gs::cci_get<uint64_t>(m_broker, m + ".target_socket.size");
             tlm::tlm_generic_payload trans;
             std::stringstream fnamestr;
-            fnamestr << m << ".0x" << std::hex << addr << "-0x" << (addr + size) << "." << p_outfile.get_value();
-            std::string fname = fnamestr.str();
+            fnamestr << m << ".0x" << std::hex << addr << "-0x" << (addr + size) << ".";
+            std::string fname = fnamestr.str() + p_outfile.get_value();
+
+            auto df = std::make_shared<dump_file>();
+            df->name = fname;
+            df->f = fopen(fname.c_str(), "wb");
+            if (!df->f) {
+                SCP_WARN(SCMOD) << "opening file " << fname;
+                continue;
+            }
+            m_files.push_back(df);
 
-            FILE* out = fopen(fname.c_str(), "wb");
+            if (sparse) {
+                uint64_t npages = (size + page_size - 1) / page_size;
+                df->hashes.resize(npages);
 
-            uint8_t data[LINESIZE];
-            for (uint64_t offset = 0; offset < size;) {
-                int rsize = LINESIZE;
-                if (offset + rsize >= size) {
-                    rsize = size - offset;
+                memdump::file_header h = {};
+                memcpy(h.magic, memdump::DUMP_MAGIC, sizeof(h.magic));
+                h.base = addr;
+                h.size = size;
+                h.page_size = page_size;
+                h.compression = comp;
+                if (!p_incremental_base.get_value().empty()) {
+                    std::string base = fnamestr.str() + p_incremental_base.get_value() + ".hashes";
+                    if (memdump::load_hashes(base, page_size, npages, df->base_hashes)) {
+                        h.flags |= memdump::FLAG_INCREMENTAL;
+                    } else {
+                        SCP_WARN(SCMOD) << "no usable page hashes in " << base << ", doing a full dump";
+                    }
                 }
+                if (fwrite(&h, sizeof(h), 1, df->f) != 1) {
+                    df->error = true;
+                }
+            }
+
+            for (uint64_t offset = 0; offset < size;) {
                 trans.set_command(tlm::TLM_READ_COMMAND);
                 trans.set_address(addr + offset);
-                trans.set_data_ptr(data);
-                trans.set_data_length(rsize);
-                trans.set_streaming_width(rsize);
+                trans.set_data_ptr(nullptr);
+                trans.set_data_length(0);
+                trans.set_streaming_width(0);
                 trans.set_byte_enable_length(0);
                 tlm::tlm_dmi dmi;
                 if (!initiator_socket->get_direct_mem_ptr(trans, dmi)) {
-                    std::stringstream info;
                     SCP_WARN(SCMOD) << "loading data (no DMI) from memory @ "
                                     << "0x" << std::hex << addr + offset;
                     break;
                 }
-                uint64_t size = (dmi.get_end_address() - dmi.get_start_address()) + 1;
-                uint8_t* ptr = dmi.get_dmi_ptr();
+                uint8_t* ptr = dmi.get_dmi_ptr() + (addr + offset - dmi.get_start_address());
+                uint64_t avail = std::min<uint64_t>(dmi.get_end_address() - (addr + offset) + 1, size - offset);
 
-                if (fwrite(ptr, size, 1, out) != 1) {
-                    SCP_WARN(SCMOD) << "saving data to file " << fname;
+                if (avail < page_size && avail < size - offset) {
+                    /* this page spans several DMI regions */
+                    uint64_t len = std::min<uint64_t>(page_size, size - offset);
+                    capture_dbg(df, addr, offset, len, sparse, comp);
+                    offset += len;
+                    continue;
+                }
+                if (avail < size - offset) {
+                    /* keep chunks page aligned, the end of the region is captured with the next one */
+                    avail -= avail % page_size;
+                }
+                for (uint64_t c = 0; c < avail; c += p_chunk_size) {
+                    capture(df, ptr + c, offset + c, std::min<uint64_t>(p_chunk_size, avail - c), sparse, comp);
                 }
-                offset += size;
+                offset += avail;
             }
-            fclose(out);
+        }
+
+        /* wait for the memories to be captured, then finish the files behind them */
+        m_pool->wait_jobs();
+        for (auto& df : m_files) {
+            m_pool->write([df, sparse, page_size]() {
+                if (sparse) {
+                    write_hashes(df, page_size);
+                }
+                if (fclose(df->f)) {
+                    df->error = true;
+                }
+            });
+        }
+
+        if (!p_async) {
+            complete();
         }
     }
 
@@ -129,6 +339,13 @@ public:
         : m_broker(cci::cci_get_broker())
         , p_dump("MemoryDumper_trigger", false)
         , p_outfile("outfile", "dumpfile")
+        , p_format("format", "raw", "dump format: raw or sparse")
+        , p_compression("compression", "none", "compression: none, zstd or lz4 (implies a sparse dump)")
+        , p_incremental_base("incremental_base", "", "outfile of a previous sparse dump to dump relative to")
+        , p_async("async", false, "return as soon as memories are captured, write them in the background")
+        , p_threads("threads", 0, "number of capture threads (0 = one per host CPU)")
+        , p_page_size("page_size", 4096, "granularity of sparse and incremental dumps")
+        , p_chunk_size("chunk_size", 1024 * 1024, "amount of memory captured by a thread at once")
         , initiator_socket("initiator_socket")
         , target_socket("target_socket")
     {
@@ -140,7 +357,9 @@ public:
     memory_dumper() = delete;
     memory_dumper(const memory_dumper&) = delete;
 
-    ~memory_dumper() {}
+    void end_of_simulation() override { complete(); }
+
+    ~memory_dumper() { complete(); }
 };
 
 void memorydumper_tgr_helper()
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _GREENSOCS_BASE_COMPONENTS_PERF_STATS_H
+#define _GREENSOCS_BASE_COMPONENTS_PERF_STATS_H
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <cci_configuration>
+#include <systemc>
+#include <scp/report.h>
+
+#include <module_factory_registery.h>
+#include <perf/counters.h>
+
+namespace gs {
+
+/**
+ * @class perf_stats
+ *
+ * @brief Enables the performance counters of the components (see
+ * perf/counters.h) and dumps them as JSON at the end of the simulation, and
+ * optionally periodically (in host time, so that a stuck simulation can
+ * still be inspected).
+ *
+ * @param @enable : record the counters
+ * @param @file : JSON output file, if empty the stats are logged at the end of the simulation
+ * @param @interval_ms : also dump the stats every interval_ms of host time (0 disables)
+ */
+class perf_stats : public sc_core::sc_module
+{
+    SCP_LOGGER(());
+
+public:
+    cci::cci_param<bool> p_enable;
+    cci::cci_param<std::string> p_file;
+    cci::cci_param<uint64_t> p_interval_ms;
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_stop = false;
+    std::thread m_dumper;
+
+    void dumper()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_cond.wait_for(lock, std::chrono::milliseconds(p_interval_ms.get_value()),
+                                [this] { return m_stop; })) {
+            dump();
+        }
+    }
+
+    void stop_dumper()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cond.notify_all();
+        if (m_dumper.joinable()) {
+            m_dumper.join();
+        }
+    }
+
+public:
+    perf_stats(const sc_core::sc_module_name& nm)
+        : sc_core::sc_module(nm)
+        , p_enable("enable", true, "Record the performance counters")
+        , p_file("file", "perf_stats.json", "JSON output file, if empty the stats are logged")
+        , p_interval_ms("interval_ms", 0, "Also dump the stats periodically, in ms of host time (0 disables)")
+    {
+        perf::enable(p_enable);
+    }
+
+    perf_stats() = delete;
+    perf_stats(const perf_stats&) = delete;
+
+    ~perf_stats() { stop_dumper(); }
+
+    void dump()
+    {
+        if (p_file.get_value().empty()) {
+            SCP_INFO(()) << "Performance counters:\n" << perf::registry::get().to_json();
+        } else if (!perf::registry::get().dump(p_file)) {
+            SCP_WARN(()) << "Unable to write the performance counters to " << p_file.get_value();
+        }
+    }
+
+    void start_of_simulation() override
+    {
+        if (p_enable && p_interval_ms && !p_file.get_value().empty()) {
+            m_dumper = std::thread(&perf_stats::dumper, this);
+        }
+    }
+
+    void end_of_simulation() override
+    {
+        stop_dumper();
+        if (p_enable) {
+            dump();
+        }
+    }
+};
+} // namespace gs
+
+extern "C" void module_register();
+#endif
@@ -0,0 +1,11 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <perf_stats.h>
+
+typedef gs::perf_stats perf_stats;
+
+void module_register() { GSC_MODULE_REGISTER_C(perf_stats); }
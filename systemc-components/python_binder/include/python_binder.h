@@ -29,6 +29,8 @@
 #include <libgssync.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/numpy.h>
+#include <chrono>
+#include <vector>
 
 
 namespace gs {
@@ -91,6 +93,38 @@ private:
 
     void target_signal_cb(int id, bool value);
 
+    bool filter_out(int id, tlm::tlm_generic_payload& trans);
+
+    pybind11::object& py_fn(pybind11::object& fn, const char* fn_name);
+
+    void print_stats();
+
+    /* Address ranges of a target socket which are handled by the python module, see target_filter */
+    struct filter_range {
+        uint64_t start;
+        uint64_t end; /* inclusive */
+        bool read;
+        bool write;
+    };
+
+    struct target_filter {
+        std::vector<filter_range> ranges; /* empty: everything goes to python */
+        tlm::tlm_response_status response = tlm::TLM_ADDRESS_ERROR_RESPONSE;
+        uint64_t filtered = 0;
+    };
+
+    /* Host time spent in a python callback */
+    struct cb_stats {
+        uint64_t calls = 0;
+        std::chrono::steady_clock::duration time = std::chrono::steady_clock::duration::zero();
+
+        void add(std::chrono::steady_clock::time_point start)
+        {
+            calls++;
+            time += std::chrono::steady_clock::now() - start;
+        }
+    };
+
 public:
     cci::cci_param<std::string> p_py_mod_name;
     cci::cci_param<std::string> p_py_mod_dir;
@@ -112,6 +146,17 @@ private:
     pybind11::module_ m_biflow_socket_mod;
     pybind11::module_ m_initiator_signal_socket_mod;
     pybind11::module_ m_cpp_shared_vars_mod;
+    pybind11::module_ m_target_filter_mod;
+
+    /* python callbacks, looked up on their first call */
+    pybind11::object m_b_transport_fn;
+    pybind11::object m_bf_b_transport_fn;
+    pybind11::object m_target_signal_cb_fn;
+
+    std::vector<target_filter> m_filters;
+    cb_stats m_b_transport_stats;
+    cb_stats m_bf_b_transport_stats;
+    cb_stats m_target_signal_cb_stats;
 };
 } // namespace gs
 
@@ -17,6 +17,7 @@
 #include <stdexcept>
 #include <cstdint>
 #include <exception>
+#include <chrono>
 
 namespace gs {
 
@@ -311,6 +312,8 @@ PYBIND11_EMBEDDED_MODULE(initiator_signal_socket, m) {}
 
 PYBIND11_EMBEDDED_MODULE(biflow_socket, m) {}
 
+PYBIND11_EMBEDDED_MODULE(target_filter, m) {}
+
 PyInterpreterManager::PyInterpreterManager() { pybind11::initialize_interpreter(); }
 
 void PyInterpreterManager::init()
@@ -388,6 +391,30 @@ void python_binder<BUSWIDTH>::init_binder()
             [this](int id, pybind11::object& py_trans, pybind11::object& delay) {
                 do_b_transport(id, py_trans, delay);
             });
+        m_tlm_do_b_transport_mod.attr("do_b_transport_batch") = pybind11::cpp_function(
+            [this](int id, pybind11::iterable& py_transs, pybind11::object& py_delay) {
+                sc_core::sc_time* delay = py_delay.cast<sc_core::sc_time*>();
+                for (pybind11::handle py_trans : py_transs) {
+                    tlm::tlm_generic_payload* trans = py_trans.cast<tlm::tlm_generic_payload*>();
+                    initiator_sockets[id]->b_transport(*trans, *delay);
+                }
+            });
+
+        /*
+         * Only the accesses to the ranges registered by the python module (if any) reach python, the others are
+         * answered with the default response.
+         */
+        m_filters.resize(p_tlm_target_ports_num.get_value());
+        m_target_filter_mod = pybind11::module_::import("target_filter");
+        m_target_filter_mod.attr("add_range") = pybind11::cpp_function(
+            [this](int id, uint64_t start, uint64_t end, bool read, bool write) {
+                m_filters.at(id).ranges.push_back({ start, end, read, write });
+            },
+            pybind11::arg("id"), pybind11::arg("start"), pybind11::arg("end"), pybind11::arg("read") = true,
+            pybind11::arg("write") = true);
+        m_target_filter_mod.attr("set_default_response") = pybind11::cpp_function(
+            [this](int id, tlm::tlm_response_status response) { m_filters.at(id).response = response; });
+        m_target_filter_mod.attr("clear") = pybind11::cpp_function([this](int id) { m_filters.at(id).ranges.clear(); });
 
         setup_biflow_socket();
 
@@ -419,7 +446,22 @@ void python_binder<BUSWIDTH>::setup_biflow_socket()
     m_biflow_socket_mod.attr("can_receive_set") = pybind11::cpp_function(
         [this](int i) { bf_socket[0].can_receive_set(i); });
     m_biflow_socket_mod.attr("can_receive_any") = pybind11::cpp_function([this]() { bf_socket[0].can_receive_any(); });
-    m_biflow_socket_mod.attr("enqueue") = pybind11::cpp_function([this](uint8_t data) { bf_socket[0].enqueue(data); });
+    /* enqueue accepts a single byte, or any bytes like object (bytes, bytearray, uint8 numpy array, list...) */
+    m_biflow_socket_mod.attr("enqueue") = pybind11::cpp_function([this](pybind11::object& data) {
+        if (pybind11::isinstance<pybind11::int_>(data)) {
+            bf_socket[0].enqueue(data.cast<uint8_t>());
+            return;
+        }
+        if (pybind11::isinstance<pybind11::buffer>(data)) {
+            pybind11::buffer_info info = pybind11::reinterpret_borrow<pybind11::buffer>(data).request();
+            if (info.itemsize == 1 && (info.ndim == 0 || (info.ndim == 1 && info.strides[0] == 1))) {
+                bf_socket[0].enqueue(static_cast<const uint8_t*>(info.ptr), info.size);
+                return;
+            }
+        }
+        std::vector<uint8_t> bytes = data.cast<std::vector<uint8_t>>();
+        bf_socket[0].enqueue(bytes.data(), bytes.size());
+    });
     m_biflow_socket_mod.attr("set_default_txn") = pybind11::cpp_function([this](pybind11::object& py_trans) {
         tlm::tlm_generic_payload* trans = py_trans.cast<tlm::tlm_generic_payload*>();
         bf_socket[0].set_default_txn(*trans);
@@ -440,17 +482,53 @@ void python_binder<BUSWIDTH>::do_b_transport(int id, pybind11::object& py_trans,
     initiator_sockets[id]->b_transport(*trans, *delay);
 }
 
+template <unsigned int BUSWIDTH>
+pybind11::object& python_binder<BUSWIDTH>::py_fn(pybind11::object& fn, const char* fn_name)
+{
+    if (!fn) {
+        fn = m_main_mod.attr(fn_name);
+    }
+    return fn;
+}
+
+template <unsigned int BUSWIDTH>
+bool python_binder<BUSWIDTH>::filter_out(int id, tlm::tlm_generic_payload& trans)
+{
+    target_filter& filter = m_filters[id];
+    if (filter.ranges.empty()) {
+        return false;
+    }
+    uint64_t start = trans.get_address();
+    uint64_t end = start + (trans.get_data_length() ? trans.get_data_length() - 1 : 0);
+    for (const filter_range& r : filter.ranges) {
+        if (start >= r.start && end <= r.end &&
+            (trans.is_read() ? r.read : (trans.is_write() ? r.write : true))) {
+            return false;
+        }
+    }
+    SCP_DEBUG(()) << "b_transport on target_socket_" << id << " filtered out, trans: "
+                  << scp::scp_txn_tostring(trans);
+    filter.filtered++;
+    trans.set_response_status(filter.response);
+    return true;
+}
+
 template <unsigned int BUSWIDTH>
 void python_binder<BUSWIDTH>::b_transport(int id, tlm::tlm_generic_payload& trans, sc_core::sc_time& delay)
 {
+    if (filter_out(id, trans)) {
+        return;
+    }
     SCP_DEBUG(()) << "before b_transport on target_socket_" << id << " trans: " << scp::scp_txn_tostring(trans);
     tlm::tlm_generic_payload* ptrans = &trans;
     sc_core::sc_time* pdelay = &delay;
+    auto start = std::chrono::steady_clock::now();
     try {
-        m_main_mod.attr("b_transport")(id, pybind11::cast(ptrans), pybind11::cast(pdelay));
+        py_fn(m_b_transport_fn, "b_transport")(id, pybind11::cast(ptrans), pybind11::cast(pdelay));
     } catch (const std::exception& e) {
         SCP_FATAL(()) << e.what();
     }
+    m_b_transport_stats.add(start);
     SCP_DEBUG(()) << "after b_transport on target_socket_" << id << " trans: " << scp::scp_txn_tostring(trans);
 }
 
@@ -461,11 +539,13 @@ void python_binder<BUSWIDTH>::bf_b_transport(tlm::tlm_generic_payload& trans, sc
                   << " trans: " << scp::scp_txn_tostring(trans);
     tlm::tlm_generic_payload* ptrans = &trans;
     sc_core::sc_time* pdelay = &delay;
+    auto start = std::chrono::steady_clock::now();
     try {
-        m_main_mod.attr("bf_b_transport")(pybind11::cast(ptrans), pybind11::cast(pdelay));
+        py_fn(m_bf_b_transport_fn, "bf_b_transport")(pybind11::cast(ptrans), pybind11::cast(pdelay));
     } catch (const std::exception& e) {
         SCP_FATAL(()) << e.what();
     }
+    m_bf_b_transport_stats.add(start);
     SCP_DEBUG(()) << "after bf_b_transport "
                   << " trans: " << scp::scp_txn_tostring(trans);
 }
@@ -533,16 +613,40 @@ template <unsigned int BUSWIDTH>
 void python_binder<BUSWIDTH>::end_of_simulation()
 {
     exec_if_py_fn_exist("end_of_simulation");
+    print_stats();
 }
 
 template <unsigned int BUSWIDTH>
 void python_binder<BUSWIDTH>::target_signal_cb(int id, bool value)
 {
+    auto start = std::chrono::steady_clock::now();
     try {
-        m_main_mod.attr("target_signal_cb")(id, value);
+        py_fn(m_target_signal_cb_fn, "target_signal_cb")(id, value);
     } catch (const std::exception& e) {
         SCP_FATAL(()) << e.what();
     }
+    m_target_signal_cb_stats.add(start);
+}
+
+template <unsigned int BUSWIDTH>
+void python_binder<BUSWIDTH>::print_stats()
+{
+    /* host time includes any SystemC wait done by the callback */
+    auto print = [this](const char* fn_name, const cb_stats& stats) {
+        if (!stats.calls) return;
+        double us = std::chrono::duration<double, std::micro>(stats.time).count();
+        SCP_INFO(()) << fn_name << ": " << stats.calls << " calls, " << us / 1000 << " ms host time, "
+                     << us / stats.calls << " us per call";
+    };
+    print("b_transport", m_b_transport_stats);
+    print("bf_b_transport", m_bf_b_transport_stats);
+    print("target_signal_cb", m_target_signal_cb_stats);
+    for (size_t i = 0; i < m_filters.size(); i++) {
+        if (m_filters[i].filtered) {
+            SCP_INFO(()) << "target_socket_" << i << ": " << m_filters[i].filtered
+                         << " accesses answered without calling python";
+        }
+    }
 }
 
 template class python_binder<32>;
@@ -8,6 +8,11 @@
 #ifndef REALTIMLIMITER_H
 #define REALTIMLIMITER_H
 
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <ctime>
 #include <thread>
 #include <mutex>
 #include <queue>
@@ -18,6 +23,7 @@
 #include <scp/report.h>
 
 #include <async_event.h>
+#include <checkpoint/checkpoint.h>
 #include <module_factory_registery.h>
 
 namespace gs {
@@ -25,15 +31,26 @@ namespace gs {
  * @brief realtimelimiter: sc_module which suspends SystemC if SystemC time drifts ahead of realtime
  * @param @RTquantum_ms : realtime tick rate between checks.
  * @param @SCTimeout_ms : If SystemC time is behind by more than this value, then generate a fatal abort (0 disables)
+ * @param @speed : SystemC time per realtime, e.g. 0.5 runs at half realtime, 10 at 10x realtime
+ * @param @precise : Tick on absolute deadlines, only suspend SystemC when it is ahead (allows sub-ms quanta)
+ * @param @max_lag_ms, @max_lead_ms, @suspended_ms : (read only) how far SystemC was behind and ahead of
+ * realtime, and how long it was suspended waiting for realtime.
  *
+ * When a checkpoint is restored, realtime pacing starts from the checkpoint time, once the platform is restored.
  */
-SC_MODULE (realtimelimiter) {
+class realtimelimiter : public sc_core::sc_module, public ckpt::checkpointable
+{
     SCP_LOGGER();
     cci::cci_param<double> p_RTquantum_ms;
     cci::cci_param<double> p_SCTimeout_ms;
     cci::cci_param<double> p_MaxTime_ms;
+    cci::cci_param<double> p_speed;
+    cci::cci_param<bool> p_precise;
+    cci::cci_param<double> p_max_lag_ms;
+    cci::cci_param<double> p_max_lead_ms;
+    cci::cci_param<double> p_suspended_ms;
 
-    std::chrono::high_resolution_clock::time_point startRT;
+    std::chrono::steady_clock::time_point startRT;
     sc_core::sc_time startSC;
     sc_core::sc_time runto;
     std::thread m_tick_thread;
@@ -42,6 +59,85 @@ SC_MODULE (realtimelimiter) {
     sc_core::sc_time suspend_at = sc_core::SC_ZERO_TIME;
     async_event tick;
 
+    /* settings, cached when enabled as they are used from the realtime thread */
+    bool m_precise = false;
+    double m_speed = 1.0;
+    double m_quantum_ms = 0;
+
+    /* shared with the realtime thread in precise mode */
+    std::atomic<bool> m_ahead{ false };
+    std::atomic<double> m_sc_seconds{ 0 };
+
+    /* statistics, SystemC thread only */
+    double m_max_lag = 0;
+    double m_max_lead = 0;
+    double m_suspended = 0;
+    uint64_t m_suspensions = 0;
+    std::chrono::steady_clock::time_point m_suspend_rt;
+    std::chrono::steady_clock::time_point m_last_publish;
+
+    /* Realtime elapsed since enable(), scaled by speed, as SystemC time */
+    sc_core::sc_time rt_now()
+    {
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - startRT).count();
+        return sc_core::sc_time(ns * m_speed, sc_core::SC_NS) + startSC;
+    }
+
+    static void sleep_until(std::chrono::steady_clock::time_point t)
+    {
+#ifdef __linux__
+        /* steady_clock is CLOCK_MONOTONIC */
+        int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+        struct timespec ts;
+        ts.tv_sec = ns / 1000000000;
+        ts.tv_nsec = ns % 1000000000;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+        }
+#else
+        std::this_thread::sleep_until(t);
+#endif
+    }
+
+    void record(const sc_core::sc_time& sc, const sc_core::sc_time& rt)
+    {
+        if (sc > rt) {
+            m_max_lead = std::max(m_max_lead, (sc - rt).to_seconds());
+        } else {
+            m_max_lag = std::max(m_max_lag, (rt - sc).to_seconds());
+        }
+    }
+
+    void publish_stats()
+    {
+        m_last_publish = std::chrono::steady_clock::now();
+        p_max_lag_ms = m_max_lag * 1000;
+        p_max_lead_ms = m_max_lead * 1000;
+        p_suspended_ms = m_suspended * 1000;
+    }
+
+    void suspend()
+    {
+        SCP_TRACE(())("Suspending");
+        tick.async_attach_suspending();
+        sc_core::sc_suspend_all(); // Dont starve while we're waiting
+                                   // for realtime.
+        suspend_at = sc_core::sc_time_stamp();
+        suspended = true;
+        m_suspensions++;
+        m_suspend_rt = std::chrono::steady_clock::now();
+    }
+
+    void resume()
+    {
+        SCP_TRACE(())("Resuming");
+        if (suspended) {
+            m_suspended += std::chrono::duration<double>(std::chrono::steady_clock::now() - m_suspend_rt).count();
+        }
+        suspended = false;
+        tick.async_detach_suspending(); // We could even starve !
+        sc_core::sc_unsuspend_all();
+    }
+
     void SCticker()
     {
         if (!running) {
@@ -49,7 +145,7 @@ SC_MODULE (realtimelimiter) {
             sc_core::sc_unsuspend_all();
             return;
         }
-        if (suspended == true && (sc_core::sc_time_stamp() > suspend_at)) {
+        if (!m_precise && suspended == true && (sc_core::sc_time_stamp() > suspend_at)) {
             /* If we were suspended, and time has drifted, then account for it here. */
             sc_core::sc_time drift = sc_core::sc_time_stamp() - suspend_at;
             startSC += drift;
@@ -58,24 +154,57 @@ SC_MODULE (realtimelimiter) {
         if (p_MaxTime_ms && sc_core::sc_time_stamp() > (sc_core::sc_time(p_MaxTime_ms, sc_core::SC_MS) + startSC)) {
             SCP_FATAL(())("Max timeout expired");
         }
+        if (std::chrono::steady_clock::now() - m_last_publish > std::chrono::seconds(1)) {
+            publish_stats();
+        }
+
+        if (m_precise) {
+            precise_tick();
+            return;
+        }
 
+        record(sc_core::sc_time_stamp(), runto);
         if (sc_core::sc_time_stamp() >= runto) {
-            SCP_TRACE(())("Suspending");
-            tick.async_attach_suspending();
-            sc_core::sc_suspend_all(); // Dont starve while we're waiting
-                                       // for realtime.
-            suspend_at = sc_core::sc_time_stamp();
-            suspended = true;
+            suspend();
         } else {
-            SCP_TRACE(())("Resuming");
-            suspended = false;
+            resume();
             // lets go with +=1/2 a RTquantum
-            tick.notify((runto + sc_core::sc_time(p_RTquantum_ms, sc_core::SC_MS) / 2) - sc_core::sc_time_stamp());
-            tick.async_detach_suspending(); // We could even starve !
-            sc_core::sc_unsuspend_all();
+            tick.notify((runto + sc_core::sc_time(p_RTquantum_ms * m_speed, sc_core::SC_MS) / 2) -
+                        sc_core::sc_time_stamp());
         }
     }
 
+    /* Compare with the current realtime, rather than the one seen by the last realtime tick */
+    void precise_tick()
+    {
+        sc_core::sc_time now = sc_core::sc_time_stamp();
+        sc_core::sc_time rt = rt_now();
+
+        m_sc_seconds = now.to_seconds();
+        record(now, rt);
+        if (now > rt) {
+            /* ahead: the realtime thread will wake us up */
+            if (!suspended) {
+                m_ahead = true;
+                suspend();
+            }
+        } else {
+            if (suspended) {
+                m_ahead = false;
+                resume();
+            }
+            /* check again when SystemC reaches where realtime will be at the next tick */
+            tick.notify((rt - now) + sc_core::sc_time(m_quantum_ms * m_speed, sc_core::SC_MS));
+        }
+    }
+
+    /* Don't pace the run to the checkpoint time when restoring */
+    void enable_when_resumed()
+    {
+        ckpt::registry::get().wait_resumed();
+        enable();
+    }
+
     void RTticker()
     {
         sc_core::sc_time last = sc_core::SC_ZERO_TIME;
@@ -83,8 +212,9 @@ SC_MODULE (realtimelimiter) {
             std::this_thread::sleep_for(std::chrono::milliseconds(p_RTquantum_ms));
 
             runto = sc_core::sc_time(std::chrono::duration_cast<std::chrono::microseconds>(
-                                         std::chrono::high_resolution_clock::now() - startRT)
-                                         .count(),
+                                         std::chrono::steady_clock::now() - startRT)
+                                             .count() *
+                                         m_speed,
                                      sc_core::SC_US) +
                     startSC;
             if (last > sc_core::SC_ZERO_TIME && sc_core::sc_time_stamp() == last) {
@@ -107,20 +237,67 @@ SC_MODULE (realtimelimiter) {
         }
     }
 
+    /* Tick on an absolute grid, so that sleep overruns don't accumulate */
+    void RTticker_precise()
+    {
+        auto quantum = std::chrono::nanoseconds(static_cast<int64_t>(m_quantum_ms * 1e6));
+        auto deadline = startRT;
+        double timeout = p_SCTimeout_ms / 1000;
+
+        while (running) {
+            deadline += quantum;
+            auto now = std::chrono::steady_clock::now();
+            if (deadline < now) {
+                /* we were late, skip the ticks we missed */
+                deadline += ((now - deadline) / quantum + 1) * quantum;
+            }
+            sleep_until(deadline);
+
+            if (m_ahead) {
+                tick.notify();
+                continue;
+            }
+
+            /* SystemC is not waiting for us, check it is not too far behind */
+            double rt = std::chrono::duration<double>(std::chrono::steady_clock::now() - startRT).count() * m_speed +
+                        startSC.to_seconds();
+            if (timeout && rt - m_sc_seconds > timeout) {
+                SCP_FATAL(())
+                ("SystemC is {}s behind realtime (SCTimeout_ms set to {}s)", rt - m_sc_seconds, timeout);
+            }
+        }
+    }
+
 public:
     /* NB all these functions should be called from the SystemC thread of course*/
     void enable()
     {
         assert(running == false);
 
+        m_precise = p_precise;
+        m_speed = p_speed;
+        m_quantum_ms = p_RTquantum_ms;
+        if (m_speed <= 0) {
+            SCP_FATAL(())("speed must be positive (got {})", m_speed);
+        }
+        if (m_quantum_ms <= 0) {
+            SCP_FATAL(())("RTquantum_ms must be positive (got {})", m_quantum_ms);
+        }
+
         running = true;
 
-        startRT = std::chrono::high_resolution_clock::now();
+        startRT = std::chrono::steady_clock::now();
+        m_last_publish = startRT;
         startSC = sc_core::sc_time_stamp();
-        runto = sc_core::sc_time(p_RTquantum_ms, sc_core::SC_MS) + sc_core::sc_time_stamp();
-        tick.notify(sc_core::sc_time(p_RTquantum_ms, sc_core::SC_MS));
+        m_sc_seconds = startSC.to_seconds();
+        runto = sc_core::sc_time(p_RTquantum_ms * m_speed, sc_core::SC_MS) + sc_core::sc_time_stamp();
+        tick.notify(sc_core::sc_time(p_RTquantum_ms * m_speed, sc_core::SC_MS));
 
-        m_tick_thread = std::thread(&realtimelimiter::RTticker, this);
+        if (m_precise) {
+            m_tick_thread = std::thread(&realtimelimiter::RTticker_precise, this);
+        } else {
+            m_tick_thread = std::thread(&realtimelimiter::RTticker, this);
+        }
     }
 
     void disable()
@@ -128,14 +305,24 @@ public:
         if (running) {
             running = false;
             m_tick_thread.join();
+            publish_stats();
+            SCP_INFO(())
+            ("Realtime pacing at {}x: max lag {}ms, max lead {}ms, suspended {} times for {}ms", m_speed,
+             m_max_lag * 1000, m_max_lead * 1000, m_suspensions, m_suspended * 1000);
         }
     }
     realtimelimiter(const sc_core::sc_module_name& name): realtimelimiter(name, true) {}
     realtimelimiter(const sc_core::sc_module_name& name, bool autostart)
         : sc_module(name)
+        , ckpt::checkpointable(sc_module::name())
         , p_RTquantum_ms("RTquantum_ms", 100, "Real time quantum in milliseconds")
         , p_SCTimeout_ms("SCTimeout_ms", 0, "Timeout for SystemC in milliseconds")
         , p_MaxTime_ms("MaxTime_ms", 0, "Maximum run time in ms (0=no limit)")
+        , p_speed("speed", 1.0, "SystemC time per realtime (e.g. 0.5 or 10)")
+        , p_precise("precise", false, "Absolute deadline pacing, allows sub-ms quanta")
+        , p_max_lag_ms("max_lag_ms", 0, "Maximum time SystemC was behind realtime (read only)")
+        , p_max_lead_ms("max_lead_ms", 0, "Maximum time SystemC was ahead of realtime (read only)")
+        , p_suspended_ms("suspended_ms", 0, "Realtime SystemC spent suspended waiting for realtime (read only)")
         , tick(false) // handle attach manually
     {
         SCP_TRACE(())("realtimelimiter constructor");
@@ -144,11 +331,28 @@ public:
         dont_initialize();
         sensitive << tick;
         if (autostart) {
-            SC_THREAD(enable);
+            SC_THREAD(enable_when_resumed);
         }
     }
 
     void end_of_simulation() { disable(); }
+
+    void checkpoint_save(ckpt::state& s) override
+    {
+        s.put(m_max_lag);
+        s.put(m_max_lead);
+        s.put(m_suspended);
+        s.put(m_suspensions);
+    }
+
+    void checkpoint_restore(ckpt::state& s) override
+    {
+        s.get(m_max_lag);
+        s.get(m_max_lead);
+        s.get(m_suspended);
+        s.get(m_suspensions);
+        publish_stats();
+    }
 };
 } // namespace gs
 
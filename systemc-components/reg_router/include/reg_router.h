@@ -7,8 +7,10 @@
 #ifndef _GREENSOCS_BASE_COMPONENTS_REG_ROUTER_H
 #define _GREENSOCS_BASE_COMPONENTS_REG_ROUTER_H
 
+#include <algorithm>
 #include <cinttypes>
 #include <iomanip>
+#include <mutex>
 #include <cci_configuration>
 #include <systemc>
 #include <tlm>
@@ -73,19 +75,20 @@ public:
 #endif
 
         bool found_cb = do_callbacks(trans, delay);
+        bool dmi_allowed = false;
         if (trans.get_response_status() >= tlm::TLM_INCOMPLETE_RESPONSE) {
             SCP_TRACEALL(()) << "call b_transport: " << txn_to_str(trans, false, found_cb);
             if (ti->use_offset) trans.set_address(addr - ti->address);
             initiator_socket[ti->index]->b_transport(trans, delay);
             if (ti->use_offset) trans.set_address(addr);
+            dmi_allowed = trans.is_dmi_allowed();
             SCP_TRACEALL(()) << "b_transport returned: " << txn_to_str(trans, false, found_cb);
         }
         if (trans.get_response_status() >= tlm::TLM_OK_RESPONSE) {
             do_callbacks(trans, delay);
         }
-        if (cb_targets.size() > 0) {
-            trans.set_dmi_allowed(false);
-        }
+        /* The register memory may be accessed through DMI, unless a callback must see the access */
+        trans.set_dmi_allowed(dmi_allowed && p_dmi && page_dmi_allowed(page_of(addr)));
     }
 
     unsigned int transport_dbg(int id, tlm::tlm_generic_payload& trans)
@@ -112,10 +115,83 @@ public:
         return ret;
     }
 
+    /*
+     * DMI is granted on the pages of the register memory where no register
+     * has callbacks, as large as the consecutive such pages allow.
+     */
     bool get_direct_mem_ptr(int id, tlm::tlm_generic_payload& trans, tlm::tlm_dmi& dmi_data)
     {
-        SCP_TRACE(()) << "[REG-MEM] call get_direct_mem_ptr (not allowed) [txn]: " << scp::scp_txn_tostring(trans);
-        return false;
+        sc_dt::uint64 addr = trans.get_address();
+        auto ti = decode_address(trans);
+
+        if (!ti || !p_dmi || !page_dmi_allowed(page_of(addr))) {
+            SCP_TRACE((DMI)) << "[REG-MEM] call get_direct_mem_ptr (not allowed) [txn]: "
+                             << scp::scp_txn_tostring(trans);
+            return false;
+        }
+
+        sc_dt::uint64 start = page_of(addr);
+        sc_dt::uint64 end = start + p_dmi_page_size - 1;
+        while (start > ti->address && page_dmi_allowed(start - p_dmi_page_size)) {
+            start -= p_dmi_page_size;
+        }
+        while (end - ti->address < ti->size - 1 && page_dmi_allowed(end + 1)) {
+            end += p_dmi_page_size;
+        }
+        start = std::max(start, ti->address);
+        end = std::min(end, ti->address + ti->size - 1);
+
+        if (ti->use_offset) trans.set_address(addr - ti->address);
+        SCP_TRACE((DMI)) << "[REG-MEM] call get_direct_mem_ptr [txn]: " << scp::scp_txn_tostring(trans);
+        bool status = initiator_socket[ti->index]->get_direct_mem_ptr(trans, dmi_data);
+        if (ti->use_offset) trans.set_address(addr);
+        if (!status) {
+            return false;
+        }
+        if (ti->use_offset) {
+            dmi_data.set_start_address(ti->address + dmi_data.get_start_address());
+            dmi_data.set_end_address(ti->address + dmi_data.get_end_address());
+        }
+
+        /* Only give the callback free part */
+        if (dmi_data.get_start_address() < start) {
+            dmi_data.set_dmi_ptr(dmi_data.get_dmi_ptr() + (start - dmi_data.get_start_address()));
+            dmi_data.set_start_address(start);
+        }
+        if (dmi_data.get_end_address() > end) {
+            dmi_data.set_end_address(end);
+        }
+        SCP_DEBUG((DMI)) << "DMI granted [0x" << std::hex << dmi_data.get_start_address() << ", 0x"
+                         << dmi_data.get_end_address() << "]";
+        return true;
+    }
+
+    /*
+     * From the targets. A callback target invalidates its DMI when a callback
+     * is added to it (see port_fnct): the pages it covers are not DMI-able
+     * anymore.
+     */
+    void invalidate_direct_mem_ptr(int id, sc_dt::uint64 start, sc_dt::uint64 end)
+    {
+        lazy_initialize();
+
+        target_info& ti = bound_targets[id];
+        if (ti.is_callback) {
+            {
+                std::lock_guard<std::mutex> lock(m_cb_dmi_mutex);
+                m_cb_dmi_allowed.erase(ti.index);
+            }
+            start = page_of(ti.address);
+            end = page_of(ti.address + ti.size - 1) + p_dmi_page_size - 1;
+        } else if (ti.use_offset) {
+            start = ti.address + start;
+            end = ti.address + end;
+        }
+
+        SCP_DEBUG((DMI)) << "Invalidating DMI [0x" << std::hex << start << ", 0x" << end << "]";
+        for (size_t i = 0; i < target_socket.size(); i++) {
+            target_socket[i]->invalidate_direct_mem_ptr(start, end);
+        }
     }
 
     std::string txn_to_str(tlm::tlm_generic_payload& trans, bool is_callback = false, bool found_callback = false)
@@ -227,6 +303,60 @@ public:
         return true;
     }
 
+    sc_dt::uint64 page_of(sc_dt::uint64 addr) const { return addr & ~(sc_dt::uint64(p_dmi_page_size) - 1); }
+
+    /*
+     * Whether a callback target has no callbacks. The targets tell it with the
+     * DMI hint of an ignored transaction (port_fnct does), it is false for the
+     * other targets.
+     */
+    bool cb_target_dmi_allowed(target_info* ti)
+    {
+        std::lock_guard<std::mutex> lock(m_cb_dmi_mutex);
+        auto it = m_cb_dmi_allowed.find(ti->index);
+        if (it != m_cb_dmi_allowed.end()) {
+            return it->second;
+        }
+
+        tlm::tlm_generic_payload probe;
+        sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
+        probe.set_command(tlm::TLM_IGNORE_COMMAND);
+        probe.set_address(ti->use_offset ? 0 : ti->address);
+        probe.set_data_ptr(nullptr);
+        probe.set_data_length(0);
+        probe.set_streaming_width(0);
+        probe.set_byte_enable_ptr(nullptr);
+        probe.set_dmi_allowed(false);
+        probe.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+        initiator_socket[ti->index]->b_transport(probe, delay);
+
+        m_cb_dmi_allowed[ti->index] = probe.is_dmi_allowed();
+        return probe.is_dmi_allowed();
+    }
+
+    /* No register with callbacks in the page */
+    bool page_dmi_allowed(sc_dt::uint64 page)
+    {
+        lazy_initialize();
+
+        sc_dt::uint64 page_end = page + p_dmi_page_size - 1;
+        auto it = cb_targets.upper_bound(page);
+        if (it != cb_targets.begin()) {
+            /* the preceding register may cross into the page */
+            it--;
+        }
+        for (; it != cb_targets.end() && it->first <= page_end; it++) {
+            target_info* ti = it->second;
+            if (ti->address + ti->size - 1 < page) {
+                continue;
+            }
+            if (!cb_target_dmi_allowed(ti)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     target_info* decode_address(tlm::tlm_generic_payload& trans)
     {
         lazy_initialize();
@@ -297,14 +427,19 @@ public:
         , target_socket("target_socket")
         , m_broker(broker)
         , lazy_init("lazy_init", false, "Initialize the reg_router lazily (eg. during simulation rather than BEOL)")
+        , p_dmi("dmi_allow", true, "Allow DMI to the pages of registers without callbacks")
+        , p_dmi_page_size("dmi_page_size", 0x1000, "Granularity of the DMI regions (power of 2)")
         , mod_addr_name_map(p_mod_addr_name_map)
     {
         SCP_DEBUG(()) << "reg_router constructed";
+        if (p_dmi_page_size == 0 || (p_dmi_page_size & (p_dmi_page_size - 1))) {
+            SCP_FATAL(()) << "dmi_page_size must be a power of 2";
+        }
 
         target_socket.register_b_transport(this, &reg_router::b_transport);
         target_socket.register_transport_dbg(this, &reg_router::transport_dbg);
         target_socket.register_get_direct_mem_ptr(this, &reg_router::get_direct_mem_ptr);
-        // memory model doesn't implement invalidate_direct_mem_ptr so no need to register it
+        initiator_socket.register_invalidate_direct_mem_ptr(this, &reg_router::invalidate_direct_mem_ptr);
         SCP_DEBUG((DMI)) << "reg_router Initializing DMI SCP reporting";
     }
 
@@ -320,10 +455,14 @@ public:
     tlm_utils::multi_passthrough_target_socket<reg_router<BUSWIDTH>, BUSWIDTH> target_socket;
     cci::cci_broker_handle m_broker;
     cci::cci_param<bool> lazy_init;
+    cci::cci_param<bool> p_dmi;
+    cci::cci_param<uint64_t> p_dmi_page_size;
 
 private:
     std::vector<target_info*> mem_targets;
     std::map<sc_dt::uint64, target_info*> cb_targets;
+    std::map<size_t, bool> m_cb_dmi_allowed; /* known callback targets without callbacks */
+    std::mutex m_cb_dmi_mutex;
     std::map<uint64_t, std::pair<uint64_t, std::string>> mod_addr_name_map;
     bool initialized = false;
 };
@@ -30,6 +30,9 @@
 #include <tlm_utils/multi_passthrough_target_socket.h>
 
 #include <tlm-extensions/pathid_extension.h>
+#include <tlm-extensions/dmi_map_extension.h>
+#include <tlm-trace/recorder.h>
+#include <perf/counters.h>
 #include <cciutils.h>
 #include <router_if.h>
 #include <module_factory_registery.h>
@@ -88,12 +91,33 @@ private:
         dinfo->initiators.insert(id);
     }
 
+    /* Performance counters of a bound target (aliases included) */
+    struct target_stats {
+        perf::counter txns;
+        perf::counter bytes;
+        perf::counter dmi_grants;
+        perf::counter dmi_invalidations;
+        perf::histogram host_ns;
+
+        target_stats(const std::string& n)
+            : txns(n + ".txns")
+            , bytes(n + ".bytes")
+            , dmi_grants(n + ".dmi_grants")
+            , dmi_invalidations(n + ".dmi_invalidations")
+            , host_ns(n + ".host_ns")
+        {
+        }
+    };
+    std::vector<std::unique_ptr<target_stats>> m_stats;
+    perf::counter m_decode_errors;
+
     void register_boundto(std::string s)
     {
         s = gs::router_if<BUSWIDTH>::nameFromSocket(s);
         target_info ti = { 0 };
         ti.name = s;
         ti.index = bound_targets.size();
+        m_stats.emplace_back(new target_stats(std::string(name()) + "[" + s + "]"));
         SCP_LOGGER_VECTOR_PUSH_BACK(D, ti.name);
         SCP_DEBUG((D[ti.index])) << "Connecting : " << ti.name;
         ti.chained = false;
@@ -208,22 +232,36 @@ private:
         if (!ti) {
             SCP_WARN(())("Attempt to access unknown register at offset 0x{:x}", addr);
             trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+            m_decode_errors.add();
+            if (m_trace) m_trace->record_txn(m_trace_source, trace::NO_ID, trans, delay, false, m_trace_data);
             return;
         }
 
         stamp_txn(id, trans);
         if (!ti->chained) SCP_TRACE((D[ti->index]), ti->name) << "calling b_transport : " << txn_tostring(ti, trans);
         if (trans.get_response_status() >= tlm::TLM_INCOMPLETE_RESPONSE) {
+            target_stats& st = *m_stats[ti->index];
+            st.txns.add();
+            st.bytes.add(trans.get_data_length());
+            perf::timer t(st.host_ns);
             if (ti->use_offset) trans.set_address(addr - ti->address);
             initiator_socket[ti->index]->b_transport(trans, delay);
             if (ti->use_offset) trans.set_address(addr);
         }
         if (!ti->chained) SCP_TRACE((D[ti->index]), ti->name) << "b_transport returned : " << txn_tostring(ti, trans);
+        if (m_trace) m_trace->record_txn(m_trace_source, ti->index, trans, delay, false, m_trace_data);
         unstamp_txn(id, trans);
     }
 
     unsigned int transport_dbg(int id, tlm::tlm_generic_payload& trans)
     {
+        DmiMapExtension* map = trans.get_extension<DmiMapExtension>();
+        if (map) {
+            export_dmi_map(*map);
+            trans.set_response_status(tlm::TLM_OK_RESPONSE);
+            return 0;
+        }
+
         sc_dt::uint64 addr = trans.get_address();
         auto ti = decode_address(trans);
         if (!ti) {
@@ -278,6 +316,7 @@ private:
                 trans.set_address(addr);
             }
             record_dmi(id, dmi_data);
+            m_stats[ti->index]->dmi_grants.add();
         }
         m_dmi_mutex.unlock();
         return status;
@@ -285,6 +324,7 @@ private:
 
     void invalidate_direct_mem_ptr(int id, sc_dt::uint64 start, sc_dt::uint64 end)
     {
+        m_stats[id]->dmi_invalidations.add();
         if (id_targets[id]->use_offset) {
             start = id_targets[id]->address + start;
             end = id_targets[id]->address + end;
@@ -329,6 +369,18 @@ private:
         }
     }
 
+    /* The windows of the static targets (and their aliases), in decode order */
+    void export_dmi_map(DmiMapExtension& map)
+    {
+        lazy_initialize();
+
+        for (auto ti : targets) {
+            if (ti->size) {
+                map.windows.emplace_back(ti->address, ti->address + ti->size - 1);
+            }
+        }
+    }
+
     target_info* decode_address(tlm::tlm_generic_payload& trans)
     {
         lazy_initialize();
@@ -425,18 +477,36 @@ private:
 
     cci::cci_broker_handle m_broker;
 
+    std::shared_ptr<trace::recorder> m_trace;
+    uint16_t m_trace_source = 0;
+    bool m_trace_data = true;
+
 public:
     cci::cci_param<bool> lazy_init;
+    cci::cci_param<std::string> p_trace_file;
+    cci::cci_param<bool> p_trace_data;
 
     explicit router(const sc_core::sc_module_name& nm, cci::cci_broker_handle broker = cci::cci_get_broker())
         : sc_core::sc_module(nm)
+        , m_decode_errors(this, "decode_errors")
         , initiator_socket("initiator_socket", [&](std::string s) -> void { register_boundto(s); })
         , target_socket("target_socket")
         , m_broker(broker)
         , lazy_init("lazy_init", false, "Initialize the router lazily (eg. during simulation rather than BEOL)")
+        , p_trace_file("trace_file", "", "Record the transactions into this binary trace file (see tlm_trace)")
+        , p_trace_data("trace_data", true, "Record the first bytes of the data in the binary trace")
     {
         SCP_DEBUG(()) << "router constructed";
 
+        if (!p_trace_file.get_value().empty()) {
+            m_trace = trace::recorder::get(p_trace_file);
+            if (!m_trace->is_open()) {
+                SCP_FATAL(()) << "Unable to open trace file " << p_trace_file.get_value();
+            }
+            m_trace_source = m_trace->add_source(name());
+            m_trace_data = p_trace_data;
+        }
+
         target_socket.register_b_transport(this, &router::b_transport);
         target_socket.register_transport_dbg(this, &router::transport_dbg);
         target_socket.register_get_direct_mem_ptr(this, &router::get_direct_mem_ptr);
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _GREENSOCS_BASE_COMPONENTS_TLM_TRACE_H
+#define _GREENSOCS_BASE_COMPONENTS_TLM_TRACE_H
+
+#include <cci_configuration>
+#include <systemc>
+#include <scp/report.h>
+
+#include <tlm_utils/simple_initiator_socket.h>
+#include <tlm_utils/simple_target_socket.h>
+#include <cciutils.h>
+#include <module_factory_registery.h>
+#include <tlm_sockets_buswidth.h>
+#include <tlm-trace/recorder.h>
+
+namespace gs {
+
+/**
+ * @class tlm_trace
+ *
+ * @brief A pass through probe that records the transactions going through it
+ * into a binary trace file (see tlm-trace/format.h and tlm-trace-decode).
+ *
+ * Like 'pass', the probe takes the address and size of the target bound to
+ * its initiator socket, so it can be inserted in front of any target.
+ *
+ * @param @trace_file : trace file, probes (and routers) using the same file share it
+ * @param @data : record the first bytes of the data
+ * @param @dbg : also record debug transactions
+ * @param @ring_size : number of records buffered per host thread
+ */
+template <unsigned int BUSWIDTH = DEFAULT_TLM_BUSWIDTH>
+class tlm_trace : public sc_core::sc_module
+{
+    SCP_LOGGER(());
+
+    cci::cci_broker_handle m_broker;
+
+    /* Alias from - to */
+    void alias_preset_param(std::string a, std::string b)
+    {
+        if (gs::cci_get<std::string>(m_broker, a, b)) {
+            m_broker.set_preset_cci_value(b, m_broker.get_preset_cci_value(a));
+            m_broker.lock_preset_value(a);
+            m_broker.ignore_unconsumed_preset_values(
+                [a](const std::pair<std::string, cci::cci_value>& iv) -> bool { return iv.first == a; });
+        }
+    }
+
+    template <typename MOD>
+    class initiator_socket_spying : public tlm_utils::simple_initiator_socket<MOD, BUSWIDTH>
+    {
+        using typename tlm_utils::simple_initiator_socket<MOD, BUSWIDTH>::base_target_socket_type;
+
+        const std::function<void(std::string)> register_cb;
+
+    public:
+        initiator_socket_spying(const char* name, const std::function<void(std::string)>& f)
+            : tlm_utils::simple_initiator_socket<MOD, BUSWIDTH>::simple_initiator_socket(name), register_cb(f)
+        {
+        }
+
+        void bind(base_target_socket_type& socket)
+        {
+            tlm_utils::simple_initiator_socket<MOD, BUSWIDTH>::bind(socket);
+            register_cb(socket.get_base_export().name());
+        }
+
+        // hierarchial binding
+        void bind(tlm::tlm_initiator_socket<BUSWIDTH>& socket)
+        {
+            tlm_utils::simple_initiator_socket<MOD, BUSWIDTH>::bind(socket);
+            register_cb(socket.get_base_port().name());
+        }
+    };
+
+    void register_boundto(std::string s)
+    {
+        alias_preset_param(s + ".address", std::string(name()) + ".target_socket.address");
+        alias_preset_param(s + ".size", std::string(name()) + ".target_socket.size");
+        alias_preset_param(s + ".relative_addresses", std::string(name()) + ".target_socket.relative_addresses");
+    }
+
+public:
+    cci::cci_param<std::string> p_trace_file;
+    cci::cci_param<bool> p_data;
+    cci::cci_param<bool> p_dbg;
+    cci::cci_param<uint32_t> p_ring_size;
+
+    initiator_socket_spying<tlm_trace<BUSWIDTH>> initiator_socket;
+    tlm_utils::simple_target_socket<tlm_trace<BUSWIDTH>, BUSWIDTH> target_socket;
+
+private:
+    std::shared_ptr<trace::recorder> m_recorder;
+    uint16_t m_source;
+    bool m_record_data;
+    bool m_record_dbg;
+
+    void b_transport(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay)
+    {
+        initiator_socket->b_transport(trans, delay);
+        m_recorder->record_txn(m_source, trace::NO_ID, trans, delay, false, m_record_data);
+    }
+
+    unsigned int transport_dbg(tlm::tlm_generic_payload& trans)
+    {
+        unsigned int ret = initiator_socket->transport_dbg(trans);
+        if (m_record_dbg) {
+            m_recorder->record_txn(m_source, trace::NO_ID, trans, sc_core::SC_ZERO_TIME, true, m_record_data);
+        }
+        return ret;
+    }
+
+    bool get_direct_mem_ptr(tlm::tlm_generic_payload& trans, tlm::tlm_dmi& dmi_data)
+    {
+        /* DMI accesses can't be traced */
+        return initiator_socket->get_direct_mem_ptr(trans, dmi_data);
+    }
+
+    void invalidate_direct_mem_ptr(sc_dt::uint64 start, sc_dt::uint64 end)
+    {
+        target_socket->invalidate_direct_mem_ptr(start, end);
+    }
+
+public:
+    explicit tlm_trace(const sc_core::sc_module_name& nm)
+        : sc_core::sc_module(nm)
+        , m_broker(cci::cci_get_broker())
+        , p_trace_file("trace_file", "trace.bin", "Binary trace file")
+        , p_data("data", true, "Record the first bytes of the data")
+        , p_dbg("dbg", false, "Also record debug transactions")
+        , p_ring_size("ring_size", 16384, "Number of records buffered per host thread")
+        , initiator_socket("initiator_socket", [&](std::string s) -> void { register_boundto(s); })
+        , target_socket("target_socket")
+        , m_record_data(p_data)
+        , m_record_dbg(p_dbg)
+    {
+        SCP_DEBUG(()) << "tlm_trace constructor";
+
+        m_recorder = trace::recorder::get(p_trace_file, p_ring_size);
+        if (!m_recorder->is_open()) {
+            SCP_FATAL(()) << "Unable to open trace file " << p_trace_file.get_value();
+        }
+        m_source = m_recorder->add_source(name());
+
+        target_socket.register_b_transport(this, &tlm_trace::b_transport);
+        target_socket.register_transport_dbg(this, &tlm_trace::transport_dbg);
+        target_socket.register_get_direct_mem_ptr(this, &tlm_trace::get_direct_mem_ptr);
+        initiator_socket.register_invalidate_direct_mem_ptr(this, &tlm_trace::invalidate_direct_mem_ptr);
+    }
+
+    tlm_trace() = delete;
+    tlm_trace(const tlm_trace&) = delete;
+    ~tlm_trace() {}
+
+    /* Write everything recorded so far to the trace file */
+    void flush() { m_recorder->flush(); }
+};
+
+} // namespace gs
+
+extern "C" void module_register();
+
+#endif
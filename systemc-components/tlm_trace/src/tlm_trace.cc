@@ -0,0 +1,11 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <tlm_trace.h>
+
+typedef gs::tlm_trace<> tlm_trace;
+
+void module_register() { GSC_MODULE_REGISTER_C(tlm_trace); }
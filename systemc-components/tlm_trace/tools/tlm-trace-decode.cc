@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Offline decoder for binary transaction traces (see tlm-trace/format.h).
+ *
+ * usage: tlm-trace-decode [options] <trace file>
+ */
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <tlm-trace/format.h>
+
+using namespace gs::trace;
+
+struct filter {
+    uint64_t addr_lo = 0;
+    uint64_t addr_hi = UINT64_MAX;
+    int command = -1;
+    std::string source;
+    int path = -1;
+    bool errors = false;
+    bool dbg = true;
+    double from = 0;
+    double to = -1;
+};
+
+static void usage(const char* prog)
+{
+    fprintf(stderr,
+            "usage: %s [options] <trace file>\n"
+            "  --csv               output comma separated values\n"
+            "  --sort              sort records by time (loads the whole trace in memory)\n"
+            "  --addr LO[-HI]      only addresses in [LO, HI] (hexadecimal)\n"
+            "  --cmd read|write    only this command\n"
+            "  --source NAME       only recording points whose name contains NAME\n"
+            "  --path ID           only transactions whose initiator path starts with ID\n"
+            "  --errors            only transactions which did not return TLM_OK_RESPONSE\n"
+            "  --no-dbg            skip debug transactions\n"
+            "  --from S, --to S    only transactions in this time window (in seconds)\n",
+            prog);
+    exit(1);
+}
+
+static const char* command_str(uint8_t cmd)
+{
+    switch (cmd) {
+    case 0:
+        return "READ";
+    case 1:
+        return "WRITE";
+    default:
+        return "IGNORE";
+    }
+}
+
+static const char* response_str(int8_t resp)
+{
+    switch (resp) {
+    case 1:
+        return "OK";
+    case 0:
+        return "INCOMPLETE";
+    case -1:
+        return "GENERIC_ERROR";
+    case -2:
+        return "ADDRESS_ERROR";
+    case -3:
+        return "COMMAND_ERROR";
+    case -4:
+        return "BURST_ERROR";
+    case -5:
+        return "BYTE_ENABLE_ERROR";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+class decoder
+{
+    FILE* m_file;
+    file_header m_header;
+    std::map<uint16_t, std::string> m_sources;
+    uint64_t m_dropped = 0;
+
+public:
+    decoder(const char* fname)
+    {
+        m_file = fopen(fname, "rb");
+        if (!m_file) {
+            fprintf(stderr, "unable to open %s\n", fname);
+            exit(1);
+        }
+        if (fread(&m_header, sizeof(m_header), 1, m_file) != 1 ||
+            memcmp(m_header.magic, TRACE_MAGIC, sizeof(m_header.magic)) || m_header.record_size != sizeof(record)) {
+            fprintf(stderr, "%s is not a transaction trace\n", fname);
+            exit(1);
+        }
+
+        /* first pass: source names and lost records */
+        record r;
+        while (fread(&r, sizeof(r), 1, m_file) == 1) {
+            if (r.kind == KIND_SOURCE) {
+                std::string& s = m_sources[r.source];
+                s.resize(r.length);
+                if (r.address + r.data_len <= r.length) {
+                    memcpy(&s[r.address], r.data, r.data_len);
+                }
+            } else if (r.kind == KIND_DROPPED) {
+                m_dropped += r.length;
+            }
+        }
+        fseek(m_file, sizeof(m_header), SEEK_SET);
+    }
+
+    ~decoder() { fclose(m_file); }
+
+    uint64_t dropped() const { return m_dropped; }
+
+    double seconds(const record& r) const { return (double)r.time * m_header.time_unit_fs * 1e-15; }
+
+    const std::string& source(uint16_t id)
+    {
+        std::string& s = m_sources[id];
+        if (s.empty()) {
+            s = "source" + std::to_string(id);
+        }
+        return s;
+    }
+
+    bool next(record& r)
+    {
+        while (fread(&r, sizeof(r), 1, m_file) == 1) {
+            if (r.kind == KIND_TXN || r.kind == KIND_DBG) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool match(const filter& f, const record& r)
+    {
+        if (r.address < f.addr_lo || r.address > f.addr_hi) return false;
+        if (f.command >= 0 && r.command != f.command) return false;
+        if (f.errors && r.response == 1) return false;
+        if (!f.dbg && r.kind == KIND_DBG) return false;
+        if (f.path >= 0 && r.path[0] != f.path) return false;
+        double t = seconds(r);
+        if (t < f.from || (f.to >= 0 && t > f.to)) return false;
+        if (!f.source.empty() && source(r.source).find(f.source) == std::string::npos) return false;
+        return true;
+    }
+
+    void print(const record& r, bool csv)
+    {
+        std::string path;
+        for (int i = 0; i < PATH_LEN && r.path[i] != NO_ID; i++) {
+            path += (i ? "." : "") + std::to_string(r.path[i]);
+        }
+        std::string data;
+        char hex[3];
+        for (int i = 0; i < r.data_len; i++) {
+            snprintf(hex, sizeof(hex), "%02x", r.data[i]);
+            data += hex;
+        }
+        if (r.data_len < r.length && r.data_len) {
+            data += "...";
+        }
+        double ns = seconds(r) * 1e9;
+        double delay_ns = (double)r.delay * m_header.time_unit_fs * 1e-6;
+
+        if (csv) {
+            printf("%.3f,%.3f,%s,%d,%s,%s%s,0x%" PRIx64 ",%u,%s,%s\n", ns, delay_ns, source(r.source).c_str(),
+                   r.target == NO_ID ? -1 : r.target, path.c_str(), r.kind == KIND_DBG ? "DBG_" : "",
+                   command_str(r.command), r.address, r.length, response_str(r.response), data.c_str());
+        } else {
+            printf("%14.3fns (+%.3fns) %s", ns, delay_ns, source(r.source).c_str());
+            if (r.target != NO_ID) {
+                printf("[%u]", r.target);
+            }
+            printf(" path:%s %s%s 0x%" PRIx64 " len:%u %s", path.empty() ? "-" : path.c_str(),
+                   r.kind == KIND_DBG ? "DBG_" : "", command_str(r.command), r.address, r.length,
+                   response_str(r.response));
+            if (!data.empty()) {
+                printf(" data:%s", data.c_str());
+            }
+            printf("\n");
+        }
+    }
+};
+
+int main(int argc, char* argv[])
+{
+    filter f;
+    bool csv = false;
+    bool sort = false;
+    const char* fname = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto value = [&]() -> const char* {
+            if (i + 1 >= argc) usage(argv[0]);
+            return argv[++i];
+        };
+        if (a == "--csv") {
+            csv = true;
+        } else if (a == "--sort") {
+            sort = true;
+        } else if (a == "--addr") {
+            std::string v = value();
+            size_t dash = v.find('-');
+            f.addr_lo = strtoull(v.substr(0, dash).c_str(), nullptr, 16);
+            f.addr_hi = (dash == std::string::npos) ? f.addr_lo : strtoull(v.substr(dash + 1).c_str(), nullptr, 16);
+        } else if (a == "--cmd") {
+            std::string v = value();
+            if (v == "read") {
+                f.command = 0;
+            } else if (v == "write") {
+                f.command = 1;
+            } else {
+                usage(argv[0]);
+            }
+        } else if (a == "--source") {
+            f.source = value();
+        } else if (a == "--path") {
+            f.path = atoi(value());
+        } else if (a == "--errors") {
+            f.errors = true;
+        } else if (a == "--no-dbg") {
+            f.dbg = false;
+        } else if (a == "--from") {
+            f.from = atof(value());
+        } else if (a == "--to") {
+            f.to = atof(value());
+        } else if (a[0] == '-' || fname) {
+            usage(argv[0]);
+        } else {
+            fname = argv[i];
+        }
+    }
+    if (!fname) {
+        usage(argv[0]);
+    }
+
+    decoder d(fname);
+    record r;
+
+    if (csv) {
+        printf("time_ns,delay_ns,source,target,path,command,address,length,response,data\n");
+    }
+    if (sort) {
+        std::vector<record> records;
+        while (d.next(r)) {
+            if (d.match(f, r)) records.push_back(r);
+        }
+        std::stable_sort(records.begin(), records.end(),
+                         [](const record& a, const record& b) { return a.time < b.time; });
+        for (auto& rec : records) {
+            d.print(rec, csv);
+        }
+    } else {
+        while (d.next(r)) {
+            if (d.match(f, r)) d.print(r, csv);
+        }
+    }
+
+    if (d.dropped()) {
+        fprintf(stderr, "warning: %" PRIu64 " records were lost while tracing\n", d.dropped());
+    }
+    return 0;
+}
@@ -16,6 +16,7 @@
 
 #include <ports/initiator-signal-socket.h>
 #include <async_event.h>
+#include <checkpoint/checkpoint.h>
 #include <ports/biflow-socket.h>
 #include <module_factory_registery.h>
 #include <scp/report.h>
@@ -78,7 +79,7 @@ class Pl011;
 /* for legacy */
 typedef Pl011 Uart;
 
-class Pl011 : public sc_core::sc_module
+class Pl011 : public sc_core::sc_module, public gs::ckpt::checkpointable
 {
     SCP_LOGGER();
 
@@ -95,7 +96,11 @@ public:
 
     SC_HAS_PROCESS(Pl011);
     Pl011(sc_core::sc_module_name name)
-        : irq("irq"), s(nullptr), socket("target_socket"), backend_socket("backend_socket")
+        : gs::ckpt::checkpointable(sc_module::name())
+        , irq("irq")
+        , s(nullptr)
+        , socket("target_socket")
+        , backend_socket("backend_socket")
     {
         SCP_TRACE(()) << "Pl011 constructor";
 
@@ -367,6 +372,22 @@ public:
         }
     }
 
+    /* The registers and the receive FIFO, the ID is constant */
+    void checkpoint_save(gs::ckpt::state& st) override
+    {
+        PL011State saved = *s;
+        saved.id = nullptr;
+        st.put(saved);
+    }
+
+    void checkpoint_restore(gs::ckpt::state& st) override
+    {
+        const unsigned char* id = s->id;
+        st.get(*s);
+        s->id = id;
+        pl011_update();
+    }
+
     ~Pl011() { delete s; }
 };
 
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <string>
+
+#include <systemc>
+#include <tlm>
+
+#include "checkpoint.h"
+#include "gs_memory.h"
+#include <checkpoint/checkpoint.h>
+#include <tests/initiator-tester.h>
+#include <tests/test-bench.h>
+
+/* A component counting how it is checkpointed */
+class CheckpointCounter : public gs::ckpt::checkpointable
+{
+public:
+    uint64_t value = 0;
+    int pauses = 0;
+    int continues = 0;
+
+    CheckpointCounter(const std::string& name): gs::ckpt::checkpointable(name) {}
+
+    void checkpoint_pause() override { pauses++; }
+    void checkpoint_continue() override { continues++; }
+    void checkpoint_save(gs::ckpt::state& s) override { s.put(value); }
+    void checkpoint_restore(gs::ckpt::state& s) override { s.get(value); }
+};
+
+class CheckpointTestBench : public TestBench
+{
+public:
+    static constexpr size_t MEMORY_SIZE = 64 * 1024;
+
+protected:
+    InitiatorTester m_initiator;
+    gs::gs_memory<> m_memory;
+    CheckpointCounter m_counter;
+    sc_core::sc_event m_resume_ev;
+
+public:
+    CheckpointTestBench(const sc_core::sc_module_name& n)
+        : TestBench(n)
+        , m_initiator("initiator")
+        , m_memory("memory", MEMORY_SIZE)
+        , m_counter(std::string(name()) + ".counter")
+    {
+        m_initiator.socket.bind(m_memory.socket);
+    }
+
+    virtual ~CheckpointTestBench() {}
+};
+
+/* The same bench with a checkpoint module, saving or restoring as configured */
+class CheckpointModuleTestBench : public CheckpointTestBench
+{
+protected:
+    gs::checkpoint m_checkpoint;
+
+public:
+    CheckpointModuleTestBench(const sc_core::sc_module_name& n): CheckpointTestBench(n), m_checkpoint("checkpoint") {}
+};
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Run twice: a first process saves a checkpoint (checkpoint.save_dir), and a
+ * second one restores it (checkpoint.restore_dir) in the same platform.
+ */
+
+#include <fstream>
+#include <sstream>
+
+#include <argparser.h>
+#include <libgsutils.h>
+
+#include "checkpoint-bench.h"
+
+static std::string read_file(const std::string& fname)
+{
+    std::ifstream f(fname, std::ios::binary);
+    std::stringstream data;
+    data << f.rdbuf();
+    return data.str();
+}
+
+// The memory content and the components are found as they were at the checkpoint time
+TEST_BENCH(CheckpointModuleTestBench, RoundTrip)
+{
+    const sc_core::sc_time save_time(100, sc_core::SC_NS);
+    gs::ckpt::registry& reg = gs::ckpt::registry::get();
+    uint32_t v;
+
+    if (!reg.restoring()) {
+        ASSERT_EQ(m_initiator.do_write<uint32_t>(0x10, 0x12345678), tlm::TLM_OK_RESPONSE);
+        ASSERT_EQ(m_initiator.do_write<uint32_t>(0x8010, 0xcafef00d), tlm::TLM_OK_RESPONSE);
+        m_counter.value = 42;
+
+        /* changed after the checkpoint */
+        sc_core::wait(save_time + sc_core::sc_time(50, sc_core::SC_NS));
+        ASSERT_EQ(m_counter.pauses, 1);
+        ASSERT_EQ(m_counter.continues, 1);
+        ASSERT_EQ(m_initiator.do_write<uint32_t>(0x10, 0xdeadbeef), tlm::TLM_OK_RESPONSE);
+        m_counter.value = 43;
+        return;
+    }
+
+    reg.wait_resumed();
+    ASSERT_EQ(sc_core::sc_time_stamp(), save_time);
+    ASSERT_EQ(m_counter.value, 42);
+    ASSERT_EQ(m_counter.continues, 1);
+
+    ASSERT_EQ(m_initiator.do_read<uint32_t>(0x10, v), tlm::TLM_OK_RESPONSE);
+    ASSERT_EQ(v, 0x12345678u);
+    ASSERT_EQ(m_initiator.do_read<uint32_t>(0x8010, v), tlm::TLM_OK_RESPONSE);
+    ASSERT_EQ(v, 0xcafef00du);
+    ASSERT_EQ(m_initiator.do_read<uint32_t>(0x4000, v), tlm::TLM_OK_RESPONSE);
+    ASSERT_EQ(v, 0u);
+
+    /* the restored memory writes to its copy, not to the checkpoint */
+    ASSERT_EQ(m_initiator.do_write<uint32_t>(0x10, 0), tlm::TLM_OK_RESPONSE);
+    ASSERT_EQ(m_initiator.do_read<uint32_t>(0x10, v), tlm::TLM_OK_RESPONSE);
+    ASSERT_EQ(v, 0u);
+    std::string image = read_file(reg.restore_file(m_memory.name(), ".mem"));
+    ASSERT_EQ(image.size(), size_t(MEMORY_SIZE));
+    memcpy(&v, &image[0x10], sizeof(v));
+    ASSERT_EQ(v, 0x12345678u);
+}
+
+int sc_main(int argc, char* argv[])
+{
+    gs::ConfigurableBroker m_broker{};
+    cci::cci_originator orig{ "sc_main" };
+    auto broker_h = m_broker.create_broker_handle(orig);
+    ArgParser ap{ broker_h, argc, argv };
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <fstream>
+#include <sstream>
+
+#include <sys/mman.h>
+
+#include "checkpoint-bench.h"
+#include <cci/utils/broker.h>
+
+static std::string read_file(const std::string& fname)
+{
+    std::ifstream f(fname, std::ios::binary);
+    std::stringstream data;
+    data << f.rdbuf();
+    return data.str();
+}
+
+// The values are read back in the order they were written
+TEST(Checkpoint, State)
+{
+    gs::ckpt::state out("top.dev", "ckpt");
+    out.put<uint32_t>(0x12345678);
+    out.put(std::string("hello"));
+    out.put<double>(1.5);
+    out.put_bytes("abc", 3);
+    ASSERT_EQ(out.file(".mem"), "ckpt/top.dev.mem");
+
+    gs::ckpt::state in("top.dev", "ckpt", out.data());
+    uint32_t u;
+    std::string s;
+    double d;
+    char b[3];
+    in.get(u);
+    in.get(s);
+    in.get(d);
+    in.get_bytes(b, 3);
+    ASSERT_EQ(u, 0x12345678);
+    ASSERT_EQ(s, "hello");
+    ASSERT_EQ(d, 1.5);
+    ASSERT_EQ(std::string(b, 3), "abc");
+}
+
+// The components and the memory content are saved, and restored in another registry
+TEST_BENCH(CheckpointTestBench, SaveRestore)
+{
+    const std::string dir = "checkpoint-tests.ckpt";
+
+    ASSERT_EQ(m_initiator.do_write<uint32_t>(0x10, 0x12345678), tlm::TLM_OK_RESPONSE);
+    ASSERT_EQ(m_initiator.do_write<uint32_t>(0x8010, 0xcafef00d), tlm::TLM_OK_RESPONSE);
+    m_counter.value = 42;
+    sc_core::wait(10, sc_core::SC_NS);
+
+    gs::ckpt::registry::get().save_all(dir, true);
+    ASSERT_EQ(m_counter.pauses, 1);
+    ASSERT_EQ(m_counter.continues, 1);
+
+    /* a sparse image of the whole memory */
+    std::string image = read_file(dir + "/" + m_memory.name() + ".mem");
+    ASSERT_EQ(image.size(), size_t(MEMORY_SIZE));
+    uint32_t v;
+    memcpy(&v, &image[0x10], sizeof(v));
+    ASSERT_EQ(v, 0x12345678);
+    memcpy(&v, &image[0x8010], sizeof(v));
+    ASSERT_EQ(v, 0xcafef00d);
+    ASSERT_EQ(image[0x4000], 0);
+
+    /* restore in a platform of its own */
+    gs::ckpt::registry restored;
+    CheckpointCounter counter(m_counter.checkpoint_name() + ".copy");
+    restored.add(m_counter.checkpoint_name(), &counter);
+    restored.open(dir, m_resume_ev);
+    ASSERT_TRUE(restored.restoring());
+    ASSERT_EQ(restored.restore_time(), sc_core::sc_time(10, sc_core::SC_NS));
+    ASSERT_FALSE(restored.resumed());
+    restored.restore_all();
+    ASSERT_TRUE(restored.resumed());
+    ASSERT_EQ(counter.value, 42);
+    ASSERT_EQ(counter.continues, 1);
+
+    /* the restored memories map their image copy-on-write */
+    std::string fname = restored.restore_file(m_memory.name(), ".mem");
+    uint8_t* p = gs::MemoryServices::get().map_file(fname.c_str(), MEMORY_SIZE, 0, true);
+    ASSERT_NE(p, nullptr);
+    memcpy(&v, p + 0x8010, sizeof(v));
+    ASSERT_EQ(v, 0xcafef00d);
+    p[0x10] = 0;
+    ASSERT_EQ(read_file(fname)[0x10], 0x78);
+    munmap(p, MEMORY_SIZE);
+}
+
+int sc_main(int argc, char* argv[])
+{
+    cci_utils::consuming_broker broker("global_broker");
+    cci_register_broker(broker);
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
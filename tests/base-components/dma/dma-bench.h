@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <cstring>
+#include <vector>
+
+#include <systemc>
+#include <tlm>
+#include <tlm_utils/simple_initiator_socket.h>
+#include <tlm_utils/simple_target_socket.h>
+
+#include "macs/dma.h"
+#include <tests/test-bench.h>
+
+/*
+ * Memory at [0, LOW_SIZE) and at the top LOW_SIZE bytes of the address
+ * space. DMI is granted on the regions given by dmi_regions() only, the rest
+ * (the holes) is accessed through b_transport.
+ */
+class DmaTarget : public sc_core::sc_module
+{
+public:
+    static constexpr uint64_t LOW_SIZE = 0x4000;
+    static constexpr uint64_t TOP_START = ~uint64_t(0) - (LOW_SIZE - 1);
+
+    struct region {
+        uint64_t start;
+        uint64_t end;
+    };
+
+    /* [0x2000, 0x2fff] is a hole */
+    static std::vector<region> dmi_regions()
+    {
+        return { { 0x0000, 0x0fff }, { 0x1000, 0x1fff }, { 0x3000, 0x3fff }, { TOP_START, ~uint64_t(0) } };
+    }
+
+    tlm_utils::simple_target_socket<DmaTarget, DEFAULT_TLM_BUSWIDTH> socket;
+
+    int dmi_requests = 0;
+    int transports = 0;
+
+    DmaTarget(const sc_core::sc_module_name& n): sc_core::sc_module(n), socket("socket"), m_low(LOW_SIZE), m_top(LOW_SIZE)
+    {
+        socket.register_b_transport(this, &DmaTarget::b_transport);
+        socket.register_get_direct_mem_ptr(this, &DmaTarget::get_direct_mem_ptr);
+        for (uint64_t i = 0; i < LOW_SIZE; i++) {
+            m_low[i] = pattern(i);
+            m_top[i] = pattern(TOP_START + i);
+        }
+    }
+
+    /* The initial content of the memory */
+    static uint8_t pattern(uint64_t addr) { return (addr * 7) ^ (addr >> 8); }
+
+    uint8_t* ptr(uint64_t addr) { return (addr >= TOP_START) ? &m_top[addr - TOP_START] : &m_low[addr]; }
+
+    void invalidate(uint64_t start, uint64_t end) { socket->invalidate_direct_mem_ptr(start, end); }
+
+private:
+    std::vector<uint8_t> m_low;
+    std::vector<uint8_t> m_top;
+
+    bool mapped(uint64_t addr, uint64_t len)
+    {
+        uint64_t last = addr + (len - 1);
+        return last >= addr && ((last < LOW_SIZE) || (addr >= TOP_START));
+    }
+
+    void b_transport(tlm::tlm_generic_payload& txn, sc_core::sc_time& delay)
+    {
+        uint64_t addr = txn.get_address();
+        uint32_t len = txn.get_data_length();
+
+        transports++;
+        if (!len || !mapped(addr, len)) {
+            txn.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+            return;
+        }
+        if (txn.is_write()) {
+            memcpy(ptr(addr), txn.get_data_ptr(), len);
+        } else {
+            memcpy(txn.get_data_ptr(), ptr(addr), len);
+        }
+        txn.set_response_status(tlm::TLM_OK_RESPONSE);
+    }
+
+    bool get_direct_mem_ptr(tlm::tlm_generic_payload& txn, tlm::tlm_dmi& dmi)
+    {
+        uint64_t addr = txn.get_address();
+
+        dmi_requests++;
+        for (const region& r : dmi_regions()) {
+            if (addr >= r.start && addr <= r.end) {
+                dmi.set_start_address(r.start);
+                dmi.set_end_address(r.end);
+                dmi.set_dmi_ptr(ptr(r.start));
+                dmi.allow_read_write();
+                txn.set_dmi_allowed(true);
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+class DmaTestBench : public TestBench
+{
+protected:
+    dma m_dma;
+    DmaTarget m_target;
+
+    /* Check that [addr, addr + len) holds data */
+    void check_mem(uint64_t addr, const uint8_t* data, uint32_t len)
+    {
+        for (uint32_t i = 0; i < len; i++) {
+            ASSERT_EQ(*m_target.ptr(addr + i), data[i]) << "at 0x" << std::hex << addr + i;
+        }
+    }
+
+    /* Check that data holds the initial content of [addr, addr + len) */
+    void check_pattern(uint64_t addr, const uint8_t* data, uint32_t len)
+    {
+        for (uint32_t i = 0; i < len; i++) {
+            ASSERT_EQ(data[i], DmaTarget::pattern(addr + i)) << "at 0x" << std::hex << addr + i;
+        }
+    }
+
+public:
+    DmaTestBench(const sc_core::sc_module_name& n): TestBench(n), m_dma("dma"), m_target("target")
+    {
+        m_dma.socket.bind(m_target.socket);
+    }
+
+    virtual ~DmaTestBench() {}
+};
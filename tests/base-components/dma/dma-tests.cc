@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "dma-bench.h"
+#include <cci/utils/broker.h>
+
+// DMI regions are requested once, then served from the cache
+TEST_BENCH(DmaTestBench, CacheHitMiss)
+{
+    uint8_t buf[16];
+
+    m_dma.bus_read(0x100, buf, sizeof(buf));
+    check_pattern(0x100, buf, sizeof(buf));
+    ASSERT_EQ(m_target.dmi_requests, 1);
+
+    /* same region */
+    m_dma.bus_read(0x800, buf, sizeof(buf));
+    check_pattern(0x800, buf, sizeof(buf));
+    ASSERT_EQ(m_target.dmi_requests, 1);
+
+    /* other region */
+    m_dma.bus_read(0x3100, buf, sizeof(buf));
+    check_pattern(0x3100, buf, sizeof(buf));
+    ASSERT_EQ(m_target.dmi_requests, 2);
+
+    /* both are cached */
+    m_dma.bus_read(0x200, buf, sizeof(buf));
+    m_dma.bus_read(0x3200, buf, sizeof(buf));
+    check_pattern(0x3200, buf, sizeof(buf));
+    ASSERT_EQ(m_target.dmi_requests, 2);
+
+    for (int i = 0; i < 16; i++) {
+        buf[i] = 0xa0 + i;
+    }
+    m_dma.bus_write(0x180, buf, sizeof(buf));
+    check_mem(0x180, buf, sizeof(buf));
+    ASSERT_EQ(m_target.dmi_requests, 2);
+    ASSERT_EQ(m_target.transports, 0);
+}
+
+// Invalidating a region drops it from the cache, and only it
+TEST_BENCH(DmaTestBench, Invalidate)
+{
+    uint8_t buf[16];
+
+    m_dma.bus_read(0x100, buf, sizeof(buf));
+    m_dma.bus_read(0x3100, buf, sizeof(buf));
+    ASSERT_EQ(m_target.dmi_requests, 2);
+
+    m_target.invalidate(0x0, 0xfff);
+    m_dma.bus_read(0x3100, buf, sizeof(buf));
+    ASSERT_EQ(m_target.dmi_requests, 2);
+    m_dma.bus_read(0x100, buf, sizeof(buf));
+    check_pattern(0x100, buf, sizeof(buf));
+    ASSERT_EQ(m_target.dmi_requests, 3);
+
+    /* a range overlapping the end of a region invalidates it */
+    m_target.invalidate(0x3ff0, 0x4fff);
+    m_dma.bus_read(0x100, buf, sizeof(buf));
+    ASSERT_EQ(m_target.dmi_requests, 3);
+    m_dma.bus_read(0x3100, buf, sizeof(buf));
+    check_pattern(0x3100, buf, sizeof(buf));
+    ASSERT_EQ(m_target.dmi_requests, 4);
+    ASSERT_EQ(m_target.transports, 0);
+}
+
+// A scatter-gather list crossing a region boundary and a hole without DMI
+TEST_BENCH(DmaTestBench, ScatterGather)
+{
+    const dma::sg_list sg = {
+        { 0x0ff0, 0x20 }, /* across the first two regions */
+        { 0x1ff8, 0x10 }, /* from a region into the hole */
+        { 0x2800, 0x8 },  /* in the hole */
+        { 0x3000, 0x8 },
+    };
+    uint8_t buf[0x40];
+
+    ASSERT_EQ(dma::sg_size(sg), sizeof(buf));
+    ASSERT_EQ(m_dma.read_sg(sg, buf), sizeof(buf));
+    check_pattern(0x0ff0, buf, 0x20);
+    check_pattern(0x1ff8, buf + 0x20, 0x10);
+    check_pattern(0x2800, buf + 0x30, 0x8);
+    check_pattern(0x3000, buf + 0x38, 0x8);
+    ASSERT_EQ(m_target.transports, 2);
+
+    /* the data ends in the hole, within the second buffer */
+    for (int i = 0; i < 0x2c; i++) {
+        buf[i] = 0xa0 + i;
+    }
+    ASSERT_EQ(m_dma.write_sg(sg, buf, 0x2c), 0x2cu);
+    check_mem(0x0ff0, buf, 0x20);
+    check_mem(0x1ff8, buf + 0x20, 0xc);
+    ASSERT_EQ(*m_target.ptr(0x2004), DmaTarget::pattern(0x2004));
+    ASSERT_EQ(*m_target.ptr(0x2800), DmaTarget::pattern(0x2800));
+    ASSERT_EQ(m_target.transports, 3);
+}
+
+// A region ending at the top of the address space
+TEST_BENCH(DmaTestBench, TopOfAddressSpace)
+{
+    const uint64_t addr = ~uint64_t(0) - 15;
+    uint8_t buf[16];
+
+    m_dma.bus_read(addr, buf, sizeof(buf));
+    check_pattern(addr, buf, sizeof(buf));
+
+    for (int i = 0; i < 16; i++) {
+        buf[i] = 0xa0 + i;
+    }
+    m_dma.bus_write(addr, buf, sizeof(buf));
+    check_mem(addr, buf, sizeof(buf));
+
+    ASSERT_EQ(m_dma.read_sg({ { addr + 8, 8 } }, buf), 8u);
+    check_mem(addr + 8, buf, 8);
+    ASSERT_EQ(m_target.dmi_requests, 1);
+    ASSERT_EQ(m_target.transports, 0);
+}
+
+int sc_main(int argc, char* argv[])
+{
+    cci_utils::consuming_broker broker("global_broker");
+    cci_register_broker(broker);
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
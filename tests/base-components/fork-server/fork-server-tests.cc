@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <string>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+#include <cci/utils/broker.h>
+#include <fork_server.h>
+
+static int connect_to(const std::string& path)
+{
+    struct sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    path.copy(addr.sun_path, path.size());
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static std::string read_line(int fd)
+{
+    std::string line;
+    char c;
+    while (read(fd, &c, 1) == 1 && c != '\n') {
+        line += c;
+    }
+    return line;
+}
+
+static bool send(int fd, const std::string& req) { return write(fd, req.data(), req.size()) == (ssize_t)req.size(); }
+
+/* The client of the test, in a process of its own: returns 0 if the server answered as expected */
+static int client(const std::string& path)
+{
+    int fd = connect_to(path);
+    if (fd < 0 || !send(fd, "param test.preset=7\nparam test.existing=3\noutput /dev/null\nrun\n")) {
+        return 1;
+    }
+    if (read_line(fd).compare(0, 4, "pid ") != 0) {
+        return 2;
+    }
+    if (read_line(fd) != "exit 10") {
+        return 3;
+    }
+    close(fd);
+
+    fd = connect_to(path);
+    if (fd < 0 || !send(fd, "param test.preset={\nrun\n") || read_line(fd).compare(0, 6, "error ") != 0) {
+        return 4;
+    }
+    close(fd);
+
+    fd = connect_to(path);
+    if (fd < 0 || !send(fd, "quit\n")) {
+        return 5;
+    }
+    close(fd);
+    return 0;
+}
+
+// A run is forked per request, with the parameters of the request
+TEST(ForkServer, Runs)
+{
+    std::string path = "/tmp/fork-server-tests-" + std::to_string(getpid()) + ".sock";
+    cci::cci_originator orig("test");
+    cci::cci_broker_handle broker = cci::cci_get_global_broker(orig);
+    cci::cci_param<int> p_existing("test.existing", 1, "", cci::CCI_ABSOLUTE_NAME, orig);
+
+    gs::fork_server server(broker, path);
+
+    pid_t cpid = fork();
+    ASSERT_GE(cpid, 0);
+    if (cpid == 0) {
+        _exit(client(path));
+    }
+
+    if (server.serve()) {
+        /* the run */
+        _exit(broker.get_preset_cci_value("test.preset").get_int() + p_existing.get_value());
+    }
+
+    int status;
+    ASSERT_EQ(waitpid(cpid, &status, 0), cpid);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+}
+
+int sc_main(int argc, char* argv[])
+{
+    cci_utils::consuming_broker broker("global_broker");
+    cci_register_broker(broker);
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <cstring>
+#include <vector>
+
+#include <systemc>
+#include <scp/report.h>
+
+#include <backends/net-switch.h>
+#include <tests/test-bench.h>
+
+/* A MAC stand-in recording everything it receives */
+class TestNic
+{
+public:
+    std::vector<std::vector<uint8_t>> frames;
+    std::vector<sc_core::sc_time> stamps;
+    NetworkBackend* m_backend = nullptr;
+    uint8_t m_mac[6];
+
+    TestNic(uint8_t id)
+    {
+        const uint8_t mac[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, id };
+        memcpy(m_mac, mac, 6);
+    }
+
+    void attach(NetworkBackend* backend)
+    {
+        m_backend = backend;
+        m_backend->register_receive(this, rx_cb, can_rx_cb);
+    }
+
+    static void rx_cb(void* opaque, Payload& frame)
+    {
+        TestNic* nic = static_cast<TestNic*>(opaque);
+        nic->frames.emplace_back(frame.data(), frame.data() + frame.size());
+        nic->stamps.push_back(sc_core::sc_time_stamp());
+    }
+
+    static int can_rx_cb(void* opaque) { return 1; }
+
+    void send_to(const uint8_t* dst, size_t len = 60)
+    {
+        Payload frame(len);
+        frame.resize(len);
+        memset(frame.data(), 0, len);
+        memcpy(frame.data(), dst, 6);
+        memcpy(frame.data() + 6, m_mac, 6);
+        m_backend->send(frame);
+    }
+
+    void send_to(const TestNic& other, size_t len = 60) { send_to(other.m_mac, len); }
+};
+
+class NetSwitchTestBench : public TestBench
+{
+public:
+    static constexpr uint32_t NUM_PORTS = 3;
+    const uint8_t bcast[6] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+
+protected:
+    NetworkSwitch m_switch;
+    std::vector<TestNic> m_nics;
+
+public:
+    NetSwitchTestBench(const sc_core::sc_module_name& n): TestBench(n), m_switch("switch", NUM_PORTS)
+    {
+        for (uint32_t i = 0; i < NUM_PORTS; i++) {
+            m_nics.emplace_back(i);
+        }
+        for (uint32_t i = 0; i < NUM_PORTS; i++) {
+            m_nics[i].attach(&m_switch.port(i));
+        }
+    }
+
+    void clear()
+    {
+        for (auto& n : m_nics) {
+            n.frames.clear();
+            n.stamps.clear();
+        }
+    }
+};
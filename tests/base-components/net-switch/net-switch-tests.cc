@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "net-switch-bench.h"
+#include <cci/utils/broker.h>
+
+// Unknown unicast destinations are flooded to every other port
+TEST_BENCH(NetSwitchTestBench, FloodUnknown)
+{
+    m_nics[0].send_to(m_nics[1]);
+    ASSERT_EQ(m_nics[0].frames.size(), 0);
+    ASSERT_EQ(m_nics[1].frames.size(), 1);
+    ASSERT_EQ(m_nics[2].frames.size(), 1);
+}
+
+// Once a source has been seen, frames to it only go to its port
+TEST_BENCH(NetSwitchTestBench, Learning)
+{
+    m_nics[1].send_to(bcast);
+    ASSERT_EQ(m_nics[0].frames.size(), 1);
+    ASSERT_EQ(m_nics[2].frames.size(), 1);
+    clear();
+
+    m_nics[0].send_to(m_nics[1]);
+    ASSERT_EQ(m_nics[1].frames.size(), 1);
+    ASSERT_EQ(m_nics[2].frames.size(), 0);
+    ASSERT_EQ(memcmp(m_nics[1].frames[0].data(), m_nics[1].m_mac, 6), 0);
+    ASSERT_EQ(memcmp(m_nics[1].frames[0].data() + 6, m_nics[0].m_mac, 6), 0);
+}
+
+// Runt frames are dropped
+TEST_BENCH(NetSwitchTestBench, Runt)
+{
+    m_nics[0].send_to(bcast, 12);
+    ASSERT_EQ(m_nics[1].frames.size(), 0);
+    ASSERT_EQ(m_switch.port(0).dropped_frames, 1);
+}
+
+// With a link rate and a latency, frames arrive later and back to back
+TEST_BENCH(NetSwitchTestBench, Timing)
+{
+    m_nics[1].send_to(bcast);
+    m_nics[2].send_to(bcast);
+    clear();
+
+    m_switch.p_link_rate_mbps = 1000;
+    m_switch.p_latency_ns = 500;
+
+    /* (1000 + 24) bytes at 1Gbit/s is 8192ns on the wire */
+    m_nics[0].send_to(m_nics[1], 1000);
+    m_nics[0].send_to(m_nics[1], 1000);
+    ASSERT_EQ(m_nics[1].frames.size(), 0);
+
+    sc_core::wait(sc_core::sc_time(20, sc_core::SC_US));
+    ASSERT_EQ(m_nics[1].frames.size(), 2);
+    ASSERT_EQ(m_nics[2].frames.size(), 0);
+    ASSERT_EQ(m_nics[1].stamps[0], sc_core::sc_time(8192 + 500, sc_core::SC_NS));
+    ASSERT_EQ(m_nics[1].stamps[1], sc_core::sc_time(2 * 8192 + 500, sc_core::SC_NS));
+}
+
+int sc_main(int argc, char* argv[])
+{
+    cci_utils::consuming_broker broker("global_broker");
+    cci_register_broker(broker);
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
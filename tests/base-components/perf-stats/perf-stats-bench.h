@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <string>
+
+#include <systemc>
+#include <tlm>
+
+#include "gs_memory.h"
+#include "perf_stats.h"
+#include "router.h"
+#include <tests/initiator-tester.h>
+#include <tests/test-bench.h>
+
+class PerfStatsTestBench : public TestBench
+{
+public:
+    static constexpr size_t MEMORY_SIZE = 256;
+
+protected:
+    gs::perf_stats m_stats;
+    InitiatorTester m_initiator;
+    gs::router<> m_router;
+    gs::gs_memory<> m_memory;
+
+    uint64_t counter(const std::string& name)
+    {
+        auto c = dynamic_cast<gs::perf::counter*>(gs::perf::registry::get().find(name));
+        EXPECT_NE(c, nullptr) << name;
+        return c ? c->value() : 0;
+    }
+
+    gs::perf::histogram* histogram(const std::string& name)
+    {
+        auto h = dynamic_cast<gs::perf::histogram*>(gs::perf::registry::get().find(name));
+        EXPECT_NE(h, nullptr) << name;
+        return h;
+    }
+
+    /* Name of the stats of the memory, as seen by the router */
+    std::string target(const std::string& stat)
+    {
+        return std::string(m_router.name()) + "[" + m_memory.socket.name() + "]." + stat;
+    }
+
+    std::string memory(const std::string& stat) { return std::string(m_memory.name()) + "." + stat; }
+
+public:
+    PerfStatsTestBench(const sc_core::sc_module_name& n)
+        : TestBench(n), m_stats("perf_stats"), m_initiator("initiator"), m_router("router"), m_memory("memory")
+    {
+        m_router.add_initiator(m_initiator.socket);
+        m_router.add_target(m_memory.socket, 0, MEMORY_SIZE);
+    }
+
+    virtual ~PerfStatsTestBench() {}
+};
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <fstream>
+#include <sstream>
+
+#include "perf-stats-bench.h"
+#include <cci/utils/broker.h>
+
+// The router and the memory count the transactions, bytes and DMI grants
+TEST_BENCH(PerfStatsTestBench, Counts)
+{
+    uint32_t data;
+
+    ASSERT_EQ(m_initiator.do_write<uint32_t>(0x10, 0x12345678), tlm::TLM_OK_RESPONSE);
+    ASSERT_EQ(m_initiator.do_read(0x10, data), tlm::TLM_OK_RESPONSE);
+    ASSERT_EQ(m_initiator.do_read(0x20, data), tlm::TLM_OK_RESPONSE);
+    ASSERT_EQ(m_initiator.do_write<uint8_t>(MEMORY_SIZE, 0x04), tlm::TLM_ADDRESS_ERROR_RESPONSE);
+    ASSERT_TRUE(m_initiator.do_dmi_request(0x10));
+
+    ASSERT_EQ(counter(target("txns")), 3);
+    ASSERT_EQ(counter(target("bytes")), 12);
+    ASSERT_EQ(counter(target("dmi_grants")), 1);
+    ASSERT_EQ(counter(std::string(m_router.name()) + ".decode_errors"), 1);
+    ASSERT_EQ(histogram(target("host_ns"))->count(), 3);
+
+    ASSERT_EQ(counter(memory("writes")), 1);
+    ASSERT_EQ(counter(memory("reads")), 2);
+    ASSERT_EQ(counter(memory("bytes_read")), 8);
+    ASSERT_EQ(counter(memory("bytes_written")), 4);
+    ASSERT_EQ(counter(memory("dmi_grants")), 1);
+
+    /* the dump holds every stat */
+    m_stats.dump();
+    std::ifstream f(m_stats.p_file.get_value());
+    std::stringstream json;
+    json << f.rdbuf();
+    ASSERT_NE(json.str().find("\"" + memory("writes") + "\": 1"), std::string::npos);
+    ASSERT_NE(json.str().find("\"" + target("host_ns") + "\": {\"count\": 3"), std::string::npos);
+}
+
+// Nothing is recorded while disabled
+TEST_BENCH(PerfStatsTestBench, Disabled)
+{
+    uint32_t data;
+
+    gs::perf::registry::get().clear();
+    gs::perf::enable(false);
+    ASSERT_EQ(m_initiator.do_read(0x10, data), tlm::TLM_OK_RESPONSE);
+    ASSERT_EQ(counter(target("txns")), 0);
+    ASSERT_EQ(counter(memory("reads")), 0);
+    gs::perf::enable(true);
+}
+
+// Histogram buckets are powers of 2
+TEST(PerfStats, Histogram)
+{
+    gs::perf::enable(true);
+    gs::perf::histogram h("test.hist");
+
+    h.record(0);
+    h.record(1);
+    h.record(5);
+    h.record(7);
+    h.record(1024);
+
+    ASSERT_EQ(h.count(), 5);
+    ASSERT_EQ(h.sum(), 1037);
+    ASSERT_EQ(h.max(), 1024);
+    ASSERT_EQ(h.bucket_count(0), 1);
+    ASSERT_EQ(h.bucket_count(1), 1);
+    ASSERT_EQ(h.bucket_count(3), 2);
+    ASSERT_EQ(h.bucket_count(11), 1);
+
+    std::stringstream json;
+    h.to_json(json);
+    ASSERT_EQ(json.str(), "{\"count\": 5, \"sum\": 1037, \"max\": 1024, \"buckets\": [[1, 1], [2, 1], [8, 2], [2048, 1]]}");
+}
+
+// Probes read a count kept elsewhere, cleared by keeping a base
+TEST(PerfStats, Probe)
+{
+    uint64_t v = 10;
+    gs::perf::enable(false);
+    gs::perf::probe p(nullptr, "test.probe", [&v]() { return v; });
+
+    ASSERT_EQ(p.value(), 10);
+    v = 15;
+    ASSERT_EQ(p.value(), 15);
+
+    p.clear();
+    ASSERT_EQ(p.value(), 0);
+    v = 18;
+
+    std::stringstream json;
+    p.to_json(json);
+    ASSERT_EQ(json.str(), "3");
+    gs::perf::enable(true);
+}
+
+int sc_main(int argc, char* argv[])
+{
+    cci_utils::consuming_broker broker("global_broker");
+    cci_register_broker(broker);
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
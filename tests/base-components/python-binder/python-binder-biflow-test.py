@@ -0,0 +1,37 @@
+# Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+# SPDX-License-Identifier: BSD-3-Clause
+
+from tlm_generic_payload import tlm_generic_payload
+from sc_core import sc_time, sc_spawn, sc_spawn_options
+import biflow_socket
+import numpy as np
+from typing import List
+
+received: List[int] = []
+
+
+def sender():
+    biflow_socket.can_receive_any()
+    # every kind of data accepted by enqueue, sent as 0x01...0x0c
+    biflow_socket.enqueue(b"\x01\x02\x03")
+    biflow_socket.enqueue(bytearray([0x04, 0x05]))
+    biflow_socket.enqueue(np.array([0x06, 0x07, 0x08], dtype=np.uint8))
+    biflow_socket.enqueue(0x09)
+    biflow_socket.enqueue([0x0A, 0x0B])
+    biflow_socket.enqueue(memoryview(b"\x0c"))
+    biflow_socket.enqueue(b"")
+
+
+def end_of_elaboration() -> None:
+    sc_spawn(sender, "sender", sc_spawn_options())
+
+
+def bf_b_transport(trans: tlm_generic_payload, delay: sc_time) -> None:
+    # echo what is received, as one bulk enqueue
+    data = trans.get_data()
+    received.extend(data.tolist())
+    biflow_socket.enqueue(data.tobytes())
+
+
+def end_of_simulation() -> None:
+    assert received == list(range(0x10, 0x30))
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "python-binder-bench.h"
+#include <ports/biflow-socket.h>
+#include <cci/utils/broker.h>
+
+class PythonBinderBiflowTestBench : public PythonBinderTestBench
+{
+public:
+    PythonBinderBiflowTestBench(const sc_core::sc_module_name& n)
+        : PythonBinderTestBench(n), m_bf_socket("test_biflow_socket")
+    {
+        m_bf_socket.register_b_transport(this, &PythonBinderBiflowTestBench::bf_b_transport);
+        m_bf_socket.bind(m_python_binder.bf_socket[0]);
+    }
+
+    void bf_b_transport(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay)
+    {
+        uint8_t* data = trans.get_data_ptr();
+        m_received.insert(m_received.end(), data, data + trans.get_data_length());
+    }
+
+protected:
+    gs::biflow_socket<PythonBinderBiflowTestBench> m_bf_socket;
+    std::vector<uint8_t> m_received;
+};
+
+TEST_BENCH(PythonBinderBiflowTestBench, test_bench)
+{
+    std::vector<uint8_t> expected;
+
+    SCP_INFO(()) << "Test biflow_socket.enqueue from python" << std::endl;
+    m_bf_socket.can_receive_any();
+    sc_core::wait(sc_core::sc_time(1, sc_core::sc_time_unit::SC_US));
+    for (int i = 0x01; i <= 0x0c; i++) {
+        expected.push_back(i);
+    }
+    ASSERT_EQ(m_received, expected);
+
+    print_dashes();
+    SCP_INFO(()) << "Test bulk echo of the python module" << std::endl;
+    m_received.clear();
+    expected.clear();
+    for (int i = 0x10; i < 0x30; i++) {
+        expected.push_back(i);
+    }
+    m_bf_socket.enqueue(expected.data(), 0x10);
+    m_bf_socket.enqueue(expected.data() + 0x10, 0x10);
+    sc_core::wait(sc_core::sc_time(1, sc_core::sc_time_unit::SC_US));
+    ASSERT_EQ(m_received, expected);
+}
+
+int sc_main(int argc, char* argv[])
+{
+    gs::ConfigurableBroker m_broker({
+        { "test_bench.mem.target_socket.address", cci::cci_value(0x1000) },
+        { "test_bench.mem.target_socket.size", cci::cci_value(0x1000) },
+
+        { "test_bench.python-binder.tlm_initiator_ports_num", cci::cci_value(1) },
+        { "test_bench.python-binder.tlm_target_ports_num", cci::cci_value(1) },
+        { "test_bench.python-binder.initiator_signals_num", cci::cci_value(1) },
+        { "test_bench.python-binder.target_signals_num", cci::cci_value(1) },
+        { "test_bench.python-binder.biflow_socket_num", cci::cci_value(1) },
+        { "test_bench.python-binder.target_socket_0.address", cci::cci_value(0x2000) },
+        { "test_bench.python-binder.target_socket_0.size", cci::cci_value(0x1000) },
+        { "test_bench.python-binder.target_socket_0.relative_addresses", cci::cci_value(false) },
+        { "test_bench.python-binder.py_module_dir", cci::cci_value(getexepath()) },
+        { "test_bench.python-binder.py_module_name", cci::cci_value("python-binder-biflow-test") },
+    });
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,31 @@
+# Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+# SPDX-License-Identifier: BSD-3-Clause
+
+from tlm_generic_payload import tlm_command, tlm_response_status, tlm_generic_payload
+from sc_core import sc_time
+import target_filter
+import numpy as np
+from typing import List
+
+calls: List[int] = []
+
+# only these accesses reach b_transport, the others get TLM_ADDRESS_ERROR_RESPONSE
+target_filter.add_range(0, 0x2000, 0x2007, read=False)
+target_filter.add_range(0, 0x2200, 0x220F, write=False)
+
+
+def b_transport(id: int, trans: tlm_generic_payload, delay: sc_time) -> None:
+    address = trans.get_address()
+    calls.append(address)
+    if address == 0x2000:
+        assert trans.get_command() == tlm_command.TLM_WRITE_COMMAND
+    elif address == 0x2200:
+        assert trans.get_command() == tlm_command.TLM_READ_COMMAND
+        trans.set_data(np.arange(trans.get_data_length(), dtype=np.uint8))
+    else:
+        raise RuntimeError(f"address: 0x{address:x} should have been filtered out")
+    trans.set_response_status(tlm_response_status.TLM_OK_RESPONSE)
+
+
+def end_of_simulation() -> None:
+    assert calls == [0x2000, 0x2200]
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "python-binder-bench.h"
+#include <cci/utils/broker.h>
+
+TEST_BENCH(PythonBinderTestBench, test_bench)
+{
+    uint8_t w_data[8] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07 };
+    uint8_t r_data[16];
+    uint8_t expected[16];
+    for (int i = 0; i < 16; i++) {
+        expected[i] = i;
+    }
+    memset(r_data, 0, sizeof(r_data));
+
+    sc_core::sc_time delay(0, sc_core::sc_time_unit::SC_NS);
+    tlm::tlm_generic_payload trans;
+
+    SCP_INFO(()) << "Test accesses within the ranges of the python module" << std::endl;
+    do_basic_trans_check(trans, delay, 0x2000, w_data, nullptr, 8, tlm::tlm_command::TLM_WRITE_COMMAND);
+    do_basic_trans_check(trans, delay, 0x2200, r_data, expected, 16, tlm::tlm_command::TLM_READ_COMMAND);
+
+    print_dashes();
+    SCP_INFO(()) << "Test accesses filtered out before reaching python" << std::endl;
+    // 0x2000 is write only for the python module
+    trans.set_address(0x2000);
+    trans.set_data_length(8);
+    trans.set_streaming_width(8);
+    trans.set_command(tlm::tlm_command::TLM_READ_COMMAND);
+    trans.set_response_status(tlm::tlm_response_status::TLM_INCOMPLETE_RESPONSE);
+    ASSERT_EQ(m_initiator.do_b_transport(trans), tlm::TLM_ADDRESS_ERROR_RESPONSE);
+    // 0x2200 is read only for the python module
+    trans.set_address(0x2200);
+    trans.set_command(tlm::tlm_command::TLM_WRITE_COMMAND);
+    trans.set_response_status(tlm::tlm_response_status::TLM_INCOMPLETE_RESPONSE);
+    ASSERT_EQ(m_initiator.do_b_transport(trans), tlm::TLM_ADDRESS_ERROR_RESPONSE);
+    // 0x2208-0x220F fits, 0x2208-0x2217 crosses the end of the range
+    trans.set_address(0x2208);
+    trans.set_data_length(16);
+    trans.set_streaming_width(16);
+    trans.set_command(tlm::tlm_command::TLM_READ_COMMAND);
+    trans.set_response_status(tlm::tlm_response_status::TLM_INCOMPLETE_RESPONSE);
+    ASSERT_EQ(m_initiator.do_b_transport(trans), tlm::TLM_ADDRESS_ERROR_RESPONSE);
+    // 0x2300 is not handled by the python module
+    trans.set_address(0x2300);
+    trans.set_data_length(8);
+    trans.set_streaming_width(8);
+    trans.set_response_status(tlm::tlm_response_status::TLM_INCOMPLETE_RESPONSE);
+    ASSERT_EQ(m_initiator.do_b_transport(trans), tlm::TLM_ADDRESS_ERROR_RESPONSE);
+}
+
+int sc_main(int argc, char* argv[])
+{
+    gs::ConfigurableBroker m_broker({
+        { "test_bench.mem.target_socket.address", cci::cci_value(0x1000) },
+        { "test_bench.mem.target_socket.size", cci::cci_value(0x1000) },
+
+        { "test_bench.python-binder.tlm_initiator_ports_num", cci::cci_value(1) },
+        { "test_bench.python-binder.tlm_target_ports_num", cci::cci_value(1) },
+        { "test_bench.python-binder.initiator_signals_num", cci::cci_value(1) },
+        { "test_bench.python-binder.target_signals_num", cci::cci_value(1) },
+        { "test_bench.python-binder.target_socket_0.address", cci::cci_value(0x2000) },
+        { "test_bench.python-binder.target_socket_0.size", cci::cci_value(0x1000) },
+        { "test_bench.python-binder.target_socket_0.relative_addresses", cci::cci_value(false) },
+        { "test_bench.python-binder.py_module_dir", cci::cci_value(getexepath()) },
+        { "test_bench.python-binder.py_module_name", cci::cci_value("python-binder-filter-test") },
+    });
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
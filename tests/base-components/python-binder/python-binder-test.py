@@ -112,9 +112,31 @@ def start_of_simulation() -> None:
     trans.set_command(tlm_command.TLM_WRITE_COMMAND)
     delay = sc_time(0, sc_time_unit.SC_NS)
     tlm_do_b_transport.do_b_transport(0, trans, delay)
+    batch_test()
     signal_writer_event.notify(sc_time(0, sc_time_unit.SC_NS))
 
 
+def batch_test() -> None:
+    log("batch_test -> testing do_b_transport_batch")
+    # write 0x1010-0x1017 with two transactions, then read it back with two others
+    data = generate_test_data3()[8:]
+    read_data = np.zeros(8, dtype=np.uint8)
+    transs = []
+    for command, buf in ((tlm_command.TLM_WRITE_COMMAND, data), (tlm_command.TLM_READ_COMMAND, read_data)):
+        for offset in (0, 4):
+            trans = tlm_generic_payload()
+            trans.set_address(0x1010 + offset)
+            trans.set_data_length(4)
+            trans.set_streaming_width(4)
+            trans.set_data_ptr(buf[offset : offset + 4])
+            trans.set_command(command)
+            transs.append(trans)
+    delay = sc_time(0, sc_time_unit.SC_NS)
+    tlm_do_b_transport.do_b_transport_batch(0, transs, delay)
+    assert all(trans.is_response_ok() for trans in transs)
+    assert (read_data == data).all()
+
+
 @sc_thread
 def signal_writer():
     dummy_event.notify(sc_time(10, sc_time_unit.SC_NS))
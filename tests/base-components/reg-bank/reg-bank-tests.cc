@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <systemc>
+#include <tlm>
+
+#include <cci/utils/broker.h>
+
+#include "test_regs.h" /* generated from test_regs.json */
+#include <tests/initiator-tester.h>
+#include <tests/test-bench.h>
+
+class RegBankTestBench : public TestBench
+{
+protected:
+    InitiatorTester m_initiator;
+    test_regs m_regs;
+
+    int m_invalidations = 0;
+
+public:
+    RegBankTestBench(const sc_core::sc_module_name& n): TestBench(n), m_initiator("initiator"), m_regs("regs")
+    {
+        m_initiator.register_invalidate_direct_mem_ptr([this](uint64_t start, uint64_t end) { m_invalidations++; });
+        m_initiator.socket.bind(m_regs.target_socket);
+    }
+};
+
+// The registers are at their reset value, and accessed through the socket or their handle
+TEST_BENCH(RegBankTestBench, Access)
+{
+    uint32_t data = 0;
+    uint16_t id = 0;
+
+    ASSERT_EQ(m_initiator.do_read(0x4, data), tlm::TLM_OK_RESPONSE);
+    ASSERT_EQ(data, 0xa5);
+    ASSERT_EQ(m_initiator.do_read(0x20, id), tlm::TLM_OK_RESPONSE);
+    ASSERT_EQ(id, 0x1234);
+    ASSERT_EQ(m_regs.CTRL, 0x1);
+
+    ASSERT_EQ(m_initiator.do_write<uint32_t>(0x0, 0xdead), tlm::TLM_OK_RESPONSE);
+    ASSERT_EQ(m_regs.CTRL, 0xdead);
+    m_regs.STATUS = 0x5a;
+    ASSERT_EQ(m_initiator.do_read(0x4, data), tlm::TLM_OK_RESPONSE);
+    ASSERT_EQ(data, 0x5a);
+
+    /* register arrays */
+    ASSERT_EQ(m_initiator.do_write<uint32_t>(0x18, 42), tlm::TLM_OK_RESPONSE);
+    ASSERT_EQ(m_regs.FIFO.get(2), 42);
+    ASSERT_EQ(m_regs.FIFO[2], 42);
+    ASSERT_EQ(m_regs.FIFO.get_size(), 16);
+
+    m_regs.reset();
+    ASSERT_EQ(m_regs.CTRL, 0x1);
+    ASSERT_EQ(m_regs.FIFO.get(2), 0);
+}
+
+// Access rights and decoding errors
+TEST_BENCH(RegBankTestBench, Errors)
+{
+    uint32_t data = 0;
+    uint64_t data64 = 0;
+
+    ASSERT_EQ(m_initiator.do_write<uint32_t>(0x4, 1), tlm::TLM_COMMAND_ERROR_RESPONSE);
+    ASSERT_EQ(m_regs.STATUS, 0xa5);
+    ASSERT_EQ(m_initiator.do_read(0x8, data), tlm::TLM_COMMAND_ERROR_RESPONSE);
+    ASSERT_EQ(m_initiator.do_write<uint32_t>(0x8, 1), tlm::TLM_OK_RESPONSE);
+
+    /* no register, across registers, out of the bank */
+    ASSERT_EQ(m_initiator.do_read(0xc, data), tlm::TLM_ADDRESS_ERROR_RESPONSE);
+    ASSERT_EQ(m_initiator.do_read(0x10, data64), tlm::TLM_ADDRESS_ERROR_RESPONSE);
+    ASSERT_EQ(m_initiator.do_read(0x20, data), tlm::TLM_ADDRESS_ERROR_RESPONSE);
+    ASSERT_EQ(m_initiator.do_read(0x100, data), tlm::TLM_ADDRESS_ERROR_RESPONSE);
+
+    /* the debug accesses go to the storage */
+    ASSERT_EQ(m_initiator.do_write<uint32_t>(0x4, 7, true), tlm::TLM_OK_RESPONSE);
+    ASSERT_EQ(m_regs.STATUS, 7);
+}
+
+// Typed field accessors
+TEST_BENCH(RegBankTestBench, Fields)
+{
+    m_regs.CTRL = 0;
+    m_regs.CTRL.MODE = 5;
+    ASSERT_EQ(m_regs.CTRL, 5 << 4);
+    m_regs.CTRL.EN = 1;
+    ASSERT_EQ(m_regs.CTRL, (5 << 4) | 1);
+    ASSERT_EQ(m_regs.CTRL.MODE, 5);
+    ASSERT_EQ(m_regs.CTRL.EN, 1);
+
+    ASSERT_EQ(m_initiator.do_write<uint32_t>(0x0, 0x30), tlm::TLM_OK_RESPONSE);
+    ASSERT_EQ(m_regs.CTRL.MODE, 3);
+    ASSERT_EQ(m_regs.CTRL.EN, 0);
+}
+
+// The callbacks have the gs_register semantics
+TEST_BENCH(RegBankTestBench, Callbacks)
+{
+    uint32_t data = 0;
+    int writes = 0;
+
+    m_regs.STATUS.pre_read([&](tlm::tlm_generic_payload& txn, sc_core::sc_time& delay) {
+        ASSERT_EQ(txn.get_address(), 0x4);
+        m_regs.STATUS = 0x77;
+    });
+    m_regs.CMD.post_write([&](tlm::tlm_generic_payload& txn, sc_core::sc_time& delay) {
+        writes++;
+        m_regs.CTRL.EN = 0;
+    });
+    m_regs.FIFO.pre_write([&](tlm::tlm_generic_payload& txn, sc_core::sc_time& delay) {
+        txn.set_response_status(tlm::TLM_GENERIC_ERROR_RESPONSE);
+    });
+
+    ASSERT_EQ(m_initiator.do_read(0x4, data), tlm::TLM_OK_RESPONSE);
+    ASSERT_EQ(data, 0x77);
+
+    ASSERT_EQ(m_initiator.do_write<uint32_t>(0x8, 1), tlm::TLM_OK_RESPONSE);
+    ASSERT_EQ(writes, 1);
+    ASSERT_EQ(m_regs.CTRL.EN, 0);
+
+    /* an error in a pre callback stops the access */
+    ASSERT_EQ(m_initiator.do_write<uint32_t>(0x10, 1), tlm::TLM_GENERIC_ERROR_RESPONSE);
+    ASSERT_EQ(m_regs.FIFO.get(0), 0);
+
+    /* no callback on the handle accesses */
+    m_regs.CMD = 2;
+    ASSERT_EQ(writes, 1);
+}
+
+// DMI to the storage while no register has callbacks
+TEST_BENCH(RegBankTestBench, Dmi)
+{
+    ASSERT_EQ(m_initiator.do_write<uint32_t>(0x0, 1), tlm::TLM_OK_RESPONSE);
+    ASSERT_TRUE(m_initiator.get_last_dmi_hint());
+
+    ASSERT_TRUE(m_initiator.do_dmi_request(0x0));
+    ASSERT_EQ(m_initiator.get_last_dmi_data().get_start_address(), 0x0);
+    ASSERT_EQ(m_initiator.get_last_dmi_data().get_end_address(), 0x3);
+    ASSERT_TRUE(m_initiator.get_last_dmi_data().is_read_allowed());
+    ASSERT_TRUE(m_initiator.get_last_dmi_data().is_write_allowed());
+
+    /* the read only registers are only readable */
+    ASSERT_TRUE(m_initiator.do_dmi_request(0x4));
+    ASSERT_EQ(m_initiator.get_last_dmi_data().get_start_address(), 0x4);
+    ASSERT_EQ(m_initiator.get_last_dmi_data().get_end_address(), 0x7);
+    ASSERT_TRUE(m_initiator.get_last_dmi_data().is_read_allowed());
+    ASSERT_FALSE(m_initiator.get_last_dmi_data().is_write_allowed());
+    ASSERT_EQ(*reinterpret_cast<uint32_t*>(m_initiator.get_last_dmi_data().get_dmi_ptr()), 0xa5);
+
+    ASSERT_TRUE(m_initiator.do_dmi_request(0x14));
+    ASSERT_EQ(m_initiator.get_last_dmi_data().get_start_address(), 0x10);
+    ASSERT_EQ(m_initiator.get_last_dmi_data().get_end_address(), 0x1f);
+    ASSERT_TRUE(m_initiator.get_last_dmi_data().is_write_allowed());
+
+    /* neither the write only registers nor the holes */
+    ASSERT_EQ(m_initiator.do_write<uint32_t>(0x8, 1), tlm::TLM_OK_RESPONSE);
+    ASSERT_FALSE(m_initiator.get_last_dmi_hint());
+    ASSERT_FALSE(m_initiator.do_dmi_request(0x8));
+    ASSERT_FALSE(m_initiator.do_dmi_request(0xc));
+    ASSERT_FALSE(m_initiator.do_dmi_request(0x30));
+
+    m_regs.CTRL.post_write([](tlm::tlm_generic_payload& txn, sc_core::sc_time& delay) {});
+    ASSERT_EQ(m_invalidations, 1);
+    ASSERT_FALSE(m_initiator.do_dmi_request(0x0));
+    ASSERT_EQ(m_initiator.do_write<uint32_t>(0x0, 1), tlm::TLM_OK_RESPONSE);
+    ASSERT_FALSE(m_initiator.get_last_dmi_hint());
+}
+
+int sc_main(int argc, char* argv[])
+{
+    cci_utils::consuming_broker broker("global_broker");
+    cci_register_broker(broker);
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
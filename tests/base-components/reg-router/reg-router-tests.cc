@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <systemc>
+#include <tlm>
+#include <cci/utils/broker.h>
+
+#include <libgsutils.h>
+
+#include "gs_memory.h"
+#include "reg_router.h"
+#include "registers.h"
+#include <tests/initiator-tester.h>
+#include <tests/test-bench.h>
+
+/*
+ * A register memory of 4 pages, with a register with callbacks in page 1 and
+ * one without callbacks in page 2.
+ */
+class RegRouterTestBench : public TestBench
+{
+protected:
+    InitiatorTester m_initiator;
+    gs::reg_router<> m_router;
+    gs::gs_memory<> m_memory;
+    gs::port_fnct m_reg_cb;
+    gs::port_fnct m_reg_plain;
+
+    int m_invalidations = 0;
+    uint64_t m_invalidated_start = 0;
+    uint64_t m_invalidated_end = 0;
+
+public:
+    RegRouterTestBench(const sc_core::sc_module_name& n)
+        : TestBench(n)
+        , m_initiator("initiator")
+        , m_router("router")
+        , m_memory("memory")
+        , m_reg_cb("reg_cb", std::string(name()) + ".reg_cb")
+        , m_reg_plain("reg_plain", std::string(name()) + ".reg_plain")
+    {
+        m_reg_cb.post_write([](tlm::tlm_generic_payload& txn, sc_core::sc_time& delay) {});
+
+        m_initiator.register_invalidate_direct_mem_ptr([this](uint64_t start, uint64_t end) {
+            m_invalidations++;
+            m_invalidated_start = start;
+            m_invalidated_end = end;
+        });
+
+        m_initiator.socket.bind(m_router.target_socket);
+        m_router.initiator_socket.bind(m_memory.socket);
+        m_router.initiator_socket.bind(m_reg_cb);
+        m_router.initiator_socket.bind(m_reg_plain);
+    }
+};
+
+// DMI is granted on the pages without callbacks
+TEST_BENCH(RegRouterTestBench, SelectiveDmi)
+{
+    ASSERT_TRUE(m_initiator.do_dmi_request(0x10));
+    ASSERT_EQ(m_initiator.get_last_dmi_data().get_start_address(), 0x0);
+    ASSERT_EQ(m_initiator.get_last_dmi_data().get_end_address(), 0xfff);
+
+    ASSERT_FALSE(m_initiator.do_dmi_request(0x1000));
+    ASSERT_FALSE(m_initiator.do_dmi_request(0x1ffc));
+
+    ASSERT_TRUE(m_initiator.do_dmi_request(0x2000));
+    ASSERT_EQ(m_initiator.get_last_dmi_data().get_start_address(), 0x2000);
+    ASSERT_EQ(m_initiator.get_last_dmi_data().get_end_address(), 0x3fff);
+
+    /* the DMI pointer is the register memory */
+    uint32_t data = 0;
+    *reinterpret_cast<uint32_t*>(m_initiator.get_last_dmi_data().get_dmi_ptr()) = 0xcafe;
+    ASSERT_EQ(m_initiator.do_read(0x2000, data), tlm::TLM_OK_RESPONSE);
+    ASSERT_EQ(data, 0xcafe);
+}
+
+// The transactions carry the same DMI hint
+TEST_BENCH(RegRouterTestBench, DmiHint)
+{
+    ASSERT_EQ(m_initiator.do_write<uint32_t>(0x2000, 1), tlm::TLM_OK_RESPONSE);
+    ASSERT_TRUE(m_initiator.get_last_dmi_hint());
+
+    ASSERT_EQ(m_initiator.do_write<uint32_t>(0x1010, 1), tlm::TLM_OK_RESPONSE);
+    ASSERT_FALSE(m_initiator.get_last_dmi_hint());
+}
+
+// Adding a callback invalidates the pages of the register
+TEST_BENCH(RegRouterTestBench, CallbackAddedLater)
+{
+    ASSERT_TRUE(m_initiator.do_dmi_request(0x2000));
+
+    m_reg_plain.pre_read([](tlm::tlm_generic_payload& txn, sc_core::sc_time& delay) {});
+    ASSERT_EQ(m_invalidations, 1);
+    ASSERT_LE(m_invalidated_start, 0x2000);
+    ASSERT_GE(m_invalidated_end, 0x2003);
+
+    ASSERT_FALSE(m_initiator.do_dmi_request(0x2000));
+    ASSERT_TRUE(m_initiator.do_dmi_request(0x3000));
+    ASSERT_EQ(m_initiator.get_last_dmi_data().get_start_address(), 0x3000);
+}
+
+int sc_main(int argc, char* argv[])
+{
+    gs::ConfigurableBroker m_broker({
+        { "test_bench.memory.target_socket.address", cci::cci_value(0x0) },
+        { "test_bench.memory.target_socket.size", cci::cci_value(0x4000) },
+        { "test_bench.reg_cb_target_socket.address", cci::cci_value(0x1010) },
+        { "test_bench.reg_cb_target_socket.size", cci::cci_value(4) },
+        { "test_bench.reg_cb_target_socket.is_callback", cci::cci_value(true) },
+        { "test_bench.reg_plain_target_socket.address", cci::cci_value(0x2000) },
+        { "test_bench.reg_plain_target_socket.size", cci::cci_value(4) },
+        { "test_bench.reg_plain_target_socket.is_callback", cci::cci_value(true) },
+    });
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
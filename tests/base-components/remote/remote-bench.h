@@ -117,4 +117,6 @@ public:
         m_pass.initiator_sockets[0].bind(m_router.target_socket);
     }
     virtual ~RemotePassTest() {}
+
+    sc_core::sc_time remote_horizon() const { return m_pass.get_remote_horizon(); }
 };
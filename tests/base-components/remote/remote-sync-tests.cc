@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "remote-bench.h"
+#include <cci/utils/broker.h>
+#include <scp/report.h>
+
+// With sync_quantum_ns on both passes, we never run past the horizon published by the remote
+TEST_BENCH(RemotePassTest, test_bench)
+{
+    for (int i = 0; i < 20; i++) {
+        do_write_read_check(0x22000 + (i % 8) * 8);
+        ASSERT_LE(sc_core::sc_time_stamp(), remote_horizon());
+        sc_core::wait(250, sc_core::SC_US);
+        ASSERT_LE(sc_core::sc_time_stamp(), remote_horizon());
+    }
+    // the remote kept up
+    ASSERT_GE(remote_horizon(), sc_core::sc_time(5, sc_core::SC_MS));
+    sc_core::sc_stop();
+}
+
+int sc_main(int argc, char* argv[])
+{
+    std::string exe = getexepath();
+    std::string remote = exe.substr(0, exe.rfind('/') + 1) + "remote-tests-remote";
+
+    gs::ConfigurableBroker m_broker({
+        { "test_bench.mem1.target_socket.address", cci::cci_value(0x11000) },
+        { "test_bench.mem1.target_socket.size", cci::cci_value(0x1000) },
+        { "test_bench.pass.mem2.target_socket.address", cci::cci_value(0x22000) },
+        { "test_bench.pass.mem2.target_socket.size", cci::cci_value(0x1000) },
+        { "test_bench.pass.mem3.target_socket.address", cci::cci_value(0x23000) },
+        { "test_bench.pass.mem3.target_socket.size", cci::cci_value(0x1000) },
+        { "test_bench.local.target_socket.address", cci::cci_value(0x11000) },
+        { "test_bench.local.target_socket.size", cci::cci_value(0x1000) },
+
+        { "test_bench.pass.tlm_initiator_ports_num", cci::cci_value(1) },
+        { "test_bench.pass.tlm_target_ports_num", cci::cci_value(2) },
+
+        { "test_bench.pass.remote_pass.tlm_initiator_ports_num", cci::cci_value(2) },
+        { "test_bench.pass.remote_pass.tlm_target_ports_num", cci::cci_value(1) },
+
+        { "test_bench.pass.target_socket_0.address", cci::cci_value(0x20000) },
+        { "test_bench.pass.target_socket_0.size", cci::cci_value(0x10000) },
+        { "test_bench.pass.target_socket_0.relative_addresses", cci::cci_value(false) },
+        { "test_bench.pass.exec_path", cci::cci_value(remote) },
+
+        { "test_bench.pass.sync_quantum_ns", cci::cci_value(1000000) },
+        { "test_bench.pass.remote_pass.sync_quantum_ns", cci::cci_value(1000000) },
+    });
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
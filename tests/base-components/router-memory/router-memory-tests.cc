@@ -213,6 +213,57 @@ TEST_BENCH(RouterMemoryTestBench, DmiWriteRead)
     ASSERT_EQ(data, data_read);
 }
 
+static long file_size(const std::string& fname)
+{
+    FILE* f = fopen(fname.c_str(), "rb");
+    if (!f) {
+        return -1;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fclose(f);
+    return size;
+}
+
+// Sparse then incremental dumps only contain the pages which are not zero, or which changed
+TEST_BENCH(RouterMemoryTestBench, SparseDump)
+{
+    cci::cci_broker_handle broker = cci::cci_get_broker();
+    auto set_param = [&](const std::string& name, auto value) {
+        cci::cci_param_typed_handle<decltype(value)>(broker.get_param_handle("SparseDump.dumper." + name))
+            .set_value(value);
+    };
+    const std::string fname = "SparseDump.Memory_1.0x101-0x201.";
+    const long page_record = sizeof(gs::memdump::file_header) + sizeof(gs::memdump::record_header) + 64;
+    std::vector<uint8_t> image;
+
+    set_param("format", std::string("sparse"));
+    set_param("page_size", 64u);
+    set_param("chunk_size", 128u);
+    set_param("threads", 2u);
+
+    /* Full dump: only the page at 0x40 is not zero */
+    ASSERT_EQ(m_initiator.do_write<uint8_t>(address[1] + 0x50, 0x42), tlm::TLM_OK_RESPONSE);
+    ASSERT_EQ(m_initiator.do_write<uint8_t>(0x10000, 0), tlm::TLM_OK_RESPONSE);
+
+    ASSERT_EQ(file_size(fname + "dumpfile"), page_record);
+    ASSERT_TRUE(gs::memdump::restore(fname + "dumpfile", image));
+    ASSERT_EQ(image.size(), size[1]);
+    ASSERT_EQ(image[0x50], 0x42);
+    ASSERT_EQ(image[0x51], 0);
+
+    /* Incremental dump: only the page at 0xc0 changed */
+    set_param("outfile", std::string("incremental"));
+    set_param("incremental_base", std::string("dumpfile"));
+    ASSERT_EQ(m_initiator.do_write<uint8_t>(address[1] + 0xc0, 0x43), tlm::TLM_OK_RESPONSE);
+    ASSERT_EQ(m_initiator.do_write<uint8_t>(0x10000, 0), tlm::TLM_OK_RESPONSE);
+
+    ASSERT_EQ(file_size(fname + "incremental"), page_record);
+    ASSERT_TRUE(gs::memdump::restore(fname + "incremental", image));
+    ASSERT_EQ(image[0x50], 0x42);
+    ASSERT_EQ(image[0xc0], 0x43);
+}
+
 int sc_main(int argc, char* argv[])
 {
     cci_utils::consuming_broker broker("global_broker");
@@ -224,6 +224,19 @@ protected:
         }
     }
 
+    /* Ask the memory map to the router, as the QEMU initiators do for eager DMI */
+    std::vector<std::pair<uint64_t, uint64_t>> get_dmi_map()
+    {
+        gs::DmiMapExtension map;
+        TlmGenericPayload txn;
+        txn.set_command(tlm::TLM_IGNORE_COMMAND);
+        txn.set_data_length(0);
+        txn.set_extension(&map);
+        m_initiator.socket->transport_dbg(txn);
+        txn.clear_extension(&map);
+        return map.windows;
+    }
+
     void do_bad_dmi_request_and_check(int id, uint64_t addr)
     {
         overlap(id);
@@ -111,6 +111,18 @@ TEST_BENCH(RouterTestBenchSimple, SimpleDmiOverlap)
     do_good_dmi_request_and_check(3, address[3], address[3], target_size[3] - 1);
 }
 
+// The router exports the windows of its targets, without forwarding the query
+TEST_BENCH(RouterTestBenchSimple, DmiMap)
+{
+    auto map = get_dmi_map();
+
+    ASSERT_EQ(map.size(), NB_TARGETS);
+    for (int i = 0; i < NB_TARGETS; i++) {
+        ASSERT_EQ(map[i].first, address[i]);
+        ASSERT_EQ(map[i].second, address[i] + size[i] - 1);
+    }
+}
+
 int sc_main(int argc, char* argv[])
 {
     cci_utils::consuming_broker broker("global_broker");
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <systemc>
+#include <tlm>
+
+#include "gs_memory.h"
+#include "tlm_trace.h"
+#include <tests/initiator-tester.h>
+#include <tests/test-bench.h>
+
+class TlmTraceTestBench : public TestBench
+{
+public:
+    static constexpr size_t MEMORY_SIZE = 256;
+
+protected:
+    InitiatorTester m_initiator;
+    gs::tlm_trace<> m_probe;
+    gs::gs_memory<> m_target;
+
+    /* Read back the transactions recorded by this bench's probe */
+    std::vector<gs::trace::record> read_trace()
+    {
+        std::vector<gs::trace::record> txns;
+        std::map<uint16_t, std::string> sources;
+        std::vector<gs::trace::record> all;
+
+        m_probe.flush();
+
+        FILE* f = fopen(m_probe.p_trace_file.get_value().c_str(), "rb");
+        EXPECT_NE(f, nullptr);
+        if (!f) {
+            return txns;
+        }
+        gs::trace::file_header h;
+        EXPECT_EQ(fread(&h, sizeof(h), 1, f), 1);
+        EXPECT_EQ(h.record_size, sizeof(gs::trace::record));
+
+        gs::trace::record r;
+        while (fread(&r, sizeof(r), 1, f) == 1) {
+            if (r.kind == gs::trace::KIND_SOURCE) {
+                std::string& s = sources[r.source];
+                s.resize(r.length);
+                memcpy(&s[r.address], r.data, r.data_len);
+            } else {
+                all.push_back(r);
+            }
+        }
+        fclose(f);
+
+        for (auto& rec : all) {
+            if (rec.kind != gs::trace::KIND_DROPPED && sources[rec.source] == m_probe.name()) {
+                txns.push_back(rec);
+            }
+        }
+        return txns;
+    }
+
+public:
+    TlmTraceTestBench(const sc_core::sc_module_name& n)
+        : TestBench(n), m_initiator("initiator"), m_probe("probe"), m_target("memory", MEMORY_SIZE)
+    {
+        m_initiator.socket.bind(m_probe.target_socket);
+        m_probe.initiator_socket.bind(m_target.socket);
+    }
+
+    virtual ~TlmTraceTestBench() {}
+};
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "tlm-trace-bench.h"
+#include <cci/utils/broker.h>
+
+// Transactions are recorded with their address, command, response and data
+TEST_BENCH(TlmTraceTestBench, Records)
+{
+    uint16_t data;
+
+    ASSERT_EQ(m_initiator.do_write<uint16_t>(0x10, 0xabcd), tlm::TLM_OK_RESPONSE);
+    ASSERT_EQ(m_initiator.do_read(0x10, data), tlm::TLM_OK_RESPONSE);
+    ASSERT_EQ(data, 0xabcd);
+    ASSERT_EQ(m_initiator.do_write<uint8_t>(MEMORY_SIZE, 0x04), tlm::TLM_ADDRESS_ERROR_RESPONSE);
+    /* debug transactions are not recorded by default */
+    ASSERT_EQ(m_initiator.do_read(0x10, data, true), tlm::TLM_OK_RESPONSE);
+
+    std::vector<gs::trace::record> txns = read_trace();
+    ASSERT_EQ(txns.size(), 3);
+
+    ASSERT_EQ(txns[0].kind, gs::trace::KIND_TXN);
+    ASSERT_EQ(txns[0].command, tlm::TLM_WRITE_COMMAND);
+    ASSERT_EQ(txns[0].address, 0x10);
+    ASSERT_EQ(txns[0].length, 2);
+    ASSERT_EQ(txns[0].response, tlm::TLM_OK_RESPONSE);
+    ASSERT_EQ(txns[0].data_len, 2);
+    ASSERT_EQ(txns[0].data[0], 0xcd);
+    ASSERT_EQ(txns[0].data[1], 0xab);
+    ASSERT_EQ(txns[0].path[0], gs::trace::NO_ID);
+
+    ASSERT_EQ(txns[1].command, tlm::TLM_READ_COMMAND);
+    ASSERT_EQ(txns[1].data[0], 0xcd);
+
+    ASSERT_EQ(txns[2].address, MEMORY_SIZE);
+    ASSERT_EQ(txns[2].response, tlm::TLM_ADDRESS_ERROR_RESPONSE);
+}
+
+/* The addresses of the transactions of a trace file, in order */
+static std::vector<uint64_t> read_addresses(const std::string& fname)
+{
+    std::vector<uint64_t> addrs;
+    FILE* f = fopen(fname.c_str(), "rb");
+    EXPECT_NE(f, nullptr);
+    if (!f) {
+        return addrs;
+    }
+    gs::trace::file_header h;
+    EXPECT_EQ(fread(&h, sizeof(h), 1, f), 1u);
+    gs::trace::record r;
+    while (fread(&r, sizeof(r), 1, f) == 1) {
+        if (r.kind == gs::trace::KIND_TXN) {
+            addrs.push_back(r.address);
+        }
+    }
+    fclose(f);
+    return addrs;
+}
+
+// A thread alternating between two recorders records into each of them
+TEST(TlmTraceRecorder, Alternating)
+{
+    const uint64_t n = 1000;
+    std::shared_ptr<gs::trace::recorder> a = gs::trace::recorder::get("tlm-trace-tests-a.trace");
+    std::shared_ptr<gs::trace::recorder> b = gs::trace::recorder::get("tlm-trace-tests-b.trace");
+    uint16_t sa = a->add_source("a");
+    uint16_t sb = b->add_source("b");
+
+    tlm::tlm_generic_payload txn;
+    txn.set_command(tlm::TLM_WRITE_COMMAND);
+    for (uint64_t i = 0; i < n; i++) {
+        txn.set_address(i);
+        a->record_txn(sa, gs::trace::NO_ID, txn, sc_core::SC_ZERO_TIME);
+        txn.set_address(i + n);
+        b->record_txn(sb, gs::trace::NO_ID, txn, sc_core::SC_ZERO_TIME);
+    }
+    a->flush();
+    b->flush();
+    ASSERT_EQ(a->dropped(), 0u);
+    ASSERT_EQ(b->dropped(), 0u);
+
+    std::vector<uint64_t> addrs_a = read_addresses("tlm-trace-tests-a.trace");
+    std::vector<uint64_t> addrs_b = read_addresses("tlm-trace-tests-b.trace");
+    ASSERT_EQ(addrs_a.size(), n);
+    ASSERT_EQ(addrs_b.size(), n);
+    for (uint64_t i = 0; i < n; i++) {
+        ASSERT_EQ(addrs_a[i], i);
+        ASSERT_EQ(addrs_b[i], i + n);
+    }
+}
+
+int sc_main(int argc, char* argv[])
+{
+    cci_utils::consuming_broker broker("global_broker");
+    cci_register_broker(broker);
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -65,6 +65,41 @@ int sc_main(int argc, char** argv)
     return EXIT_FAILURE;
 }
 
+// Runs before the simulation, at time 0
+TEST(tlm_quantumkeeper_extended, domain_quantum)
+{
+    sc_core::sc_time saved = tlm_utils::tlm_quantumkeeper::get_global_quantum();
+    sc_core::sc_time global(1, sc_core::SC_MS);
+    sc_core::sc_time quantum(10, sc_core::SC_US);
+    tlm_utils::tlm_quantumkeeper::set_global_quantum(global);
+
+    gs::tlm_quantumkeeper_extended qk;
+    EXPECT_EQ(global, qk.get_quantum());
+    qk.set_quantum(quantum);
+    EXPECT_EQ(quantum, qk.get_quantum());
+    EXPECT_EQ(global, qk.get_global_quantum());
+
+    // the sync points are on the boundaries of the domain quantum
+    qk.reset();
+    EXPECT_EQ(quantum, qk.time_to_sync());
+    qk.inc(quantum - sc_core::sc_time(1, sc_core::SC_NS));
+    EXPECT_FALSE(qk.need_sync());
+    qk.inc(sc_core::sc_time(1, sc_core::SC_NS));
+    EXPECT_TRUE(qk.need_sync());
+
+    qk.set_quantum(sc_core::SC_ZERO_TIME);
+    EXPECT_EQ(global, qk.get_quantum());
+
+    using gs::tlm_quantumkeeper_extended;
+    sc_core::sc_time us(1, sc_core::SC_US);
+    EXPECT_EQ(6 * us, tlm_quantumkeeper_extended::common_boundary(2 * us, 3 * us));
+    EXPECT_EQ(global, tlm_quantumkeeper_extended::common_boundary(quantum, global));
+    EXPECT_EQ(sc_core::SC_ZERO_TIME, tlm_quantumkeeper_extended::common_boundary(quantum, sc_core::SC_ZERO_TIME));
+
+    // the other tests expect the global quantum they start with
+    tlm_utils::tlm_quantumkeeper::set_global_quantum(saved);
+}
+
 TEST(tlm_quantumkeeper_extended, basic_test)
 {
     test_base tb("test_base");
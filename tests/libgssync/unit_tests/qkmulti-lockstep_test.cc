@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <atomic>
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "qkmulti-lockstep.h"
+
+gs::tlm_quantumkeeper_extended* qk = nullptr;
+
+bool done;
+std::atomic<int> ticks;
+
+/* A SystemC process running at every quantum boundary */
+void ticker()
+{
+    sc_core::sc_time quantum(1, sc_core::SC_MS);
+    for (;;) {
+        sc_core::wait(quantum);
+        ticks++;
+    }
+}
+
+void lockstep()
+{
+    sc_core::sc_time quantum(1, sc_core::SC_MS);
+    for (int k = 1; k <= 10; k++) {
+        // SystemC has caught up with us, we have a quantum of budget
+        EXPECT_EQ(qk->time_to_sync(), quantum);
+        EXPECT_FALSE(qk->need_sync());
+        qk->inc(quantum);
+        // and none until SystemC has caught up again
+        EXPECT_TRUE(qk->need_sync());
+        qk->sync();
+        // SystemC reached our local time, without going past it
+        EXPECT_EQ(sc_core::sc_time_stamp(), quantum * k);
+        EXPECT_GE(ticks, k - 1);
+    }
+    done = true;
+    qk->stop();
+}
+
+int sc_main(int argc, char** argv)
+{
+    qk = new gs::tlm_quantumkeeper_multi_lockstep;
+    sc_core::sc_time quantum(1, sc_core::SC_MS);
+    tlm_utils::tlm_quantumkeeper::set_global_quantum(quantum);
+    sc_core::sc_spawn(&ticker);
+    testing::InitGoogleTest(&argc, argv);
+    int status = RUN_ALL_TESTS();
+    return status;
+}
+
+TEST(qkmulti_lockstep, lockstep)
+{
+    done = false;
+    ticks = 0;
+    qk->start();
+    qk->reset();
+    std::thread t1(lockstep);
+    while (sc_core::sc_pending_activity() || !done) {
+        if (sc_core::sc_pending_activity()) {
+            sc_core::sc_time t = sc_core::sc_time_to_pending_activity();
+            sc_start(t);
+        }
+        if (done) {
+            break;
+        }
+    }
+    t1.join();
+}
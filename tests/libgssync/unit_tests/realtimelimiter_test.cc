@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <chrono>
+
+#include <gtest/gtest.h>
+#include <cci/utils/broker.h>
+#include "realtimelimiter.h"
+
+/* SystemC time per realtime */
+static const double SPEED = 2.0;
+static const int SIM_MS = 1000;
+static const double QUANTUM_MS = 1;
+
+class pacing_bench : public sc_core::sc_module
+{
+public:
+    gs::realtimelimiter rtl;
+    double wall_s = 0;
+
+    pacing_bench(const sc_core::sc_module_name& n): sc_core::sc_module(n), rtl("rtl", false)
+    {
+        SC_HAS_PROCESS(pacing_bench);
+        SC_THREAD(run);
+    }
+
+    void run()
+    {
+        rtl.enable();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < SIM_MS; i++) {
+            wait(1, sc_core::SC_MS);
+        }
+        wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        rtl.disable();
+        sc_core::sc_stop();
+    }
+};
+
+// In precise mode, SystemC runs at speed times realtime
+TEST(realtimelimiter, precise_speed)
+{
+    cci::cci_broker_handle broker = cci::cci_get_broker();
+    broker.set_preset_cci_value("bench.rtl.speed", cci::cci_value(SPEED));
+    broker.set_preset_cci_value("bench.rtl.precise", cci::cci_value(true));
+    broker.set_preset_cci_value("bench.rtl.RTquantum_ms", cci::cci_value(QUANTUM_MS));
+
+    pacing_bench bench("bench");
+    sc_core::sc_start();
+
+    double expected = SIM_MS / 1000.0 / SPEED;
+    /* SystemC may be ahead by up to a quantum, and behind on a loaded host */
+    EXPECT_GE(bench.wall_s, expected - 2 * QUANTUM_MS / 1000);
+    EXPECT_LE(bench.wall_s, expected * 1.2 + 0.05);
+}
+
+int sc_main(int argc, char** argv)
+{
+    cci_utils::consuming_broker broker("global_broker");
+    cci_register_broker(broker);
+
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <fstream>
+#include <string>
+
+#include <systemc>
+#include <libgsutils.h>
+#include <config_cache.h>
+#include <gtest/gtest.h>
+#include <scp/report.h>
+
+static const std::string cache_file = "config_cache_test.cache";
+static const std::string data_file = "config_cache_test.data";
+
+static void write_file(const std::string& name, const std::string& content)
+{
+    std::ofstream f(name, std::ios::trunc);
+    f << content;
+}
+
+static gs::config_record make_record()
+{
+    gs::config_record rec;
+    rec.presets["top.u"] = cci::cci_value(uint64_t(0x100000000ULL));
+    rec.presets["top.i"] = cci::cci_value(int64_t(-3));
+    rec.presets["top.d"] = cci::cci_value(0.5);
+    rec.presets["top.b"] = cci::cci_value(true);
+    rec.presets["top.s"] = cci::cci_value(std::string("a string"));
+    rec.presets["top.l"] = cci::cci_value::from_json("[1, \"two\"]");
+    rec.inputs.emplace(data_file, gs::CONFIG_INPUT_FILE);
+    rec.inputs.emplace("config_cache_test.absent", gs::CONFIG_INPUT_ABSENT);
+    rec.inputs.emplace("CONFIG_CACHE_TEST_ENV", gs::CONFIG_INPUT_ENV);
+    return rec;
+}
+
+// The values are read back as they were written
+TEST(config_cache, round_trip)
+{
+    write_file(data_file, "1");
+    uint64_t key = gs::config_cache::key({ { 'l', "conf.lua" }, { 'p', "top.x=1" } });
+
+    gs::config_record rec = make_record();
+    ASSERT_TRUE(gs::config_cache(cache_file).save(key, rec));
+
+    gs::config_cache cache(cache_file);
+    ASSERT_TRUE(cache.load(key));
+    std::string changed;
+    ASSERT_TRUE(cache.up_to_date(changed));
+    ASSERT_EQ(cache.presets(), rec.presets);
+    ASSERT_TRUE(cache.presets().at("top.u").is_uint64());
+    ASSERT_TRUE(cache.presets().at("top.i").is_int64());
+    ASSERT_EQ(cache.diff(rec), 0);
+
+    rec.presets["top.s"] = cci::cci_value(std::string("another string"));
+    rec.presets.erase("top.b");
+    ASSERT_EQ(cache.diff(rec), 2);
+}
+
+// A cache is only used for its command line
+TEST(config_cache, key)
+{
+    uint64_t key = gs::config_cache::key({ { 'l', "conf.lua" }, { 'p', "top.x=1" } });
+    ASSERT_NE(key, gs::config_cache::key({ { 'p', "top.x=1" }, { 'l', "conf.lua" } }));
+    ASSERT_NE(key, gs::config_cache::key({ { 'l', "conf.lua" }, { 'p', "top.x=2" } }));
+
+    ASSERT_TRUE(gs::config_cache(cache_file).save(key, make_record()));
+    ASSERT_FALSE(gs::config_cache(cache_file).load(key + 1));
+
+    write_file(cache_file, "not a cache");
+    ASSERT_FALSE(gs::config_cache(cache_file).load(key));
+}
+
+// A cache is out of date once one of its inputs changes
+TEST(config_cache, inputs)
+{
+    uint64_t key = gs::config_cache::key({});
+    std::string changed;
+
+    write_file(data_file, "1");
+    unsetenv("CONFIG_CACHE_TEST_ENV");
+    ASSERT_TRUE(gs::config_cache(cache_file).save(key, make_record()));
+
+    gs::config_cache cache(cache_file);
+    ASSERT_TRUE(cache.load(key));
+    ASSERT_TRUE(cache.up_to_date(changed));
+
+    setenv("CONFIG_CACHE_TEST_ENV", "1", 1);
+    ASSERT_FALSE(cache.up_to_date(changed));
+    ASSERT_EQ(changed, "CONFIG_CACHE_TEST_ENV");
+    unsetenv("CONFIG_CACHE_TEST_ENV");
+
+    write_file("config_cache_test.absent", "");
+    ASSERT_FALSE(cache.up_to_date(changed));
+    ASSERT_EQ(changed, "config_cache_test.absent");
+    unlink("config_cache_test.absent");
+
+    write_file(data_file, "22");
+    ASSERT_FALSE(cache.up_to_date(changed));
+    ASSERT_EQ(changed, data_file);
+}
+
+int sc_main(int argc, char** argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    int status = RUN_ALL_TESTS();
+    unlink(cache_file.c_str());
+    unlink(data_file.c_str());
+    return status;
+}
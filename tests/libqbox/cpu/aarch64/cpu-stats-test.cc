@@ -0,0 +1,149 @@
+/*
+ * This file is part of libqbox
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <cinttypes>
+#include <cstdio>
+#include <vector>
+
+#include "test/cpu.h"
+#include "test/tester/mmio.h"
+
+#include "cortex-a53.h"
+#include "qemu-instance.h"
+
+/*
+ * ARM Cortex-A53 instruction and translation block counts (cpu_stats).
+ *
+ * Each CPU runs a loop of three instructions, (CPU index + 1) * ITERATIONS
+ * times, between two writes to the tester (at CPU index * 16). On each write,
+ * the test bench reads the statistics of the CPU: in between, the CPU must
+ * have executed the instructions and the TBs of its own loop only. The CPUs
+ * are spread over the two QEMU instances, which both count their vCPUs from
+ * 0, so the counts of an instance mixed with the other one's would be seen.
+ */
+class CpuArmCortexA53CpuStatsTest : public CpuTestBench<cpu_arm_cortexA53, CpuTesterMmio>
+{
+public:
+    static constexpr uint64_t ITERATIONS = 100000;
+    static constexpr uint64_t LOOP_INSNS = 3;
+
+    /* the TBs around the loop, and the ones executed again with icount */
+    static constexpr uint64_t SLACK = 16;
+
+    static constexpr const char* FIRMWARE = R"(
+        _start:
+            ldr x1, =0x%08)" PRIx64 R"(
+
+            mrs x0, mpidr_el1
+            and x2, x0, #0xff
+            and x0, x0, #0xff00
+            lsr x0, x0, #5
+            orr x0, x0, x2
+
+            lsl x3, x0, #4
+            add x1, x1, x3
+
+            add x0, x0, #1
+            ldr x2, =%llu
+            mul x0, x0, x2
+            mov x2, #0
+
+            str x0, [x1]
+        loop:
+            add x2, x2, #1
+            subs x0, x0, #1
+            b.ne loop
+            str x2, [x1, #8]
+
+        end:
+            wfi
+            b end
+    )";
+
+private:
+    struct Run {
+        uint64_t iterations = 0;
+        QemuCpu::Stats start;
+        bool done = false;
+    };
+
+    std::vector<Run> m_runs;
+
+public:
+    CpuArmCortexA53CpuStatsTest(const sc_core::sc_module_name& n)
+        : CpuTestBench<cpu_arm_cortexA53, CpuTesterMmio>(n), m_runs(p_num_cpu)
+    {
+        char buf[1024];
+
+        std::snprintf(buf, sizeof(buf), FIRMWARE, CpuTesterMmio::MMIO_ADDR, (unsigned long long)ITERATIONS);
+        set_firmware(buf);
+    }
+
+    virtual void mmio_write(int id, uint64_t addr, uint64_t data, size_t len) override
+    {
+        size_t cpu = addr >> 4;
+        TEST_ASSERT(cpu < m_runs.size());
+        Run& r = m_runs[cpu];
+        QemuCpu::Stats s = m_cpus[cpu].get_stats();
+
+        switch (addr & 0xf) {
+        case 0:
+            TEST_ASSERT(data == (cpu + 1) * ITERATIONS);
+            r.iterations = data;
+            r.start = s;
+            break;
+        case 8: {
+            TEST_ASSERT(data == r.iterations);
+            uint64_t insns = s.insns - r.start.insns;
+            uint64_t tbs = s.tbs_executed - r.start.tbs_executed;
+            uint64_t translated = s.tbs_translated - r.start.tbs_translated;
+
+            SCP_INFO(SCMOD) << "CPU " << cpu << ": " << insns << " instructions, " << tbs << " TBs executed, "
+                            << translated << " TBs translated";
+
+            /* the first iteration is in the TB of the first write, counted before it */
+            TEST_ASSERT(insns >= (r.iterations - 1) * LOOP_INSNS);
+            TEST_ASSERT(insns <= r.iterations * LOOP_INSNS + SLACK);
+            TEST_ASSERT(tbs >= r.iterations - 1);
+            TEST_ASSERT(tbs <= r.iterations + SLACK);
+            TEST_ASSERT(translated <= SLACK);
+            r.done = true;
+            break;
+        }
+        default:
+            TEST_FAIL("Unexpected CPU write");
+        }
+    }
+
+    virtual void end_of_simulation() override
+    {
+        CpuTestBench<cpu_arm_cortexA53, CpuTesterMmio>::end_of_simulation();
+
+        for (Run& r : m_runs) {
+            TEST_ASSERT(r.done);
+        }
+    }
+};
+
+constexpr const char* CpuArmCortexA53CpuStatsTest::FIRMWARE;
+
+int sc_main(int argc, char* argv[])
+{
+    /* count the vCPUs of both instances, before the command line arguments */
+    std::vector<char*> args(argv, argv + 1);
+    const char* defaults[] = {
+        "-p", "test-bench.inst_a.cpu_stats=true",
+        "-p", "test-bench.inst_b.cpu_stats=true",
+    };
+    for (const char* arg : defaults) {
+        args.push_back(const_cast<char*>(arg));
+    }
+    args.insert(args.end(), argv + 1, argv + argc);
+    args.push_back(nullptr);
+
+    return run_testbench<CpuArmCortexA53CpuStatsTest>(args.size() - 1, args.data());
+}
@@ -27,7 +27,8 @@
  * effectively starving the kernel and ending the simulation.
  *
  * On each write, the test bench checks the written value. It also checks the
- * number of write at the end of the simulation.
+ * number of write at the end of the simulation, and the vCPU profiles of the
+ * instances which have vcpu_profile set.
  */
 class CpuArmCortexA53SimpleWriteTest : public CpuTestBench<cpu_arm_cortexA53, CpuTesterMmio>
 {
@@ -93,6 +94,33 @@ public:
         m_writes[cpuid]++;
     }
 
+    /* Each vCPU ran guest code and did its I/O accesses, with a consistent timeline */
+    void check_vcpu_profile(QemuInstance& inst)
+    {
+        QemuVcpuProfiler* profiler = inst.get_vcpu_profiler();
+        if (!profiler) {
+            return;
+        }
+
+        for (const QemuVcpuProfile* p : profiler->profiles()) {
+            SCP_INFO(SCMOD) << "Checking the profile of " << p->name();
+            TEST_ASSERT(p->total(QemuVcpuProfile::TCG) > 0);
+            TEST_ASSERT(p->total(QemuVcpuProfile::IO) > 0);
+
+            size_t n = p->nb_events();
+            int io = 0;
+            for (size_t i = 0; i < n; i++) {
+                const QemuVcpuProfile::Event& e = p->event(i);
+                TEST_ASSERT(e.end >= e.start);
+                TEST_ASSERT(i == 0 || e.start == p->event(i - 1).end);
+                io += e.state == QemuVcpuProfile::IO;
+            }
+            if (n && !p->timeline_full()) {
+                TEST_ASSERT(io >= NUM_WRITES);
+            }
+        }
+    }
+
     virtual void end_of_simulation() override
     {
         CpuTestBench<cpu_arm_cortexA53, CpuTesterMmio>::end_of_simulation();
@@ -100,6 +128,9 @@ public:
         for (int i = 0; i < p_num_cpu; i++) {
             TEST_ASSERT(m_writes[i] == NUM_WRITES);
         }
+
+        check_vcpu_profile(m_inst_a);
+        check_vcpu_profile(m_inst_b);
     }
 };
 
@@ -0,0 +1,142 @@
+/*
+ *  This file is part of libqbox
+ *  Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <frame-capture.h>
+
+#include "test/test.h"
+
+/*
+ * Checks the hashes and the image files of the headless display captures.
+ */
+class FrameCaptureTest : public TestBench
+{
+    static std::vector<uint8_t> read_file(const std::string& fname)
+    {
+        std::vector<uint8_t> data;
+        FILE* f = fopen(fname.c_str(), "rb");
+        if (f) {
+            int c;
+            while ((c = fgetc(f)) != EOF) {
+                data.push_back(c);
+            }
+            fclose(f);
+        }
+        return data;
+    }
+
+    static uint32_t be32(const uint8_t* b) { return (b[0] << 24) | (b[1] << 16) | (b[2] << 8) | b[3]; }
+
+    static FrameCapture pattern(uint32_t w, uint32_t h)
+    {
+        FrameCapture f(w, h);
+        for (uint32_t y = 0; y < h; y++) {
+            for (uint32_t x = 0; x < w; x++) {
+                f.at(x, y) = (x * 13) << 16 | (y * 7) << 8 | ((x + y) & 0xff);
+            }
+        }
+        return f;
+    }
+
+    void check_hash()
+    {
+        FrameCapture a = pattern(17, 5);
+        FrameCapture b = pattern(17, 5);
+        TEST_ASSERT(a.hash() == b.hash());
+
+        /* the top byte is not part of the image */
+        b.at(3, 2) |= 0xff000000;
+        TEST_ASSERT(a.hash() == b.hash());
+
+        b.at(3, 2) ^= 1;
+        TEST_ASSERT(a.hash() != b.hash());
+
+        /* same pixels, other geometry */
+        FrameCapture c = pattern(5, 17);
+        c.pixels = a.pixels;
+        TEST_ASSERT(a.hash() != c.hash());
+    }
+
+    void check_ppm()
+    {
+        FrameCapture f = pattern(17, 5);
+        std::string fname = std::string(name()) + ".ppm";
+        TEST_ASSERT(f.write_ppm(fname));
+
+        std::vector<uint8_t> data = read_file(fname);
+        std::string header = "P6\n17 5\n255\n";
+        TEST_ASSERT(data.size() == header.size() + 17 * 5 * 3);
+        TEST_ASSERT(std::string(data.begin(), data.begin() + header.size()) == header);
+
+        const uint8_t* px = &data[header.size() + (2 * 17 + 3) * 3];
+        uint32_t v = f.at(3, 2);
+        TEST_ASSERT(px[0] == ((v >> 16) & 0xff) && px[1] == ((v >> 8) & 0xff) && px[2] == (v & 0xff));
+        remove(fname.c_str());
+    }
+
+    void check_png()
+    {
+        if (!FrameCapture::png_supported()) {
+            SCP_WARN(SCMOD) << "Built without zlib, skipping the PNG test";
+            return;
+        }
+
+        FrameCapture f = pattern(17, 5);
+        std::string fname = std::string(name()) + ".png";
+        TEST_ASSERT(f.write_png(fname));
+
+        std::vector<uint8_t> data = read_file(fname);
+        static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+        TEST_ASSERT(data.size() > 8 + 25 + 12 + 12);
+        TEST_ASSERT(std::equal(signature, signature + 8, data.begin()));
+
+        /* IHDR: 17x5, 8 bits RGB */
+        TEST_ASSERT(be32(&data[8]) == 13 && std::string(data.begin() + 12, data.begin() + 16) == "IHDR");
+        TEST_ASSERT(be32(&data[16]) == 17 && be32(&data[20]) == 5 && data[24] == 8 && data[25] == 2);
+
+#ifdef HAVE_ZLIB
+        size_t idat = 8 + 25;
+        TEST_ASSERT(std::string(data.begin() + idat + 4, data.begin() + idat + 8) == "IDAT");
+        uint32_t len = be32(&data[idat]);
+        TEST_ASSERT(crc32(crc32(0, &data[idat + 4], 4), &data[idat + 8], len) == be32(&data[idat + 8 + len]));
+
+        std::vector<uint8_t> raw(5 * (1 + 17 * 3));
+        uLongf raw_len = raw.size();
+        TEST_ASSERT(uncompress(raw.data(), &raw_len, &data[idat + 8], len) == Z_OK);
+        TEST_ASSERT(raw_len == raw.size());
+
+        /* each row starts with its filter type (none) */
+        const uint8_t* row = &raw[2 * (1 + 17 * 3)];
+        uint32_t v = f.at(3, 2);
+        TEST_ASSERT(row[0] == 0);
+        TEST_ASSERT(row[1 + 9] == ((v >> 16) & 0xff) && row[1 + 10] == ((v >> 8) & 0xff) && row[1 + 11] == (v & 0xff));
+
+        size_t iend = idat + 12 + len;
+        TEST_ASSERT(iend + 12 == data.size());
+        TEST_ASSERT(std::string(data.begin() + iend + 4, data.begin() + iend + 8) == "IEND");
+#endif
+        remove(fname.c_str());
+    }
+
+public:
+    FrameCaptureTest(const sc_core::sc_module_name& n): TestBench(n) {}
+
+    virtual void end_of_simulation() override
+    {
+        TestBench::end_of_simulation();
+
+        check_hash();
+        check_ppm();
+        check_png();
+    }
+};
+
+int sc_main(int argc, char* argv[]) { return run_testbench<FrameCaptureTest>(argc, argv); }
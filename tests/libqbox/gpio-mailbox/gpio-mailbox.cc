@@ -0,0 +1,85 @@
+/*
+ *  This file is part of libqbox
+ *  Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <thread>
+#include <vector>
+
+#include <ports/qemu-gpio-mailbox.h>
+
+#include "test/test.h"
+
+class GpioMailboxTest : public TestBench
+{
+private:
+    QemuGpioMailbox m_mailbox;
+    std::vector<bool> m_a_values;
+    std::vector<bool> m_b_values;
+    std::vector<bool> m_c_values;
+    QemuGpioMailbox::Line m_a;
+    QemuGpioMailbox::Line m_b;
+    QemuGpioMailbox::Line m_c;
+
+    void drained() { sc_core::wait(1, sc_core::SC_NS); }
+
+    void test()
+    {
+        /* changes before the mailbox is drained are coalesced */
+        m_mailbox.post(m_a, true);
+        m_mailbox.post(m_b, true);
+        m_mailbox.post(m_a, false);
+        m_mailbox.post(m_a, true);
+        drained();
+        TEST_ASSERT(m_a_values == std::vector<bool>({ true }));
+        TEST_ASSERT(m_b_values == std::vector<bool>({ true }));
+
+        /* but pulses are not lost */
+        m_mailbox.post(m_a, false);
+        m_mailbox.post(m_a, true);
+        m_mailbox.post(m_b, true);
+        drained();
+        TEST_ASSERT(m_a_values == std::vector<bool>({ true, false, true }));
+        TEST_ASSERT(m_b_values == std::vector<bool>({ true }));
+
+        /* posts done while a receiver waits are not lost */
+        m_mailbox.post(m_c, true);
+        sc_core::wait(5, sc_core::SC_NS);
+        m_mailbox.post(m_a, false);
+        sc_core::wait(20, sc_core::SC_NS);
+        TEST_ASSERT(m_c_values == std::vector<bool>({ true }));
+        TEST_ASSERT(m_a_values == std::vector<bool>({ true, false, true, false }));
+
+        /* posting from another thread */
+        std::thread t([this]() {
+            for (int i = 0; i < 1000; i++) {
+                m_mailbox.post(m_b, i & 1);
+            }
+        });
+        t.join();
+        drained();
+        TEST_ASSERT(m_b_values.back() == true);
+        for (size_t i = 1; i < m_b_values.size(); i++) {
+            TEST_ASSERT(m_b_values[i] != m_b_values[i - 1]);
+        }
+    }
+
+public:
+    GpioMailboxTest(const sc_core::sc_module_name& n)
+        : TestBench(n)
+        , m_mailbox("mailbox")
+        , m_a([this](bool val) { m_a_values.push_back(val); })
+        , m_b([this](bool val) { m_b_values.push_back(val); })
+        , m_c([this](bool val) {
+            m_c_values.push_back(val);
+            sc_core::wait(10, sc_core::SC_NS);
+        })
+    {
+        SC_HAS_PROCESS(GpioMailboxTest);
+        SC_THREAD(test);
+    }
+};
+
+int sc_main(int argc, char* argv[]) { return run_testbench<GpioMailboxTest>(argc, argv); }
@@ -0,0 +1,141 @@
+/*
+ *  This file is part of libqbox
+ *  Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * GPIO latency benchmark: two QEMU instances ping-pong a GPIO line.
+ *
+ * Each side toggles its output from a timer of its own instance (i.e. from
+ * its main loop, as a device would) when its input changes. By default the
+ * GPIOs go through SystemC, set cross_instance_gpio on both instances to
+ * measure the direct path.
+ */
+
+#include <chrono>
+#include <memory>
+
+#include <async_event.h>
+#include <device.h>
+#include <ports/qemu-initiator-signal-socket.h>
+#include <ports/qemu-target-signal-socket.h>
+
+#include "test/test.h"
+
+class PingPong : public QemuDevice
+{
+public:
+    class Out : public QemuInitiatorSignalSocket
+    {
+    public:
+        Out(const char* name): QemuInitiatorSignalSocket(name) {}
+
+        /* The GPIO is driven by the bench rather than by a device output */
+        void init_bench(qemu::Device dev) { init_internal(dev); }
+
+        void set(bool val) { m_proxy.set(val); }
+    };
+
+    class In : public QemuTargetSignalSocket
+    {
+    public:
+        In(const char* name): QemuTargetSignalSocket(name) {}
+
+        void init_bench(qemu::Gpio gpio) { init_with_gpio(gpio); }
+    };
+
+    Out out;
+    In in;
+
+    std::function<void()> on_receive;
+
+private:
+    qemu::Gpio m_in_gpio;
+    std::shared_ptr<qemu::Timer> m_timer;
+    bool m_level = false;
+
+public:
+    PingPong(const sc_core::sc_module_name& n, QemuInstance& inst)
+        : QemuDevice(n, inst, "reset_gpio"), out("out"), in("in")
+    {
+    }
+
+    virtual void end_of_elaboration() override
+    {
+        QemuDevice::end_of_elaboration();
+
+        m_in_gpio = m_inst.get().gpio_new();
+        m_in_gpio.set_event_callback([this](bool) { on_receive(); });
+        in.init_bench(m_in_gpio);
+        out.init_bench(m_dev);
+
+        m_timer = m_inst.get().timer_new();
+        m_timer->set_callback([this]() {
+            m_level = !m_level;
+            out.set(m_level);
+        });
+    }
+
+    /* Toggle the output from this instance's main loop */
+    void send() { m_timer->mod(m_inst.get().get_virtual_clock()); }
+};
+
+class GpioPingPongBench : public TestBench
+{
+private:
+    cci::cci_param<int> p_rounds;
+
+    QemuInstanceManager m_inst_manager;
+    QemuInstance m_inst_a;
+    QemuInstance m_inst_b;
+    PingPong m_a;
+    PingPong m_b;
+
+    int m_count = 0;
+    gs::async_event m_done;
+
+    void run_bench()
+    {
+        auto start = std::chrono::steady_clock::now();
+        m_a.send();
+        wait(m_done);
+        auto end = std::chrono::steady_clock::now();
+
+        double us = std::chrono::duration<double, std::micro>(end - start).count();
+        SCP_INFO(SCMOD) << p_rounds.get_value() << " round trips in " << us / 1000 << " ms, " << us / p_rounds
+                        << " us per round trip";
+        TEST_ASSERT(m_count == p_rounds);
+
+        m_done.async_detach_suspending();
+        sc_core::sc_stop();
+    }
+
+public:
+    GpioPingPongBench(const sc_core::sc_module_name& n)
+        : TestBench(n)
+        , p_rounds("rounds", 10000, "Number of round trips")
+        , m_inst_a("inst_a", &m_inst_manager, qemu::Target::AARCH64)
+        , m_inst_b("inst_b", &m_inst_manager, qemu::Target::AARCH64)
+        , m_a("a", m_inst_a)
+        , m_b("b", m_inst_b)
+    {
+        m_a.out.bind(m_b.in);
+        m_b.out.bind(m_a.in);
+
+        m_b.on_receive = [this]() { m_b.send(); };
+        m_a.on_receive = [this]() {
+            if (++m_count < p_rounds) {
+                m_a.send();
+            } else {
+                m_done.async_notify();
+            }
+        };
+
+        SC_HAS_PROCESS(GpioPingPongBench);
+        SC_THREAD(run_bench);
+    }
+};
+
+int sc_main(int argc, char* argv[]) { return run_testbench<GpioPingPongBench>(argc, argv); }
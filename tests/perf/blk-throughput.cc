@@ -0,0 +1,342 @@
+/*
+ *  This file is part of libqbox
+ *  Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Block I/O throughput: the bench drives a virtio-mmio block device from
+ * SystemC (no CPU), reading then writing a locally generated image with
+ * several requests in flight.
+ *
+ * The image is made of 64 bits words holding their offset, which the reads
+ * check. The writes store the complement. With an overlay, the image must be
+ * unchanged at the end.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <systemc>
+#include <tlm>
+
+#include <gs_memory.h>
+#include <router.h>
+#include <tests/initiator-tester.h>
+
+#include "qemu-instance.h"
+#include "global_peripheral_initiator.h"
+#include "virtio_mmio_blk.h"
+
+#include "test/test.h"
+#include "perf/bench-report.h"
+
+class BlkThroughputBench : public TestBench
+{
+    /* legacy virtio-mmio registers */
+    static constexpr uint64_t REG_MAGIC = 0x000;
+    static constexpr uint64_t REG_VERSION = 0x004;
+    static constexpr uint64_t REG_DEVICE_ID = 0x008;
+    static constexpr uint64_t REG_GUEST_FEATURES = 0x020;
+    static constexpr uint64_t REG_GUEST_PAGE_SIZE = 0x028;
+    static constexpr uint64_t REG_QUEUE_SEL = 0x030;
+    static constexpr uint64_t REG_QUEUE_NUM_MAX = 0x034;
+    static constexpr uint64_t REG_QUEUE_NUM = 0x038;
+    static constexpr uint64_t REG_QUEUE_ALIGN = 0x03c;
+    static constexpr uint64_t REG_QUEUE_PFN = 0x040;
+    static constexpr uint64_t REG_QUEUE_NOTIFY = 0x050;
+    static constexpr uint64_t REG_INTERRUPT_STATUS = 0x060;
+    static constexpr uint64_t REG_INTERRUPT_ACK = 0x064;
+    static constexpr uint64_t REG_STATUS = 0x070;
+    static constexpr uint64_t REG_CAPACITY = 0x100;
+
+    /* the queue, the request headers and statuses, then the buffers */
+    static constexpr uint64_t RAM_SIZE = 64 * 1024 * 1024;
+    static constexpr uint32_t QUEUE_SIZE = 64;
+    static constexpr uint64_t DESC_ADDR = 0x0;
+    static constexpr uint64_t AVAIL_ADDR = DESC_ADDR + 16 * QUEUE_SIZE;
+    static constexpr uint64_t USED_ADDR = 0x1000;
+    static constexpr uint64_t HDR_ADDR = 0x2000;
+    static constexpr uint64_t STATUS_ADDR = 0x3000;
+    static constexpr uint64_t BUF_ADDR = 0x100000;
+
+    static constexpr uint16_t DESC_F_NEXT = 1;
+    static constexpr uint16_t DESC_F_WRITE = 2;
+    static constexpr uint32_t BLK_T_IN = 0;
+    static constexpr uint32_t BLK_T_OUT = 1;
+    static constexpr uint64_t MAGIC = 0x5a5a5a5a00000000ULL;
+
+    cci::cci_param<int> p_image_mb;
+    cci::cci_param<int> p_request_kb;
+    cci::cci_param<int> p_depth;
+    cci::cci_param<int> p_passes;
+    cci::cci_param<std::string> p_image;
+    BenchReport m_report;
+
+    QemuInstanceManager m_inst_manager;
+    QemuInstance m_inst;
+    std::unique_ptr<virtio_mmio_blk> m_blk;
+    std::unique_ptr<global_peripheral_initiator> m_gpi;
+    gs::router<> m_router;
+    gs::gs_memory<> m_ram;
+    InitiatorTester m_mmio;
+    InitiatorTester m_mem;
+
+    uint16_t m_avail_idx = 0;
+    uint16_t m_used_idx = 0;
+    double m_read_s = 0;
+    double m_write_s = 0;
+    bool m_done = false;
+
+    uint64_t image_size() const { return uint64_t(p_image_mb) * 1024 * 1024; }
+    uint64_t request_size() const { return uint64_t(p_request_kb) * 1024; }
+
+    void generate_image()
+    {
+        std::ofstream f(p_image.get_value(), std::ios::binary | std::ios::trunc);
+        std::vector<uint64_t> chunk(1024 * 1024 / sizeof(uint64_t));
+        for (uint64_t off = 0; off < image_size(); off += chunk.size() * sizeof(uint64_t)) {
+            for (size_t i = 0; i < chunk.size(); i++) {
+                chunk[i] = MAGIC | (off + i * sizeof(uint64_t));
+            }
+            f.write(reinterpret_cast<const char*>(chunk.data()), chunk.size() * sizeof(uint64_t));
+        }
+        TEST_ASSERT(f.good());
+    }
+
+    uint32_t reg_read(uint64_t reg)
+    {
+        uint32_t v = 0;
+        TEST_ASSERT(m_mmio.do_read(reg, v) == tlm::TLM_OK_RESPONSE);
+        return v;
+    }
+
+    void reg_write(uint64_t reg, uint32_t v) { TEST_ASSERT(m_mmio.do_write(reg, v) == tlm::TLM_OK_RESPONSE); }
+
+    template <class T>
+    void mem_write(uint64_t addr, const T& v)
+    {
+        TEST_ASSERT(m_mem.do_write(addr, v, true) == tlm::TLM_OK_RESPONSE);
+    }
+
+    template <class T>
+    T mem_read(uint64_t addr)
+    {
+        T v{};
+        TEST_ASSERT(m_mem.do_read(addr, v, true) == tlm::TLM_OK_RESPONSE);
+        return v;
+    }
+
+    void setup_device()
+    {
+        TEST_ASSERT(reg_read(REG_MAGIC) == 0x74726976); /* "virt" */
+        TEST_ASSERT(reg_read(REG_VERSION) == 1);
+        TEST_ASSERT(reg_read(REG_DEVICE_ID) == 2);
+
+        reg_write(REG_STATUS, 0);
+        reg_write(REG_STATUS, 1 | 2); /* acknowledge, driver */
+        reg_write(REG_GUEST_FEATURES, 0);
+        reg_write(REG_GUEST_PAGE_SIZE, 0x1000);
+
+        reg_write(REG_QUEUE_SEL, 0);
+        TEST_ASSERT(reg_read(REG_QUEUE_NUM_MAX) >= QUEUE_SIZE);
+        reg_write(REG_QUEUE_NUM, QUEUE_SIZE);
+        reg_write(REG_QUEUE_ALIGN, 0x1000);
+        reg_write(REG_QUEUE_PFN, DESC_ADDR >> 12);
+        reg_write(REG_STATUS, 1 | 2 | 4); /* driver ok */
+
+        uint64_t capacity = reg_read(REG_CAPACITY) | uint64_t(reg_read(REG_CAPACITY + 4)) << 32;
+        TEST_ASSERT(capacity * 512 == image_size());
+    }
+
+    void set_desc(uint16_t i, uint64_t addr, uint32_t len, uint16_t flags, uint16_t next)
+    {
+        uint64_t d = DESC_ADDR + i * 16;
+        mem_write<uint64_t>(d, addr);
+        mem_write<uint32_t>(d + 8, len);
+        mem_write<uint16_t>(d + 12, flags);
+        mem_write<uint16_t>(d + 14, next);
+    }
+
+    /* A request uses the 3 descriptors of its slot: header, data and status */
+    void queue_request(int slot, uint32_t type, uint64_t offset)
+    {
+        uint16_t head = slot * 3;
+        uint64_t hdr = HDR_ADDR + slot * 16;
+        mem_write<uint32_t>(hdr, type);
+        mem_write<uint32_t>(hdr + 4, 0);
+        mem_write<uint64_t>(hdr + 8, offset / 512);
+        mem_write<uint8_t>(STATUS_ADDR + slot, 0xff);
+
+        set_desc(head, hdr, 16, DESC_F_NEXT, head + 1);
+        set_desc(head + 1, BUF_ADDR + slot * request_size(), request_size(),
+                 DESC_F_NEXT | (type == BLK_T_IN ? DESC_F_WRITE : 0), head + 2);
+        set_desc(head + 2, STATUS_ADDR + slot, 1, DESC_F_WRITE, 0);
+
+        mem_write<uint16_t>(AVAIL_ADDR + 4 + (m_avail_idx % QUEUE_SIZE) * 2, head);
+        m_avail_idx++;
+    }
+
+    void kick()
+    {
+        mem_write<uint16_t>(AVAIL_ADDR + 2, m_avail_idx);
+        reg_write(REG_QUEUE_NOTIFY, 0);
+    }
+
+    /* Wait for a request to complete, returns its slot */
+    int wait_request()
+    {
+        while (mem_read<uint16_t>(USED_ADDR + 2) == m_used_idx) {
+            wait(1, sc_core::SC_US);
+        }
+        uint32_t head = mem_read<uint32_t>(USED_ADDR + 4 + (m_used_idx % QUEUE_SIZE) * 8);
+        m_used_idx++;
+
+        uint32_t isr = reg_read(REG_INTERRUPT_STATUS);
+        if (isr) {
+            reg_write(REG_INTERRUPT_ACK, isr);
+        }
+
+        int slot = head / 3;
+        TEST_ASSERT(mem_read<uint8_t>(STATUS_ADDR + slot) == 0);
+        return slot;
+    }
+
+    /* The whole image, with depth requests in flight, returns the host time in s */
+    double run_pass(uint32_t type)
+    {
+        int depth = p_depth;
+        uint64_t nb = image_size() / request_size();
+        std::vector<uint64_t> offsets(depth);
+        uint64_t next = 0, done = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for (int s = 0; s < depth && next < nb; s++, next++) {
+            offsets[s] = next * request_size();
+            queue_request(s, type, offsets[s]);
+        }
+        kick();
+
+        while (done < nb) {
+            int s = wait_request();
+            done++;
+            if (type == BLK_T_IN) {
+                /* a word per request, not to measure the check */
+                uint64_t w = request_size() / 2;
+                TEST_ASSERT(mem_read<uint64_t>(BUF_ADDR + s * request_size() + w) == (MAGIC | (offsets[s] + w)));
+            }
+            if (next < nb) {
+                offsets[s] = (next++) * request_size();
+                queue_request(s, type, offsets[s]);
+                kick();
+            }
+        }
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void bench()
+    {
+        m_gpi->m_initiator.map_dmi_eagerly();
+        setup_device();
+
+        for (int p = 0; p < p_passes; p++) {
+            m_read_s += run_pass(BLK_T_IN);
+        }
+
+        for (int s = 0; s < p_depth; s++) {
+            for (uint64_t w = 0; w < request_size(); w += sizeof(uint64_t)) {
+                mem_write<uint64_t>(BUF_ADDR + s * request_size() + w, ~MAGIC);
+            }
+        }
+        for (int p = 0; p < p_passes; p++) {
+            m_write_s += run_pass(BLK_T_OUT);
+        }
+
+        /* the writes are seen by the device */
+        queue_request(0, BLK_T_IN, image_size() - request_size());
+        kick();
+        TEST_ASSERT(wait_request() == 0);
+        TEST_ASSERT(mem_read<uint64_t>(BUF_ADDR) == ~MAGIC);
+
+        m_done = true;
+        sc_core::sc_stop();
+    }
+
+public:
+    BlkThroughputBench(const sc_core::sc_module_name& n)
+        : TestBench(n)
+        , p_image_mb("image_mb", 256, "Size of the generated image, in MiB")
+        , p_request_kb("request_kb", 128, "Size of the requests, in KiB")
+        , p_depth("depth", 8, "Number of requests in flight")
+        , p_passes("passes", 2, "Number of passes over the image, for each direction")
+        , p_image("image", "blk-throughput.img", "Generated image file")
+        , m_report("blk-throughput")
+        , m_inst("inst", &m_inst_manager, qemu::Target::AARCH64)
+        , m_router("router")
+        , m_ram("ram", RAM_SIZE)
+        , m_mmio("mmio")
+        , m_mem("mem")
+    {
+        if (p_request_kb <= 0 || p_depth <= 0 || p_depth > int(QUEUE_SIZE / 3) ||
+            BUF_ADDR + uint64_t(p_depth) * request_size() > RAM_SIZE) {
+            SCP_FATAL(SCMOD) << "depth must be between 1 and " << QUEUE_SIZE / 3 << ", and fit its requests in "
+                             << (RAM_SIZE - BUF_ADDR) / (1024 * 1024) << "MiB";
+        }
+        if (p_image_mb <= 0 || image_size() % request_size()) {
+            SCP_FATAL(SCMOD) << "image_mb must be a multiple of request_kb";
+        }
+
+        generate_image();
+        cci::cci_get_broker().set_preset_cci_value(std::string(name()) + ".blk.blob_file",
+                                                   cci::cci_value(p_image.get_value()));
+
+        m_blk = std::make_unique<virtio_mmio_blk>("blk", m_inst);
+        m_gpi = std::make_unique<global_peripheral_initiator>("gpi", m_inst, *m_blk);
+
+        m_router.add_target(m_ram.socket, 0, RAM_SIZE);
+        m_router.add_initiator(m_gpi->m_initiator);
+        m_mem.socket.bind(m_router.target_socket);
+        m_mmio.socket.bind(m_blk->socket);
+
+        SC_HAS_PROCESS(BlkThroughputBench);
+        SC_THREAD(bench);
+    }
+
+    virtual void end_of_simulation() override
+    {
+        TestBench::end_of_simulation();
+
+        TEST_ASSERT(m_done);
+
+        std::string overlay = cci::cci_get_broker().get_cci_value(std::string(name()) + ".blk.overlay").get_string();
+        if (!overlay.empty()) {
+            uint64_t w = 0;
+            std::ifstream f(p_image.get_value(), std::ios::binary);
+            f.seekg(image_size() - request_size());
+            f.read(reinterpret_cast<char*>(&w), sizeof(w));
+            TEST_ASSERT(w == (MAGIC | (image_size() - request_size())));
+        }
+
+        double bytes = double(image_size()) * p_passes;
+        m_report.config("image_mb", p_image_mb);
+        m_report.config("request_kb", p_request_kb);
+        m_report.config("depth", p_depth);
+        for (const char* p : { "overlay", "aio", "cache" }) {
+            m_report.config(p, cci::cci_get_broker().get_cci_value(std::string(name()) + ".blk." + p).get_string());
+        }
+        m_report.config("iothread",
+                        cci::cci_get_broker().get_cci_value(std::string(name()) + ".blk.iothread").get_bool() ? 1 : 0);
+        m_report.result("read_throughput", bytes / m_read_s / 1e6, "MB/s");
+        m_report.result("write_throughput", bytes / m_write_s / 1e6, "MB/s");
+        TEST_ASSERT(m_report.write());
+
+        remove(p_image.get_value().c_str());
+    }
+};
+
+int sc_main(int argc, char* argv[]) { return run_testbench<BlkThroughputBench>(argc, argv); }
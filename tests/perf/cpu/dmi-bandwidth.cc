@@ -0,0 +1,130 @@
+/*
+ *  This file is part of libqbox
+ *  Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * DMI bandwidth: the CPU writes, then reads, a region of the bulk memory with
+ * 16 bytes pair stores and loads.
+ *
+ * A first pass writes the whole region so that the DMI pointers are in place
+ * (and the memory is allocated) before the measure. Stores to the tester mark
+ * the start of the writes, of the reads, and the end.
+ */
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+
+#include "test/cpu.h"
+#include "test/tester/mmio.h"
+
+#include "cortex-a53.h"
+#include "qemu-instance.h"
+
+#include "perf/bench-report.h"
+
+class DmiBandwidthBench : public CpuTestBench<cpu_arm_cortexA53, CpuTesterMmio>
+{
+public:
+    static constexpr const char* FIRMWARE = R"(
+        _start:
+            ldr x1, =0x%08)" PRIx64 R"(
+            ldr x4, =0x%08)" PRIx64 R"(
+            ldr x5, =0x%08)" PRIx64 R"(
+            ldr x7, =%d
+            add x8, x4, x5
+            mov x2, #1
+            mov x3, #2
+
+            mov x6, x4
+        warm:
+            stp x2, x3, [x6], #16
+            cmp x6, x8
+            b.ne warm
+
+            str xzr, [x1]
+            mov x9, x7
+        wpass:
+            mov x6, x4
+        wloop:
+            stp x2, x3, [x6], #16
+            cmp x6, x8
+            b.ne wloop
+            subs x9, x9, #1
+            b.ne wpass
+
+            str xzr, [x1, #8]
+            mov x9, x7
+        rpass:
+            mov x6, x4
+        rloop:
+            ldp x2, x3, [x6], #16
+            cmp x6, x8
+            b.ne rloop
+            subs x9, x9, #1
+            b.ne rpass
+
+            str xzr, [x1, #16]
+
+        end:
+            wfi
+            b end
+    )";
+
+private:
+    cci::cci_param<int> p_size_mb;
+    cci::cci_param<int> p_passes;
+    BenchReport m_report;
+
+    std::chrono::steady_clock::time_point m_marks[3];
+    int m_nb_marks = 0;
+
+public:
+    DmiBandwidthBench(const sc_core::sc_module_name& n)
+        : CpuTestBench<cpu_arm_cortexA53, CpuTesterMmio>(n)
+        , p_size_mb("size_mb", 64, "Size of the region, in MiB")
+        , p_passes("passes", 8, "Number of passes over the region, for each direction")
+        , m_report("dmi-bandwidth")
+    {
+        char buf[2048];
+
+        if (p_size_mb <= 0 || uint64_t(p_size_mb) * 1024 * 1024 > BULKMEM_SIZE) {
+            SCP_FATAL(SCMOD) << "size_mb must be between 1 and " << BULKMEM_SIZE / (1024 * 1024);
+        }
+
+        std::snprintf(buf, sizeof(buf), FIRMWARE, CpuTesterMmio::MMIO_ADDR, BULKMEM_ADDR,
+                      uint64_t(p_size_mb) * 1024 * 1024, p_passes.get_value());
+        set_firmware(buf);
+    }
+
+    virtual void mmio_write(int id, uint64_t addr, uint64_t data, size_t len) override
+    {
+        TEST_ASSERT(addr == uint64_t(m_nb_marks) * 8 && m_nb_marks < 3);
+        m_marks[m_nb_marks++] = std::chrono::steady_clock::now();
+    }
+
+    virtual void end_of_simulation() override
+    {
+        CpuTestBench<cpu_arm_cortexA53, CpuTesterMmio>::end_of_simulation();
+
+        TEST_ASSERT(m_nb_marks == 3);
+
+        double bytes = double(p_size_mb) * 1024 * 1024 * p_passes;
+        double write_s = std::chrono::duration<double>(m_marks[1] - m_marks[0]).count();
+        double read_s = std::chrono::duration<double>(m_marks[2] - m_marks[1]).count();
+
+        m_report.config("size_mb", p_size_mb);
+        m_report.config("passes", p_passes);
+        m_report.config("sync_policy", m_inst_a.p_sync_policy.get_value());
+        m_report.result("write_bandwidth", bytes / write_s / 1e6, "MB/s");
+        m_report.result("read_bandwidth", bytes / read_s / 1e6, "MB/s");
+        TEST_ASSERT(m_report.write());
+    }
+};
+
+constexpr const char* DmiBandwidthBench::FIRMWARE;
+
+int sc_main(int argc, char* argv[]) { return run_testbench<DmiBandwidthBench>(argc, argv); }
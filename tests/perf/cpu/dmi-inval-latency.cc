@@ -0,0 +1,124 @@
+/*
+ *  This file is part of libqbox
+ *  Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * DMI invalidation latency: host time of invalidate_direct_mem_ptr while the
+ * CPU uses the region, and of the following refill.
+ *
+ * The CPU loads from the DMI region of the tester and reports on the MMIO
+ * socket, where the bench invalidates the region. The next load goes through
+ * a new DMI request, the time from the invalidation to the next report is the
+ * refill.
+ */
+
+#include <cinttypes>
+#include <cstdio>
+
+#include "test/cpu.h"
+#include "test/tester/dmi.h"
+
+#include "cortex-a53.h"
+#include "qemu-instance.h"
+
+#include "perf/bench-report.h"
+
+class DmiInvalLatencyBench : public CpuTestBench<cpu_arm_cortexA53, CpuTesterDmi>
+{
+public:
+    static constexpr const char* FIRMWARE = R"(
+        _start:
+            ldr x1, =0x%08)" PRIx64 R"(
+            ldr x4, =0x%08)" PRIx64 R"(
+            ldr x7, =%d
+
+        loop:
+            ldr x0, [x4]
+            str x0, [x1]
+            subs x7, x7, #1
+            b.ne loop
+
+            str xzr, [x1, #8]
+
+        end:
+            wfi
+            b end
+    )";
+
+private:
+    cci::cci_param<int> p_invalidations;
+    BenchReport m_report;
+
+    LatencyStats m_inval;
+    LatencyStats m_refill;
+    int m_nb_reports = 0;
+    int m_nb_requests = 0;
+    bool m_done = false;
+
+public:
+    DmiInvalLatencyBench(const sc_core::sc_module_name& n)
+        : CpuTestBench<cpu_arm_cortexA53, CpuTesterDmi>(n)
+        , p_invalidations("invalidations", 10000, "Number of invalidations")
+        , m_report("dmi-inval-latency")
+    {
+        char buf[1024];
+
+        std::snprintf(buf, sizeof(buf), FIRMWARE, CpuTesterDmi::MMIO_ADDR, CpuTesterDmi::DMI_ADDR,
+                      p_invalidations.get_value());
+        set_firmware(buf);
+    }
+
+    virtual uint64_t mmio_read(int id, uint64_t addr, size_t len) override
+    {
+        /* the load before a DMI pointer is granted */
+        TEST_ASSERT(id == CpuTesterDmi::SOCKET_DMI);
+        return 0;
+    }
+
+    virtual bool dmi_request(int id, uint64_t addr, size_t len, tlm::tlm_dmi& ret) override
+    {
+        m_nb_requests++;
+        return true;
+    }
+
+    virtual void mmio_write(int id, uint64_t addr, uint64_t data, size_t len) override
+    {
+        TEST_ASSERT(id == CpuTesterDmi::SOCKET_MMIO);
+        if (addr == 8) {
+            m_refill.stop();
+            m_done = true;
+            return;
+        }
+        TEST_ASSERT(addr == 0);
+
+        if (m_nb_reports++) {
+            m_refill.stop();
+        }
+        m_inval.start();
+        m_tester.dmi_invalidate();
+        m_inval.stop();
+        m_refill.start();
+    }
+
+    virtual void end_of_simulation() override
+    {
+        CpuTestBench<cpu_arm_cortexA53, CpuTesterDmi>::end_of_simulation();
+
+        TEST_ASSERT(m_done && m_nb_reports == p_invalidations);
+        /* each invalidation is followed by a new request */
+        TEST_ASSERT(m_nb_requests >= p_invalidations);
+
+        m_report.config("invalidations", p_invalidations);
+        m_report.config("sync_policy", m_inst_a.p_sync_policy.get_value());
+        m_inval.report(m_report, "invalidate");
+        m_refill.report(m_report, "refill");
+        TEST_ASSERT(m_report.write());
+    }
+};
+
+constexpr const char* DmiInvalLatencyBench::FIRMWARE;
+
+int sc_main(int argc, char* argv[]) { return run_testbench<DmiInvalLatencyBench>(argc, argv); }
@@ -0,0 +1,164 @@
+/*
+ *  This file is part of libqbox
+ *  Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * IRQ round trip: host time from raising the IRQ line of a CPU in SystemC to
+ * the first store of its interrupt handler.
+ *
+ * The CPU (which starts at EL3) routes the IRQs to EL3, unmasks them and
+ * waits in wfi. The handler acknowledges with a store to the tester, then
+ * polls the level of the line until the bench lowers it, and returns.
+ */
+
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+
+#include <async_event.h>
+
+#include "test/cpu.h"
+#include "test/tester/mmio.h"
+
+#include "cortex-a53.h"
+#include "qemu-instance.h"
+
+#include "perf/bench-report.h"
+
+class IrqLatencyBench : public CpuTestBench<cpu_arm_cortexA53, CpuTesterMmio>
+{
+public:
+    static constexpr const char* FIRMWARE = R"(
+        _start:
+            ldr x1, =0x%08)" PRIx64 R"(
+
+            mrs x0, scr_el3
+            orr x0, x0, #2
+            msr scr_el3, x0
+            msr vbar_el3, xzr
+            isb
+            msr daifclr, #2
+
+            str xzr, [x1]
+
+        end:
+            wfi
+            b end
+    )";
+
+    /* Current EL with SPx, IRQ */
+    static constexpr uint64_t HANDLER_ADDR = 0x280;
+    static constexpr const char* HANDLER = R"(
+            str xzr, [x1, #8]
+        poll:
+            ldr x0, [x1, #16]
+            cbnz x0, poll
+            eret
+    )";
+
+private:
+    cci::cci_param<int> p_rounds;
+    BenchReport m_report;
+
+    sc_core::sc_vector<InitiatorSignalSocket<bool>> m_irqs;
+
+    std::atomic<bool> m_ready{ false };
+    std::atomic<int> m_acks{ 0 };
+    std::atomic<bool> m_level{ false };
+    gs::async_event m_ev{ false };
+
+    LatencyStats m_latency;
+    bool m_done = false;
+
+    /* Wait until cond holds, cond being set by the vCPU */
+    template <class COND>
+    void wait_for_cpu(COND cond)
+    {
+        m_ev.async_attach_suspending();
+        while (!cond()) {
+            wait(m_ev);
+        }
+        m_ev.async_detach_suspending();
+    }
+
+    void bench()
+    {
+        wait_for_cpu([this] { return m_ready.load(); });
+
+        for (int i = 0; i < p_rounds; i++) {
+            m_level = true;
+            m_latency.start();
+            m_irqs[0]->write(true);
+            wait_for_cpu([this, i] { return m_acks > i; });
+            m_latency.stop();
+
+            m_level = false;
+            m_irqs[0]->write(false);
+            wait(1, sc_core::SC_US);
+        }
+
+        m_done = true;
+        sc_core::sc_stop();
+    }
+
+public:
+    IrqLatencyBench(const sc_core::sc_module_name& n)
+        : CpuTestBench<cpu_arm_cortexA53, CpuTesterMmio>(n)
+        , p_rounds("rounds", 10000, "Number of interrupts")
+        , m_report("irq-latency")
+        , m_irqs("irq", p_num_cpu)
+    {
+        char buf[1024];
+
+        std::snprintf(buf, sizeof(buf), FIRMWARE, CpuTesterMmio::MMIO_ADDR);
+        set_firmware(buf);
+        set_firmware(HANDLER, HANDLER_ADDR);
+
+        map_irqs_to_cpus(m_irqs);
+
+        SC_HAS_PROCESS(IrqLatencyBench);
+        SC_THREAD(bench);
+    }
+
+    virtual uint64_t mmio_read(int id, uint64_t addr, size_t len) override
+    {
+        TEST_ASSERT(addr == 16);
+        return m_level;
+    }
+
+    virtual void mmio_write(int id, uint64_t addr, uint64_t data, size_t len) override
+    {
+        switch (addr) {
+        case 0:
+            m_ready = true;
+            break;
+        case 8:
+            m_acks++;
+            break;
+        default:
+            TEST_FAIL("Unexpected CPU write");
+        }
+        m_ev.async_notify();
+    }
+
+    virtual void end_of_simulation() override
+    {
+        CpuTestBench<cpu_arm_cortexA53, CpuTesterMmio>::end_of_simulation();
+
+        TEST_ASSERT(m_done && m_acks == p_rounds);
+
+        m_report.config("rounds", p_rounds);
+        m_report.config("quantum_ns", p_quantum_ns);
+        m_report.config("sync_policy", m_inst_a.p_sync_policy.get_value());
+        m_latency.report(m_report, "irq_to_handler");
+        TEST_ASSERT(m_report.write());
+    }
+};
+
+constexpr const char* IrqLatencyBench::FIRMWARE;
+constexpr const char* IrqLatencyBench::HANDLER;
+
+int sc_main(int argc, char* argv[]) { return run_testbench<IrqLatencyBench>(argc, argv); }
@@ -0,0 +1,109 @@
+/*
+ *  This file is part of libqbox
+ *  Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Guest instructions per host second, on a loop of four integer instructions
+ * which never leaves the CPU. Two stores to the tester mark the start and the
+ * end of the loop.
+ */
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+
+#include "test/cpu.h"
+#include "test/tester/mmio.h"
+
+#include "cortex-a53.h"
+#include "qemu-instance.h"
+
+#include "perf/bench-report.h"
+
+class MipsBench : public CpuTestBench<cpu_arm_cortexA53, CpuTesterMmio>
+{
+public:
+    static constexpr int LOOP_INSNS = 4;
+
+    static constexpr const char* FIRMWARE = R"(
+        _start:
+            ldr x1, =0x%08)" PRIx64 R"(
+            ldr x0, =%llu
+            mov x2, #0
+            mov x3, #0
+
+            str xzr, [x1]
+        loop:
+            add x2, x2, #1
+            eor x3, x3, x2
+            subs x0, x0, #1
+            b.ne loop
+            str x3, [x1, #8]
+
+        end:
+            wfi
+            b end
+    )";
+
+private:
+    cci::cci_param<uint64_t> p_iterations;
+    BenchReport m_report;
+
+    std::chrono::steady_clock::time_point m_start;
+    double m_seconds = 0;
+    sc_core::sc_time m_sc_start;
+    sc_core::sc_time m_sc_time;
+
+public:
+    MipsBench(const sc_core::sc_module_name& n)
+        : CpuTestBench<cpu_arm_cortexA53, CpuTesterMmio>(n)
+        , p_iterations("iterations", 100000000, "Number of iterations of the loop")
+        , m_report("mips")
+    {
+        char buf[1024];
+
+        std::snprintf(buf, sizeof(buf), FIRMWARE, CpuTesterMmio::MMIO_ADDR,
+                      (unsigned long long)p_iterations.get_value());
+        set_firmware(buf);
+    }
+
+    virtual void mmio_write(int id, uint64_t addr, uint64_t data, size_t len) override
+    {
+        switch (addr) {
+        case 0:
+            m_start = std::chrono::steady_clock::now();
+            m_sc_start = sc_core::sc_time_stamp();
+            break;
+        case 8:
+            m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+            m_sc_time = sc_core::sc_time_stamp() - m_sc_start;
+            break;
+        default:
+            TEST_FAIL("Unexpected CPU write");
+        }
+    }
+
+    virtual void end_of_simulation() override
+    {
+        CpuTestBench<cpu_arm_cortexA53, CpuTesterMmio>::end_of_simulation();
+
+        TEST_ASSERT(m_seconds > 0);
+
+        double insns = double(p_iterations) * LOOP_INSNS;
+        m_report.config("iterations", p_iterations);
+        m_report.config("quantum_ns", p_quantum_ns);
+        m_report.config("sync_policy", m_inst_a.p_sync_policy.get_value());
+        m_report.config("icount", m_inst_a.p_icount.get_value() ? "true" : "false");
+        m_report.result("mips", insns / m_seconds / 1e6, "MIPS");
+        m_report.result("host_time", m_seconds, "s");
+        m_report.result("sim_time", m_sc_time.to_seconds(), "s");
+        TEST_ASSERT(m_report.write());
+    }
+};
+
+constexpr const char* MipsBench::FIRMWARE;
+
+int sc_main(int argc, char* argv[]) { return run_testbench<MipsBench>(argc, argv); }
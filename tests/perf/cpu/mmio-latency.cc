@@ -0,0 +1,126 @@
+/*
+ *  This file is part of libqbox
+ *  Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * MMIO round-trip latency: host time of a guest store or load to a SystemC
+ * target, from the vCPU through the router and back.
+ *
+ * The CPU does a number of stores to the tester, then as many loads, and a
+ * last store at offset 16 to mark the end. The time between two consecutive
+ * accesses is one round trip (the few instructions in between are
+ * negligible).
+ */
+
+#include <cinttypes>
+#include <cstdio>
+
+#include "test/cpu.h"
+#include "test/tester/mmio.h"
+
+#include "cortex-a53.h"
+#include "qemu-instance.h"
+
+#include "perf/bench-report.h"
+
+class MmioLatencyBench : public CpuTestBench<cpu_arm_cortexA53, CpuTesterMmio>
+{
+public:
+    static constexpr const char* FIRMWARE = R"(
+        _start:
+            ldr x1, =0x%08)" PRIx64 R"(
+            ldr x2, =%d
+
+            mov x0, x2
+        write:
+            str x0, [x1]
+            subs x0, x0, #1
+            b.ne write
+
+            mov x0, x2
+        read:
+            ldr x3, [x1, #8]
+            subs x0, x0, #1
+            b.ne read
+
+            str x0, [x1, #16]
+
+        end:
+            wfi
+            b end
+    )";
+
+private:
+    cci::cci_param<int> p_accesses;
+    BenchReport m_report;
+
+    LatencyStats m_writes;
+    LatencyStats m_reads;
+    int m_nb_writes = 0;
+    int m_nb_reads = 0;
+    bool m_done = false;
+
+    void lap(LatencyStats& stats, int& count)
+    {
+        if (count++) {
+            stats.stop();
+        }
+        stats.start();
+    }
+
+public:
+    MmioLatencyBench(const sc_core::sc_module_name& n)
+        : CpuTestBench<cpu_arm_cortexA53, CpuTesterMmio>(n)
+        , p_accesses("accesses", 100000, "Number of stores, and of loads")
+        , m_report("mmio-latency")
+    {
+        char buf[1024];
+
+        std::snprintf(buf, sizeof(buf), FIRMWARE, CpuTesterMmio::MMIO_ADDR, p_accesses.get_value());
+        set_firmware(buf);
+    }
+
+    virtual uint64_t mmio_read(int id, uint64_t addr, size_t len) override
+    {
+        TEST_ASSERT(addr == 8);
+        if (!m_nb_reads) {
+            /* the first load ends the last store */
+            m_writes.stop();
+        }
+        lap(m_reads, m_nb_reads);
+        return 0;
+    }
+
+    virtual void mmio_write(int id, uint64_t addr, uint64_t data, size_t len) override
+    {
+        if (addr == 16) {
+            m_reads.stop();
+            m_done = true;
+            return;
+        }
+        TEST_ASSERT(addr == 0);
+        lap(m_writes, m_nb_writes);
+    }
+
+    virtual void end_of_simulation() override
+    {
+        CpuTestBench<cpu_arm_cortexA53, CpuTesterMmio>::end_of_simulation();
+
+        TEST_ASSERT(m_done);
+        TEST_ASSERT(m_nb_writes == p_accesses && m_nb_reads == p_accesses);
+
+        m_report.config("accesses", p_accesses);
+        m_report.config("quantum_ns", p_quantum_ns);
+        m_report.config("sync_policy", m_inst_a.p_sync_policy.get_value());
+        m_writes.report(m_report, "write");
+        m_reads.report(m_report, "read");
+        TEST_ASSERT(m_report.write());
+    }
+};
+
+constexpr const char* MmioLatencyBench::FIRMWARE;
+
+int sc_main(int argc, char* argv[]) { return run_testbench<MmioLatencyBench>(argc, argv); }
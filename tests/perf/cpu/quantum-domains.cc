@@ -0,0 +1,170 @@
+/*
+ *  This file is part of libqbox
+ *  Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Throughput of a platform with two quantum domains: a tightly coupled "dsp"
+ * CPU (instance inst_a) with the global quantum, and a loosely coupled "apps"
+ * CPU (instance inst_b) with a larger quantum. Both run the loop of the mips
+ * bench, marking its start and its end with two stores to the tester (at
+ * CPU index * 16). Run it with inst_b.quantum_ns=0 to compare with a single
+ * quantum.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "test/cpu.h"
+#include "test/tester/mmio.h"
+
+#include "cortex-a53.h"
+#include "qemu-instance.h"
+
+#include "perf/bench-report.h"
+
+class QuantumDomainsBench : public CpuTestBench<cpu_arm_cortexA53, CpuTesterMmio>
+{
+public:
+    static constexpr int LOOP_INSNS = 4;
+    static constexpr int NUM_DOMAINS = 2;
+
+    static constexpr const char* FIRMWARE = R"(
+        _start:
+            ldr x1, =0x%08)" PRIx64 R"(
+
+            mrs x0, mpidr_el1
+            and x2, x0, #0xff
+            and x0, x0, #0xff00
+            lsr x0, x0, #5
+            orr x0, x0, x2
+            lsl x0, x0, #4
+            add x1, x1, x0
+
+            ldr x0, =%llu
+            mov x2, #0
+            mov x3, #0
+
+            str xzr, [x1]
+        loop:
+            add x2, x2, #1
+            eor x3, x3, x2
+            subs x0, x0, #1
+            b.ne loop
+            str x3, [x1, #8]
+
+        end:
+            wfi
+            b end
+    )";
+
+private:
+    struct Domain {
+        std::chrono::steady_clock::time_point start;
+        double seconds = 0;
+        sc_core::sc_time sc_start;
+        sc_core::sc_time sc_time;
+    };
+
+    cci::cci_param<uint64_t> p_iterations;
+    BenchReport m_report;
+
+    std::vector<Domain> m_domains;
+    std::chrono::steady_clock::time_point m_first_start;
+    std::chrono::steady_clock::time_point m_last_end;
+
+public:
+    QuantumDomainsBench(const sc_core::sc_module_name& n)
+        : CpuTestBench<cpu_arm_cortexA53, CpuTesterMmio>(n)
+        , p_iterations("iterations", 100000000, "Number of iterations of the loop, in each domain")
+        , m_report("quantum-domains")
+        , m_domains(NUM_DOMAINS)
+    {
+        char buf[1024];
+
+        if (p_num_cpu.get_value() != NUM_DOMAINS) {
+            SCP_FATAL(SCMOD) << "One CPU per domain is expected, num_cpu must be " << NUM_DOMAINS;
+        }
+
+        std::snprintf(buf, sizeof(buf), FIRMWARE, CpuTesterMmio::MMIO_ADDR,
+                      (unsigned long long)p_iterations.get_value());
+        set_firmware(buf);
+    }
+
+    virtual void mmio_write(int id, uint64_t addr, uint64_t data, size_t len) override
+    {
+        size_t cpu = addr >> 4;
+        TEST_ASSERT(cpu < m_domains.size());
+        Domain& d = m_domains[cpu];
+        auto now = std::chrono::steady_clock::now();
+
+        switch (addr & 0xf) {
+        case 0:
+            d.start = now;
+            d.sc_start = sc_core::sc_time_stamp();
+            if (m_first_start == std::chrono::steady_clock::time_point() || now < m_first_start) {
+                m_first_start = now;
+            }
+            break;
+        case 8:
+            d.seconds = std::chrono::duration<double>(now - d.start).count();
+            d.sc_time = sc_core::sc_time_stamp() - d.sc_start;
+            m_last_end = std::max(m_last_end, now);
+            break;
+        default:
+            TEST_FAIL("Unexpected CPU write");
+        }
+    }
+
+    virtual void end_of_simulation() override
+    {
+        CpuTestBench<cpu_arm_cortexA53, CpuTesterMmio>::end_of_simulation();
+
+        /* CPU 0 is in inst_a, CPU 1 in inst_b */
+        const char* names[NUM_DOMAINS] = { "dsp", "apps" };
+        QemuInstance* insts[NUM_DOMAINS] = { &m_inst_a, &m_inst_b };
+        double insns = double(p_iterations) * LOOP_INSNS;
+        double seconds = std::chrono::duration<double>(m_last_end - m_first_start).count();
+
+        m_report.config("iterations", p_iterations);
+        m_report.config("quantum_ns", p_quantum_ns);
+        m_report.config("sync_policy", m_inst_a.p_sync_policy.get_value());
+        for (int i = 0; i < NUM_DOMAINS; i++) {
+            std::string name = names[i];
+            TEST_ASSERT(m_domains[i].seconds > 0);
+            m_report.config(name + "_quantum_ns", insts[i]->get_quantum().to_seconds() * 1e9);
+            m_report.result(name + "_mips", insns / m_domains[i].seconds / 1e6, "MIPS");
+            m_report.result(name + "_host_time", m_domains[i].seconds, "s");
+            m_report.result(name + "_sim_time", m_domains[i].sc_time.to_seconds(), "s");
+        }
+        m_report.result("mips", NUM_DOMAINS * insns / seconds / 1e6, "MIPS");
+        m_report.result("host_time", seconds, "s");
+        TEST_ASSERT(m_report.write());
+    }
+};
+
+constexpr const char* QuantumDomainsBench::FIRMWARE;
+
+int sc_main(int argc, char* argv[])
+{
+    /* the default domains, before the command line arguments which can change them */
+    std::vector<char*> args(argv, argv + 1);
+    const char* defaults[] = {
+        "-p", "test-bench.num_cpu=2",                 /* one CPU per domain */
+        "-p", "test-bench.quantum_ns=10000",          /* the global quantum, of the dsp domain */
+        "-p", "test-bench.inst_b.quantum_ns=1000000", /* the apps domain */
+    };
+    for (const char* arg : defaults) {
+        args.push_back(const_cast<char*>(arg));
+    }
+    args.insert(args.end(), argv + 1, argv + argc);
+    args.push_back(nullptr);
+
+    return run_testbench<QuantumDomainsBench>(args.size() - 1, args.data());
+}
@@ -0,0 +1,146 @@
+/*
+ *  This file is part of libqbox
+ *  Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef TESTS_PERF_BENCH_REPORT_H
+#define TESTS_PERF_BENCH_REPORT_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <systemc>
+#include <cci_configuration>
+#include <scp/report.h>
+
+/**
+ * @class BenchReport
+ *
+ * @brief The results of a performance benchmark, written as a JSON object
+ *
+ * @details {"bench": name, "config": {key: value...}, "results": {key:
+ * {"value": v, "unit": u}...}}. The results are logged, and written to the
+ * file given by the "report" parameter of the bench (if not empty).
+ */
+class BenchReport
+{
+    std::string m_bench;
+    std::vector<std::pair<std::string, std::string>> m_config;
+    std::vector<std::pair<std::string, std::pair<double, std::string>>> m_results;
+
+    static std::string quote(const std::string& s) { return "\"" + s + "\""; }
+
+public:
+    cci::cci_param<std::string> p_report;
+
+    BenchReport(const std::string& bench)
+        : m_bench(bench), p_report("report", bench + ".json", "File where to write the results (none if empty)")
+    {
+    }
+
+    void config(const std::string& key, const std::string& value) { m_config.emplace_back(key, quote(value)); }
+    void config(const std::string& key, double value)
+    {
+        std::ostringstream ss;
+        ss << value;
+        m_config.emplace_back(key, ss.str());
+    }
+
+    void result(const std::string& key, double value, const std::string& unit)
+    {
+        m_results.emplace_back(key, std::make_pair(value, unit));
+    }
+
+    std::string to_json() const
+    {
+        std::ostringstream ss;
+        ss.precision(10);
+        ss << "{\"bench\": " << quote(m_bench) << ", \"config\": {";
+        for (size_t i = 0; i < m_config.size(); i++) {
+            ss << (i ? ", " : "") << quote(m_config[i].first) << ": " << m_config[i].second;
+        }
+        ss << "}, \"results\": {";
+        for (size_t i = 0; i < m_results.size(); i++) {
+            ss << (i ? ", " : "") << quote(m_results[i].first) << ": {\"value\": " << m_results[i].second.first
+               << ", \"unit\": " << quote(m_results[i].second.second) << "}";
+        }
+        ss << "}}";
+        return ss.str();
+    }
+
+    /* Log the results and write them to the report file */
+    bool write() const
+    {
+        std::string json = to_json();
+        SCP_INFO("perf") << json;
+        if (p_report.get_value().empty()) {
+            return true;
+        }
+        std::ofstream f(p_report.get_value());
+        f << json << "\n";
+        return f.good();
+    }
+};
+
+/**
+ * @class LatencyStats
+ *
+ * @brief Host time samples, in ns
+ */
+class LatencyStats
+{
+    std::vector<double> m_samples;
+    std::chrono::steady_clock::time_point m_start;
+
+public:
+    void start() { m_start = std::chrono::steady_clock::now(); }
+
+    void stop()
+    {
+        m_samples.push_back(
+            std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - m_start).count());
+    }
+
+    void add(double ns) { m_samples.push_back(ns); }
+
+    size_t count() const { return m_samples.size(); }
+
+    double mean() const
+    {
+        double sum = 0;
+        for (double s : m_samples) {
+            sum += s;
+        }
+        return m_samples.empty() ? 0 : sum / m_samples.size();
+    }
+
+    /* p in [0, 1] */
+    double percentile(double p) const
+    {
+        if (m_samples.empty()) {
+            return 0;
+        }
+        std::vector<double> sorted(m_samples);
+        std::sort(sorted.begin(), sorted.end());
+        return sorted[std::min(sorted.size() - 1, size_t(p * sorted.size()))];
+    }
+
+    /* Add the mean, median, 99th percentile and maximum to a report */
+    void report(BenchReport& r, const std::string& key) const
+    {
+        r.result(key + "_mean", mean(), "ns");
+        r.result(key + "_p50", percentile(0.5), "ns");
+        r.result(key + "_p99", percentile(0.99), "ns");
+        r.result(key + "_max", percentile(1), "ns");
+    }
+};
+
+#endif
@@ -0,0 +1,18 @@
+# Merge the results of the benchmarks in RESULTS_DIR into qbox-perf.json:
+# {"version": ..., "date": ..., "benches": [<result of each bench>...]}
+
+file(GLOB _results ${RESULTS_DIR}/perf-*.json)
+list(SORT _results)
+
+set(_benches "")
+foreach(_f ${_results})
+    file(READ ${_f} _json)
+    string(STRIP "${_json}" _json)
+    list(APPEND _benches "${_json}")
+endforeach()
+string(REPLACE ";" ",\n  " _benches "${_benches}")
+
+string(TIMESTAMP _date "%Y-%m-%dT%H:%M:%SZ" UTC)
+file(WRITE ${RESULTS_DIR}/qbox-perf.json
+     "{\"version\": \"${VERSION}\", \"date\": \"${_date}\", \"benches\": [\n  ${_benches}\n]}\n")
+message(STATUS "Performance results in ${RESULTS_DIR}/qbox-perf.json")
@@ -0,0 +1,46 @@
+/*
+ *  This file is part of libqbox
+ *  Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Child process of the PassRPC latency bench: a memory behind the pass.
+ */
+
+#include <systemc>
+#include <tlm>
+#include <cci_configuration>
+#include <scp/report.h>
+
+#include <libgsutils.h>
+
+#include "gs_memory.h"
+#include "remote.h"
+
+class RemoteLatencyRemote : public sc_core::sc_module
+{
+    gs::PassRPC<> m_pass;
+    gs::gs_memory<> m_mem;
+
+public:
+    RemoteLatencyRemote(const sc_core::sc_module_name& n)
+        : sc_core::sc_module(n), m_pass("remote_pass"), m_mem("mem", 0x1000)
+    {
+        m_pass.initiator_sockets[0].bind(m_mem.socket);
+    }
+};
+
+int sc_main(int argc, char* argv[])
+{
+    try {
+        gs::ConfigurableBroker m_broker;
+        RemoteLatencyRemote remote("remote");
+        sc_core::sc_start();
+    } catch (const std::exception& exc) {
+        std::cerr << "Error: '" << exc.what() << "'\n";
+        exit(1);
+    }
+    return 0;
+}
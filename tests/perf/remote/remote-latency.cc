@@ -0,0 +1,118 @@
+/*
+ *  This file is part of libqbox
+ *  Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * PassRPC latency: host time of a b_transport to a memory in another
+ * process, through the pass and back.
+ */
+
+#include <string>
+
+#include <unistd.h>
+
+#include <systemc>
+#include <tlm>
+#include <tlm_utils/simple_initiator_socket.h>
+
+#include "remote.h"
+#include <tlm_sockets_buswidth.h>
+
+#include "test/test.h"
+#include "perf/bench-report.h"
+
+class RemoteLatencyBench : public TestBench
+{
+    gs::PassRPC<> m_pass;
+    cci::cci_param<int> p_accesses;
+    BenchReport m_report;
+
+    tlm_utils::simple_initiator_socket<RemoteLatencyBench, DEFAULT_TLM_BUSWIDTH> m_socket;
+
+    LatencyStats m_writes;
+    LatencyStats m_reads;
+
+    void access(tlm::tlm_command cmd, LatencyStats& stats, uint64_t addr, uint64_t& data)
+    {
+        tlm::tlm_generic_payload txn;
+        sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
+
+        txn.set_command(cmd);
+        txn.set_address(addr);
+        txn.set_data_ptr(reinterpret_cast<unsigned char*>(&data));
+        txn.set_data_length(sizeof(data));
+        txn.set_streaming_width(sizeof(data));
+        txn.set_byte_enable_length(0);
+        txn.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+
+        stats.start();
+        m_socket->b_transport(txn, delay);
+        stats.stop();
+
+        TEST_ASSERT(txn.is_response_ok());
+    }
+
+    void bench()
+    {
+        for (int i = 0; i < p_accesses; i++) {
+            uint64_t addr = (i * 8) % 0x1000;
+            uint64_t v = i, r = 0;
+            access(tlm::TLM_WRITE_COMMAND, m_writes, addr, v);
+            access(tlm::TLM_READ_COMMAND, m_reads, addr, r);
+            TEST_ASSERT(r == v);
+        }
+        sc_core::sc_stop();
+    }
+
+public:
+    RemoteLatencyBench(const sc_core::sc_module_name& n)
+        : TestBench(n)
+        , m_pass("pass")
+        , p_accesses("accesses", 10000, "Number of writes, and of reads")
+        , m_report("remote-latency")
+        , m_socket("initiator_socket")
+    {
+        m_socket.bind(m_pass.target_sockets[0]);
+
+        SC_HAS_PROCESS(RemoteLatencyBench);
+        SC_THREAD(bench);
+    }
+
+    virtual void end_of_simulation() override
+    {
+        TestBench::end_of_simulation();
+
+        TEST_ASSERT(m_writes.count() == size_t(p_accesses));
+
+        m_report.config("accesses", p_accesses);
+        m_writes.report(m_report, "write");
+        m_reads.report(m_report, "read");
+        TEST_ASSERT(m_report.write());
+    }
+};
+
+static std::string exe_path()
+{
+    char path[1024];
+    ssize_t n = readlink("/proc/self/exe", path, sizeof(path));
+    return std::string(path, n > 0 ? n : 0);
+}
+
+int sc_main(int argc, char* argv[])
+{
+    scp::init_logging(scp::LogConfig().fileInfoFrom(sc_core::SC_ERROR).logAsync(false).logLevel(scp::log::INFO));
+    gs::ConfigurableBroker m_broker({
+        { "test-bench.pass.tlm_target_ports_num", cci::cci_value(1) },
+        { "test-bench.pass.remote_pass.tlm_initiator_ports_num", cci::cci_value(1) },
+        { "test-bench.pass.exec_path", cci::cci_value(exe_path() + "-remote") },
+    });
+    cci::cci_originator orig{ "sc_main" };
+    ArgParser ap{ m_broker.create_broker_handle(orig), argc, argv };
+
+    RemoteLatencyBench test_bench("test-bench");
+    test_bench.run();
+    return test_bench.get_rc();
+}
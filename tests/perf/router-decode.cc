@@ -0,0 +1,134 @@
+/*
+ *  This file is part of libqbox
+ *  Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ *  SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Router decode cost versus the number of targets: host time of a
+ * b_transport through routers of 1 to 4096 targets which do nothing, to the
+ * first and to the last target of the address map.
+ */
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <systemc>
+#include <tlm>
+#include <tlm_utils/simple_initiator_socket.h>
+#include <tlm_utils/simple_target_socket.h>
+
+#include <router.h>
+#include <tlm_sockets_buswidth.h>
+
+#include "test/test.h"
+#include "perf/bench-report.h"
+
+class NullTarget : public sc_core::sc_module
+{
+    void b_transport(tlm::tlm_generic_payload& txn, sc_core::sc_time& delay)
+    {
+        txn.set_response_status(tlm::TLM_OK_RESPONSE);
+    }
+
+public:
+    tlm_utils::simple_target_socket<NullTarget, DEFAULT_TLM_BUSWIDTH> socket;
+
+    NullTarget(const sc_core::sc_module_name& n): sc_core::sc_module(n), socket("target_socket")
+    {
+        socket.register_b_transport(this, &NullTarget::b_transport);
+    }
+};
+
+class RouterUnderTest : public sc_core::sc_module
+{
+public:
+    static constexpr uint64_t TARGET_SIZE = 0x1000;
+
+    size_t nb_targets;
+    tlm_utils::simple_initiator_socket<RouterUnderTest, DEFAULT_TLM_BUSWIDTH> socket;
+    gs::router<> router;
+    sc_core::sc_vector<NullTarget> targets;
+
+    RouterUnderTest(const sc_core::sc_module_name& n, size_t nb)
+        : sc_core::sc_module(n), nb_targets(nb), socket("initiator_socket"), router("router"), targets("target", nb)
+    {
+        socket.bind(router.target_socket);
+        for (size_t i = 0; i < nb; i++) {
+            router.add_target(targets[i].socket, i * TARGET_SIZE, TARGET_SIZE);
+        }
+    }
+};
+
+class RouterDecodeBench : public TestBench
+{
+    static constexpr size_t TARGET_COUNTS[] = { 1, 16, 256, 4096 };
+
+    cci::cci_param<int> p_accesses;
+    BenchReport m_report;
+
+    std::vector<std::unique_ptr<RouterUnderTest>> m_routers;
+
+    double time_accesses(RouterUnderTest& r, uint64_t addr)
+    {
+        uint32_t data = 0;
+        tlm::tlm_generic_payload txn;
+        sc_core::sc_time delay;
+
+        txn.set_command(tlm::TLM_WRITE_COMMAND);
+        txn.set_data_ptr(reinterpret_cast<unsigned char*>(&data));
+        txn.set_data_length(sizeof(data));
+        txn.set_streaming_width(sizeof(data));
+        txn.set_byte_enable_length(0);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < p_accesses; i++) {
+            txn.set_address(addr);
+            txn.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+            delay = sc_core::SC_ZERO_TIME;
+            r.socket->b_transport(txn, delay);
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        TEST_ASSERT(txn.is_response_ok());
+        return ns / p_accesses;
+    }
+
+    void bench()
+    {
+        for (auto& r : m_routers) {
+            std::string n = std::to_string(r->nb_targets);
+            m_report.result("first_of_" + n, time_accesses(*r, 0), "ns");
+            m_report.result("last_of_" + n, time_accesses(*r, (r->nb_targets - 1) * RouterUnderTest::TARGET_SIZE),
+                            "ns");
+        }
+        sc_core::sc_stop();
+    }
+
+public:
+    RouterDecodeBench(const sc_core::sc_module_name& n)
+        : TestBench(n), p_accesses("accesses", 1000000, "Number of accesses per measure"), m_report("router-decode")
+    {
+        for (size_t nb : TARGET_COUNTS) {
+            m_routers.emplace_back(new RouterUnderTest(("router_" + std::to_string(nb)).c_str(), nb));
+        }
+
+        SC_HAS_PROCESS(RouterDecodeBench);
+        SC_THREAD(bench);
+    }
+
+    virtual void end_of_simulation() override
+    {
+        TestBench::end_of_simulation();
+
+        m_report.config("accesses", p_accesses);
+        TEST_ASSERT(m_report.write());
+    }
+};
+
+constexpr size_t RouterDecodeBench::TARGET_COUNTS[];
+
+int sc_main(int argc, char* argv[]) { return run_testbench<RouterDecodeBench>(argc, argv); }